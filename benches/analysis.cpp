@@ -0,0 +1,44 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <memory>
+#include <arc/analysis/call-graph.hpp>
+#include <arc/analysis/tbaa.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/pass-manager.hpp>
+#include <arc/support/generator.hpp>
+#include <benchmark/benchmark.h>
+#include "bench-support.hpp"
+
+/* analyses leave the module alone, so one module serves every iteration */
+template<typename P>
+static void run_analysis(benchmark::State &state)
+{
+	const std::unique_ptr<arc::Module> module = arc::generate({ .nodes = static_cast<std::size_t>(state.range(0)) });
+	const std::size_t nodes = count_nodes(*module);
+	AllocationCounts allocations;
+
+	for (auto _: state)
+	{
+		arc::PassManager pm;
+		pm.add<P>();
+
+		CountAllocations count(allocations);
+		pm.run(*module);
+	}
+	report(state, nodes, allocations);
+}
+
+static void BM_TBAA(benchmark::State &state)
+{
+	run_analysis<arc::TypeBasedAliasAnalysisPass>(state);
+}
+
+static void BM_CallGraph(benchmark::State &state)
+{
+	run_analysis<arc::CallGraphAnalysisPass>(state);
+}
+
+BENCHMARK(BM_TBAA)->Apply(sweep_sizes);
+BENCHMARK(BM_CallGraph)->Apply(sweep_sizes);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,135 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/support/allocator.hpp>
+#include "bench-support.hpp"
+
+namespace
+{
+	std::atomic<std::uint64_t> allocation_count = 0;
+	std::atomic<std::uint64_t> allocation_bytes = 0;
+
+#ifdef ARC_COUNT_POOL_ALLOCATIONS
+	/* nodes, regions and the like come from ach's pools, which never call operator new */
+	void count_pool_allocation(const std::size_t size)
+	{
+		allocation_count.fetch_add(1, std::memory_order_relaxed);
+		allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+	}
+
+	[[maybe_unused]] const bool pool_hooked = (ach::allocation_hook = count_pool_allocation, true);
+#endif
+
+	void *counted_allocate(const std::size_t size, const std::size_t alignment)
+	{
+		allocation_count.fetch_add(1, std::memory_order_relaxed);
+		allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+
+		const std::size_t bytes = size == 0 ? 1 : size;
+		void *p = alignment <= alignof(std::max_align_t)
+			          ? std::malloc(bytes)
+			          : std::aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment);
+		if (!p)
+			throw std::bad_alloc();
+		return p;
+	}
+
+	std::size_t count_region(const arc::Region *region) // NOLINT(*-no-recursion)
+	{
+		std::size_t count = region->nodes().size();
+		for (const arc::Region *child: region->children())
+			count += count_region(child);
+		return count;
+	}
+}
+
+void *operator new(const std::size_t size)
+{
+	return counted_allocate(size, alignof(std::max_align_t));
+}
+
+void *operator new[](const std::size_t size)
+{
+	return counted_allocate(size, alignof(std::max_align_t));
+}
+
+void *operator new(const std::size_t size, const std::align_val_t alignment)
+{
+	return counted_allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void *operator new[](const std::size_t size, const std::align_val_t alignment)
+{
+	return counted_allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+
+AllocationCounts allocation_counts()
+{
+	return { allocation_count.load(std::memory_order_relaxed), allocation_bytes.load(std::memory_order_relaxed) };
+}
+
+std::size_t count_nodes(arc::Module &module)
+{
+	std::size_t count = count_region(module.root());
+	if (const arc::Region *rodata = module.rodata())
+		count += count_region(rodata);
+	return count;
+}
+
+void sweep_sizes(benchmark::internal::Benchmark *bench)
+{
+	bench->RangeMultiplier(10)->Range(1'000, 1'000'000)->Unit(benchmark::kMillisecond)->Complexity();
+}
+
+void report(benchmark::State &state, const std::size_t nodes, const AllocationCounts &allocations)
+{
+	const auto iterations = static_cast<double>(state.iterations());
+	state.SetComplexityN(state.range(0));
+	state.counters["nodes"] = benchmark::Counter(static_cast<double>(nodes) * iterations, benchmark::Counter::kIsRate);
+	state.counters["allocs"] = benchmark::Counter(static_cast<double>(allocations.count), benchmark::Counter::kAvgIterations);
+	state.counters["alloc_bytes"] = benchmark::Counter(static_cast<double>(allocations.bytes), benchmark::Counter::kAvgIterations);
+}
@@ -0,0 +1,53 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <benchmark/benchmark.h>
+
+namespace arc
+{
+	class Module;
+}
+
+/* allocations made through operator new since the program started, and through
+ * ach's allocators too when built with ARC_COUNT_POOL_ALLOCATIONS; every
+ * benchmark target linking bench-support.cpp counts them */
+struct AllocationCounts
+{
+	std::uint64_t count = 0;
+	std::uint64_t bytes = 0;
+};
+
+AllocationCounts allocation_counts();
+
+/* adds the allocations made during its lifetime to `total` */
+class CountAllocations
+{
+public:
+	explicit CountAllocations(AllocationCounts &total) : total(total), start(allocation_counts()) {}
+
+	~CountAllocations()
+	{
+		const AllocationCounts end = allocation_counts();
+		total.count += end.count - start.count;
+		total.bytes += end.bytes - start.bytes;
+	}
+
+	CountAllocations(const CountAllocations &) = delete;
+	CountAllocations &operator=(const CountAllocations &) = delete;
+
+private:
+	AllocationCounts &total;
+	AllocationCounts start;
+};
+
+/* nodes in every region of the module, rodata included */
+std::size_t count_nodes(arc::Module &module);
+
+/* module sizes of the per-pass sweeps, in generated nodes */
+void sweep_sizes(benchmark::internal::Benchmark *bench);
+
+/* reports nodes/second, allocations per iteration and the complexity input */
+void report(benchmark::State &state, std::size_t nodes, const AllocationCounts &allocations);
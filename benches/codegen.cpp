@@ -0,0 +1,164 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <memory>
+#include <utility>
+#include <vector>
+#include <arc/codegen/insn-selector.hpp>
+#include <arc/codegen/lowering.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/pass-manager.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/support/generator.hpp>
+#include <benchmark/benchmark.h>
+#include "bench-support.hpp"
+
+/* a three-operand RISC target; only what selection needs */
+struct BenchInstruction
+{
+	enum class Opcode : std::uint16_t { ADD, SUB, MUL, AND, OR, XOR, SHL, SHR, LOAD, STORE, MOV };
+
+	static constexpr std::size_t max_operands()
+	{
+		return 3;
+	}
+
+	static constexpr std::size_t encoding_size()
+	{
+		return 4;
+	}
+};
+
+struct BenchTarget
+{
+	using instruction_type = BenchInstruction;
+
+	static constexpr arc::TargetArch target_arch()
+	{
+		return arc::TargetArch::RISCV64;
+	}
+};
+
+using Selector = arc::InstructionSelector<BenchTarget>;
+using DAG = arc::SelectionDAG<BenchInstruction>;
+
+static void collect_regions(arc::Region *region, std::vector<arc::Region *> &regions) // NOLINT(*-no-recursion)
+{
+	regions.push_back(region);
+	for (arc::Region *child: region->children())
+		collect_regions(child, regions);
+}
+
+/* function bodies and their blocks; the root only holds FUNCTION nodes */
+static std::vector<arc::Region *> code_regions(arc::Module &module)
+{
+	std::vector<arc::Region *> regions;
+	for (arc::Region *body: module.root()->children())
+		collect_regions(body, regions);
+	return regions;
+}
+
+static void define_patterns(Selector &selector)
+{
+	using Opcode = BenchInstruction::Opcode;
+	static constexpr std::pair<arc::NodeType, Opcode> table[] = {
+		{ arc::NodeType::ADD, Opcode::ADD }, { arc::NodeType::SUB, Opcode::SUB },
+		{ arc::NodeType::MUL, Opcode::MUL }, { arc::NodeType::BAND, Opcode::AND },
+		{ arc::NodeType::BOR, Opcode::OR }, { arc::NodeType::BXOR, Opcode::XOR },
+		{ arc::NodeType::BSHL, Opcode::SHL }, { arc::NodeType::BSHR, Opcode::SHR },
+		{ arc::NodeType::LOAD, Opcode::LOAD }, { arc::NodeType::STORE, Opcode::STORE }
+	};
+
+	for (const auto &[type, opcode]: table)
+	{
+		selector.define([type](Selector::dag_node *node)
+		                {
+			                return node->source && node->source->ir_type == type;
+		                },
+		                [&selector, opcode](Selector::dag_node *node)
+		                {
+			                std::vector<Selector::dag_node *> operands(node->operands.begin(), node->operands.end());
+			                return selector.make_instruction(opcode, operands);
+		                }, 10);
+	}
+
+	/* everything else becomes a move so every value is selected */
+	selector.define([](Selector::dag_node *) { return true; },
+	                [&selector](Selector::dag_node *) { return selector.make_instruction(BenchInstruction::Opcode::MOV); });
+}
+
+static void BM_Lowering(benchmark::State &state)
+{
+	AllocationCounts allocations;
+	std::size_t nodes = 0;
+
+	for (auto _: state)
+	{
+		state.PauseTiming();
+		const std::unique_ptr<arc::Module> module = arc::generate({ .nodes = static_cast<std::size_t>(state.range(0)) });
+		nodes = count_nodes(*module);
+		arc::IRLoweringPass pass;
+		arc::PassManager pm;
+		state.ResumeTiming();
+
+		CountAllocations count(allocations);
+		benchmark::DoNotOptimize(pass.run(*module, pm));
+	}
+	report(state, nodes, allocations);
+}
+
+static void BM_DAGBuild(benchmark::State &state)
+{
+	const std::unique_ptr<arc::Module> module = arc::generate({ .nodes = static_cast<std::size_t>(state.range(0)) });
+	const std::size_t nodes = count_nodes(*module);
+	const std::vector<arc::Region *> regions = code_regions(*module);
+	AllocationCounts allocations;
+
+	for (auto _: state)
+	{
+		CountAllocations count(allocations);
+		for (arc::Region *region: regions)
+		{
+			DAG dag(region);
+			dag.build();
+			benchmark::DoNotOptimize(dag.nodes().size());
+		}
+	}
+	report(state, nodes, allocations);
+}
+
+static void BM_ISel(benchmark::State &state)
+{
+	const std::unique_ptr<arc::Module> module = arc::generate({ .nodes = static_cast<std::size_t>(state.range(0)) });
+	const std::size_t nodes = count_nodes(*module);
+	const std::vector<arc::Region *> regions = code_regions(*module);
+	AllocationCounts allocations;
+
+	for (auto _: state)
+	{
+		/* selection marks DAG nodes, so every iteration selects fresh DAGs */
+		state.PauseTiming();
+		std::vector<std::unique_ptr<DAG> > dags;
+		dags.reserve(regions.size());
+		for (arc::Region *region: regions)
+		{
+			dags.push_back(std::make_unique<DAG>(region));
+			dags.back()->build();
+		}
+		state.ResumeTiming();
+
+		CountAllocations count(allocations);
+		for (const auto &dag: dags)
+		{
+			Selector selector(*dag);
+			define_patterns(selector);
+			benchmark::DoNotOptimize(selector.select_all());
+		}
+	}
+	report(state, nodes, allocations);
+}
+
+BENCHMARK(BM_Lowering)->Apply(sweep_sizes);
+BENCHMARK(BM_DAGBuild)->Apply(sweep_sizes);
+BENCHMARK(BM_ISel)->Apply(sweep_sizes);
+
+BENCHMARK_MAIN();
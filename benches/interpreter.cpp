@@ -0,0 +1,199 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <memory>
+#include <arc/foundation/builder.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/interp/interpreter.hpp>
+#include <benchmark/benchmark.h>
+
+/* small kernels exercising the dispatch loop, calls, memory and atomics */
+struct KernelModule
+{
+	std::unique_ptr<arc::Module> module = std::make_unique<arc::Module>("interp_bench");
+	arc::Builder builder { *module };
+
+	KernelModule()
+	{
+		build_sum_loop();
+		build_fib();
+		build_memory();
+		build_atomics();
+	}
+
+	void build_sum_loop()
+	{
+		/* sum of 1..n through FROM nodes; no memory traffic */
+		builder.function<arc::DataType::INT64>("sum_loop")
+				.param<arc::DataType::INT64>("n")
+				.body([&](arc::Builder &fb, arc::Node *n)
+				{
+					auto loop = fb.block<arc::DataType::VOID>("loop");
+					auto exit = fb.block<arc::DataType::VOID>("exit");
+
+					auto *zero = fb.lit(std::int64_t { 0 });
+					fb.jump(loop.entry());
+
+					arc::Node *total = nullptr;
+					loop([&](arc::Builder &lb)
+					{
+						auto *i = lb.from({ zero });
+						total = lb.from({ zero });
+						auto *next = lb.add(i, lb.lit(std::int64_t { 1 }));
+						auto *sum = lb.add(total, next);
+						arc::Builder::connect_inputs(i, { next });
+						arc::Builder::connect_inputs(total, { sum });
+						return lb.branch(lb.lt(next, n), loop.entry(), exit.entry());
+					});
+
+					exit([&](arc::Builder &eb)
+					{
+						return eb.ret(total);
+					});
+
+					return nullptr;
+				});
+	}
+
+	void build_fib()
+	{
+		auto fib = builder.opaque_t<arc::DataType::FUNCTION>("fib");
+		fib.function<arc::DataType::INT32>()
+				.param<arc::DataType::INT32>("n")
+				.body([&](arc::Builder &fb, arc::Node *n)
+				{
+					auto *two = fb.lit(2);
+					auto *base = fb.block<arc::DataType::INT32>("base")([&](arc::Builder &bb)
+					{
+						return bb.ret(n);
+					});
+
+					auto *recurse = fb.block<arc::DataType::INT32>("recurse")([&](arc::Builder &bb)
+					{
+						auto *a = bb.call(fib.node(), { bb.sub(n, bb.lit(1)) });
+						auto *b = bb.call(fib.node(), { bb.sub(n, two) });
+						return bb.ret(bb.add(a, b));
+					});
+
+					return fb.branch(fb.lt(n, two), base->parent->entry(), recurse->parent->entry());
+				});
+	}
+
+	void build_memory()
+	{
+		/* counter and accumulator kept in ALLOC memory */
+		builder.function<arc::DataType::INT32>("memory")
+				.param<arc::DataType::INT32>("n")
+				.body([&](arc::Builder &fb, arc::Node *n)
+				{
+					auto loop = fb.block<arc::DataType::VOID>("loop");
+					auto exit = fb.block<arc::DataType::VOID>("exit");
+
+					auto *counter = fb.alloc<arc::DataType::INT32>(fb.lit(1));
+					auto *total = fb.alloc<arc::DataType::INT32>(fb.lit(1));
+					fb.store(fb.lit(0), counter);
+					fb.store(fb.lit(0), total);
+					fb.jump(loop.entry());
+
+					loop([&](arc::Builder &lb)
+					{
+						auto *i = lb.add(lb.load(counter), lb.lit(1));
+						lb.store(i, counter);
+						lb.store(lb.bxor(lb.load(total), lb.mul(i, i)), total);
+						return lb.branch(lb.lt(i, n), loop.entry(), exit.entry());
+					});
+
+					exit([&](arc::Builder &eb)
+					{
+						return eb.ret(eb.load(total));
+					});
+
+					return nullptr;
+				});
+	}
+
+	void build_atomics()
+	{
+		/* release stores followed by acquire loads of one cell */
+		builder.function<arc::DataType::INT32>("atomics")
+				.param<arc::DataType::INT32>("n")
+				.body([&](arc::Builder &fb, arc::Node *n)
+				{
+					auto loop = fb.block<arc::DataType::VOID>("loop");
+					auto exit = fb.block<arc::DataType::VOID>("exit");
+
+					auto *cell = fb.alloc<arc::DataType::INT32>(fb.lit(1));
+					auto *address = fb.addr_of(cell);
+					auto *acquire = fb.lit(static_cast<std::uint8_t>(arc::AtomicOrdering::ACQUIRE));
+					auto *zero = fb.lit(0);
+					fb.store(zero).to_atomic(cell, arc::AtomicOrdering::RELEASE);
+					fb.jump(loop.entry());
+
+					loop([&](arc::Builder &lb)
+					{
+						auto *i = lb.from({ zero });
+						auto *current = lb.create_node(arc::NodeType::ATOMIC_LOAD, arc::DataType::INT32);
+						arc::Builder::connect_inputs(current, { address, acquire });
+						auto *next = lb.add(i, lb.lit(1));
+						lb.store(lb.add(current, next)).to_atomic(cell, arc::AtomicOrdering::RELEASE);
+						arc::Builder::connect_inputs(i, { next });
+						return lb.branch(lb.lt(next, n), loop.entry(), exit.entry());
+					});
+
+					exit([&](arc::Builder &eb)
+					{
+						return eb.ret(eb.load(cell));
+					});
+
+					return nullptr;
+				});
+	}
+};
+
+static void run_kernel(benchmark::State &state, const char *name, arc::Value arg)
+{
+	KernelModule kernels;
+	arc::Interpreter interp(*kernels.module);
+
+	for (auto _: state)
+		benchmark::DoNotOptimize(interp.call(name, { arg }).bits());
+}
+
+static void BM_SumLoop(benchmark::State &state)
+{
+	run_kernel(state, "sum_loop", static_cast<std::int64_t>(state.range(0)));
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_Fibonacci(benchmark::State &state)
+{
+	run_kernel(state, "fib", static_cast<std::int32_t>(state.range(0)));
+}
+
+static void BM_MemoryLoop(benchmark::State &state)
+{
+	run_kernel(state, "memory", static_cast<std::int32_t>(state.range(0)));
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_AtomicLoop(benchmark::State &state)
+{
+	run_kernel(state, "atomics", static_cast<std::int32_t>(state.range(0)));
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_Compile(benchmark::State &state)
+{
+	KernelModule kernels;
+
+	for (auto _: state)
+	{
+		arc::Interpreter interp(*kernels.module, { .stack_slots = 1 << 10, .max_depth = 64, .arena_bytes = 1 << 10 });
+		benchmark::DoNotOptimize(interp.function("fib"));
+	}
+}
+
+BENCHMARK(BM_SumLoop)->Range(1 << 10, 1 << 16)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Fibonacci)->DenseRange(15, 25, 5)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_MemoryLoop)->Range(1 << 10, 1 << 16)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_AtomicLoop)->Range(1 << 10, 1 << 16)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Compile)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,614 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+/* runs the benchmark suites, stores their results keyed by commit and
+ * compares them to a baseline:
+ *
+ *     bench-runner --bench-dir build/bin --baseline benches/baseline.json --output build/bench-results
+ *
+ * every benchmark is repeated and summarized by its median and median
+ * absolute deviation; a change counts only when it is beyond both the
+ * relative threshold and the noise of either run, so a single noisy
+ * repetition does not flag a regression. a missing baseline is an error;
+ * --update-baseline records the current results as the baseline instead of
+ * comparing. exit status is 1 if anything got slower, 2 on errors. */
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <map>
+#include <print>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+#include <sys/wait.h>
+
+namespace
+{
+	namespace fs = std::filesystem;
+
+	/* just enough JSON for google benchmark output and our own result files */
+	struct Json
+	{
+		using Array = std::vector<Json>;
+		using Object = std::vector<std::pair<std::string, Json> >;
+
+		std::variant<std::nullptr_t, bool, double, std::string, Array, Object> value;
+
+		[[nodiscard]] const Json *find(const std::string_view key) const
+		{
+			if (const auto *object = std::get_if<Object>(&value))
+			{
+				for (const auto &[name, member]: *object)
+				{
+					if (name == key)
+						return &member;
+				}
+			}
+			return nullptr;
+		}
+
+		[[nodiscard]] double number(const std::string_view key, const double fallback = 0) const
+		{
+			const Json *member = find(key);
+			const auto *n = member ? std::get_if<double>(&member->value) : nullptr;
+			return n ? *n : fallback;
+		}
+
+		[[nodiscard]] std::string_view string(const std::string_view key) const
+		{
+			const Json *member = find(key);
+			const auto *s = member ? std::get_if<std::string>(&member->value) : nullptr;
+			return s ? std::string_view(*s) : std::string_view();
+		}
+	};
+
+	class JsonReader
+	{
+	public:
+		explicit JsonReader(const std::string_view text) : text(text) {}
+
+		Json read()
+		{
+			Json result = value();
+			skip();
+			if (pos != text.size())
+				fail("trailing characters");
+			return result;
+		}
+
+	private:
+		std::string_view text;
+		std::size_t pos = 0;
+
+		[[noreturn]] void fail(const std::string_view what) const
+		{
+			throw std::runtime_error(std::format("invalid JSON at offset {}: {}", pos, what));
+		}
+
+		void skip()
+		{
+			while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+				++pos;
+		}
+
+		bool accept(const char c)
+		{
+			skip();
+			if (pos < text.size() && text[pos] == c)
+			{
+				++pos;
+				return true;
+			}
+			return false;
+		}
+
+		void expect(const char c)
+		{
+			if (!accept(c))
+				fail(std::format("expected '{}'", c));
+		}
+
+		bool keyword(const std::string_view word)
+		{
+			if (!text.substr(pos).starts_with(word))
+				return false;
+			pos += word.size();
+			return true;
+		}
+
+		Json value() // NOLINT(*-no-recursion)
+		{
+			skip();
+			if (pos >= text.size())
+				fail("unexpected end");
+
+			if (accept('{'))
+			{
+				Json::Object object;
+				if (accept('}'))
+					return { std::move(object) };
+				do
+				{
+					skip();
+					std::string key = string();
+					expect(':');
+					object.emplace_back(std::move(key), value());
+				}
+				while (accept(','));
+				expect('}');
+				return { std::move(object) };
+			}
+
+			if (accept('['))
+			{
+				Json::Array array;
+				if (accept(']'))
+					return { std::move(array) };
+				do
+					array.push_back(value());
+				while (accept(','));
+				expect(']');
+				return { std::move(array) };
+			}
+
+			if (text[pos] == '"')
+				return { string() };
+			if (keyword("true"))
+				return { true };
+			if (keyword("false"))
+				return { false };
+			if (keyword("null"))
+				return { nullptr };
+
+			double number = 0;
+			const auto [end, ec] = std::from_chars(text.data() + pos, text.data() + text.size(), number);
+			if (ec != std::errc())
+				fail("expected a value");
+			pos = static_cast<std::size_t>(end - text.data());
+			return { number };
+		}
+
+		std::string string()
+		{
+			if (pos >= text.size() || text[pos] != '"')
+				fail("expected a string");
+			++pos;
+
+			std::string result;
+			while (pos < text.size() && text[pos] != '"')
+			{
+				if (const char c = text[pos++]; c != '\\')
+				{
+					result += c;
+					continue;
+				}
+
+				if (pos >= text.size())
+					fail("unterminated escape");
+				switch (const char c = text[pos++])
+				{
+					case 'b':
+						result += '\b';
+						break;
+					case 'f':
+						result += '\f';
+						break;
+					case 'n':
+						result += '\n';
+						break;
+					case 'r':
+						result += '\r';
+						break;
+					case 't':
+						result += '\t';
+						break;
+					case 'u':
+					{
+						unsigned code = 0;
+						const auto [end, ec] = std::from_chars(text.data() + pos, text.data() + std::min(pos + 4, text.size()), code, 16);
+						if (ec != std::errc() || end != text.data() + pos + 4)
+							fail("invalid \\u escape");
+						pos += 4;
+						/* benchmark names are ASCII; keep anything else as a placeholder */
+						result += code < 0x80 ? static_cast<char>(code) : '?';
+						break;
+					}
+					default:
+						result += c;
+						break;
+				}
+			}
+
+			if (pos >= text.size())
+				fail("unterminated string");
+			++pos;
+			return result;
+		}
+	};
+
+	std::string escape(const std::string_view text)
+	{
+		std::string result;
+		result.reserve(text.size());
+		for (const char c: text)
+		{
+			if (c == '"' || c == '\\')
+				result += '\\';
+			result += c;
+		}
+		return result;
+	}
+
+	struct Options
+	{
+		fs::path bench_dir = "bin";
+		fs::path baseline;
+		fs::path output = "bench-results";
+		std::string commit;
+		std::string filter;
+		std::string min_time;
+		unsigned repetitions = 5;
+		double threshold = 0.05;
+		double noise = 3.0;
+		bool update_baseline = false;
+	};
+
+	struct Stats
+	{
+		double median = 0;
+		double mad = 0;
+		std::vector<double> samples;
+	};
+
+	/* benchmark key ("suite/name/arg") to its cpu time per iteration in ns */
+	using Results = std::map<std::string, Stats>;
+
+	double median_of(std::vector<double> values)
+	{
+		if (values.empty())
+			return 0;
+
+		const std::size_t mid = values.size() / 2;
+		std::ranges::nth_element(values, values.begin() + static_cast<std::ptrdiff_t>(mid));
+		const double upper = values[mid];
+		if (values.size() % 2 != 0)
+			return upper;
+		return (*std::ranges::max_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(mid)) + upper) / 2;
+	}
+
+	Stats summarize(std::vector<double> samples)
+	{
+		Stats stats;
+		stats.median = median_of(samples);
+
+		std::vector<double> deviations;
+		deviations.reserve(samples.size());
+		for (const double sample: samples)
+			deviations.push_back(std::abs(sample - stats.median));
+		stats.mad = median_of(std::move(deviations));
+		stats.samples = std::move(samples);
+		return stats;
+	}
+
+	double to_ns(const double value, const std::string_view unit)
+	{
+		if (unit == "us")
+			return value * 1e3;
+		if (unit == "ms")
+			return value * 1e6;
+		if (unit == "s")
+			return value * 1e9;
+		return value;
+	}
+
+	std::string quote(const std::string_view arg)
+	{
+		std::string result = "'";
+		for (const char c: arg)
+		{
+			if (c == '\'')
+				result += "'\\''";
+			else
+				result += c;
+		}
+		return result + "'";
+	}
+
+	std::string capture(const std::string &command)
+	{
+		std::FILE *pipe = ::popen(command.c_str(), "r");
+		if (!pipe)
+			throw std::runtime_error(std::format("cannot run '{}'", command));
+
+		std::string output;
+		char buffer[1 << 14];
+		for (std::size_t n; (n = std::fread(buffer, 1, sizeof(buffer), pipe)) > 0;)
+			output.append(buffer, n);
+
+		if (const int status = ::pclose(pipe); !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+			throw std::runtime_error(std::format("'{}' failed", command));
+		return output;
+	}
+
+	std::string current_commit()
+	{
+		try
+		{
+			std::string commit = capture("git rev-parse HEAD 2>/dev/null");
+			while (!commit.empty() && std::isspace(static_cast<unsigned char>(commit.back())))
+				commit.pop_back();
+			return commit.empty() ? "unknown" : commit;
+		}
+		catch (const std::runtime_error &)
+		{
+			return "unknown";
+		}
+	}
+
+	/* every executable named `*-bench` next to this one */
+	std::vector<fs::path> suites(const fs::path &dir)
+	{
+		std::vector<fs::path> result;
+		for (const auto &entry: fs::directory_iterator(dir))
+		{
+			const std::string name = entry.path().filename().string();
+			if (entry.is_regular_file() && name.ends_with("-bench") &&
+			    (entry.status().permissions() & fs::perms::owner_exec) != fs::perms::none)
+				result.push_back(entry.path());
+		}
+		std::ranges::sort(result);
+		return result;
+	}
+
+	void run_suite(const fs::path &suite, const Options &options, Results &results)
+	{
+		std::string command = std::format("{} --benchmark_format=json --benchmark_repetitions={}",
+		                                  quote(suite.string()), options.repetitions);
+		if (!options.filter.empty())
+			command += " --benchmark_filter=" + quote(options.filter);
+		if (!options.min_time.empty())
+			command += " --benchmark_min_time=" + quote(options.min_time);
+
+		std::println(stderr, "running {}", suite.filename().string());
+		const Json report = JsonReader(capture(command)).read();
+		const Json *benchmarks = report.find("benchmarks");
+		if (!benchmarks || !std::holds_alternative<Json::Array>(benchmarks->value))
+			throw std::runtime_error(std::format("{} printed no benchmarks", suite.string()));
+
+		/* repetitions come as separate runs; aggregates are recomputed here */
+		std::map<std::string, std::vector<double> > samples;
+		for (const Json &run: std::get<Json::Array>(benchmarks->value))
+		{
+			if (run.string("run_type") == "aggregate" || run.find("error_occurred"))
+				continue;
+
+			const std::string_view name = run.find("run_name") ? run.string("run_name") : run.string("name");
+			samples[std::format("{}/{}", suite.filename().string(), name)].push_back(
+				to_ns(run.number("cpu_time"), run.string("time_unit")));
+		}
+
+		for (auto &[key, values]: samples)
+			results[key] = summarize(std::move(values));
+	}
+
+	Results read_results(const fs::path &path)
+	{
+		std::ifstream in(path);
+		if (!in)
+			throw std::runtime_error(std::format("cannot read '{}'", path.string()));
+		std::stringstream text;
+		text << in.rdbuf();
+
+		Results results;
+		const Json file = JsonReader(text.str()).read();
+		const Json *benchmarks = file.find("benchmarks");
+		if (!benchmarks || !std::holds_alternative<Json::Object>(benchmarks->value))
+			return results;
+
+		for (const auto &[key, entry]: std::get<Json::Object>(benchmarks->value))
+		{
+			std::vector<double> samples;
+			if (const Json *list = entry.find("samples_ns"); list && std::holds_alternative<Json::Array>(list->value))
+			{
+				for (const Json &sample: std::get<Json::Array>(list->value))
+				{
+					if (const auto *n = std::get_if<double>(&sample.value))
+						samples.push_back(*n);
+				}
+			}
+
+			if (!samples.empty())
+				results[key] = summarize(std::move(samples));
+			else
+				results[key] = { entry.number("median_ns"), entry.number("mad_ns"), {} };
+		}
+		return results;
+	}
+
+	void write_results(const fs::path &path, const Options &options, const Results &results)
+	{
+		if (path.has_parent_path())
+			fs::create_directories(path.parent_path());
+
+		std::ofstream out(path);
+		if (!out)
+			throw std::runtime_error(std::format("cannot write '{}'", path.string()));
+
+		out << std::format("{{\n  \"commit\": \"{}\",\n  \"repetitions\": {},\n  \"benchmarks\": {{", escape(options.commit), options.repetitions);
+		bool first = true;
+		for (const auto &[key, stats]: results)
+		{
+			out << (first ? "\n" : ",\n");
+			first = false;
+			out << std::format("    \"{}\": {{ \"median_ns\": {}, \"mad_ns\": {}, \"samples_ns\": [", escape(key), stats.median, stats.mad);
+			for (std::size_t i = 0; i < stats.samples.size(); ++i)
+				out << (i ? ", " : "") << std::format("{}", stats.samples[i]);
+			out << "] }";
+		}
+		out << "\n  }\n}\n";
+	}
+
+	/* `BM_DCE/1000` belongs to `DCE` */
+	std::string pass_of(const std::string_view key)
+	{
+		std::string_view name = key.substr(key.find('/') + 1);
+		name = name.substr(0, name.find('/'));
+		if (name.starts_with("BM_"))
+			name.remove_prefix(3);
+		return std::string(name);
+	}
+
+	/* returns the number of regressions */
+	std::size_t compare(const Results &baseline, const Results &current, const Options &options)
+	{
+		std::size_t regressions = 0;
+		std::map<std::string, double> moved; /* pass to its largest relative change */
+
+		std::println("{:<56} {:>14} {:>14} {:>9}", "benchmark", "baseline", "current", "change");
+		for (const auto &[key, now]: current)
+		{
+			const auto it = baseline.find(key);
+			if (it == baseline.end())
+			{
+				std::println("{:<56} {:>14} {:>11.0f} ns {:>9}", key, "-", now.median, "new");
+				continue;
+			}
+
+			const Stats &before = it->second;
+			const double change = before.median > 0 ? (now.median - before.median) / before.median : 0;
+			/* 1.4826 scales the MAD to a standard deviation for normal noise */
+			const double noise = options.noise * 1.4826 * std::max(before.mad, now.mad);
+			const bool significant = std::abs(change) > options.threshold && std::abs(now.median - before.median) > noise;
+
+			std::string_view verdict;
+			if (significant && change > 0)
+			{
+				verdict = "SLOWER";
+				++regressions;
+			}
+			else if (significant)
+				verdict = "faster";
+
+			if (significant)
+			{
+				double &largest = moved[std::format("{} ({})", pass_of(key), key.substr(0, key.find('/')))];
+				if (std::abs(change) > std::abs(largest))
+					largest = change;
+			}
+
+			std::println("{:<56} {:>11.0f} ns {:>11.0f} ns {:>+8.1f}% {}", key, before.median, now.median, change * 100, verdict);
+		}
+
+		for (const auto &[key, before]: baseline)
+		{
+			if (!current.contains(key))
+				std::println("{:<56} {:>11.0f} ns {:>14} {:>9}", key, before.median, "-", "gone");
+		}
+
+		if (moved.empty())
+			std::println("\nno benchmark moved beyond {:.1f}% and the noise", options.threshold * 100);
+		else
+		{
+			std::println("\npasses that moved:");
+			for (const auto &[pass, change]: moved)
+				std::println("    {:<40} {:>+8.1f}%", pass, change * 100);
+		}
+		return regressions;
+	}
+
+	Options parse_args(const int argc, char **argv)
+	{
+		Options options;
+		auto next = [&](int &i) -> std::string
+		{
+			if (i + 1 >= argc)
+				throw std::invalid_argument(std::format("missing value for {}", argv[i]));
+			return argv[++i];
+		};
+
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string_view arg = argv[i];
+			if (arg == "--bench-dir")
+				options.bench_dir = next(i);
+			else if (arg == "--baseline")
+				options.baseline = next(i);
+			else if (arg == "--output")
+				options.output = next(i);
+			else if (arg == "--commit")
+				options.commit = next(i);
+			else if (arg == "--filter")
+				options.filter = next(i);
+			else if (arg == "--min-time")
+				options.min_time = next(i);
+			else if (arg == "--repetitions")
+				options.repetitions = static_cast<unsigned>(std::stoul(next(i)));
+			else if (arg == "--threshold")
+				options.threshold = std::stod(next(i)) / 100;
+			else if (arg == "--noise")
+				options.noise = std::stod(next(i));
+			else if (arg == "--update-baseline")
+				options.update_baseline = true;
+			else
+				throw std::invalid_argument(std::format(
+					"unknown argument '{}'\nusage: bench-runner [--bench-dir DIR] [--baseline FILE] [--output DIR] "
+					"[--commit SHA] [--filter REGEX] [--min-time T] [--repetitions N] [--threshold PERCENT] "
+					"[--noise MADS] [--update-baseline]", arg));
+		}
+
+		options.repetitions = std::max(options.repetitions, 3u);
+		if (options.commit.empty())
+			options.commit = current_commit();
+		return options;
+	}
+}
+
+int main(const int argc, char **argv)
+{
+	try
+	{
+		const Options options = parse_args(argc, argv);
+
+		Results results;
+		for (const fs::path &suite: suites(options.bench_dir))
+			run_suite(suite, options, results);
+		if (results.empty())
+			throw std::runtime_error(std::format("no benchmark results from '{}'", options.bench_dir.string()));
+
+		const fs::path output = options.output / (options.commit + ".json");
+		write_results(output, options, results);
+		std::println(stderr, "results written to {}", output.string());
+
+		if (options.baseline.empty())
+			return 0;
+
+		if (options.update_baseline)
+		{
+			write_results(options.baseline, options, results);
+			std::println(stderr, "baseline {} set to {}", options.baseline.string(), options.commit);
+			return 0;
+		}
+
+		/* writing one here would make the first run compare against itself */
+		if (!fs::exists(options.baseline))
+			throw std::runtime_error(std::format("baseline '{}' does not exist; record one with --update-baseline",
+			                                     options.baseline.string()));
+
+		return compare(read_results(options.baseline), results, options) > 0 ? 1 : 0;
+	}
+	catch (const std::exception &e)
+	{
+		std::println(stderr, "bench-runner: {}", e.what());
+		return 2;
+	}
+}
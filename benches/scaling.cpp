@@ -0,0 +1,130 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <map>
+#include <memory>
+#include <string>
+#include <arc/analysis/call-graph.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/pass-manager.hpp>
+#include <arc/foundation/verifier.hpp>
+#include <arc/support/generator.hpp>
+#include <arc/support/output-buffer.hpp>
+#include <arc/support/parser.hpp>
+#include <arc/support/printer.hpp>
+#include <arc/transform/constfold.hpp>
+#include <arc/transform/dce.hpp>
+#include <benchmark/benchmark.h>
+
+/* every subsystem is swept over the same module sizes; google benchmark fits
+ * a complexity curve to each sweep, so a subsystem that stops scaling
+ * linearly shows up as a worse fit in the report */
+static arc::GeneratorOptions options_for(const std::int64_t nodes)
+{
+	return { .nodes = static_cast<std::size_t>(nodes) };
+}
+
+/* generating the larger modules takes a while, and read-only subsystems can
+ * share them */
+static arc::Module &shared_module(const std::int64_t nodes)
+{
+	static std::map<std::int64_t, std::unique_ptr<arc::Module> > modules;
+	auto &module = modules[nodes];
+	if (!module)
+		module = arc::generate(options_for(nodes));
+	return *module;
+}
+
+static void sweep(benchmark::internal::Benchmark *bench)
+{
+	bench->RangeMultiplier(10)->Range(1'000, 10'000'000)->Unit(benchmark::kMillisecond)->Complexity();
+}
+
+static void finish(benchmark::State &state)
+{
+	state.SetComplexityN(state.range(0));
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_Generate(benchmark::State &state)
+{
+	for (auto _: state)
+		benchmark::DoNotOptimize(arc::generate(options_for(state.range(0))));
+	finish(state);
+}
+
+static void BM_Print(benchmark::State &state)
+{
+	arc::Module &module = shared_module(state.range(0));
+	for (auto _: state)
+	{
+		arc::OutputBuffer out;
+		arc::Printer(module).print(out);
+		benchmark::DoNotOptimize(out.size());
+	}
+	finish(state);
+}
+
+static void BM_Parse(benchmark::State &state)
+{
+	arc::OutputBuffer out;
+	arc::Printer(shared_module(state.range(0))).print(out);
+	const std::string text = out.str();
+
+	for (auto _: state)
+		benchmark::DoNotOptimize(arc::parse(text));
+	finish(state);
+	state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(text.size()));
+}
+
+static void BM_Verify(benchmark::State &state)
+{
+	arc::Module &module = shared_module(state.range(0));
+	for (auto _: state)
+	{
+		arc::Verifier verifier(module);
+		if (const auto diagnostics = verifier.verify(); !diagnostics.empty())
+		{
+			state.SkipWithError(diagnostics.front().message.c_str());
+			break;
+		}
+	}
+	finish(state);
+}
+
+static void BM_CallGraph(benchmark::State &state)
+{
+	arc::Module &module = shared_module(state.range(0));
+	for (auto _: state)
+	{
+		arc::PassManager pm;
+		pm.add<arc::CallGraphAnalysisPass>();
+		pm.run(module);
+	}
+	finish(state);
+}
+
+static void BM_Optimize(benchmark::State &state)
+{
+	/* transforms change the module, so every iteration needs a fresh one */
+	for (auto _: state)
+	{
+		state.PauseTiming();
+		const std::unique_ptr<arc::Module> module = arc::generate(options_for(state.range(0)));
+		arc::PassManager pm;
+		pm.add<arc::ConstantFoldingPass>();
+		pm.add<arc::DeadCodeElimination>();
+		state.ResumeTiming();
+
+		pm.run(*module);
+	}
+	finish(state);
+}
+
+BENCHMARK(BM_Generate)->Apply(sweep);
+BENCHMARK(BM_Print)->Apply(sweep);
+BENCHMARK(BM_Parse)->Apply(sweep);
+BENCHMARK(BM_Verify)->Apply(sweep);
+BENCHMARK(BM_CallGraph)->Apply(sweep);
+BENCHMARK(BM_Optimize)->Apply(sweep);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,115 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <cstdint>
+#include <format>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <unistd.h>
+#include <arc/analysis/tbaa.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/pass-manager.hpp>
+#include <arc/support/compile-server.hpp>
+#include <arc/support/generator.hpp>
+#include <arc/support/output-buffer.hpp>
+#include <arc/support/parser.hpp>
+#include <arc/support/printer.hpp>
+#include <arc/transform/constfold.hpp>
+#include <arc/transform/cse.hpp>
+#include <arc/transform/dce.hpp>
+#include <benchmark/benchmark.h>
+
+/* small jobs are where per-job setup dominates: a cold compile builds its
+ * pipeline and fills the allocator's pools from scratch, while the server
+ * pays for that once and only forks per job */
+static void configure(arc::PassManager &pm)
+{
+	pm.add<arc::TypeBasedAliasAnalysisPass>()
+			.add<arc::ConstantFoldingPass>()
+			.add<arc::CommonSubexpressionEliminationPass>()
+			.add<arc::DeadCodeElimination>();
+}
+
+static const std::string &job_text(const std::int64_t nodes)
+{
+	static std::map<std::int64_t, std::string> texts;
+	std::string &text = texts[nodes];
+	if (text.empty())
+	{
+		arc::OutputBuffer out;
+		arc::Printer(*arc::generate({ .nodes = static_cast<std::size_t>(nodes) })).print(out);
+		text = out.str();
+	}
+	return text;
+}
+
+/* one server for the whole run; its jobs are forked from the thread that serves */
+static const std::string &server_path()
+{
+	struct Running
+	{
+		arc::CompileServer server;
+		std::thread serving;
+
+		explicit Running(arc::ServerConfig config) : server(std::move(config))
+		{
+			server.pipeline(configure);
+			serving = std::thread([this] { server.serve(); });
+		}
+
+		~Running()
+		{
+			server.stop();
+			serving.join();
+		}
+	};
+
+	static const std::string path = std::format("/tmp/arc-server-bench-{}.sock", ::getpid());
+	static Running running({ .socket_path = path });
+	return path;
+}
+
+static void jobs(benchmark::internal::Benchmark *bench)
+{
+	bench->Arg(64)->Arg(256)->Arg(1024)->Unit(benchmark::kMicrosecond)->UseRealTime();
+}
+
+static void BM_ColdCompile(benchmark::State &state)
+{
+	const std::string &text = job_text(state.range(0));
+	for (auto _: state)
+	{
+		arc::PassManager pm;
+		configure(pm);
+		const std::unique_ptr<arc::Module> module = arc::parse(text);
+		pm.run(*module);
+		arc::OutputBuffer out;
+		arc::Printer(*module).print(out);
+		benchmark::DoNotOptimize(out.size());
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_ServerCompile(benchmark::State &state)
+{
+	const std::string &text = job_text(state.range(0));
+	const arc::CompileClient client(server_path());
+	for (auto _: state)
+	{
+		const arc::CompileResult result = client.compile(text);
+		if (result.status != arc::JobStatus::OK)
+		{
+			state.SkipWithError(result.output.c_str());
+			break;
+		}
+		benchmark::DoNotOptimize(result.output.size());
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_ColdCompile)->Apply(jobs);
+BENCHMARK(BM_ServerCompile)->Apply(jobs)->ThreadRange(1, 8);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,143 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <arc/analysis/tbaa.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/pass-manager.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/support/generator.hpp>
+#include <arc/transform/constfold.hpp>
+#include <arc/transform/cse.hpp>
+#include <arc/transform/dce.hpp>
+#include <arc/transform/dse.hpp>
+#include <arc/transform/hoistexpr.hpp>
+#include <arc/transform/inliner.hpp>
+#include <arc/transform/mem2reg.hpp>
+#include <arc/transform/sroa.hpp>
+#include <benchmark/benchmark.h>
+#include "bench-support.hpp"
+
+/* every iteration transforms a freshly generated module; generation and
+ * the analyses the pass requires are left out of the measurement */
+template<typename P>
+static void run_transform(benchmark::State &state)
+{
+	AllocationCounts allocations;
+	std::size_t nodes = 0;
+
+	for (auto _: state)
+	{
+		state.PauseTiming();
+		const std::unique_ptr<arc::Module> module = arc::generate({ .nodes = static_cast<std::size_t>(state.range(0)) });
+		nodes = count_nodes(*module);
+
+		P pass;
+		arc::PassManager pm;
+		if (const auto required = pass.require();
+			std::ranges::find(required, "type-based-alias-analysis") != required.end())
+		{
+			pm.add<arc::TypeBasedAliasAnalysisPass>();
+			pm.run(*module);
+		}
+		state.ResumeTiming();
+
+		CountAllocations count(allocations);
+		benchmark::DoNotOptimize(pass.run(*module, pm));
+	}
+	report(state, nodes, allocations);
+}
+
+static void collect_calls(arc::Region *region, std::vector<std::pair<arc::Node *, arc::Node *> > &calls) // NOLINT(*-no-recursion)
+{
+	for (arc::Node *node: region->nodes())
+	{
+		if (node->ir_type == arc::NodeType::CALL && !node->inputs.empty() &&
+		    node->inputs[0]->ir_type == arc::NodeType::FUNCTION)
+			calls.emplace_back(node, node->inputs[0]);
+	}
+	for (arc::Region *child: region->children())
+		collect_calls(child, calls);
+}
+
+static void BM_ConstantFolding(benchmark::State &state)
+{
+	run_transform<arc::ConstantFoldingPass>(state);
+}
+
+static void BM_CSE(benchmark::State &state)
+{
+	run_transform<arc::CommonSubexpressionEliminationPass>(state);
+}
+
+static void BM_DCE(benchmark::State &state)
+{
+	run_transform<arc::DeadCodeElimination>(state);
+}
+
+static void BM_DSE(benchmark::State &state)
+{
+	run_transform<arc::DeadStoreEliminationPass>(state);
+}
+
+static void BM_SROA(benchmark::State &state)
+{
+	run_transform<arc::SROAPass>(state);
+}
+
+static void BM_Mem2Reg(benchmark::State &state)
+{
+	run_transform<arc::Mem2RegPass>(state);
+}
+
+static void BM_HoistExpr(benchmark::State &state)
+{
+	run_transform<arc::HoistExpr>(state);
+}
+
+static void BM_Inliner(benchmark::State &state)
+{
+	AllocationCounts allocations;
+	std::size_t nodes = 0;
+
+	/* small functions so a good share of the call sites is inlined */
+	arc::Inliner inliner;
+	inliner.set_config({ .max_size = 64, .min_benefit = 0.0f });
+
+	for (auto _: state)
+	{
+		state.PauseTiming();
+		const std::unique_ptr<arc::Module> module = arc::generate({
+			.nodes = static_cast<std::size_t>(state.range(0)),
+			.nodes_per_function = 48,
+			.depth = 1,
+			.fan_out = 2
+		});
+		nodes = count_nodes(*module);
+
+		std::vector<std::pair<arc::Node *, arc::Node *> > calls;
+		collect_calls(module->root(), calls);
+		state.ResumeTiming();
+
+		CountAllocations count(allocations);
+		for (const auto &[call, callee]: calls)
+		{
+			if (inliner.evaluate(call, callee).should_inline)
+				benchmark::DoNotOptimize(inliner.inline_call(call, callee, *module));
+		}
+	}
+	report(state, nodes, allocations);
+}
+
+BENCHMARK(BM_ConstantFolding)->Apply(sweep_sizes);
+BENCHMARK(BM_CSE)->Apply(sweep_sizes);
+BENCHMARK(BM_DCE)->Apply(sweep_sizes);
+BENCHMARK(BM_DSE)->Apply(sweep_sizes);
+BENCHMARK(BM_SROA)->Apply(sweep_sizes);
+BENCHMARK(BM_Mem2Reg)->Apply(sweep_sizes);
+BENCHMARK(BM_HoistExpr)->Apply(sweep_sizes);
+BENCHMARK(BM_Inliner)->Apply(sweep_sizes);
+
+BENCHMARK_MAIN();
@@ -93,6 +93,18 @@ function(arc_library name)
     # compile features
     target_compile_features(${name} PUBLIC cxx_std_26)
 
+    # statistics compile to no-ops unless defined; exported so consumers of
+    # Arc::Arc see the same setting as the libraries
+    if (ARC_ENABLE_STATISTICS)
+        target_compile_definitions(${name} PUBLIC ARC_ENABLE_STATISTICS)
+    endif ()
+
+    # the allocation hook is compiled out of the allocator unless defined; it
+    # has to match in every translation unit sharing the allocator's templates
+    if (ARC_COUNT_POOL_ALLOCATIONS)
+        target_compile_definitions(${name} PUBLIC ARC_COUNT_POOL_ALLOCATIONS)
+    endif ()
+
     # set up output directories
     set_target_properties(${name} PROPERTIES
             RUNTIME_OUTPUT_DIRECTORY "${CMAKE_BINARY_DIR}/bin"
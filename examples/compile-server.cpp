@@ -0,0 +1,92 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+/* keeps a warm optimization pipeline around and compiles the modules clients
+ * send it until interrupted:
+ *
+ *     arc-compile-server --socket /tmp/arc.sock --workers 8 --memory-limit 256
+ *
+ * clients use `arc::CompileClient` with the same socket path */
+
+#include <csignal>
+#include <cstddef>
+#include <exception>
+#include <format>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <arc/analysis/tbaa.hpp>
+#include <arc/foundation/pass-manager.hpp>
+#include <arc/support/compile-server.hpp>
+#include <arc/transform/constfold.hpp>
+#include <arc/transform/cse.hpp>
+#include <arc/transform/dce.hpp>
+
+namespace
+{
+	arc::CompileServer *running = nullptr;
+
+	void interrupt(int)
+	{
+		if (running)
+			running->stop();
+	}
+
+	arc::ServerConfig parse_args(const int argc, char **argv)
+	{
+		arc::ServerConfig config { .socket_path = "/tmp/arc-compile-server.sock" };
+		auto next = [&](int &i) -> std::string
+		{
+			if (i + 1 >= argc)
+				throw std::invalid_argument(std::format("missing value for {}", argv[i]));
+			return argv[++i];
+		};
+
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string_view arg = argv[i];
+			if (arg == "--socket")
+				config.socket_path = next(i);
+			else if (arg == "--workers")
+				config.workers = std::stoul(next(i));
+			else if (arg == "--memory-limit")
+				config.memory_limit = std::stoul(next(i)) << 20;
+			else if (arg == "--max-request")
+				config.max_request = std::stoul(next(i)) << 20;
+			else
+				throw std::invalid_argument(std::format(
+					"unknown argument '{}'\nusage: arc-compile-server [--socket PATH] [--workers N] "
+					"[--memory-limit MIB] [--max-request MIB]", arg));
+		}
+		return config;
+	}
+}
+
+int main(const int argc, char **argv)
+{
+	try
+	{
+		arc::CompileServer server(parse_args(argc, argv));
+		server.pipeline([](arc::PassManager &pm)
+		{
+			pm.add<arc::TypeBasedAliasAnalysisPass>()
+					.add<arc::ConstantFoldingPass>()
+					.add<arc::CommonSubexpressionEliminationPass>()
+					.add<arc::DeadCodeElimination>();
+		});
+
+		running = &server;
+		std::signal(SIGINT, interrupt);
+		std::signal(SIGTERM, interrupt);
+		server.serve();
+		running = nullptr;
+
+		std::println(stderr, "arc-compile-server: served {} jobs", server.jobs());
+		return 0;
+	}
+	catch (const std::exception &e)
+	{
+		std::println(stderr, "arc-compile-server: {}", e.what());
+		return 1;
+	}
+}
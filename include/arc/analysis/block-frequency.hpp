@@ -0,0 +1,111 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <arc/analysis/profile.hpp>
+#include <arc/foundation/pass.hpp>
+
+namespace arc
+{
+	class Module;
+	struct Node;
+	class Region;
+
+	/**
+	 * @brief Branch probabilities and block frequencies of every function
+	 *
+	 * Frequencies are relative to one execution of the function the region
+	 * belongs to, so the function body always has a frequency of 1 and the
+	 * header of a loop taken 7 times out of 8 has a frequency of 8.
+	 */
+	class BlockFrequencyResult final : public Analysis
+	{
+	public:
+		[[nodiscard]] std::string name() const override
+		{
+			return "block-frequency-analysis";
+		}
+
+		/**
+		 * @brief Get the probability of the true edge of a branch
+		 * @param branch BRANCH node
+		 * @return Probability in [0, 1] or std::nullopt if the branch was not analyzed
+		 */
+		[[nodiscard]] std::optional<float> branch_probability(Node *branch) const;
+
+		/**
+		 * @brief Get the probability of control flowing from one region to another
+		 * @param from Source region
+		 * @param to Target region
+		 * @return Sum of the probabilities of every edge from `from` to `to`
+		 */
+		[[nodiscard]] float edge_probability(Region *from, Region *to) const;
+
+		/**
+		 * @brief Get the execution frequency of a region per call of its function
+		 * @param region Region of an analyzed function
+		 * @return Relative frequency or std::nullopt if the region was not analyzed
+		 */
+		[[nodiscard]] std::optional<float> frequency(Region *region) const;
+
+		/**
+		 * @brief Check if a region is the target of a back edge
+		 */
+		[[nodiscard]] bool loop_header(Region *region) const;
+
+	private:
+		std::unordered_map<Node *, float> branches;
+		std::unordered_map<Region *, std::vector<std::pair<Region *, float> > > successors;
+		std::unordered_map<Region *, float> frequencies;
+		std::unordered_set<Region *> headers;
+
+		friend class BlockFrequencyAnalysisPass;
+	};
+
+	/**
+	 * @brief Estimates branch probabilities and propagates block frequencies
+	 *
+	 * Branch probabilities come from user-supplied weights when available and
+	 * from static heuristics otherwise: loop back edges are likely, leaving a
+	 * loop is unlikely, pointer and integer equality tests (null and error
+	 * checks) are unlikely to hold and edges into exception handlers are
+	 * cold. heuristics that apply to the same branch are combined with
+	 * Dempster-Shafer evidence combination.
+	 *
+	 * Frequencies are propagated through the region CFG of each function
+	 * innermost loop first, scaling each loop header by its cyclic
+	 * probability (Wu & Larus, "Static Branch Frequency and Program Profile
+	 * Analysis", MICRO 1994).
+	 */
+	class BlockFrequencyAnalysisPass final : public AnalysisPass
+	{
+	public:
+		/**
+		 * @brief Estimate from heuristics and optional per-branch weights
+		 * @param weights Weights of BRANCH nodes that override the heuristics
+		 */
+		explicit BlockFrequencyAnalysisPass(std::unordered_map<Node *, BranchWeights> weights = {});
+
+		/**
+		 * @brief Estimate from heuristics and the weights of a collected profile
+		 * @param profile Profile matched against the module as ProfileAnalysisPass does
+		 */
+		explicit BlockFrequencyAnalysisPass(Profile profile);
+
+		[[nodiscard]] std::string name() const override;
+
+		Analysis *run(const Module &module) override;
+
+	private:
+		std::unordered_map<Node *, BranchWeights> annotations;
+		Profile data;
+
+		void analyze(BlockFrequencyResult *result, const ProfileLayout::Function &fn,
+		             const std::unordered_map<Node *, BranchWeights> &weights) const;
+	};
+}
@@ -190,6 +190,8 @@ namespace arc
 		 * @brief Run call graph analysis on the module
 		 * @param module Module to analyze
 		 * @return Call graph analysis result
+		 * @note functions evicted to a `ColdStore` are not rehydrated: they get the edges
+		 * their record names but no call sites, and their parameters are taken to escape
 		 */
 		Analysis *run(const Module &module) override;
 
@@ -0,0 +1,214 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <arc/foundation/pass.hpp>
+
+namespace arc
+{
+	class Module;
+	struct Node;
+	class Region;
+
+	/**
+	 * @brief Execution counts of the two edges of a BRANCH node
+	 */
+	struct BranchWeights
+	{
+		/** @brief Times the true target was taken */
+		std::uint64_t taken = 0;
+		/** @brief Times the false target was taken */
+		std::uint64_t not_taken = 0;
+
+		bool operator==(const BranchWeights &) const = default;
+	};
+
+	/**
+	 * @brief Counter layout of the edge profile of a module
+	 *
+	 * Each function with a body owns a contiguous block of counters: one for
+	 * its entry followed by a taken/not taken pair for every BRANCH node.
+	 * branches are numbered in pre-order over the function's region tree so
+	 * the same layout is recomputed from an instrumented and an original
+	 * module alike.
+	 */
+	struct ProfileLayout
+	{
+		struct Function
+		{
+			Node *node = nullptr;
+			Region *body = nullptr;
+			std::vector<Node *> branches;
+			std::uint32_t offset = 0; /* index of the entry counter */
+		};
+
+		std::vector<Function> functions;
+		std::uint32_t counters = 0;
+
+		/**
+		 * @brief Compute the counter layout of a module
+		 * @param module Module to lay out
+		 * @return Layout covering every function with a body
+		 */
+		static ProfileLayout of(const Module &module);
+	};
+
+	/**
+	 * @brief Edge profile of one function
+	 */
+	struct FunctionProfile
+	{
+		std::uint64_t entry_count = 0;
+		std::vector<BranchWeights> branches;
+	};
+
+	/**
+	 * @brief Serialized edge profile collected from instrumented runs
+	 *
+	 * The file format is line based text:
+	 * @code
+	 * arc-profile 1
+	 * function <name> <entry count> <branch count>
+	 * <taken> <not taken>
+	 * @endcode
+	 * with one weight line per branch following its function line.
+	 */
+	struct Profile
+	{
+		std::unordered_map<std::string, FunctionProfile> functions;
+
+		/**
+		 * @brief Build a profile from the counters of an instrumented run
+		 * @param module Module the counters were collected from
+		 * @param counters Counter values in ProfileLayout order
+		 * @return Profile keyed by function name
+		 * @throws std::invalid_argument if the counters do not match the layout
+		 */
+		static Profile from_counters(const Module &module, std::span<const std::uint64_t> counters);
+
+		/**
+		 * @brief Parse a profile
+		 * @param in Stream in the profile file format
+		 * @return Parsed profile
+		 * @throws std::runtime_error on malformed input
+		 */
+		static Profile read(std::istream &in);
+
+		/**
+		 * @brief Serialize the profile in the profile file format
+		 * @param out Output stream
+		 */
+		void write(std::ostream &out) const;
+
+		/**
+		 * @brief Accumulate the counts of another run
+		 * @param other Profile of the same module
+		 */
+		void merge(const Profile &other);
+	};
+
+	/**
+	 * @brief Profile counts attached to the nodes and regions of a module
+	 *
+	 * Branch weights and function entry counts come straight from the profile.
+	 * region counts are derived from them by propagating along the edges of
+	 * each function; a JUMP passes its region's count on unchanged.
+	 */
+	class ProfileResult final : public Analysis
+	{
+	public:
+		[[nodiscard]] std::string name() const override
+		{
+			return "profile-analysis";
+		}
+
+		/**
+		 * @brief Keep the result across transformations
+		 * @return Always true; counts stay attached to nodes that survive
+		 */
+		bool update(const std::vector<Region *> &modified_regions) override;
+
+		/**
+		 * @brief Get the profiled weights of a branch
+		 * @param branch BRANCH node
+		 * @return Weights or std::nullopt if the branch was not profiled
+		 */
+		[[nodiscard]] std::optional<BranchWeights> branch_weights(Node *branch) const;
+
+		/**
+		 * @brief Get the number of calls into a function
+		 * @param function FUNCTION node
+		 * @return Entry count or std::nullopt if the function was not profiled
+		 */
+		[[nodiscard]] std::optional<std::uint64_t> entry_count(Node *function) const;
+
+		/**
+		 * @brief Get the number of times a region was executed
+		 * @param region Region of a profiled function
+		 * @return Execution count or std::nullopt if unknown
+		 */
+		[[nodiscard]] std::optional<std::uint64_t> count(Region *region) const;
+
+		/**
+		 * @brief Get the number of times a call site was executed
+		 * @param call_site CALL or INVOKE node
+		 * @return Execution count of the call site's region or std::nullopt if unknown
+		 */
+		[[nodiscard]] std::optional<std::uint64_t> call_count(Node *call_site) const;
+
+		/**
+		 * @brief Get the execution count of a region per call of its function
+		 * @param region Region of a profiled function
+		 * @return Relative frequency or std::nullopt if unknown or never called
+		 */
+		[[nodiscard]] std::optional<float> frequency(Region *region) const;
+
+		/**
+		 * @brief Check if a region was profiled and never executed
+		 */
+		[[nodiscard]] bool cold(Region *region) const;
+
+		/**
+		 * @brief Check if no function of the module matched the profile
+		 */
+		[[nodiscard]] bool empty() const;
+
+	private:
+		std::unordered_map<Node *, BranchWeights> branches;
+		std::unordered_map<Node *, std::uint64_t> entries;
+		std::unordered_map<Region *, std::uint64_t> regions;
+		std::unordered_map<Region *, Node *> region_function;
+
+		friend class ProfileAnalysisPass;
+	};
+
+	/**
+	 * @brief Attaches a collected profile to a module
+	 *
+	 * Functions are matched by name. a function whose branch count differs
+	 * from the profile changed since the profile was collected and is left
+	 * without counts.
+	 */
+	class ProfileAnalysisPass final : public AnalysisPass
+	{
+	public:
+		explicit ProfileAnalysisPass(Profile profile = {});
+
+		[[nodiscard]] std::string name() const override;
+
+		Analysis *run(const Module &module) override;
+
+	private:
+		Profile data;
+
+		static void propagate(ProfileResult *result, const ProfileLayout::Function &fn,
+		                      const FunctionProfile &profile);
+	};
+}
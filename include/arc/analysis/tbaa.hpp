@@ -177,6 +177,11 @@ namespace arc
 		std::unordered_set<Node*> escaped_allocations;
 		std::unordered_map<Node*, std::uint64_t> allocation_sizes;
 		std::vector<Node*> mem_accesses;
+
+		/**
+		 * @brief Classify two accesses; `alias` wraps this to count the answers
+		 */
+		TBAAResult classify(Node* access1, Node* access2) const;
 	};
 
 	/**
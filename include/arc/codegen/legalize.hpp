@@ -0,0 +1,180 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <arc/codegen/insn-selector.hpp>
+#include <arc/foundation/pass.hpp>
+#include <arc/foundation/typed-data.hpp>
+
+namespace arc
+{
+	class Module;
+	class PassManager;
+	struct Node;
+	class Region;
+
+	/**
+	 * @brief Vector capability table of a target
+	 *
+	 * Describes which vector shapes the target can hold in a single register.
+	 * Element types missing from the lane table have no native vector support
+	 * and are either promoted or scalarized during legalization.
+	 */
+	struct VectorCapabilities
+	{
+		/** @brief Natively supported lane counts per element type */
+		std::unordered_map<DataType, std::vector<std::uint32_t> > lanes;
+		/** @brief Wider element type used in place of an unsupported one */
+		std::unordered_map<DataType, DataType> promotions;
+
+		/**
+		 * @brief Check if a vector shape maps to one target register
+		 * @param elem Element type
+		 * @param lane_count Number of lanes
+		 * @return true if the target supports the shape natively
+		 */
+		[[nodiscard]] bool legal(DataType elem, std::uint32_t lane_count) const;
+
+		/**
+		 * @brief Get the element type a vector is computed in
+		 * @param elem Element type of the original vector
+		 * @return Promoted element type, or elem if it needs no promotion
+		 */
+		[[nodiscard]] DataType promote(DataType elem) const;
+
+		/**
+		 * @brief Build a capability table from vector register widths
+		 * @param register_bytes Supported vector register widths in bytes
+		 * @param elements Element types the target supports in vector registers
+		 * @return Table with every lane count that fills one of the widths
+		 */
+		static VectorCapabilities from_widths(const std::vector<std::uint32_t> &register_bytes,
+		                                      const std::vector<DataType> &elements);
+
+		/**
+		 * @brief Get the default capability table of a target architecture
+		 * @param arch Target architecture
+		 * @return Capability table for the baseline vector extension of the target
+		 */
+		static VectorCapabilities of(TargetArch arch);
+	};
+
+	/**
+	 * @brief Vector type legalization pass
+	 *
+	 * Runs between IR lowering and SelectionDAG construction and rewrites vector
+	 * operations whose shape the target cannot hold in a register:
+	 * - unsupported element types are promoted to a wider supported type
+	 * - vectors wider than any register are split into legal parts
+	 * - narrow remainders are widened to the next legal width
+	 * - element types without any vector support are scalarized
+	 *
+	 * VECTOR_BUILD, VECTOR_SPLAT, VECTOR_EXTRACT and elementwise arithmetic are
+	 * rewritten part by part; an extract with a run time index is scalarized
+	 * into a select over every lane. an illegal vector that is produced or used
+	 * any other way is reported rather than passed on to SelectionDAG.
+	 */
+	class VectorLegalizationPass final : public TransformPass
+	{
+	public:
+		/**
+		 * @brief Construct the pass for a target capability table
+		 * @param capabilities Vector shapes supported by the target
+		 */
+		explicit VectorLegalizationPass(VectorCapabilities capabilities = VectorCapabilities::of(TargetArch::AARCH64));
+
+		/**
+		 * @brief Get the pass name
+		 * @return Pass identifier for dependency resolution
+		 */
+		[[nodiscard]] std::string name() const override;
+
+		/**
+		 * @brief Get analyses invalidated by this pass
+		 * @return Vector of analysis names that become stale after legalization
+		 */
+		[[nodiscard]] std::vector<std::string> invalidates() const override;
+
+		/**
+		 * @brief Run vector legalization on the module
+		 * @param module Module to transform
+		 * @param pm Pass manager for accessing cached analyses
+		 * @return Vector of regions that were modified
+		 * @throws std::runtime_error if an illegal vector has no part-wise form
+		 */
+		std::vector<Region *> run(Module &module, PassManager &pm) override;
+
+	private:
+		/**
+		 * @brief Legal piece of an illegal vector value
+		 */
+		struct Part
+		{
+			/** @brief Node computing the part; a scalar if the part is one lane wide */
+			Node *node = nullptr;
+			/** @brief First lane of the original vector covered by this part */
+			std::uint32_t offset = 0;
+			/** @brief Lanes of the original vector covered by this part */
+			std::uint32_t lanes = 0;
+			/** @brief Lanes of the part register; larger than lanes when widened */
+			std::uint32_t width = 0;
+		};
+
+		VectorCapabilities caps;
+		std::unordered_map<Node *, std::vector<Part> > legalized;
+
+		/**
+		 * @brief Split a vector shape into legal parts
+		 * @param elem Element type after promotion
+		 * @param lane_count Lane count of the original vector
+		 * @return Parts without nodes; a single part equal to the shape if it is legal
+		 */
+		[[nodiscard]] std::vector<Part> layout(DataType elem, std::uint32_t lane_count) const;
+
+		/**
+		 * @brief Check if a node produces a vector the target cannot hold as is
+		 * @param node Node to check
+		 * @return true if the vector must be promoted, split or widened
+		 */
+		[[nodiscard]] bool needs_legalization(const Node *node) const;
+
+		/**
+		 * @brief Legalize every vector node of a region
+		 * @param region Region to process
+		 * @return true if the region was modified
+		 */
+		bool process_region(Region *region);
+
+		/**
+		 * @brief Legalize a vector producing node
+		 * @param node Node with VECTOR result type
+		 * @return true if the node was split into parts
+		 */
+		bool legalize_vector(Node *node);
+
+		/**
+		 * @brief Rewrite an extract from a legalized vector to read its part
+		 * @param extract VECTOR_EXTRACT node
+		 * @return true if the extract was rewritten
+		 */
+		bool legalize_extract(Node *extract);
+
+		/**
+		 * @brief Read one lane of a legalized vector
+		 * @param part Part covering the lane
+		 * @param lane Lane of the original vector
+		 * @param before Node the extract is inserted before
+		 * @return The part itself if it is a scalar, otherwise an extract from it
+		 */
+		static Node *lane_of(const Part &part, std::uint32_t lane, Node *before);
+
+		/**
+		 * @brief Remove legalized nodes that no longer have users
+		 * @param region Region to clean up
+		 */
+		void remove_dead(Region *region);
+	};
+}
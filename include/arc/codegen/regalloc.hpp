@@ -4,11 +4,15 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 #include <optional>
 #include <unordered_set>
+#include <arc/analysis/block-frequency.hpp>
+#include <arc/analysis/profile.hpp>
 #include <arc/codegen/insn-selector.hpp>
 #include <arc/codegen/selection-dag.hpp>
 #include <arc/foundation/region.hpp>
+#include <arc/support/algorithm.hpp>
 
 namespace arc
 {
@@ -99,6 +103,20 @@ namespace arc
 		}
 	};
 
+	/**
+	 * @brief Register move produced by FROM node destruction
+	 */
+	template<typename Arch>
+	struct Move
+	{
+		using register_type = typename Arch::register_type;
+
+		register_type src = {};
+		register_type dst = {};
+		/** @brief Exchange src and dst instead of copying; used to break cycles without a scratch register */
+		bool swap = false;
+	};
+
 	/**
 	 * @brief Target architecture concept for register allocation
 	 */
@@ -127,6 +145,25 @@ namespace arc
 
 		explicit RegisterAllocator(const Arch &target, dag_type &dag) : arch(target), selection_dag(dag) {}
 
+		/**
+		 * @brief Weigh region pressure by profiled execution counts
+		 * @param result Profile of the module being allocated or nullptr to use loop depth only
+		 */
+		void set_profile(const ProfileResult *result)
+		{
+			profile = result;
+		}
+
+		/**
+		 * @brief Weigh region pressure by estimated block frequencies
+		 * @param result Frequencies of the module being allocated or nullptr to use loop depth only
+		 * @note A profile takes precedence for regions it has counts for
+		 */
+		void set_frequencies(const BlockFrequencyResult *result)
+		{
+			frequencies = result;
+		}
+
 		Budget<Arch> allocate(Region *region, Budget<Arch> available)
 		{
 			region_budgets[region] = {
@@ -273,7 +310,7 @@ namespace arc
 				return;
 
 			auto &result = it->second;
-			if (result.reg)
+			if (result.reg && release_web(node, *result.reg))
 			{
 				/* return the register to the available pool for this region.
 				 * this allows later allocations in the same region to reuse
@@ -353,9 +390,96 @@ namespace arc
 			return it != allocations.end() ? it->second : Result<Arch> {};
 		}
 
+		/**
+		 * @brief Check if two values were coalesced into the same FROM web
+		 * @param a First DAG node
+		 * @param b Second DAG node
+		 * @return True if both values share a web and therefore a register
+		 */
+		bool coalesced(dag_node *a, dag_node *b) const
+		{
+			if (!a || !b || !a->source || !b->source)
+				return false;
+
+			Node *web_a = web_of(a->source);
+			return web_a && web_a == web_of(b->source);
+		}
+
+		/**
+		 * @brief Compute the moves required on a control flow edge
+		 *
+		 * Collects the parallel copy implied by the FROM nodes of the successor
+		 * for values flowing in from the predecessor and sequences it. values
+		 * coalesced into the FROM web need no move and are dropped.
+		 *
+		 * @param pred Predecessor region of the edge
+		 * @param succ Successor region holding the FROM nodes
+		 * @param temp Scratch register used to break copy cycles; swaps are emitted when absent
+		 * @return Ordered moves to place at the end of the predecessor
+		 */
+		std::vector<Move<Arch> > copies(Region *pred, Region *succ, std::optional<register_type> temp = std::nullopt) const
+		{
+			std::vector<std::pair<register_type, register_type> > parallel;
+			if (!pred || !succ)
+				return {};
+
+			for (Node *from: succ->nodes())
+			{
+				if (from->ir_type != NodeType::FROM)
+					continue;
+
+				Node *incoming = incoming_value(from, pred);
+				if (!incoming)
+					continue;
+
+				/* coalesced values already share the register of the FROM node */
+				auto *dag_from = selection_dag.find(from);
+				auto *dag_incoming = selection_dag.find(incoming);
+				if (coalesced(dag_from, dag_incoming))
+					continue;
+
+				/* spilled or unallocated values are reloaded by the code generator */
+				auto dst = get(dag_from);
+				auto src = get(dag_incoming);
+				if (dst.allocated() && src.allocated())
+					parallel.emplace_back(*src.reg, *dst.reg);
+			}
+
+			return sequence(std::move(parallel), temp);
+		}
+
+		/**
+		 * @brief Sequence a parallel copy into ordered register moves
+		 *
+		 * Register form of `sequence_copies`: cycles are broken through the
+		 * scratch register, or with swaps if none is available.
+		 *
+		 * @param parallel Pairs of (source, destination) registers copied simultaneously
+		 * @param temp Optional scratch register not involved in the copy
+		 * @return Moves that have the same effect as the parallel copy
+		 */
+		static std::vector<Move<Arch> > sequence(const std::vector<std::pair<register_type, register_type> > &parallel,
+		                                         std::optional<register_type> temp = std::nullopt)
+		{
+			std::vector<Move<Arch> > copies;
+			copies.reserve(parallel.size());
+			for (const auto &[src, dst]: parallel)
+				copies.push_back({ .src = src, .dst = dst });
+
+			std::vector<Move<Arch> > moves;
+			const auto scratch = [&](const Move<Arch> &) { return temp; };
+			sequence_copies(std::move(copies), scratch, [&](const Move<Arch> &move, const bool swap)
+			{
+				moves.push_back({ .src = move.src, .dst = move.dst, .swap = swap });
+			});
+			return moves;
+		}
+
 	private:
 		const Arch &arch;
 		dag_type &selection_dag;
+		const ProfileResult *profile = nullptr;
+		const BlockFrequencyResult *frequencies = nullptr;
 
 		/**
 		 * @brief Budget and allocation state for a region
@@ -370,6 +494,17 @@ namespace arc
 		std::unordered_map<dag_node *, Result<Arch> > allocations;
 		std::unordered_map<Region *, Constraints<Arch> > region_constraints;
 
+		/* FROM webs; a union-find over IR values keyed by representative. values of
+		 * one web never interfere and share a single register */
+		std::unordered_map<Node *, Node *> web_parent;
+		std::unordered_map<Node *, std::vector<Node *> > web_members;
+		std::unordered_map<Node *, register_type> web_registers;
+		std::unordered_map<Node *, std::uint32_t> web_refs;
+
+		/* positions of nodes within their regions, filled a region at a time by `position` */
+		mutable std::unordered_set<const Region *> indexed_regions;
+		mutable std::unordered_map<const Node *, std::size_t> node_positions;
+
 		/**
 		 * @brief Bottom-up constraint analysis with temporal overlap computation
 		 */
@@ -418,6 +553,15 @@ namespace arc
 				 * exponentially more pressure due to overlapping iterations */
 				float loop_multiplier = 1.0f + (static_cast<float>(std::pow(constraints.loop_depth, 2)) * 0.3f);
 
+				/* a profile replaces the nesting guess with how often the region
+				 * actually ran, so spills are pushed into cold code */
+				if (profile && profile->cold(region))
+					loop_multiplier = 0.5f;
+				else if (const auto frequency = profile ? profile->frequency(region) : std::nullopt)
+					loop_multiplier = 1.0f + std::log2(1.0f + *frequency);
+				else if (const auto estimate = frequencies ? frequencies->frequency(region) : std::nullopt)
+					loop_multiplier = 1.0f + std::log2(1.0f + *estimate);
+
 				constraints.min_required[cls] = pressure_info.min_required;
 				constraints.max_simultaneous[cls] = pressure_info.max_simultaneous;
 				constraints.complexity[cls] = pressure_info.complexity * loop_multiplier;
@@ -553,6 +697,10 @@ namespace arc
 		            other_nodes.push_back(node);
 		    }
 
+		    /* group FROM nodes and their sources into non-interfering webs before
+		     * any of them is assigned a register, so the whole web can agree on one */
+		    coalesce(from_nodes);
+
 		    /* allocate FROM nodes first because they have the highest potential
 		     * for register reuse, which can significantly reduce code size and
 		     * improve performance by eliminating move instructions */
@@ -595,6 +743,13 @@ namespace arc
 		            RegisterClass cls = infer_class(dead_node->value_t);
 		            register_type released_reg = *result.reg;
 
+		            /* a web register stays taken while other members still hold it */
+		            if (!release_web(dead_node, released_reg))
+		            {
+		                result.reg = std::nullopt;
+		                continue;
+		            }
+
 		            /* add register back to available pool */
 		            budget.available[cls].insert(released_reg);
 		            --budget.allocated[cls];
@@ -608,7 +763,11 @@ namespace arc
 		            result.reg = std::nullopt;
 		        }
 
-		    	allocate_regular(node, budget);
+		        if (!allocate_web(node, budget))
+		        {
+		            allocate_regular(node, budget);
+		            bind_web(node);
+		        }
 		    }
 		}
 
@@ -619,6 +778,11 @@ namespace arc
 		{
 			RegisterClass cls = infer_class(node->value_t);
 
+			/* a coalesced web already agreed on a register; taking it means the
+			 * merge needs no move on any edge whose source is part of the web */
+			if (allocate_web(node, budget))
+				return;
+
 			/* we try to reuse registers from source values in order to
 			 * eliminate move instructions. since FROM nodes represent control
 			 * flow merges, reusing a source register means the value can flow
@@ -631,6 +795,7 @@ namespace arc
 					if (is_available(budget, cls, *alloc.reg))
 					{
 						allocate_specific(node, *alloc.reg, cls, budget);
+						bind_web(node);
 						return;
 					}
 				}
@@ -643,6 +808,7 @@ namespace arc
 					if (!caller_saved.empty() && is_available(budget, cls, caller_saved[0]))
 					{
 						allocate_specific(node, caller_saved[0], cls, budget);
+						bind_web(node);
 						return;
 					}
 				}
@@ -652,6 +818,326 @@ namespace arc
 			 * this will require move instructions to be generated during code
 			 * generation to handle the control flow merge */
 			allocate_regular(node, budget);
+			bind_web(node);
+		}
+
+		/**
+		 * @brief Union FROM nodes with their sources where lifetimes do not interfere
+		 */
+		void coalesce(const std::vector<dag_node *> &from_nodes)
+		{
+			indexed_regions.clear();
+			node_positions.clear();
+
+			for (auto *node: from_nodes)
+			{
+				if (!needs_allocation(node))
+					continue;
+
+				Node *from = node->source;
+				RegisterClass cls = infer_class(node->value_t);
+				for (Node *input: from->inputs)
+				{
+					if (!input || !input->parent || infer_class(input->type_kind) != cls)
+						continue;
+
+					Node *a = find_web(from);
+					Node *b = find_web(input);
+					if (a == b || webs_interfere(a, b))
+						continue;
+
+					/* two webs that already hold different registers would still
+					 * need a move between them, so keep them apart */
+					auto reg_a = web_registers.find(a);
+					auto reg_b = web_registers.find(b);
+					if (reg_a != web_registers.end() && reg_b != web_registers.end() &&
+					    reg_a->second != reg_b->second)
+					{
+						continue;
+					}
+
+					unite(a, b);
+				}
+			}
+		}
+
+		/**
+		 * @brief Find the web of a value, creating a singleton web if needed
+		 */
+		Node *find_web(Node *value)
+		{
+			auto [it, inserted] = web_parent.try_emplace(value, value);
+			if (inserted)
+			{
+				web_members[value] = { value };
+
+				/* values allocated before they joined a web seed it with their register */
+				if (auto *dag = selection_dag.find(value))
+				{
+					if (auto alloc = get(dag);
+						alloc.allocated())
+					{
+						web_registers[value] = *alloc.reg;
+						web_refs[value] = 1;
+					}
+				}
+				return value;
+			}
+
+			Node *root = it->second;
+			while (web_parent[root] != root)
+				root = web_parent[root];
+
+			/* path compression */
+			while (value != root)
+			{
+				Node *next = web_parent[value];
+				web_parent[value] = root;
+				value = next;
+			}
+			return root;
+		}
+
+		/**
+		 * @brief Find the web of a value without modifying the union-find
+		 * @return Representative of the web, or nullptr if the value is in none
+		 */
+		Node *web_of(Node *value) const
+		{
+			auto it = web_parent.find(value);
+			if (it == web_parent.end())
+				return nullptr;
+
+			Node *root = it->second;
+			while (web_parent.at(root) != root)
+				root = web_parent.at(root);
+			return root;
+		}
+
+		void unite(Node *a, Node *b)
+		{
+			/* union by size keeps the member lists short to move */
+			if (web_members[a].size() < web_members[b].size())
+				std::swap(a, b);
+
+			web_parent[b] = a;
+			auto &members = web_members[a];
+			auto &merged = web_members[b];
+			members.insert(members.end(), merged.begin(), merged.end());
+			web_members.erase(b);
+
+			if (auto it = web_registers.find(b);
+				it != web_registers.end())
+			{
+				web_registers[a] = it->second;
+				web_refs[a] += web_refs[b];
+				web_registers.erase(it);
+				web_refs.erase(b);
+			}
+		}
+
+		bool webs_interfere(Node *a, Node *b) const
+		{
+			const auto &members_a = web_members.at(a);
+			const auto &members_b = web_members.at(b);
+			for (Node *x: members_a)
+			{
+				for (Node *y: members_b)
+				{
+					if (interferes(x, y))
+						return true;
+				}
+			}
+			return false;
+		}
+
+		/**
+		 * @brief Check if two SSA values are live at the same time
+		 *
+		 * In strict SSA form two values interfere only if one is live at the
+		 * definition of the other, and that requires the first definition to
+		 * dominate the second.
+		 */
+		bool interferes(Node *a, Node *b) const
+		{
+			if (a == b || !a->parent || !b->parent)
+				return false;
+
+			if (defined_before(a, b))
+				return live_at(a, b);
+			if (defined_before(b, a))
+				return live_at(b, a);
+			return false;
+		}
+
+		bool defined_before(Node *a, Node *b) const
+		{
+			if (a->parent == b->parent)
+				return position(a) < position(b);
+			return a->parent->dominates(b->parent);
+		}
+
+		/**
+		 * @brief Check if a value is still needed after the definition of another
+		 */
+		bool live_at(Node *value, Node *point) const
+		{
+			Region *point_region = point->parent;
+			const std::size_t point_pos = position(point);
+
+			/* regions control can reach from the point without passing through the
+			 * definition of value again; a use in any of them keeps value alive */
+			std::unordered_set<Region *> reachable;
+			std::vector<Region *> worklist = successors(point_region);
+			while (!worklist.empty())
+			{
+				Region *current = worklist.back();
+				worklist.pop_back();
+				if (current == value->parent || !reachable.insert(current).second)
+					continue;
+
+				for (Region *succ: successors(current))
+					worklist.push_back(succ);
+			}
+
+			for (Node *user: value->users)
+			{
+				if (!user->parent)
+					continue;
+
+				/* a FROM reads its source on the incoming edge, which is the end of
+				 * the region the source flows out of */
+				Region *use_region = user->parent;
+				std::size_t use_pos = position(user);
+				if (user->ir_type == NodeType::FROM)
+				{
+					use_region = value->parent;
+					use_pos = std::numeric_limits<std::size_t>::max();
+				}
+
+				if (use_region == point_region && use_pos > point_pos)
+					return true;
+				if (reachable.contains(use_region))
+					return true;
+			}
+			return false;
+		}
+
+		static std::vector<Region *> successors(Region *region)
+		{
+			std::vector<Region *> succs;
+			for (Node *node: region->nodes())
+			{
+				switch (node->ir_type)
+				{
+					case NodeType::JUMP:
+						if (!node->inputs.empty() && node->inputs[0] && node->inputs[0]->parent)
+							succs.push_back(node->inputs[0]->parent);
+						break;
+					case NodeType::BRANCH:
+						for (std::uint8_t i = 1; i < node->inputs.size() && i < 3; ++i)
+						{
+							if (node->inputs[i] && node->inputs[i]->parent)
+								succs.push_back(node->inputs[i]->parent);
+						}
+						break;
+					case NodeType::INVOKE:
+						/* { function, normal, except, args... }; see `Builder::invoke` */
+						for (std::uint8_t i = 1; i < node->inputs.size() && i < 3; ++i)
+						{
+							if (node->inputs[i] && node->inputs[i]->parent)
+								succs.push_back(node->inputs[i]->parent);
+						}
+						break;
+					default:
+						break;
+				}
+			}
+			return succs;
+		}
+
+		/**
+		 * @brief Index of a node within its region
+		 *
+		 * Regions are indexed once on first use, so the interference checks of
+		 * coalescing look positions up instead of scanning the region each time.
+		 */
+		std::size_t position(Node *node) const
+		{
+			if (indexed_regions.insert(node->parent).second)
+			{
+				const auto &ns = node->parent->nodes();
+				for (std::size_t i = 0; i < ns.size(); ++i)
+					node_positions[ns[i]] = i;
+			}
+			return node_positions.at(node);
+		}
+
+		/**
+		 * @brief Give a node the register of its web if the web has one
+		 * @return True if the node was allocated
+		 */
+		bool allocate_web(dag_node *node, Budget<Arch> &budget)
+		{
+			Node *web = node->source ? web_of(node->source) : nullptr;
+			if (!web)
+				return false;
+
+			auto it = web_registers.find(web);
+			if (it == web_registers.end())
+				return false;
+
+			/* members of a web never interfere, so a register still held by one
+			 * of them can be shared without taking it from the budget again */
+			register_type reg = it->second;
+			if (web_refs[web] > 0)
+			{
+				allocations[node] = Result<Arch> { .reg = reg };
+				++web_refs[web];
+				return true;
+			}
+
+			RegisterClass cls = infer_class(node->value_t);
+			if (!is_available(budget, cls, reg))
+				return false;
+
+			allocate_specific(node, reg, cls, budget);
+			++web_refs[web];
+			return true;
+		}
+
+		/**
+		 * @brief Record the register of a node as the register of its web
+		 */
+		void bind_web(dag_node *node)
+		{
+			Node *web = node->source ? web_of(node->source) : nullptr;
+			if (!web || web_registers.contains(web))
+				return;
+
+			if (auto alloc = get(node);
+				alloc.allocated())
+			{
+				web_registers[web] = *alloc.reg;
+				web_refs[web] = 1;
+			}
+		}
+
+		/**
+		 * @brief Drop a reference to a web register
+		 * @return True if the register can go back to the pool
+		 */
+		bool release_web(dag_node *node, register_type reg)
+		{
+			Node *web = node->source ? web_of(node->source) : nullptr;
+			if (!web)
+				return true;
+
+			auto it = web_registers.find(web);
+			if (it == web_registers.end() || it->second != reg)
+				return true;
+
+			return web_refs[web] == 0 || --web_refs[web] == 0;
 		}
 
 		/**
@@ -421,6 +421,7 @@ namespace arc
 			arr_data.count = Count;
 			arr_data.elements = {};
 			alloc_node->value.set<decltype(arr_data), DataType::ARRAY>(arr_data);
+			module.intern_t(alloc_node);
 			connect_inputs(alloc_node, { count_lit });
 			return alloc_node;
 		}
@@ -438,7 +439,7 @@ namespace arc
 		Node* array_index(Node* array, Node* index);
 
 		/**
-		 * @brief Create a new node with specified type
+		 * @brief Create a new node with specified type, reusing one the module recycled if possible
 		 * @param type Node type
 		 * @param result_type Result data type
 		 * @return Newly created node
@@ -523,6 +524,7 @@ namespace arc
 			set_t<ReturnType>(*ret_type);
 			fn_data.return_type = ret_type;
 			opaque_node->value.set<decltype(fn_data), DataType::FUNCTION>(fn_data);
+			builder.module.intern_t(opaque_node);
 
 			const std::string_view func_name = builder.module.strtable().get(opaque_node->str_id);
 			Region* func_region = builder.module.create_region(func_name, builder.get_insertion_point());
@@ -851,6 +853,7 @@ namespace arc
 		arc::set_t<ReturnType>(*ret_type);
 		fn_data.return_type = ret_type;
 		function->value.set<decltype(fn_data), DataType::FUNCTION>(fn_data);
+		builder.module.intern_t(function);
 
 		Region *old_region = builder.get_insertion_point();
 		builder.set_insertion_point(region);
@@ -981,6 +984,7 @@ namespace arc
 			DataTraits<DataType::FUNCTION>::value fn_data;
 			fn_data.return_type = nullptr; /* will be set later by ::function<ReturnType>() */
 			func_node->value.set<decltype(fn_data), DataType::FUNCTION>(fn_data);
+			module.intern_t(func_node);
 			module.add_fn(func_node);
 			return Opaque<DataType::FUNCTION>(*this, func_node);
 		}
@@ -0,0 +1,198 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+#include <arc/foundation/module.hpp>
+
+namespace arc
+{
+	/**
+	 * @brief Where a `ColdStore` keeps the bodies it evicts
+	 */
+	enum class ColdMedium : std::uint8_t
+	{
+		MEMORY, /* encoded in a buffer of the store */
+		FILE    /* encoded in a temporary file, removed with the store */
+	};
+
+	/**
+	 * @brief When the pass manager evicts function bodies; see `PassManager::memory_budget`
+	 */
+	struct EvictionPolicy
+	{
+		/** @brief Bytes of resident function bodies allowed between passes; 0 never evicts */
+		std::size_t budget = 0;
+		/** @brief Safe points a function must go through unchanged before it may be evicted */
+		std::size_t cold_after = 2;
+		/** @brief Where evicted bodies are kept */
+		ColdMedium medium = ColdMedium::MEMORY;
+	};
+
+	/**
+	 * @brief Evicts the bodies of functions nothing works on anymore and brings them back later
+	 *
+	 * An evicted function is encoded into a compact byte stream: nodes in
+	 * region order, varint fields, and edges as distances between nodes rather
+	 * than pointers, which takes a fraction of the node graph it replaces. Its
+	 * nodes are freed. The FUNCTION node, its PARAM nodes and the regions with
+	 * their ENTRY nodes stay, so while evicted the function stands as an EXTERN
+	 * declaration that passes walking the module through `Module::open_body`
+	 * leave alone, and calls keep targeting it. Code that looks into another
+	 * function, such as the `Inliner`, goes through `Module::load_body` with
+	 * `BodyUse::CALLEE`, which rehydrates it first; an evicted callee is never
+	 * mistaken for an external function. The call graph does not need the
+	 * body: it finds the store through `Module::cold_store` and takes what an
+	 * evicted function calls and whether it writes memory from its record.
+	 *
+	 * Rehydrating rebuilds the body in place from the encoding: the function,
+	 * its parameters and its regions are the same objects as before, and the
+	 * rebuilt regions are recorded as changed so incremental passes look at
+	 * them again. Anything still evicted when the store is destroyed is
+	 * rehydrated then; errors doing so are swallowed, so call `rehydrate_all`
+	 * first to see them.
+	 *
+	 * Evicting and rehydrating are safe points of the module, like
+	 * `Module::reclaim`: pointers into evicted bodies, including ones cached
+	 * by analyses, must not be used afterwards. A function is kept resident if
+	 * a node outside its body still refers to one of its nodes. The store is
+	 * not thread-safe.
+	 *
+	 * @code
+	 * arc::ColdStore cold(module, arc::ColdMedium::FILE);
+	 * cold.evict(finished);     // bodies of finished functions go to disk
+	 * run_more_passes(module);  // they are skipped as declarations
+	 * cold.rehydrate_all();     // and come back as they were
+	 * @endcode
+	 */
+	class ColdStore
+	{
+	public:
+		/**
+		 * @param module Module whose functions are evicted; must outlive the store
+		 * @param medium Where evicted bodies are kept
+		 */
+		explicit ColdStore(Module &module, ColdMedium medium = ColdMedium::MEMORY);
+
+		/** @brief Rehydrates every function still evicted it can and removes the temporary file */
+		~ColdStore();
+
+		ColdStore(const ColdStore &) = delete;
+		ColdStore &operator=(const ColdStore &) = delete;
+		ColdStore(ColdStore &&) = delete;
+		ColdStore &operator=(ColdStore &&) = delete;
+
+		/**
+		 * @brief Evict the body of one function
+		 * @param fn FUNCTION node of the module
+		 * @return Whether it was evicted; declarations, functions already evicted and
+		 * functions whose nodes are referred to from outside their body are not
+		 * @throws std::system_error if the temporary file cannot be written
+		 */
+		bool evict(Node *fn);
+
+		/**
+		 * @brief Evict the bodies of several functions at once
+		 * @param fns FUNCTION nodes of the module
+		 * @return Number of functions evicted; see the single function overload
+		 * @throws std::system_error if the temporary file cannot be written
+		 */
+		std::size_t evict(const std::vector<Node *> &fns);
+
+		/**
+		 * @brief Rebuild the body of an evicted function; resident functions are left as they are
+		 * @param fn FUNCTION node of the module
+		 * @throws std::logic_error if the declaration was changed while evicted
+		 * @throws std::system_error if the temporary file cannot be read
+		 */
+		void rehydrate(Node *fn);
+
+		/**
+		 * @brief Rebuild every evicted function, in the order of the module
+		 * @return Number of functions rehydrated
+		 */
+		std::size_t rehydrate_all();
+
+		/** @brief Whether the body of a function is evicted */
+		[[nodiscard]] bool evicted(const Node *fn) const;
+
+		/** @brief Number of evicted functions */
+		[[nodiscard]] std::size_t evicted_count() const;
+
+		/**
+		 * @brief Functions the body of an evicted function refers to, read without rehydrating it
+		 *
+		 * The ones it calls and the ones whose address it takes, each once, in
+		 * the order the body first refers to them.
+		 *
+		 * @param fn FUNCTION node of the module
+		 * @return Empty if the function is not evicted
+		 */
+		[[nodiscard]] std::vector<Node *> referenced_functions(const Node *fn) const;
+
+		/**
+		 * @brief Whether the body of an evicted function stores to memory or does atomics
+		 * @param fn FUNCTION node of the module
+		 * @return false if the function is not evicted; stores through writeonly pointers do not count
+		 */
+		[[nodiscard]] bool writes_memory(const Node *fn) const;
+
+		/** @brief Estimated bytes of one resident function body: its nodes and their edges */
+		[[nodiscard]] std::size_t resident_bytes(const Node *fn) const;
+
+		/** @brief Estimated bytes of every resident function body of the module */
+		[[nodiscard]] std::size_t resident_bytes() const;
+
+		/** @brief Bytes the encoded bodies of evicted functions take, in memory or in the file */
+		[[nodiscard]] std::size_t stored_bytes() const;
+
+		/**
+		 * @brief Evict the functions that stopped changing while resident bodies are over budget
+		 *
+		 * Meant to be called at every safe point of a pipeline. A function becomes
+		 * a candidate once it went through `policy.cold_after` calls without being
+		 * changed; candidates changed least recently go first, ties in the order
+		 * of the module, until the module is under budget or none are left.
+		 * Ages are measured with `Module::checkpoint`, so calling this starts the
+		 * module's journal.
+		 *
+		 * @param policy Budget and coldness threshold; the medium is the store's own
+		 * @return Number of functions evicted
+		 */
+		std::size_t enforce(const EvictionPolicy &policy);
+
+	private:
+		struct Record
+		{
+			NodeTraits traits = NodeTraits::NONE; /* the function's own, while it stands as a declaration */
+			std::vector<std::uint8_t> bytes;       /* encoded body; empty once written to the file */
+			long offset = 0;                       /* position of the encoding in the file */
+			std::size_t size = 0;                  /* length of the encoding */
+			std::vector<Node *> externals;         /* nodes outside the body it refers to */
+			std::vector<TypedData> values;         /* struct and function values, kept as they are */
+			bool writes = false;                   /* see `writes_memory` */
+		};
+
+		struct Age
+		{
+			std::uint64_t stamp = 0;    /* latest change of the body when last looked at */
+			std::size_t unchanged = 0;  /* safe points since that change */
+		};
+
+		Module &mod;
+		Module::BodyLoader fallback; /* loader of the module before this store's */
+		ColdStore *outer = nullptr;  /* store of the module before this one */
+		ColdMedium medium;
+		std::FILE *file = nullptr;
+		std::size_t stored = 0;
+		std::unordered_map<const Node *, Record> records;
+		std::unordered_map<const Node *, Age> ages;
+
+		void store(Record &record);
+		[[nodiscard]] std::vector<std::uint8_t> read(const Record &record) const;
+	};
+}
@@ -0,0 +1,137 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+#include <arc/foundation/type-context.hpp>
+
+namespace arc
+{
+	/**
+	 * @brief Size, alignment and field offsets of a struct type
+	 *
+	 * Fields are addressed two ways: the raw index counts the padding fields
+	 * `StructBuilder` inserts, the logical index skips them.
+	 */
+	struct StructLayout
+	{
+		/** @brief Size in bytes, padding included */
+		std::uint64_t size = 0;
+		/** @brief Alignment in bytes */
+		std::uint32_t alignment = 1;
+		/** @brief Bytes taken by padding fields */
+		std::uint64_t padding = 0;
+		/** @brief Byte offset of every field by raw index */
+		std::vector<std::uint64_t> offsets;
+		/** @brief Raw index of every field by logical index */
+		std::vector<std::uint8_t> fields;
+		/** @brief Raw index of every named field */
+		std::unordered_map<StringTable::StringId, std::uint8_t> names;
+
+		/**
+		 * @brief Find a field by name
+		 * @return Raw index or std::nullopt if the struct has no such field
+		 */
+		[[nodiscard]] std::optional<std::uint8_t> index_of(StringTable::StringId name) const;
+
+		/**
+		 * @brief Get the byte offset of a field by logical index
+		 * @return Offset or std::nullopt if `logical` is out of bounds
+		 */
+		[[nodiscard]] std::optional<std::uint64_t> offset_of(std::size_t logical) const;
+
+		/**
+		 * @brief Check if the field at a raw index is padding
+		 */
+		[[nodiscard]] bool padding_at(std::size_t raw) const;
+	};
+
+	/**
+	 * @brief Size and alignment of an array type
+	 */
+	struct ArrayLayout
+	{
+		std::uint64_t size = 0;
+		std::uint32_t alignment = 1;
+		std::uint64_t element_size = 0;
+	};
+
+	/**
+	 * @brief Per-module cache of type layouts
+	 *
+	 * Struct layouts are computed once per interned struct and keyed by its
+	 * field storage, so every pass asking for the same type shares a single
+	 * offset table and name map instead of walking `fields` on each access.
+	 * structs must be interned in the module's `TypeContext`; structs viewing
+	 * other storage are laid out on every call.
+	 *
+	 * Lookups are thread-safe, so passes of a parallel batch may share the
+	 * module's layout; `clear` must not race with them.
+	 *
+	 * Sizes follow `StructBuilder`: fields are laid out back to back with the
+	 * padding it inserted, and nested structs contribute their full size.
+	 */
+	class DataLayout
+	{
+	public:
+		/**
+		 * @param strings String table used to recognize padding fields
+		 * @param types Context whose structs may be cached
+		 */
+		DataLayout(const StringTable &strings, const TypeContext &types);
+
+		DataLayout(const DataLayout &) = delete;
+
+		DataLayout &operator=(const DataLayout &) = delete;
+
+		/**
+		 * @brief Get the layout of a struct
+		 * @param type Struct type data
+		 * @return Layout; stable until `clear` is called, or until the next
+		 * call on the same thread if the struct is not interned in the context
+		 */
+		const StructLayout &of(const DataTraits<DataType::STRUCT>::value &type);
+
+		/**
+		 * @brief Get the layout of an array
+		 * @param type Array type data
+		 */
+		[[nodiscard]] ArrayLayout of(const DataTraits<DataType::ARRAY>::value &type) const;
+
+		/**
+		 * @brief Get the size of a value of any type
+		 * @param type Kind of the value
+		 * @param data Type data; required for STRUCT, ARRAY and VECTOR
+		 * @return Size in bytes; 0 if unknown
+		 */
+		std::uint64_t size_of(DataType type, const TypedData &data);
+
+		/**
+		 * @brief Get the alignment of a value of any type
+		 */
+		std::uint32_t align_of(DataType type, const TypedData &data);
+
+		/**
+		 * @brief Number of cached struct layouts
+		 */
+		[[nodiscard]] std::size_t size() const;
+
+		/**
+		 * @brief Drop every cached layout
+		 */
+		void clear();
+
+	private:
+		const StringTable &strtb;
+		const TypeContext &ctx;
+		mutable std::shared_mutex mutex;
+		/* node based, so entries stay put while other threads insert */
+		std::unordered_map<const TypeContext::Field *, StructLayout> structs;
+
+		void compute(const DataTraits<DataType::STRUCT>::value &type, StructLayout &layout);
+	};
+}
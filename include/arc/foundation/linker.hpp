@@ -0,0 +1,190 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <arc/foundation/module.hpp>
+
+namespace arc
+{
+	/**
+	 * @brief Thrown when modules cannot be linked together
+	 */
+	class LinkError : public std::runtime_error
+	{
+	public:
+		LinkError(std::string symbol, const std::string &message);
+
+		/** @brief Name of the function or type the error is about */
+		[[nodiscard]] const std::string &symbol() const;
+
+	private:
+		std::string sym;
+	};
+
+	/**
+	 * @brief Copies functions of other modules into a destination module
+	 *
+	 * Functions are matched by name: an EXTERN declaration is resolved by the
+	 * EXPORT definition of the same name in one of the added modules. A
+	 * resolved declaration keeps its FUNCTION node and PARAM nodes and only
+	 * has its body filled in, so every call that already targets it now calls
+	 * the definition, and the `Inliner` and the call graph see through it.
+	 *
+	 * Imported code is copied, never moved; the added modules are left as they
+	 * were. While copying, strings are re-interned in the destination, struct
+	 * types are rebuilt in its type context, typedefs are merged, and calls to
+	 * functions of the source module are redirected to their copies. Functions
+	 * without EXPORT are private to their module and are renamed to
+	 * `name.module` if the destination already uses their name.
+	 *
+	 * @code
+	 * arc::Linker linker(main_module);
+	 * linker.add(math_module).add(io_module);
+	 * linker.resolve(); // only what main_module declares, and what that calls
+	 * @endcode
+	 */
+	class Linker
+	{
+	public:
+		/**
+		 * @param dest Module receiving the imported functions
+		 */
+		explicit Linker(Module &dest);
+
+		Linker(const Linker &) = delete;
+		Linker &operator=(const Linker &) = delete;
+		Linker(Linker &&) = delete;
+		Linker &operator=(Linker &&) = delete;
+
+		/**
+		 * @brief Make the exports of a module available for linking
+		 * @param source Module to import from; must outlive the linker
+		 * @return Reference to this linker for chaining
+		 * @throws LinkError if another added module exports a function of the same name
+		 * @throws std::invalid_argument if `source` is the destination
+		 */
+		Linker &add(Module &source);
+
+		/**
+		 * @brief Import a single exported function and everything it calls
+		 * @param name Name of the function
+		 * @return FUNCTION node of the copy in the destination
+		 * @throws LinkError if no added module exports `name`, or the destination
+		 * defines a function of that name itself
+		 */
+		Node *import(std::string_view name);
+
+		/**
+		 * @brief Import one function of an added module, private or not, and everything it calls
+		 *
+		 * The copy keeps its name unless the destination already uses it.
+		 * @param fn FUNCTION node of an added module
+		 * @return FUNCTION node of the copy in the destination
+		 * @throws std::invalid_argument if `fn` does not belong to an added module
+		 */
+		Node *import(Node *fn);
+
+		/**
+		 * @brief Import functions of added modules in a given order, and everything they call
+		 *
+		 * The copies are added to the destination in the order of `fns`, ahead
+		 * of the callees they pull in, whatever modules they come from.
+		 * @param fns FUNCTION nodes of added modules
+		 * @return FUNCTION nodes of the copies, in the same order
+		 * @throws std::invalid_argument if a function does not belong to an added module
+		 */
+		std::vector<Node *> import(const std::vector<Node *> &fns);
+
+		/**
+		 * @brief Declare, instead of copy, the callees `predicate` accepts
+		 *
+		 * A function referenced by imported code that `predicate` accepts gets an
+		 * EXTERN declaration of the same name in the destination and its body is
+		 * left behind. Functions imported explicitly are always copied.
+		 * @param predicate Called with the function of the added module
+		 * @return Reference to this linker for chaining
+		 */
+		Linker &declare_if(std::function<bool(const Node *)> predicate);
+
+		/**
+		 * @brief Declare functions of added modules without copying their bodies
+		 * A later import of one of them fills in its declaration, so calls that
+		 * already target the declaration reach the definition.
+		 * @param fns FUNCTION nodes of added modules
+		 * @return EXTERN declarations in the destination, in the same order
+		 * @throws std::invalid_argument if a function does not belong to an added module
+		 */
+		std::vector<Node *> declare(const std::vector<Node *> &fns);
+
+		/**
+		 * @brief Copy the globals and read-only data of every added module, in their order
+		 * Functions they refer to are imported, or declared as `declare_if` says.
+		 */
+		void import_globals();
+
+		/**
+		 * @brief Fill in every EXTERN declaration of the destination an added module exports
+		 * @return Number of declarations that were resolved
+		 * @throws LinkError if a declaration and its definition have different signatures
+		 */
+		std::size_t resolve();
+
+		/**
+		 * @brief Merge every added module into the destination
+		 *
+		 * All functions, globals and read-only data are copied, whether or not
+		 * the destination uses them; declarations of the destination are
+		 * resolved as by `resolve`.
+		 * @throws LinkError on duplicate exports, mismatched signatures or conflicting typedefs
+		 */
+		void link();
+
+		/**
+		 * @brief Names of the destination's EXTERN declarations no added module defines
+		 */
+		[[nodiscard]] std::vector<std::string> unresolved() const;
+
+	private:
+		using NodeMap = std::unordered_map<const Node *, Node *>;
+
+		Module &dest;
+		std::vector<Module *> sources;
+		std::unordered_map<std::string, Node *> exports;   /* name -> exported definition in a source */
+		std::unordered_map<std::string, Node *> dest_fns;  /* name -> function of the destination */
+		NodeMap functions;                                 /* source function -> destination function */
+		NodeMap stubs;                                     /* source function -> declaration made by declare or declare_if */
+		NodeMap globals;                                   /* source global, rodata or type carrier -> copy */
+		std::unordered_map<const void *, TypedData> structs; /* source field storage -> rebuilt struct */
+		std::unordered_set<const Module *> merged_typedefs;
+		std::deque<std::pair<Node *, Node *> > pending;    /* bodies left to copy */
+		std::unordered_set<const Node *> in_place;         /* destination declarations being filled in */
+		std::function<bool(const Node *)> declared;        /* callees left as declarations */
+
+		void index_dest();
+		void drain();
+		void merge_typedefs(Module &from);
+
+		Node *import_function(Node *src_fn);
+		Node *declare(Node *src_fn);
+		Node *create_function(Module &from, Node *src_fn, std::string_view name);
+		void copy_body(Node *src_fn, Node *dest_fn);
+		Node *import_global(Module &from, Node *node);
+		Node *carrier(Module &from, Node *node);
+		Node *resolve(Module &from, Node *node, const NodeMap &local, bool type_only);
+		Node *shell(Module &from, const Node *node);
+
+		TypedData import_value(Module &from, const TypedData &value, const NodeMap &local);
+		TypedData import_struct(Module &from, const TypedData &type);
+		StringTable::StringId remap(Module &from, StringTable::StringId id);
+		std::string private_name(Module &from, std::string_view name) const;
+		void check_signature(Module &from, const Node *src_fn, const Node *dest_fn) const;
+	};
+}
@@ -2,18 +2,64 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
 #include <string_view>
 #include <unordered_map>
 #include <vector>
+#include <arc/foundation/data-layout.hpp>
 #include <arc/foundation/node.hpp>
+#include <arc/foundation/type-context.hpp>
 
 namespace arc
 {
+	class ColdStore;
 	class Region;
 
+	/**
+	 * @brief Changes recorded in a module's journal after an epoch
+	 */
+	struct ChangeSet
+	{
+		/** @brief Nodes edited through the tracking APIs, each once; some may have left their region since */
+		std::vector<Node*> nodes;
+		/** @brief Regions changed by passes that do not track their edits; rescan them whole */
+		std::vector<Region*> regions;
+		/** @brief Whether the journal covers the epoch; when false everything has to be rescanned */
+		bool complete = false;
+	};
+
+	/**
+	 * @brief Record a change to `node` in the journal of the module it belongs to
+	 *
+	 * For code that writes `Node` fields directly; the region, transaction and
+	 * connection helpers record their edits themselves. Detached nodes are
+	 * skipped, they are recorded once placed in a region.
+	 */
+	void mark_dirty(Node* node);
+
+	/**
+	 * @brief Why code asks for the body of a function; see `Module::load_body`
+	 */
+	enum class BodyUse : std::uint8_t
+	{
+		WALK,  /* a pass walking the functions of the module to read or change them */
+		CALLEE /* inter-procedural code reading the body of another function */
+	};
+
 	class Module
 	{
 	public:
+		/**
+		 * @brief Brings the body of a function declared in the module back from wherever it is held
+		 *
+		 * Called with a FUNCTION node that is an EXTERN declaration for now and
+		 * what the body is wanted for; returns true if it filled in the body.
+		 */
+		using BodyLoader = std::function<bool(Node*, BodyUse)>;
+
 		/**
 		 * @brief Construct a new module
 		 * @param name Name of the module
@@ -21,7 +67,11 @@ namespace arc
 		explicit Module(std::string_view name);
 
 		/**
-		 * @brief Module destructor
+		 * @brief Free every region of the module and the nodes it owns
+		 *
+		 * Owned nodes are those placed in a region, the listed functions and
+		 * the nodes handed back through `retire`. A node removed from its
+		 * region and never retired belongs to whoever removed it.
 		 */
 		~Module();
 
@@ -59,12 +109,74 @@ namespace arc
 		 */
 		[[nodiscard]] Node* find_fn(std::string_view name);
 
+		/**
+		 * @brief Find the body of a function
+		 *
+		 * Function bodies are the children of the root named after their function.
+		 *
+		 * @param fn Function node of this module
+		 * @return The first root child named after the function, or nullptr if it has none
+		 */
+		[[nodiscard]] Region* body(const Node* fn) const;
+
+		/**
+		 * @brief Index the body of every function by name
+		 *
+		 * For looking up many functions at once, where `body` would scan the
+		 * root for each of them.
+		 *
+		 * @return The first root child of each name; valid until the root's children change
+		 */
+		[[nodiscard]] std::unordered_map<std::string_view, Region*> bodies() const;
+
+		/**
+		 * @brief Find the body of a function a pass is about to read or change
+		 *
+		 * Goes through `load_body` for a `BodyUse::WALK` first, so a body held
+		 * outside the module can be brought in by the first pass walking into it.
+		 *
+		 * @param fn Function node of this module
+		 * @return Its body, or nullptr if it has none
+		 */
+		Region* open_body(Node* fn);
+
 		/**
 		 * @brief Add a function node into this module
 		 * @param fn Function node to register
 		 */
 		void add_fn(Node* fn);
 
+		/**
+		 * @brief Install the loader `load_body` hands declarations to
+		 *
+		 * Whatever keeps function bodies outside the module installs one, so
+		 * passes see bodies rather than declarations where the holder wants them to.
+		 *
+		 * @param loader Loader to install; empty to remove it
+		 * @return The loader it replaces, for a temporary one to restore
+		 */
+		BodyLoader lazy_bodies(BodyLoader loader);
+
+		/**
+		 * @brief Make sure the body of a function is in the module before looking into it
+		 *
+		 * Inter-procedural code calls this before reading a callee, and passes
+		 * through `open_body` before walking into a function; a function that
+		 * already has a body, or a real declaration, is left as it is. Loaders
+		 * run one at a time.
+		 *
+		 * @param fn Function about to be read
+		 * @param use What the body is wanted for
+		 * @return true if the body was loaded by this call
+		 */
+		bool load_body(Node* fn, BodyUse use = BodyUse::CALLEE);
+
+		/**
+		 * @brief Get the store holding the evicted function bodies of this module
+		 * @return The most recently created `ColdStore` still alive, or nullptr if there is none
+		 */
+		[[nodiscard]] const ColdStore* cold_store() const;
+
 		/**
 		 * @brief Add a literal node to .rodata region
 		 */
@@ -109,14 +221,40 @@ namespace arc
 		 */
 		StringTable& strtable();
 
+		/**
+		 * @brief Get the string table
+		 * @return String table
+		 */
+		[[nodiscard]]
+		const StringTable& strtable() const;
+
+		/**
+		 * @brief Get the uniqued composite types of this module
+		 * @return Type context
+		 */
+		TypeContext& types();
+
+		/**
+		 * @brief Get the cached layouts of the types of this module
+		 * @return Data layout
+		 */
+		DataLayout& layout();
+
 		/**
 		 * @brief Register a type
 		 * @param name Name of the type
-		 * @param tdef Data with type
+		 * @param tdef Data with type; composite types are interned in `types()`
 		 * @return Reference to the TypedData that's registered
 		 */
 		const TypedData& add_t(const std::string& name, TypedData tdef);
 
+		/**
+		 * @brief Intern the type of a node's value and record its handle on the node
+		 * @param node Node whose value was just set
+		 * @return Handle stored in `node->type_id`; `TypeContext::invalid` if the value is not composite
+		 */
+		TypeContext::TypeId intern_t(Node* node);
+
 		/**
 		 * @brief Look up type
 		 */
@@ -127,7 +265,84 @@ namespace arc
 		 */
 		const std::unordered_map<std::string, TypedData>& typemap();
 
+		/**
+		 * @brief End the current generation of changes
+		 *
+		 * Nothing is journaled until the first checkpoint, so building a module
+		 * costs nothing extra. Epochs come from a clock shared by every module,
+		 * so an epoch taken on another module is never mistaken for one of this
+		 * module's.
+		 *
+		 * @return Epoch to pass to `changes_since` later
+		 */
+		std::uint64_t checkpoint();
+
+		/**
+		 * @brief Record that a node of this module changed
+		 * @param node Node whose edges, value, type, traits or placement changed
+		 */
+		void touch(Node* node);
+
+		/**
+		 * @brief Record that a region changed in ways that were not tracked per node
+		 * @param region Region whose nodes must all be treated as changed
+		 */
+		void touch(Region* region);
+
+		/**
+		 * @brief Drop freed nodes from the journal
+		 * @param nodes Nodes about to be deallocated
+		 */
+		void forget(const std::vector<Node*>& nodes);
+
+		/**
+		 * @brief Collect everything that changed after an epoch
+		 * @param epoch Value returned by `checkpoint`
+		 * @return Changed nodes and regions; incomplete if the journal no longer covers `epoch`
+		 */
+		[[nodiscard]] ChangeSet changes_since(std::uint64_t epoch) const;
+
+		/**
+		 * @brief Allocate a node, reusing one recycled by `reclaim` when there is one
+		 * @param type IR type of the node
+		 * @param kind Data type of the node
+		 * @return Node not placed in any region
+		 */
+		Node* create_node(NodeType type, DataType kind = DataType::VOID);
+
+		/**
+		 * @brief Hand a node taken out of its region back to the module
+		 *
+		 * The node stays valid until the next safe point, so a pass may keep
+		 * looking at what it removed. It is only recycled then if it is still
+		 * detached and has no users; a node placed again is left alone.
+		 *
+		 * @param node Node removed from its region
+		 */
+		void retire(Node* node);
+
+		/**
+		 * @brief Safe point: recycle retired nodes nothing can reach anymore
+		 *
+		 * Called by the pass manager between passes. Pointers to retired nodes,
+		 * including ones cached by analyses, must not be used past this call.
+		 *
+		 * @return Number of nodes recycled
+		 */
+		std::size_t reclaim();
+
 	private:
+		struct Change
+		{
+			Node* node;           /* changed node, or nullptr for a whole region */
+			Region* region;       /* region changed wholesale */
+			std::uint64_t generation;
+		};
+
+		void record(const Change& change);
+
+		/* declared first so interned field storage outlives every node viewing it */
+		TypeContext type_ctx;
 		std::unordered_map<std::string, TypedData> typedefs;
 		std::vector<Node*> fns;
 		std::vector<Region*> regions;
@@ -137,5 +352,20 @@ namespace arc
 		Region* rodata_region; /* read-only section */
 		StringTable strtb;
 		StringTable::StringId mod_id;
+		DataLayout data_layout { strtb, type_ctx };
+
+		mutable std::mutex journal_mutex;
+		std::vector<Change> journal; /* ordered by generation */
+		std::uint64_t generation;    /* stamp of the changes being recorded */
+		std::uint64_t floor;         /* oldest epoch the journal still covers */
+
+		std::mutex loader_mutex;
+		BodyLoader body_loader;
+		friend class ColdStore; /* registers itself for as long as it lives */
+		ColdStore* cold = nullptr;
+
+		std::mutex pool_mutex;
+		std::vector<Node*> retired;    /* removed nodes waiting for the next safe point */
+		std::vector<Node*> free_nodes; /* recycled nodes handed out by `create_node` */
 	};
 }
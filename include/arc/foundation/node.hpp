@@ -3,6 +3,7 @@
 #pragma once
 
 #include <cstdint>
+#include <arc/foundation/type-context.hpp>
 #include <arc/foundation/typed-data.hpp>
 #include <arc/support/slice.hpp>
 #include <arc/support/string-table.hpp>
@@ -213,6 +214,8 @@ namespace arc
 		DataType type_kind;
 		/** @brief String interning reference */
 		StringTable::StringId str_id = {};
+		/** @brief Handle of the interned type of a composite value; see `Module::intern_t` */
+		TypeContext::TypeId type_id = TypeContext::invalid;
 
 		/* the packed attribute is used mainly to reduce the cache line
 		 * footprint from 72 bytes to 64 bytes. 72 bytes would span two cache lines,
@@ -225,4 +228,6 @@ namespace arc
 		 * and type of the value is last as they are only accessed in a fairly small
 		 * amount of passes that needs to see value such as SROA, AA, or CSE */
 	} __attribute__((packed));
+
+	static_assert(sizeof(Node) == 64, "a node must fit one cache line");
 }
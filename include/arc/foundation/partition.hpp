@@ -0,0 +1,125 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <arc/foundation/module.hpp>
+
+namespace arc
+{
+	class BlockFrequencyResult;
+
+	/**
+	 * @brief Tuning knobs for `Partitioner`
+	 */
+	struct PartitionConfig
+	{
+		/** @brief Number of partitions; 0 uses one per hardware thread */
+		std::size_t partitions = 0;
+		/** @brief How far above the mean size, as a factor, a partition may grow */
+		float imbalance = 1.25f;
+		/** @brief Rounds of moving single functions to the partition they call most */
+		std::size_t refine_rounds = 4;
+	};
+
+	/**
+	 * @brief Splits a module into independently optimizable pieces along its call graph
+	 *
+	 * Every defined function is assigned to one partition. Call edges are
+	 * weighted by how often the call site runs, when block frequencies are
+	 * given, or by the number of call sites otherwise; functions joined by the
+	 * heaviest edges are clustered first so that as little call weight as
+	 * possible crosses partitions, and the largest partition stays within
+	 * `imbalance` times the mean size, counted in nodes.
+	 *
+	 * Each partition is copied into its own module. Functions keep their names:
+	 * a function called from another partition is marked EXPORT there and
+	 * declared EXTERN where it is called, and private functions promoted this
+	 * way lose EXPORT again when the partitions are merged back, so the merged
+	 * module has the same symbols as the original.
+	 *
+	 * @code
+	 * arc::Partitioner partitioner(module, { .partitions = 8 });
+	 * std::unique_ptr<arc::Module> optimized = partitioner.run([](arc::Module &part)
+	 * {
+	 *     arc::PassManager pm;
+	 *     pm.add<arc::CommonSubexpressionEliminationPass>();
+	 *     pm.add<arc::DeadCodeElimination>();
+	 *     pm.run(part);
+	 * });
+	 * @endcode
+	 */
+	class Partitioner
+	{
+	public:
+		/** @brief Work done on each partition, on its own thread */
+		using Pipeline = std::function<void(Module &)>;
+
+		/**
+		 * @param module Module to split; not modified
+		 * @param config Partitioning parameters
+		 * @param frequencies Optional block frequencies of `module` to weight call edges by
+		 */
+		explicit Partitioner(Module &module, PartitionConfig config = {},
+		                     const BlockFrequencyResult *frequencies = nullptr);
+
+		/** @brief Functions of each partition; partitions that would be empty are dropped */
+		[[nodiscard]] const std::vector<std::vector<Node *> > &partitions() const;
+
+		/** @brief Partition a function of the source module was assigned to, or -1 for declarations */
+		[[nodiscard]] std::ptrdiff_t partition_of(const Node *fn) const;
+
+		/** @brief Total weight of the call edges between different partitions */
+		[[nodiscard]] double cut_weight() const;
+
+		/**
+		 * @brief Copy each partition into its own module
+		 * @return One module per partition, named `<module>.part<N>`
+		 */
+		[[nodiscard]] std::vector<std::unique_ptr<Module> > split() const;
+
+		/**
+		 * @brief Link partitions produced by `split` back into one module
+		 * @param parts Partitions, possibly transformed since they were split
+		 * @return Module with every function of every partition
+		 */
+		[[nodiscard]] std::unique_ptr<Module> merge(std::vector<std::unique_ptr<Module> > &parts) const;
+
+		/**
+		 * @brief Split, run `pipeline` on every partition concurrently, and merge the results
+		 * @param pipeline Work to do on each partition
+		 * @return The merged module
+		 * @throws whatever a pipeline threw, after every partition has finished
+		 */
+		[[nodiscard]] std::unique_ptr<Module> run(const Pipeline &pipeline) const;
+
+	private:
+		struct Edge
+		{
+			std::size_t a;
+			std::size_t b;
+			double weight;
+		};
+
+		Module &module;
+		PartitionConfig config;
+		std::vector<Node *> functions;                         /* defined functions, in module order */
+		std::unordered_map<const Node *, std::size_t> index;   /* function -> position in `functions` */
+		std::vector<std::size_t> sizes;                        /* node count of each function */
+		std::vector<Edge> edges;                               /* undirected, one per pair of functions */
+		std::vector<std::size_t> assignment;                   /* function -> partition */
+		std::vector<std::vector<Node *> > parts;
+		std::unordered_set<std::string> promoted;              /* private functions exported between partitions */
+
+		void collect(const BlockFrequencyResult *frequencies);
+		void cluster(std::size_t count);
+		void refine(std::size_t count);
+		void finalize();
+	};
+}
@@ -2,18 +2,23 @@
 
 #pragma once
 
+#include <optional>
 #include <shared_mutex>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
+#include <arc/foundation/cold-store.hpp>
 #include <arc/foundation/module.hpp>
 #include <arc/foundation/pass.hpp>
 #include <arc/foundation/region.hpp>
+#include <arc/foundation/verifier.hpp>
 #include <arc/support/allocator.hpp>
 
 namespace arc
 {
+	class PerfProfile;
 	class TaskGraph;
 
 	/**
@@ -21,8 +26,9 @@ namespace arc
 	 */
 	enum class ExecutionPolicy
 	{
-		SEQUENTIAL,  /* run passes one by one */
-		PARALLEL     /* run independent passes concurrently */
+		SEQUENTIAL,    /* run passes one by one */
+		PARALLEL,      /* run independent passes concurrently */
+		DETERMINISTIC  /* run independent analyses concurrently and transforms one by one in batch order */
 	};
 
 	/**
@@ -74,6 +80,38 @@ namespace arc
 			return *this;
 		}
 
+		/**
+		 * @brief Verify the IR after every transform pass
+		 * @param mode `MODIFIED` checks only the regions each transform reports,
+		 * `FULL` checks the whole module
+		 * @return Reference to this PassManager for chaining
+		 * @note a failing check throws `VerificationError` naming the pass
+		 */
+		PassManager& verify(VerifyMode mode);
+
+		/**
+		 * @brief Count hardware events around every pass that runs
+		 * @param profile Profile that receives a row per pass; must outlive the runs
+		 * @return Reference to this PassManager for chaining
+		 * @note only the pass itself is measured, not verification or invalidation;
+		 * where counters are unavailable the rows are recorded without events
+		 */
+		PassManager& profile(PerfProfile& profile);
+
+		/**
+		 * @brief Evict function bodies that stopped changing while the module is over a memory budget
+		 * @param policy Budget, how long a function must go unchanged and where its body goes
+		 * @return Reference to this PassManager for chaining
+		 * @note checked at every safe point of `run`; an evicted function stands as an EXTERN
+		 * declaration for the passes after it, so a pass that would still have changed it
+		 * does not. The `Inliner` rehydrates the callees it looks into; they go again
+		 * once cold. The call graph reads what an evicted function calls from the store
+		 * instead, and nothing is evicted while an analysis that loads bodies is cached
+		 * (`AnalysisPass::loads_bodies`). Every evicted function is rehydrated before
+		 * `run` returns. See `ColdStore`
+		 */
+		PassManager& memory_budget(const EvictionPolicy& policy);
+
 		/**
 		 * @brief Get a cached analysis result
 		 * @tparam T Analysis result type (must derive from Analysis)
@@ -99,6 +137,10 @@ namespace arc
 
 		/**
 		 * @brief Run all registered passes on the given module
+		 *
+		 * Nodes the passes retire are recycled between passes; see `Module::reclaim`.
+		 * Under a `memory_budget`, cold function bodies are evicted there as well.
+		 *
 		 * @param module Module to process
 		 */
 		void run(Module& module);
@@ -128,19 +170,58 @@ namespace arc
 		std::vector<Pass*> passes;
 		std::vector<std::vector<Pass*>> execution_batches; /* for TaskGraph mode */
 		ExecutionPolicy exec_policy;
+		VerifyMode verify_mode = VerifyMode::NONE;
+		std::optional<Verifier> verifier; /* lives for one `run`, so its body index is built once */
+		std::unordered_set<std::string> stale_analyses; /* cached across a transform, so may name nodes it retired */
+		PerfProfile* perf_profile = nullptr;
+		EvictionPolicy eviction;
 		mutable std::shared_mutex analyses_mutex;
 
 		/**
 		 * @brief Run passes sequentially
 		 * @param module Module to process
+		 * @param cold Store evicting cold functions, or nullptr without a memory budget
 		 */
-		void run_sequential(Module& module);
+		void run_sequential(Module& module, ColdStore* cold);
 
 		/**
 		 * @brief Run passes in parallel batches
 		 * @param module Module to process
+		 * @param cold Store evicting cold functions, or nullptr without a memory budget
+		 */
+		void run_parallel(Module& module, ColdStore* cold);
+
+		/**
+		 * @brief Recycle retired nodes and enforce the memory budget between passes
+		 *
+		 * Retired nodes are only recycled once no analysis cached across the
+		 * transform that retired them is cached anymore; until a pass invalidates
+		 * those, a new node cannot take the address of one they may be keyed by.
+		 * Evicting frees nodes too and waits alike, and does not happen at all
+		 * while an analysis that loads bodies is cached; cached analyses are
+		 * computed again if bodies were evicted.
+		 *
+		 * @param module Module to process
+		 * @param cold Store evicting cold functions, or nullptr without a memory budget
+		 */
+		void safe_point(Module& module, ColdStore* cold);
+
+		/**
+		 * @brief Record every cached analysis as possibly naming nodes the last transform retired
 		 */
-		void run_parallel(Module& module);
+		void mark_stale_analyses();
+
+		/**
+		 * @brief Find the analysis passes whose results are cached
+		 * @return Those passes, in no particular order
+		 */
+		[[nodiscard]] std::vector<AnalysisPass*> cached_analyses() const;
+
+		/**
+		 * @brief Compute every cached analysis again after function bodies were evicted or rehydrated
+		 * @param module Module to analyze
+		 */
+		void refresh_analyses(Module& module);
 
 		/**
 		 * @brief Execute a single pass with proper validation
@@ -156,6 +237,13 @@ namespace arc
 		 */
 		void execute_batch(const std::vector<Pass*>& batch, Module& module);
 
+		/**
+		 * @brief Execute a batch so that its result does not depend on thread scheduling
+		 * @param batch Passes to execute; analyses run concurrently, transforms in batch order
+		 * @param module Module to process
+		 */
+		void execute_ordered(const std::vector<Pass*>& batch, Module& module);
+
 		/**
 		 * @brief Invalidate analyses affected by a transform
 		 * @param modified_regions Regions that were modified
@@ -184,5 +272,23 @@ namespace arc
 		 * @param module Module to transform
 		 */
 		void run_transform(TransformPass* transform, Module& module);
+
+		/**
+		 * @brief Verify the IR a transform produced according to `verify_mode`
+		 * @param transform Transform pass that ran
+		 * @param module Module that was transformed
+		 * @param modified_regions Regions the transform reported as modified
+		 */
+		void verify_transform(const TransformPass* transform, Module& module,
+		                      const std::vector<Region*>& modified_regions);
+
+		/**
+		 * @brief Record the regions a transform changed in the module's journal
+		 * @param transform Transform pass that ran
+		 * @param module Module that was transformed
+		 * @param modified_regions Regions the transform reported as modified
+		 */
+		static void journal_transform(const TransformPass* transform, Module& module,
+		                              const std::vector<Region*>& modified_regions);
 	};
 }
@@ -81,6 +81,16 @@ namespace arc
 		 * @return Raw pointer to analysis result
 		 */
 		virtual Analysis *run(const Module &module) = 0;
+
+		/**
+		 * @brief Whether the analysis reads function bodies through `Module::load_body`
+		 * @return true if computing it brings evicted bodies back, in which case the
+		 * pass manager does not evict while its result is cached
+		 */
+		[[nodiscard]] virtual bool loads_bodies() const
+		{
+			return false;
+		}
 		
 	protected:
 		/**
@@ -137,6 +147,15 @@ namespace arc
 		 * @return Vector of regions that were modified by this transform
 		 */
 		virtual std::vector<Region *> run(Module &module, PassManager &pm) = 0;
+
+		/**
+		 * @brief Whether every edit this pass makes is recorded in the module's change journal
+		 * @return false to have the pass manager mark the returned regions as changed wholesale
+		 */
+		[[nodiscard]] virtual bool tracks_changes() const
+		{
+			return false;
+		}
 	};
 
 	/**
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <string_view>
 #include <vector>
@@ -55,6 +57,12 @@ namespace arc
 		 */
 		[[nodiscard]] const Module& module() const;
 
+		/**
+		 * @brief Generation of the last change recorded for this region
+		 * @return Stamp comparable with `Module::checkpoint` epochs; 0 if never changed
+		 */
+		[[nodiscard]] std::uint64_t modified() const;
+
 		/**
 		 * @brief Add a child region
 		 * @param child Child region to add
@@ -169,6 +177,12 @@ namespace arc
 		 */
 		void walk_dominated_regions(const std::function<void(Region*)>& visitor) const;
 
+		/**
+		 * @brief Collect this region and all dominated regions in pre-order
+		 * @return This region followed by every region nested in it, parents before children
+		 */
+		[[nodiscard]] std::vector<Region*> dominated_regions() const;
+
 		/**
 		 * @brief Check if control flow can reach another region
 		 * @param target Region to check reachability to
@@ -189,5 +203,9 @@ namespace arc
 		Module& mod; /** @brief Module that owns this region */
 		Region* prnt; /** @brief The parent region */
 		StringTable::StringId region_id; /** @brief Region id to intern */
+		std::atomic<std::uint64_t> stamp = 0; /** @brief Generation of the last recorded change */
+
+		friend class ColdStore; /* rebuilds the node lists of the bodies it evicts */
+		friend class Module;
 	};
 }
@@ -0,0 +1,139 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <arc/foundation/linker.hpp>
+#include <arc/foundation/module.hpp>
+
+namespace arc
+{
+	class ModuleVariant;
+
+	/**
+	 * @brief Frozen module that any number of variants are forked from
+	 *
+	 * The module is built once and handed to the snapshot, which never changes
+	 * it again. Variants read their functions out of it, so it must outlive
+	 * every variant forked from it. Forking and materializing may happen on
+	 * several threads at once; they take turns reading the snapshot.
+	 *
+	 * @code
+	 * arc::ModuleSnapshot snapshot(build_module());
+	 * for (const Trial &trial : trials)
+	 * {
+	 *     std::unique_ptr<arc::ModuleVariant> variant = snapshot.fork();
+	 *     variant->materialize("hot_loop");
+	 *     run(trial.pipeline, variant->module());
+	 *     score(trial, variant->module());
+	 * }
+	 * @endcode
+	 */
+	class ModuleSnapshot
+	{
+	public:
+		/**
+		 * @param module Module to freeze; nothing else may change it afterwards
+		 * @throws std::invalid_argument if `module` is null
+		 */
+		explicit ModuleSnapshot(std::unique_ptr<Module> module);
+
+		ModuleSnapshot(const ModuleSnapshot &) = delete;
+		ModuleSnapshot &operator=(const ModuleSnapshot &) = delete;
+		ModuleSnapshot(ModuleSnapshot &&) = delete;
+		ModuleSnapshot &operator=(ModuleSnapshot &&) = delete;
+
+		/** @brief The frozen module */
+		[[nodiscard]] const Module &module() const;
+
+		/**
+		 * @brief Start a variant that shares every function with the snapshot
+		 * @param name Name of the variant's module; empty keeps the snapshot's
+		 * @return The variant; it must not outlive the snapshot
+		 */
+		[[nodiscard]] std::unique_ptr<ModuleVariant> fork(std::string_view name = {}) const;
+
+	private:
+		friend class ModuleVariant;
+
+		std::unique_ptr<Module> base;
+		/* the linker reads the base through accessors that are not const, so
+		 * variants copying out of it do so one at a time */
+		mutable std::mutex mutex;
+	};
+
+	/**
+	 * @brief Module forked from a snapshot that copies functions only once they are needed
+	 *
+	 * A fresh variant holds a declaration for every function of the snapshot:
+	 * the FUNCTION node and its parameters, but no body. Globals, read-only data
+	 * and typedefs are copied up front. A function is copied out of the
+	 * snapshot the first time something needs its body: a pass walking into it
+	 * through `Module::open_body`, or an inter-procedural pass such as the
+	 * `Inliner` or the call graph looking into a callee through
+	 * `Module::load_body`. A pipeline run on the variant therefore gives the
+	 * same module as the same pipeline run on the snapshot's module, and a
+	 * variant that is only read costs memory in proportion to the functions
+	 * materialized rather than to the whole module.
+	 *
+	 * Materializing copies a function's body out of the snapshot into its
+	 * declaration, which keeps its identity: calls that already target it now
+	 * call the definition. Calls in the copied body to functions that are still
+	 * shared target their declarations until they are materialized in turn.
+	 */
+	class ModuleVariant
+	{
+	public:
+		/**
+		 * @param snapshot Snapshot to share functions with; must outlive the variant
+		 * @param name Name of the variant's module; empty keeps the snapshot's
+		 */
+		ModuleVariant(const ModuleSnapshot &snapshot, std::string_view name = {});
+
+		ModuleVariant(const ModuleVariant &) = delete;
+		ModuleVariant &operator=(const ModuleVariant &) = delete;
+		ModuleVariant(ModuleVariant &&) = delete;
+		ModuleVariant &operator=(ModuleVariant &&) = delete;
+
+		/** @brief The variant's own module */
+		[[nodiscard]] Module &module();
+
+		/** @brief Whether a function of the variant still shares its body with the snapshot */
+		[[nodiscard]] bool shared(const Node *fn) const;
+
+		/** @brief Number of functions still shared with the snapshot */
+		[[nodiscard]] std::size_t shared_count() const;
+
+		/**
+		 * @brief Copy one function out of the snapshot
+		 * @param name Name of the function
+		 * @return FUNCTION node of the variant; the one it already had
+		 * @throws std::invalid_argument if the variant has no function of that name
+		 */
+		Node *materialize(std::string_view name);
+
+		/**
+		 * @brief Copy the shared functions `predicate` accepts out of the snapshot
+		 * @param predicate Called with each shared FUNCTION node of the variant
+		 * @return Number of functions copied
+		 */
+		std::size_t materialize_if(const std::function<bool(const Node *)> &predicate);
+
+		/**
+		 * @brief Copy every remaining function, making the variant a module of its own
+		 * @return Number of functions copied
+		 */
+		std::size_t materialize_all();
+
+	private:
+		const ModuleSnapshot &origin;
+		std::unique_ptr<Module> mod;
+		Linker linker;
+		std::unordered_map<const Node *, Node *> sources; /* shared declaration -> function of the snapshot */
+	};
+}
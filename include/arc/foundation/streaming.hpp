@@ -0,0 +1,161 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <arc/foundation/module.hpp>
+
+namespace arc
+{
+	class PassManager;
+
+	/**
+	 * @brief Tuning knobs for `StreamingCompiler`
+	 */
+	struct StreamingConfig
+	{
+		/** @brief Worker threads; 0 uses one per hardware thread */
+		std::size_t workers = 0;
+		/** @brief Units submitted but not yet linked before `submit` blocks; 0 uses twice the workers */
+		std::size_t queue_depth = 0;
+		/** @brief Link finished units into the destination; without it they are dropped after the sink */
+		bool retain = true;
+	};
+
+	/**
+	 * @brief Optimizes functions while the front end is still building the rest of the module
+	 *
+	 * The front end builds each function in its own small module obtained from
+	 * `unit`, declaring whatever it calls with `imported()`, and hands it to
+	 * `submit`. Worker threads run the function-local pipeline and the sink on
+	 * every unit as it arrives, then link the units into the destination in
+	 * the order they were submitted, so the result does not depend on
+	 * scheduling. Declarations are resolved by name as their definitions are
+	 * linked; linkage of the functions is left as the front end set it.
+	 *
+	 * `submit` blocks while `queue_depth` units are in flight, which bounds the
+	 * IR held outside the destination: a unit is freed as soon as it is linked,
+	 * so a function exists twice only between its linking and the unit's
+	 * release. With `retain` off, units are dropped once the sink has seen
+	 * them and only the sink's output survives.
+	 *
+	 * @code
+	 * arc::StreamingCompiler compiler(module);
+	 * compiler.function_passes([](arc::PassManager &pm) { pm.add<arc::ConstantFoldingPass>(); })
+	 *         .module_passes([](arc::PassManager &pm) { pm.add<arc::CallGraphAnalysisPass>(); });
+	 * for (const Decl &decl : parser)
+	 * {
+	 *     std::unique_ptr<arc::Module> unit = compiler.unit(decl.name);
+	 *     build(*unit, decl);
+	 *     compiler.submit(std::move(unit));
+	 * }
+	 * compiler.finish();
+	 * @endcode
+	 */
+	class StreamingCompiler
+	{
+	public:
+		/** @brief Adds passes to a fresh `PassManager` */
+		using Configure = std::function<void(PassManager &)>;
+		/** @brief Consumes an optimized unit, e.g. to generate code for it */
+		using Sink = std::function<void(Module &)>;
+
+		/**
+		 * @param dest Module receiving the optimized functions
+		 * @param config Streaming parameters
+		 */
+		explicit StreamingCompiler(Module &dest, StreamingConfig config = {});
+
+		/** @brief Waits for the workers; errors not collected by `finish` are dropped */
+		~StreamingCompiler();
+
+		StreamingCompiler(const StreamingCompiler &) = delete;
+		StreamingCompiler &operator=(const StreamingCompiler &) = delete;
+		StreamingCompiler(StreamingCompiler &&) = delete;
+		StreamingCompiler &operator=(StreamingCompiler &&) = delete;
+
+		/**
+		 * @brief Set the passes run on every unit on a worker thread
+		 * @note must be set before the first `submit`
+		 */
+		StreamingCompiler &function_passes(Configure configure);
+
+		/**
+		 * @brief Set the passes run on the destination once every unit is linked
+		 */
+		StreamingCompiler &module_passes(Configure configure);
+
+		/**
+		 * @brief Set the callback every unit is handed to after its passes ran
+		 * @note must be set before the first `submit`; called on worker threads
+		 */
+		StreamingCompiler &sink(Sink sink);
+
+		/**
+		 * @brief Create an empty module for the front end to build one function in
+		 * @param name Name of the unit, usually the function's
+		 */
+		[[nodiscard]] std::unique_ptr<Module> unit(std::string_view name) const;
+
+		/**
+		 * @brief Queue a finished unit; blocks while `queue_depth` units are in flight
+		 * @param unit Unit built by the front end
+		 * @throws std::logic_error after `finish`
+		 */
+		void submit(std::unique_ptr<Module> unit);
+
+		/**
+		 * @brief Wait for every unit, then run the module passes on the destination
+		 * @throws the first error a unit's passes, sink or linking raised
+		 */
+		void finish();
+
+		/** @brief Units submitted so far */
+		[[nodiscard]] std::size_t submitted() const;
+
+	private:
+		struct Job
+		{
+			std::uint64_t seq;
+			std::unique_ptr<Module> unit;
+		};
+
+		Module &dest;
+		StreamingConfig config;
+		Configure function_config;
+		Configure module_config;
+		Sink unit_sink;
+
+		mutable std::mutex mutex;
+		std::condition_variable work_ready;    /* workers wait for jobs */
+		std::condition_variable slot_free;     /* submitters wait for room */
+		std::deque<Job> queue;
+		std::map<std::uint64_t, std::unique_ptr<Module> > finished; /* optimized, waiting for their turn to link */
+		std::vector<std::thread> workers;
+		std::exception_ptr error;
+		std::uint64_t next_seq = 0;
+		std::uint64_t next_link = 0;
+		std::size_t in_flight = 0;
+		bool closing = false;
+		bool closed = false;
+
+		std::mutex link_mutex;                 /* serializes linking into the destination */
+
+		void start();
+		void stop();
+		void work();
+		void link_ready();
+		void link(Module &unit);
+	};
+}
@@ -0,0 +1,171 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <arc/foundation/node.hpp>
+
+namespace arc
+{
+	class Module;
+	class Region;
+
+	/**
+	 * @brief Journal of IR edits that can be committed or undone
+	 *
+	 * Every edit made through a transaction is applied immediately and logged
+	 * as one or more fixed-size entries recording just enough to invert it:
+	 * an operand slot, a position in a user list or region, or the previous
+	 * value of a field. Rolling back replays the log backwards, so undoing a
+	 * speculative transform costs time proportional to what it changed rather
+	 * than to the size of the function.
+	 *
+	 * Only edits made through the transaction are tracked; a pass mixing
+	 * direct writes to `Node` fields with transactional ones cannot roll back
+	 * correctly. Nodes created by the transaction are freed on rollback, so
+	 * they must not be referenced from outside it afterwards. A transaction
+	 * that is neither committed nor rolled back is rolled back when destroyed.
+	 * Edits and their rollback are recorded in the module's change journal
+	 * like any other mutation.
+	 *
+	 * @code
+	 * arc::Transaction tx;
+	 * const auto result = inliner.inline_call(call, callee, module, nullptr, nullptr, &tx);
+	 * if (cost(module) < before)
+	 *     tx.commit();
+	 * else
+	 *     tx.rollback();
+	 * @endcode
+	 */
+	class Transaction
+	{
+	public:
+		Transaction() = default;
+
+		/** @brief Rolls back whatever was not committed */
+		~Transaction();
+
+		Transaction(const Transaction &) = delete;
+		Transaction &operator=(const Transaction &) = delete;
+		Transaction(Transaction &&) = delete;
+		Transaction &operator=(Transaction &&) = delete;
+
+		/**
+		 * @brief Allocate a node owned by the transaction until it commits
+		 * @param type IR type of the node
+		 * @param kind Data type of the node
+		 * @return Node not placed in any region
+		 */
+		Node *create(NodeType type, DataType kind = DataType::VOID);
+
+		/**
+		 * @brief Allocate a copy of a node's fields, without its edges
+		 * @param node Node to copy
+		 * @return Node not placed in any region
+		 */
+		Node *clone(const Node *node);
+
+		/** @brief Append `node` to `region`, moving it out of its current region */
+		void append(Region *region, Node *node);
+
+		/** @brief Place `node` before `before` in its region */
+		void insert_before(Node *before, Node *node);
+
+		/** @brief Place `node` after `after` in its region */
+		void insert_after(Node *after, Node *node);
+
+		/** @brief Take `node` out of its region; its edges are left alone */
+		void remove(Node *node);
+
+		/**
+		 * @brief Take `node` out of its region and drop it from the users of its inputs
+		 * @note `node` should have no users left
+		 */
+		void erase(Node *node);
+
+		/** @brief Add `input` as the last operand of `user` */
+		void connect(Node *user, Node *input);
+
+		/**
+		 * @brief Replace operand `index` of `user`
+		 * @param user Node whose operand changes
+		 * @param index Operand slot
+		 * @param input New operand; may be nullptr
+		 */
+		void set_input(Node *user, std::size_t index, Node *input);
+
+		/**
+		 * @brief Make every user of `from` use `to` instead
+		 * @return Number of operands rewritten
+		 */
+		std::size_t replace_all_uses(Node *from, Node *to);
+
+		/** @brief Change the value of a node */
+		void set_value(Node *node, TypedData value);
+
+		/** @brief Change the data type of a node */
+		void set_type(Node *node, DataType kind);
+
+		/** @brief Change the traits of a node */
+		void set_traits(Node *node, NodeTraits traits);
+
+		/**
+		 * @brief Position in the log to roll back to later
+		 */
+		[[nodiscard]] std::size_t mark() const;
+
+		/**
+		 * @brief Undo every edit made after `mark`, newest first
+		 * @param mark Value returned by `mark`; 0 undoes everything
+		 */
+		void rollback(std::size_t mark = 0);
+
+		/** @brief Keep every edit and clear the log */
+		void commit();
+
+		/** @brief Number of logged entries */
+		[[nodiscard]] std::size_t size() const;
+
+		/** @brief Whether there is nothing to commit or roll back */
+		[[nodiscard]] bool empty() const;
+
+	private:
+		enum class Op : std::uint8_t
+		{
+			CREATE,       /* node was allocated */
+			PLACE,        /* node moved into a region; a = old region, b = node before it there */
+			UNPLACE,      /* node left its region; a = region, b = node before it there */
+			INPUT_SET,    /* operand slot changed; a = old operand */
+			INPUT_INSERT, /* operand slot added */
+			INPUT_ERASE,  /* operand slot removed; a = old operand */
+			USER_INSERT,  /* user added at index */
+			USER_ERASE,   /* user removed from index; a = old user */
+			VALUE,        /* index = slot in `values` holding the old value */
+			TYPE,         /* index = old data type */
+			TRAITS        /* index = old traits */
+		};
+
+		struct Entry
+		{
+			Node *node;
+			void *a;
+			void *b;
+			std::uint32_t index;
+			Op op;
+		};
+
+		std::vector<Entry> log;
+		std::vector<TypedData> values; /* previous values, referenced by VALUE entries */
+		std::vector<std::pair<Module *, Node *> > departed; /* nodes taken back out of the region they first entered */
+		std::vector<Node *> freed;     /* created nodes whose CREATE was undone, released after the rollback */
+
+		void place(Region *region, Node *node, Node *anchor, bool before);
+		void insert_user(Node *node, Node *user);
+		void erase_user(Node *node, const Node *user);
+		void undo(const Entry &entry);
+		void release();
+	};
+}
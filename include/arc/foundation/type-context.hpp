@@ -0,0 +1,149 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <span>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include <arc/foundation/typed-data.hpp>
+
+namespace arc
+{
+	/**
+	 * @brief Uniqued storage of composite type descriptors
+	 *
+	 * Every distinct STRUCT, ARRAY, FUNCTION and VECTOR type is stored once and
+	 * identified by a small `TypeId`. structs are the only descriptors that own
+	 * out-of-line data; their field lists live here and `TypedData` holding a
+	 * struct only views them, so copying a struct-typed value is a fixed-size
+	 * copy and two structs interned by the same context are the same type
+	 * exactly when their field storage is the same.
+	 *
+	 * Structs are interned by name, alignment and the types of their fields;
+	 * the values a field's data happens to hold are not part of the type, and
+	 * pointer fields compare by what they point to rather than by the node
+	 * that carries it. nested structs are compared by identity, so they must
+	 * be interned before their parent.
+	 *
+	 * The context may be read and extended from several threads at once, as
+	 * passes of a parallel batch do: lookups share it, interning takes it alone.
+	 * Descriptors never move, so references returned by `get` stay valid.
+	 */
+	class TypeContext
+	{
+	public:
+		/** @brief Struct field; name, type and type data */
+		using Field = std::tuple<StringTable::StringId, DataType, TypedData>;
+
+		/**
+		 * @brief Handle of an interned type; 0 is never a valid handle
+		 *
+		 * Nodes carry one in the bytes left over in their cache line, which
+		 * bounds a context to 65535 composite types.
+		 */
+		using TypeId = std::uint16_t;
+
+		static constexpr TypeId invalid = 0;
+
+		TypeContext() = default;
+
+		TypeContext(const TypeContext &) = delete;
+
+		TypeContext &operator=(const TypeContext &) = delete;
+
+		TypeContext(TypeContext &&) = delete;
+
+		TypeContext &operator=(TypeContext &&) = delete;
+
+		/**
+		 * @brief Intern a struct type
+		 * @param name Interned name of the struct
+		 * @param fields Fields in declaration order, padding included
+		 * @param alignment Alignment of the struct
+		 * @return Struct type viewing the canonical field storage
+		 * @throws std::length_error if the struct has more than 255 fields or the context is full
+		 */
+		TypedData struct_t(StringTable::StringId name, std::span<const Field> fields, std::uint32_t alignment);
+
+		/**
+		 * @brief Intern a composite type
+		 * @param type STRUCT, ARRAY, FUNCTION or VECTOR type data
+		 * @return Handle of the canonical descriptor
+		 * @throws std::invalid_argument if `type` is not a composite type
+		 * @throws std::length_error if the context already holds 65535 types
+		 *
+		 * note: the elements of an ARRAY are not part of its type; only the
+		 * element type and count are.
+		 */
+		TypeId intern(const TypedData &type);
+
+		/**
+		 * @brief Find an already interned type
+		 * @param type Type data to look up
+		 * @return Handle of the canonical descriptor or `invalid` if not interned
+		 */
+		[[nodiscard]] TypeId find(const TypedData &type) const;
+
+		/**
+		 * @brief Get the canonical descriptor of a handle
+		 * @param id Handle returned by `intern`
+		 * @return Canonical type data; stable for the lifetime of the context
+		 * @throws std::out_of_range if `id` is not a handle of this context
+		 */
+		[[nodiscard]] const TypedData &get(TypeId id) const;
+
+		/**
+		 * @brief Check if two type descriptors denote the same type
+		 * @return true if both intern to the same handle
+		 */
+		[[nodiscard]] bool same(const TypedData &lhs, const TypedData &rhs) const;
+
+		/**
+		 * @brief Check if struct field storage belongs to this context
+		 * @param fields Storage viewed by a struct type
+		 * @return true if it is the canonical storage of an interned struct
+		 */
+		[[nodiscard]] bool owns(const Field *fields) const;
+
+		/**
+		 * @brief Number of interned types
+		 */
+		[[nodiscard]] std::size_t size() const;
+
+	private:
+		struct Entry
+		{
+			TypedData type;
+			std::vector<Field> fields; /* storage viewed by STRUCT types */
+			std::size_t hash = 0;
+		};
+
+		/* deque keeps entries and thus field storage at stable addresses */
+		std::deque<Entry> entries;
+		std::unordered_multimap<std::size_t, TypeId> by_hash;
+		std::unordered_map<const Field *, TypeId> by_fields;
+		mutable std::shared_mutex mutex;
+
+		/* the unlocked halves of the public members; callers hold `mutex` */
+		Entry &append();
+
+		TypeId intern_struct(StringTable::StringId name, std::span<const Field> fields, std::uint32_t alignment);
+
+		[[nodiscard]] TypeId find_unlocked(const TypedData &type) const;
+
+		[[nodiscard]] TypeId lookup(const TypedData &type, std::size_t hash) const;
+
+		static std::size_t hash_of(const TypedData &type);
+
+		static bool equal(const TypedData &lhs, const TypedData &rhs);
+
+		/* struct fields contribute their type only, not the value they hold */
+		static std::size_t hash_field(const TypedData &field);
+
+		static bool equal_field(const TypedData &lhs, const TypedData &rhs);
+	};
+}
@@ -259,12 +259,20 @@ namespace arc
 	{
 		struct value
 		{
-			/** @brief The fields of the struct */
-			u8slice<std::tuple<StringTable::StringId, DataType, TypedData> > fields;
+			/** @brief The fields of the struct; owned by the `TypeContext` that interned it */
+			u8view<std::tuple<StringTable::StringId, DataType, TypedData> > fields;
 			/** @brief The alignment of the struct */
 			std::uint32_t alignment;
 			/** @brief Interned string id to the struct name */
 			StringTable::StringId name;
+
+			/* structs interned by the same context share their field storage,
+			 * so identity of the storage is identity of the type */
+			bool operator==(const value &other) const
+			{
+				return fields.data() == other.fields.data() && fields.size() == other.fields.size() &&
+				       alignment == other.alignment && name == other.name;
+			}
 		} __attribute__((packed));
 	};
 
@@ -0,0 +1,139 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace arc
+{
+	class Module;
+	class Region;
+	struct Node;
+
+	/**
+	 * @brief How much of the module the pass manager verifies after each transform
+	 */
+	enum class VerifyMode
+	{
+		NONE,     /* never verify */
+		MODIFIED, /* verify the regions a transform reports as modified */
+		FULL      /* verify the whole module */
+	};
+
+	/**
+	 * @brief A single well-formedness violation
+	 */
+	struct Diagnostic
+	{
+		/** @brief Offending node; nullptr for region-level problems */
+		const Node *node = nullptr;
+		/** @brief Region the violation was found in */
+		const Region *region = nullptr;
+		std::string message;
+	};
+
+	/**
+	 * @brief Thrown when verification finds a violation
+	 */
+	class VerificationError : public std::runtime_error
+	{
+	public:
+		VerificationError(const std::string &what, std::vector<Diagnostic> diagnostics);
+
+		[[nodiscard]] const std::vector<Diagnostic> &diagnostics() const;
+
+	private:
+		std::vector<Diagnostic> diags;
+	};
+
+	/**
+	 * @brief Checks the structural invariants of the IR
+	 *
+	 * Every node of a verified region is checked for:
+	 * - input/user symmetry, and inputs that were removed from their region
+	 * - operand and result types of arithmetic, comparison and FROM nodes,
+	 *   following the promotion rules of `infer_binary_t`
+	 * - ENTRY placement; exactly one ENTRY, first in its region, and control
+	 *   flow only targets ENTRY nodes of the same function
+	 * - termination; function regions end in RET, JUMP, BRANCH or INVOKE and
+	 *   have no terminator before their last node
+	 * - FROM arity; at least one input and no more than the region has predecessors
+	 *
+	 * Verification is local to each region, so checking the regions a pass
+	 * modified costs time proportional to their size and not to the module's.
+	 * The index from function bodies to their FUNCTION nodes is built on the
+	 * first call and kept across calls on the same verifier; later calls only
+	 * revisit the regions they are given, unless functions were added or removed.
+	 */
+	class Verifier
+	{
+	public:
+		/**
+		 * @param module Module the verified regions belong to
+		 */
+		explicit Verifier(Module &module);
+
+		/**
+		 * @brief Verify every region of the module
+		 * @return Violations found; empty if the module is well-formed
+		 */
+		[[nodiscard]] std::vector<Diagnostic> verify();
+
+		/**
+		 * @brief Verify only the given regions
+		 * @param regions Regions to check; their children are not visited
+		 * @return Violations found
+		 */
+		[[nodiscard]] std::vector<Diagnostic> verify(const std::vector<Region *> &regions);
+
+		/**
+		 * @brief Verify every region and throw if any is malformed
+		 * @throws VerificationError listing every violation
+		 */
+		void check();
+
+		/**
+		 * @brief Verify the given regions and throw if any is malformed
+		 * @throws VerificationError listing every violation
+		 */
+		void check(const std::vector<Region *> &regions);
+
+	private:
+		Module &mod;
+		std::unordered_map<const Region *, Node *> bodies; /* function body region to FUNCTION node */
+		std::unordered_map<const Region *, std::unordered_map<const Region *, std::unordered_set<const Region *> > > preds;
+		std::vector<Diagnostic> diags;
+		bool indexed = false;
+		std::size_t indexed_functions = 0; /* function count when `bodies` was built */
+		std::size_t indexed_children = 0;  /* root region children when `bodies` was built */
+
+		/**
+		 * @brief Build the body index of the whole module
+		 */
+		void index();
+
+		/**
+		 * @brief Bring the body index up to date before verifying some regions
+		 * @param regions Regions about to be verified; the only ones whose entries are rechecked
+		 */
+		void refresh(const std::vector<Region *> &regions);
+
+		void verify_region(const Region *region);
+
+		void verify_node(const Region *region, const Node *node, const Region *function);
+
+		void verify_types(const Region *region, const Node *node);
+
+		void verify_target(const Region *region, const Node *node, const Node *target, const Region *function);
+
+		[[nodiscard]] const Region *function_of(const Region *region) const;
+
+		const std::unordered_set<const Region *> &predecessors(const Region *function, const Region *region);
+
+		void report(const Region *region, const Node *node, std::string message);
+	};
+}
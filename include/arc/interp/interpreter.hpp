@@ -0,0 +1,275 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <arc/foundation/node.hpp>
+
+/* every bytecode operation of the interpreter. integer operations come in
+ * I32/U32/I64 flavours that differ only in how the result is re-normalized
+ * into its 64-bit slot; 8- and 16-bit integers compute in the 32-bit
+ * flavour followed by one of the SEXT/ZEXT operations */
+#define ARC_INTERP_OPCODES(X) \
+	X(MOV) X(MOVN) X(ADDR) \
+	X(ADD_I32) X(ADD_U32) X(ADD_I64) X(ADD_F32) X(ADD_F64) \
+	X(SUB_I32) X(SUB_U32) X(SUB_I64) X(SUB_F32) X(SUB_F64) \
+	X(MUL_I32) X(MUL_U32) X(MUL_I64) X(MUL_F32) X(MUL_F64) \
+	X(DIV_I32) X(DIV_I64) X(DIV_U64) X(DIV_F32) X(DIV_F64) \
+	X(MOD_I32) X(MOD_I64) X(MOD_U64) X(MOD_F32) X(MOD_F64) \
+	X(AND) X(OR) X(XOR) X(NOT_I32) X(NOT_U32) X(NOT_I64) \
+	X(SHL_I32) X(SHL_U32) X(SHL_I64) X(SHR_I32) X(SHR_U32) X(SHR_I64) X(SHR_U64) \
+	X(EQ_I) X(NE_I) X(EQ_F32) X(NE_F32) X(EQ_F64) X(NE_F64) \
+	X(LT_S) X(LE_S) X(LT_U) X(LE_U) X(LT_F32) X(LE_F32) X(LT_F64) X(LE_F64) \
+	X(SEXT8) X(SEXT16) X(SEXT32) X(ZEXT1) X(ZEXT8) X(ZEXT16) X(ZEXT32) X(NEZ) \
+	X(S2F32) X(S2F64) X(U2F32) X(U2F64) X(F32_S) X(F32_U) X(F64_S) X(F64_U) \
+	X(F32_F64) X(F64_F32) X(NEZ_F32) X(NEZ_F64) \
+	X(SEL) X(SELN) \
+	X(ALLOCA) X(ALLOCA_N) X(LEA) X(ADDI) \
+	X(LD8S) X(LD8U) X(LD16S) X(LD16U) X(LD32S) X(LD32U) X(LD64) X(LDN) \
+	X(ST8) X(ST16) X(ST32) X(ST64) X(STN) \
+	X(ALD8) X(ALD16) X(ALD32) X(ALD64) X(AST8) X(AST16) X(AST32) X(AST64) \
+	X(ACAS8) X(ACAS16) X(ACAS32) X(ACAS64) \
+	X(VBIN) X(VNOT) X(VBUILD) X(VSPLAT) X(VEXT) \
+	X(JMP) X(BR) X(CALL) X(INVOKE) X(RET) X(RETV)
+
+namespace arc
+{
+	class Module;
+	class Region;
+
+	/**
+	 * @brief Contents of one interpreter register slot
+	 *
+	 * Integers are kept sign- or zero-extended to 64 bits according to their
+	 * signedness, booleans as 0 or 1, FLOAT32 as its bit pattern in the low
+	 * half and pointers as their address.
+	 */
+	class Value
+	{
+	public:
+		constexpr Value() = default;
+
+		template<typename T>
+			requires std::is_arithmetic_v<T> || std::is_pointer_v<T>
+		constexpr Value(T value)
+		{
+			if constexpr (std::is_same_v<T, bool>)
+				raw = value ? 1 : 0;
+			else if constexpr (std::is_same_v<T, float>)
+				raw = std::bit_cast<std::uint32_t>(value);
+			else if constexpr (std::is_same_v<T, double>)
+				raw = std::bit_cast<std::uint64_t>(value);
+			else if constexpr (std::is_pointer_v<T>)
+				raw = reinterpret_cast<std::uintptr_t>(value);
+			else if constexpr (std::is_signed_v<T>)
+				raw = static_cast<std::uint64_t>(static_cast<std::int64_t>(value));
+			else
+				raw = static_cast<std::uint64_t>(value);
+		}
+
+		/**
+		 * @brief Reinterpret the slot as a C++ type
+		 * @tparam T Arithmetic or pointer type matching the IR type of the value
+		 * @return The stored value
+		 */
+		template<typename T>
+			requires std::is_arithmetic_v<T> || std::is_pointer_v<T>
+		[[nodiscard]] constexpr T as() const
+		{
+			if constexpr (std::is_same_v<T, bool>)
+				return raw != 0;
+			else if constexpr (std::is_same_v<T, float>)
+				return std::bit_cast<float>(static_cast<std::uint32_t>(raw));
+			else if constexpr (std::is_same_v<T, double>)
+				return std::bit_cast<double>(raw);
+			else if constexpr (std::is_pointer_v<T>)
+				return reinterpret_cast<T>(static_cast<std::uintptr_t>(raw));
+			else
+				return static_cast<T>(raw);
+		}
+
+		/**
+		 * @brief Get the raw slot bits
+		 */
+		[[nodiscard]] constexpr std::uint64_t bits() const
+		{
+			return raw;
+		}
+
+		static constexpr Value from_bits(const std::uint64_t bits)
+		{
+			Value v;
+			v.raw = bits;
+			return v;
+		}
+
+	private:
+		std::uint64_t raw = 0;
+	};
+
+	/**
+	 * @brief Host implementation of an EXTERN function
+	 *
+	 * Exceptions thrown by a host function are reported as a trap, which an
+	 * INVOKE in the calling function turns into a jump to its except target.
+	 */
+	using HostFunction = std::function<Value(std::span<const Value>)>;
+
+	/**
+	 * @brief Threaded-code interpreter for Arc IR
+	 *
+	 * Each function's region graph is compiled once into a linear bytecode in
+	 * which every value producing node owns a fixed range of 64-bit register
+	 * slots. regions are laid out one after another; FROM nodes are resolved
+	 * by parallel copies on the incoming control flow edges, so no node is
+	 * ever looked up at run time. instructions carry the address of their
+	 * handler and are dispatched with computed goto.
+	 *
+	 * Execution draws frames, register slots and ALLOC memory from stacks
+	 * that are sized once at construction; running code never touches the
+	 * heap. runtime errors (division by zero, exhausted stacks, unresolved
+	 * externs) trap: the innermost active INVOKE resumes at its except
+	 * target, and a trap nothing handles is thrown as std::runtime_error.
+	 */
+	class Interpreter
+	{
+	public:
+		/**
+		 * @brief Sizes of the preallocated execution stacks
+		 */
+		struct Config
+		{
+			std::size_t stack_slots = 1 << 16;  /* register slots shared by all frames */
+			std::size_t max_depth = 1 << 12;    /* maximum call depth */
+			std::size_t arena_bytes = 1 << 20;  /* memory for ALLOC nodes */
+		};
+
+		enum class Opcode : std::uint16_t
+		{
+#define ARC_INTERP_ENUM(name) name,
+			ARC_INTERP_OPCODES(ARC_INTERP_ENUM)
+#undef ARC_INTERP_ENUM
+		};
+
+		/**
+		 * @brief One bytecode instruction
+		 *
+		 * Operands are slot indices into the current frame unless noted
+		 * otherwise by the opcode; jump targets are instruction indices.
+		 */
+		struct Instruction
+		{
+			const void *handler = nullptr; /* dispatch target, set once compiled */
+			Opcode op = Opcode::RETV;
+			std::uint16_t n = 0;           /* width, lane count, argc or memory order */
+			std::uint32_t dst = 0;
+			std::uint32_t a = 0;
+			std::uint32_t b = 0;
+			std::uint32_t c = 0;
+		};
+
+		/**
+		 * @brief Compiled form of one function
+		 */
+		struct Function
+		{
+			Node *node = nullptr;
+			std::string name;
+			std::vector<Instruction> code;
+			std::vector<std::uint64_t> frame;                           /* initial slots; holds the constants */
+			std::vector<std::uint32_t> operands;                        /* argument lists of calls and builds */
+			std::vector<std::pair<std::uint32_t, std::uint16_t> > params; /* slot and width of each parameter */
+			HostFunction host;
+			bool external = false;
+		};
+
+		/**
+		 * @brief Compile every function of a module
+		 * @param module Module to execute; must outlive the interpreter
+		 * @param config Execution stack sizes
+		 * @throws std::invalid_argument if the IR cannot be compiled
+		 */
+		explicit Interpreter(Module &module, Config config);
+
+		explicit Interpreter(Module &module);
+
+		~Interpreter();
+
+		Interpreter(const Interpreter &) = delete;
+
+		Interpreter &operator=(const Interpreter &) = delete;
+
+		/**
+		 * @brief Provide the implementation of an EXTERN function
+		 * @param name Function name
+		 * @param fn Host implementation
+		 * @throws std::invalid_argument if the module declares no such function
+		 */
+		void bind(std::string_view name, HostFunction fn);
+
+		/**
+		 * @brief Run a function to completion
+		 * @param name Function name
+		 * @param args Arguments in parameter order
+		 * @return First slot of the returned value; zero for void functions
+		 * @throws std::runtime_error on an unhandled trap
+		 */
+		Value call(std::string_view name, std::span<const Value> args);
+
+		Value call(std::string_view name, std::initializer_list<Value> args = {});
+
+		/**
+		 * @brief Get the compiled form of a function
+		 * @param name Function name
+		 * @return Compiled function or nullptr if the module has none by that name
+		 */
+		[[nodiscard]] const Function *function(std::string_view name) const;
+
+		/**
+		 * @brief Get the memory of a global
+		 * @param node ALLOC node of the root region
+		 * @return Address of the global's storage or nullptr if node is not a global
+		 */
+		[[nodiscard]] void *global(Node *node) const;
+
+	private:
+		struct Frame
+		{
+			const Function *fn = nullptr;
+			const Instruction *ret = nullptr;    /* resume point in the caller */
+			const Instruction *unwind = nullptr; /* except target of the calling INVOKE */
+			std::uint64_t *slots = nullptr;
+			std::size_t arena = 0;               /* arena top when the frame was entered */
+			std::uint32_t dst = 0;               /* caller slot receiving the result */
+		};
+
+		Module &mod;
+		Config cfg;
+		std::vector<std::unique_ptr<Function> > functions;
+		std::unordered_map<std::string, Function *> by_name;
+		std::unordered_map<Node *, Function *> by_node;
+		std::unordered_map<Node *, std::uint64_t> addresses;
+
+		/* globals live for the lifetime of the interpreter, everything else
+		 * is carved out of the stacks below by running code */
+		std::vector<std::uint64_t> globals;
+		std::vector<std::uint64_t> stack;
+		std::vector<Frame> frames;
+		std::vector<std::uint64_t> arena;
+		std::size_t arena_top = 0;
+		std::size_t depth = 0;
+		const void *const *handlers = nullptr;
+
+		std::uint64_t execute(const Function *entry, std::span<const Value> args);
+	};
+}
@@ -3,6 +3,9 @@
 #pragma once
 
 #include <algorithm>
+#include <optional>
+#include <utility>
+#include <vector>
 #include <arc/codegen/instruction.hpp>
 #include <arc/support/slice.hpp>
 
@@ -76,4 +79,86 @@ namespace arc
 	 * @return Integer value, or 0 if not a literal
 	 */
 	std::int64_t extract_literal_value(Node *node);
+
+	/**
+	 * @brief Find the FROM operand that arrives along the edge from a predecessor
+	 * @param from FROM node of the successor
+	 * @param pred Predecessor region of the edge
+	 * @return Operand defined in the predecessor, else one defined in a region
+	 * dominating it, or nullptr if none arrives along the edge
+	 */
+	Node *incoming_value(const Node *from, const Region *pred);
+
+	/**
+	 * @brief Sequence a parallel copy into ordered moves
+	 *
+	 * Emits every copy whose destination is no longer read by another pending
+	 * copy first. the remaining copies form cycles which are broken by saving
+	 * one destination to a scratch location, or with swaps if there is none.
+	 *
+	 * @tparam Copy Copy with `src` and `dst` members; other members are carried along
+	 * @param parallel Copies performed simultaneously
+	 * @param scratch Called with the copy whose destination must be saved; returns a
+	 * location not involved in the copy, or std::nullopt to exchange the pair instead
+	 * @param emit Called with every move in order and whether it exchanges src and dst
+	 */
+	template<typename Copy, typename Scratch, typename Emit>
+	void sequence_copies(std::vector<Copy> parallel, Scratch &&scratch, Emit &&emit)
+	{
+		std::erase_if(parallel, [](const Copy &copy)
+		{
+			return copy.src == copy.dst;
+		});
+
+		while (!parallel.empty())
+		{
+			auto ready = std::ranges::find_if(parallel, [&](const Copy &copy)
+			{
+				return std::ranges::none_of(parallel, [&](const Copy &other)
+				{
+					return other.src == copy.dst;
+				});
+			});
+
+			if (ready != parallel.end())
+			{
+				emit(std::as_const(*ready), false);
+				parallel.erase(ready);
+				continue;
+			}
+
+			/* only cycles are left. saving one destination to the scratch location
+			 * frees it up so the cycle unrolls into a chain on the next iteration */
+			const Copy blocked = parallel.front();
+			if (const auto temp = scratch(blocked))
+			{
+				Copy save = blocked;
+				save.src = blocked.dst;
+				save.dst = *temp;
+				emit(std::as_const(save), false);
+				for (Copy &copy: parallel)
+				{
+					if (copy.src == blocked.dst)
+						copy.src = *temp;
+				}
+				continue;
+			}
+
+			/* without a scratch location the pair is exchanged; afterwards the old
+			 * value of dst lives in src and vice versa */
+			emit(blocked, true);
+			parallel.erase(parallel.begin());
+			for (Copy &copy: parallel)
+			{
+				if (copy.src == blocked.dst)
+					copy.src = blocked.src;
+				else if (copy.src == blocked.src)
+					copy.src = blocked.dst;
+			}
+			std::erase_if(parallel, [](const Copy &copy)
+			{
+				return copy.src == copy.dst;
+			});
+		}
+	}
 }
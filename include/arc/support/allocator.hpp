@@ -30,6 +30,18 @@ namespace ach
 		SHARED        /* thread-safe shared allocation */
 	};
 
+#ifdef ARC_COUNT_POOL_ALLOCATIONS
+	/**
+	 * @brief Observer called with the byte size of every allocation made through `allocator`
+	 *
+	 * Only compiled in with ARC_COUNT_POOL_ALLOCATIONS, which the benchmarks
+	 * build with, and unset by default. Pool and mmap allocations never reach
+	 * the global `operator new`, so tools counting allocations install one
+	 * here; set it before threads start allocating.
+	 */
+	inline std::atomic<void (*)(std::size_t)> allocation_hook = nullptr;
+#endif
+
 	/**
 	 * @brief Memory allocator with pool-based allocation strategy
 	 *
@@ -87,6 +99,10 @@ namespace ach
 				return nullptr;
 
 			const size_type bytes_needed = n * sizeof(T);
+#ifdef ARC_COUNT_POOL_ALLOCATIONS
+			if (const auto hook = allocation_hook.load(std::memory_order_relaxed))
+				hook(bytes_needed);
+#endif
 			void *result = nullptr;
 
 			if (bytes_needed >= LARGE_THRESHOLD)
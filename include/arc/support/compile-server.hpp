@@ -0,0 +1,168 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace arc
+{
+	class PassManager;
+
+	/**
+	 * @brief Outcome of a job sent to a `CompileServer`
+	 */
+	enum class JobStatus : std::uint8_t
+	{
+		OK,            /* output is the optimized module */
+		PARSE_ERROR,   /* output is the parser's message */
+		OUT_OF_MEMORY, /* the job went over its memory limit */
+		FAILED,        /* a pass threw; output is its message */
+		CRASHED,       /* the job's process died; output names the signal */
+		REJECTED       /* the request was malformed or larger than `max_request` */
+	};
+
+	/**
+	 * @brief Reply to a compile request
+	 */
+	struct CompileResult
+	{
+		JobStatus status = JobStatus::OK;
+		/** @brief Module in the textual form of `dump` if the job succeeded, otherwise why it did not */
+		std::string output;
+	};
+
+	/**
+	 * @brief Tuning knobs for `CompileServer`
+	 */
+	struct ServerConfig
+	{
+		/** @brief Path of the Unix domain socket; an existing socket there is replaced */
+		std::string socket_path;
+		/** @brief Jobs running at once; 0 uses one per hardware thread */
+		std::size_t workers = 0;
+		/** @brief Address space a job may allocate beyond what the server holds, in bytes; 0 is unlimited */
+		std::size_t memory_limit = std::size_t { 512 } << 20;
+		/** @brief Largest request accepted, in bytes */
+		std::size_t max_request = std::size_t { 64 } << 20;
+		/** @brief Nodes of the generated module compiled once before serving; 0 skips the warm-up */
+		std::size_t warm_up_nodes = std::size_t { 1 } << 12;
+	};
+
+	/**
+	 * @brief Compiles modules sent over a local socket with a pipeline built once
+	 *
+	 * Clients connect to the socket, send a module in the textual form of
+	 * `dump` and read back the module the pipeline made of it, one job per
+	 * connection. The server builds its `PassManager` and compiles a generated
+	 * module once before accepting jobs, so pass objects, lazily built tables
+	 * and the allocator's pools are already set up when the first job arrives.
+	 *
+	 * Each job is compiled in a process forked from the server. The fork shares
+	 * the warm state copy-on-write, a job over its memory limit fails alone
+	 * instead of taking the server down, and nothing a job leaves behind is
+	 * seen by the next one. A job that dies is answered by the server with
+	 * `CRASHED`.
+	 *
+	 * The allocator's thread-local pools are inherited only from the thread
+	 * that forks, which is why the warm-up runs in `serve` rather than in the
+	 * constructor. Other threads must not be inside Arc while `serve` forks.
+	 *
+	 * Wire format, in host byte order: a request is a u32 length followed by
+	 * the text; a reply is a u8 `JobStatus`, a u32 length and the output.
+	 *
+	 * @code
+	 * arc::CompileServer server({ .socket_path = "/run/arc.sock" });
+	 * server.pipeline([](arc::PassManager &pm)
+	 * {
+	 *     pm.add<arc::ConstantFoldingPass>();
+	 *     pm.add<arc::DeadCodeElimination>();
+	 * });
+	 * server.serve(); // until `stop`
+	 * @endcode
+	 */
+	class CompileServer
+	{
+	public:
+		/** @brief Adds passes to the `PassManager` every job is compiled with */
+		using Configure = std::function<void(PassManager &)>;
+
+		/**
+		 * @brief Bind the socket; clients may connect before `serve` runs
+		 * @param config Server parameters
+		 * @throws std::system_error if the socket cannot be created or bound
+		 */
+		explicit CompileServer(ServerConfig config);
+
+		/** @brief Closes and removes the socket */
+		~CompileServer();
+
+		CompileServer(const CompileServer &) = delete;
+		CompileServer &operator=(const CompileServer &) = delete;
+		CompileServer(CompileServer &&) = delete;
+		CompileServer &operator=(CompileServer &&) = delete;
+
+		/**
+		 * @brief Set the passes jobs are compiled with
+		 * @note must be set before `serve`
+		 */
+		CompileServer &pipeline(Configure configure);
+
+		/**
+		 * @brief Warm up, then accept jobs until `stop` is called
+		 * @throws std::system_error if waiting on the socket fails; a job that cannot be
+		 * started is answered with `FAILED`
+		 */
+		void serve();
+
+		/**
+		 * @brief Make `serve` return once the jobs in progress are finished
+		 * @note async-signal-safe, so it may be called from a signal handler
+		 */
+		void stop();
+
+		/** @brief Jobs accepted so far */
+		[[nodiscard]] std::size_t jobs() const;
+
+	private:
+		ServerConfig config;
+		Configure configure;
+		std::unique_ptr<PassManager> pm;
+		int listener = -1;
+		int wake[2] = { -1, -1 }; /* `stop` writes to wake[1] to interrupt `serve` */
+		std::atomic<std::size_t> accepted = 0;
+
+		void warm_up();
+		[[noreturn]] void run_job(int connection) const;
+		[[nodiscard]] CompileResult compile(std::string_view text) const;
+	};
+
+	/**
+	 * @brief Sends jobs to a `CompileServer`
+	 *
+	 * Every `compile` opens a connection of its own, so one client may be used
+	 * from several threads at once.
+	 */
+	class CompileClient
+	{
+	public:
+		/** @param socket_path Path the server is listening on */
+		explicit CompileClient(std::string socket_path);
+
+		/**
+		 * @brief Compile a module on the server
+		 * @param text Module in the textual form of `dump`
+		 * @return The server's reply
+		 * @throws std::system_error if the server cannot be reached or hangs up without replying
+		 */
+		[[nodiscard]] CompileResult compile(std::string_view text) const;
+
+	private:
+		std::string path;
+	};
+}
@@ -17,6 +17,14 @@ namespace arc
 	 */
 	void dump(Module& module, std::ostream& os = std::cout);
 
+	/**
+	 * @brief Dump IR straight to a file descriptor without going through a stream
+	 * @param module Module to dump
+	 * @param fd Open file descriptor; not closed
+	 * @throws std::system_error if the descriptor cannot be written
+	 */
+	void dump(Module& module, int fd);
+
 	/**
 	 * @brief Dump region to output stream with module context
 	 * @param region Region to dump
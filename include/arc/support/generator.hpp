@@ -0,0 +1,67 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace arc
+{
+	class Module;
+
+	/**
+	 * @brief Relative weights of the kinds of nodes a generated function is made of
+	 */
+	struct NodeMix
+	{
+		/** @brief Integer arithmetic, bitwise operations and comparisons */
+		std::uint32_t arithmetic = 50;
+		/** @brief Loads and stores of stack slots and struct fields */
+		std::uint32_t memory = 25;
+		/** @brief Calls to previously generated functions */
+		std::uint32_t calls = 10;
+		/** @brief Vector splats, builds and extracts */
+		std::uint32_t vectors = 10;
+		/** @brief Atomic loads and stores of stack slots */
+		std::uint32_t atomics = 5;
+	};
+
+	/**
+	 * @brief Shape of a generated module
+	 */
+	struct GeneratorOptions
+	{
+		/** @brief Seed of the generator; the same options always give the same module */
+		std::uint64_t seed = 0x5eed;
+		/** @brief Approximate number of nodes in the module */
+		std::size_t nodes = 1 << 10;
+		/** @brief Number of functions; 0 derives it from `nodes_per_function` */
+		std::size_t functions = 0;
+		/** @brief Approximate number of nodes per function when `functions` is 0 */
+		std::size_t nodes_per_function = 256;
+		/** @brief Maximum nesting of blocks inside a function body */
+		std::uint32_t depth = 2;
+		/** @brief Child blocks of every region that is not at the maximum depth */
+		std::uint32_t fan_out = 3;
+		/** @brief Fraction of innermost blocks that branch back to themselves */
+		double loops = 0.25;
+		/** @brief Operands are picked among this many most recent values in scope */
+		std::uint32_t window = 16;
+		NodeMix mix;
+	};
+
+	/**
+	 * @brief Generate a module of the given shape for scalability benchmarks
+	 *
+	 * Functions are built through `Builder` exactly like hand-written IR. Every
+	 * function takes two i32 parameters and returns an i32; its body is a tree
+	 * of blocks `depth` deep in which each block jumps to the next one and the
+	 * last one returns. Calls only target functions generated earlier, so the
+	 * call graph is acyclic and every function terminates when interpreted.
+	 *
+	 * @param options Shape of the module
+	 * @return The generated module
+	 */
+	std::unique_ptr<Module> generate(const GeneratorOptions &options);
+}
@@ -0,0 +1,113 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace arc
+{
+	/**
+	 * @brief Append-only text buffer made of fixed-size chunks
+	 *
+	 * Appending never moves text that was already written, so the buffer grows
+	 * without the copying a `std::string` does when it reallocates, and whole
+	 * buffers can be spliced together by moving their chunks.
+	 */
+	class OutputBuffer
+	{
+	public:
+		/** @brief Size of a chunk; larger single writes get a chunk of their own */
+		static constexpr std::size_t chunk_size = 64 * 1024;
+
+		OutputBuffer() = default;
+		~OutputBuffer() = default;
+
+		OutputBuffer(const OutputBuffer &) = delete;
+		OutputBuffer &operator=(const OutputBuffer &) = delete;
+		OutputBuffer(OutputBuffer &&) noexcept = default;
+		OutputBuffer &operator=(OutputBuffer &&) noexcept = default;
+
+		OutputBuffer &operator<<(std::string_view str);
+
+		OutputBuffer &operator<<(char c);
+
+		template<std::integral T>
+			requires (!std::same_as<T, char> && !std::same_as<T, bool>)
+		OutputBuffer &operator<<(const T value)
+		{
+			constexpr std::size_t max_digits = 24;
+			char *first = reserve(max_digits);
+			const auto [last, ec] = std::to_chars(first, first + max_digits, value);
+			commit(static_cast<std::size_t>(last - first));
+			return *this;
+		}
+
+		/** @brief Shortest representation that round-trips, as `std::format("{}")` prints it */
+		OutputBuffer &operator<<(float value);
+
+		/** @brief Shortest representation that round-trips, as `std::format("{}")` prints it */
+		OutputBuffer &operator<<(double value);
+
+		/**
+		 * @brief Move the contents of another buffer to the end of this one
+		 * @param other Buffer to splice in; left empty
+		 */
+		void append(OutputBuffer &&other);
+
+		/**
+		 * @return Number of characters written
+		 */
+		[[nodiscard]] std::size_t size() const;
+
+		/**
+		 * @return `true` if nothing has been written
+		 */
+		[[nodiscard]] bool empty() const;
+
+		/**
+		 * @return The contents as a contiguous string
+		 */
+		[[nodiscard]] std::string str() const;
+
+		/**
+		 * @brief Write the contents to a stream
+		 * @param os Stream to write to
+		 */
+		void write(std::ostream &os) const;
+
+		/**
+		 * @brief Write the contents straight to a file descriptor
+		 * @param fd Open file descriptor; not closed
+		 * @throws std::system_error if the descriptor cannot be written
+		 */
+		void write(int fd) const;
+
+		/**
+		 * @brief Discard the contents and release the chunks
+		 */
+		void clear();
+
+	private:
+		struct Chunk
+		{
+			std::unique_ptr<char[]> data;
+			std::size_t used = 0;
+			std::size_t capacity = 0;
+		};
+
+		std::vector<Chunk> chunks;
+		std::size_t total = 0;
+
+		/* space for at least `n` contiguous characters at the end of the last chunk */
+		char *reserve(std::size_t n);
+
+		void commit(std::size_t n);
+	};
+}
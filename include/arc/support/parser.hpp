@@ -0,0 +1,64 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace arc
+{
+	class Module;
+
+	/**
+	 * @brief Thrown when the text is not in the format `dump` prints
+	 */
+	class ParseError : public std::runtime_error
+	{
+	public:
+		ParseError(std::size_t line, std::size_t column, const std::string &message);
+
+		/** @brief 1-based line of the error */
+		[[nodiscard]] std::size_t line() const;
+
+		/** @brief 1-based column of the error */
+		[[nodiscard]] std::size_t column() const;
+
+	private:
+		std::size_t ln;
+		std::size_t col;
+	};
+
+	/**
+	 * @brief Build a module from the text `dump` prints
+	 *
+	 * The text is read once from start to end without backtracking. Values and
+	 * regions may be used before they are defined; uses are connected to the
+	 * definition when it is reached, so loops and forward jumps need no second pass.
+	 *
+	 * `dump` does not print everything a node holds, so the rebuilt module is
+	 * equal to the original as far as the text shows it: printing it again
+	 * gives the same text. In particular
+	 * - literals printed inline (`#42`) take their type from the operation
+	 *   using them; an i32, i64 or f64 literal when that says nothing
+	 * - parameter names are not printed and become `arg<N>`
+	 * - pointees are stand-in nodes of the printed type unless the pointer is
+	 *   the address of an operand
+	 *
+	 * @param text Text to parse; only needs to live for the duration of the call
+	 * @return The rebuilt module
+	 * @throws ParseError naming the line and column of the first error
+	 */
+	std::unique_ptr<Module> parse(std::string_view text);
+
+	/**
+	 * @brief Build a module from a file written by `dump`
+	 * @param path Path of the file; it is memory-mapped rather than read
+	 * @return The rebuilt module
+	 * @throws std::system_error if the file cannot be opened or mapped
+	 * @throws ParseError naming the line and column of the first error
+	 */
+	std::unique_ptr<Module> parse_file(const std::string &path);
+}
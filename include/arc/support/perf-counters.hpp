@@ -0,0 +1,181 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace arc
+{
+	/**
+	 * @brief Hardware events a `PerfCounters` group counts
+	 */
+	enum class PerfEvent : std::uint8_t
+	{
+		CYCLES,        /* core cycles */
+		INSTRUCTIONS,  /* retired instructions */
+		L1D_MISSES,    /* L1 data cache read misses */
+		LLC_MISSES,    /* last level cache misses */
+		BRANCH_MISSES, /* mispredicted branches */
+		COUNT
+	};
+
+	/** @brief Number of events in `PerfEvent` */
+	inline constexpr std::size_t perf_event_count = static_cast<std::size_t>(PerfEvent::COUNT);
+
+	/**
+	 * @brief Event counts of one measured interval
+	 *
+	 * Events the host could not count are absent rather than zero, so a
+	 * missing counter never reads as a perfect miss rate.
+	 */
+	struct PerfSample
+	{
+		std::array<std::uint64_t, perf_event_count> values = {};
+		std::uint32_t present = 0; /* bit per `PerfEvent` that was counted */
+
+		[[nodiscard]] bool has(PerfEvent event) const
+		{
+			return present & 1u << static_cast<std::uint32_t>(event);
+		}
+
+		[[nodiscard]] std::uint64_t operator[](PerfEvent event) const
+		{
+			return values[static_cast<std::size_t>(event)];
+		}
+
+		/**
+		 * @brief Instructions per cycle
+		 * @return IPC, or a negative value if either event is missing
+		 */
+		[[nodiscard]] double ipc() const;
+
+		/**
+		 * @brief Misses per thousand instructions
+		 * @param event One of the miss events
+		 * @return MPKI, or a negative value if the event or the instruction count is missing
+		 */
+		[[nodiscard]] double mpki(PerfEvent event) const;
+
+		/** @brief Accumulate another sample; an event stays present only if both have it */
+		PerfSample &operator+=(const PerfSample &other);
+	};
+
+	/**
+	 * @brief Hardware counters of the calling thread, via `perf_event_open`
+	 *
+	 * Every event is opened on its own, so a host that lacks one of them (a VM
+	 * without an LLC event, say) still counts the rest. When the kernel
+	 * multiplexes counters the counts are scaled by the time each was running.
+	 * On hosts without `perf_event_open`, or where `perf_event_paranoid` forbids
+	 * it, nothing is opened and every sample comes back empty.
+	 */
+	class PerfCounters
+	{
+	public:
+		PerfCounters();
+		~PerfCounters();
+
+		PerfCounters(const PerfCounters &) = delete;
+		PerfCounters &operator=(const PerfCounters &) = delete;
+		PerfCounters(PerfCounters &&) = delete;
+		PerfCounters &operator=(PerfCounters &&) = delete;
+
+		/** @brief Whether at least one event could be opened */
+		[[nodiscard]] bool available() const;
+
+		/** @brief Reset and enable every open counter */
+		void start();
+
+		/**
+		 * @brief Disable the counters and read them
+		 * @return Counts since the last `start()`
+		 */
+		PerfSample stop();
+
+	private:
+		std::array<int, perf_event_count> fds;
+	};
+
+	/**
+	 * @brief Per-name accumulation of hardware counter samples
+	 *
+	 * `PassManager::profile` fills one with a row per pass; codegen phases that
+	 * run outside a pass manager are measured by holding a `scope` around them.
+	 * Recording is thread-safe, so passes of a parallel batch may share a profile.
+	 */
+	class PerfProfile
+	{
+	public:
+		struct Entry
+		{
+			std::string name;
+			std::size_t runs = 0;
+			PerfSample sample;
+		};
+
+		/**
+		 * @brief Counts the calling thread from construction to destruction
+		 */
+		class Scope
+		{
+		public:
+			Scope(PerfProfile &profile, std::string name);
+			~Scope();
+
+			Scope(const Scope &) = delete;
+			Scope &operator=(const Scope &) = delete;
+			Scope(Scope &&) = delete;
+			Scope &operator=(Scope &&) = delete;
+
+		private:
+			PerfProfile &profile;
+			std::string name;
+			PerfCounters counters;
+		};
+
+		/**
+		 * @brief Measure the enclosing block under a name
+		 * @param name Row to accumulate into
+		 * @return Scope that records when it is destroyed
+		 */
+		[[nodiscard]] Scope scope(std::string name)
+		{
+			return { *this, std::move(name) };
+		}
+
+		/**
+		 * @brief Add a sample to the row of a name
+		 * @param name Row to accumulate into; created on first use
+		 * @param sample Counts of one run
+		 */
+		void record(const std::string &name, const PerfSample &sample);
+
+		/** @brief Rows in the order they were first recorded */
+		[[nodiscard]] std::vector<Entry> entries() const;
+
+		/** @brief Whether any recorded sample carries at least one event */
+		[[nodiscard]] bool available() const;
+
+		/**
+		 * @brief Print a table of cycles, instructions, IPC and MPKI per row
+		 * @param os Stream to print to
+		 * @note events that were not counted print as `n/a`
+		 */
+		void print(std::ostream &os) const;
+
+		void clear();
+
+	private:
+		mutable std::mutex mutex;
+		std::vector<Entry> rows;
+		std::unordered_map<std::string, std::size_t> index;
+	};
+}
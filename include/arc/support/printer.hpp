@@ -0,0 +1,101 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <arc/foundation/typed-data.hpp>
+#include <arc/support/output-buffer.hpp>
+#include <arc/support/string-table.hpp>
+
+namespace arc
+{
+	class Module;
+	class Region;
+	struct Node;
+
+	/**
+	 * @brief Value numbers handed out to nodes as they are printed
+	 */
+	struct NodeNumbers
+	{
+		/** @brief Numbers visible to this scope that it must not reuse; the rodata of a module */
+		const NodeNumbers *outer = nullptr;
+		std::unordered_map<const Node *, std::uint32_t> numbers;
+		std::uint32_t next = 1;
+
+		std::uint32_t get(const Node *node);
+	};
+
+	/**
+	 * @brief Memoized type strings such as `ptr<X>` or `arr<i32 x 4>`
+	 */
+	class TypeNames
+	{
+	public:
+		explicit TypeNames(Module &module);
+
+		/** @brief The typedef name of a struct, or `struct <name>` if it has none */
+		std::string_view structure(StringTable::StringId name);
+
+		/** @brief `ptr<T>` for a pointee of the given kind; `name` is the struct name if it is a struct */
+		std::string_view pointer(DataType kind, StringTable::StringId name = StringTable::INVALID_STRING_ID);
+
+		std::string_view array(DataType elem, std::uint32_t count);
+
+		std::string_view vector(DataType elem, std::uint32_t lanes);
+
+	private:
+		Module &mod;
+		std::unordered_map<std::uint64_t, std::string> cache;
+	};
+
+	/**
+	 * @brief Prints IR in the textual form of `dump` into an `OutputBuffer`
+	 *
+	 * Nodes are numbered per function, after the rodata section, so functions
+	 * are independent of each other; with more than one thread every thread
+	 * prints a contiguous run of functions into a buffer of its own, and the
+	 * buffers are then spliced together in module order. The output is the same
+	 * for any number of threads.
+	 */
+	class Printer
+	{
+	public:
+		/** @brief Below this many functions a module is always printed on the calling thread */
+		static constexpr std::size_t min_parallel_functions = 16;
+
+		/**
+		 * @param module Module the printed IR belongs to
+		 * @param threads Maximum number of threads used to print functions
+		 */
+		explicit Printer(Module &module, unsigned threads = 1);
+
+		/**
+		 * @brief Print the whole module
+		 * @param out Buffer to append to
+		 */
+		void print(OutputBuffer &out);
+
+		/**
+		 * @brief Print a region and its children
+		 * @param region Region to print
+		 * @param out Buffer to append to
+		 */
+		void print(Region &region, OutputBuffer &out);
+
+		/**
+		 * @brief Print a single node
+		 * @param node Node to print
+		 * @param out Buffer to append to
+		 */
+		void print(Node &node, OutputBuffer &out);
+
+	private:
+		Module &mod;
+		unsigned workers;
+		TypeNames names;
+		NodeNumbers numbers;
+	};
+}
@@ -609,4 +609,78 @@ namespace arc
 
 	/* u64slice is not defined as it would require 24 bytes of storage,
 	 * which defeats the purpose of using a smaller size type */
+
+	/**
+	 * @brief Non-owning read-only view over contiguous elements with configurable size type.
+	 *
+	 * Counterpart of `slice` for storage owned elsewhere, such as the interned
+	 * types of a `TypeContext`. copying a view never copies the elements.
+	 *
+	 * @tparam T Type of elements viewed.
+	 * @tparam SizeType Size type. Defaults to `std::uint16_t`.
+	 */
+	template<typename T, typename SizeType = std::uint16_t>
+		requires(std::is_unsigned_v<SizeType>)
+	class slice_view
+	{
+	public:
+		using value_type = T;
+		using size_type = SizeType;
+		using difference_type = std::ptrdiff_t;
+		using const_reference = const T&;
+		using const_pointer = const T*;
+		using iterator = const T*;
+		using const_iterator = const T*;
+
+		constexpr slice_view() noexcept : dt(nullptr), sz(0) {}
+
+		constexpr slice_view(const_pointer data, size_type count) noexcept : dt(data), sz(count) {}
+
+		constexpr const_reference operator[](size_type pos) const noexcept
+		{
+			return dt[pos];
+		}
+
+		constexpr const_reference at(size_type pos) const
+		{
+			if (pos >= sz)
+				throw std::out_of_range("slice_view::at");
+			return dt[pos];
+		}
+
+		constexpr const_pointer data() const noexcept
+		{
+			return dt;
+		}
+
+		constexpr const_iterator begin() const noexcept
+		{
+			return dt;
+		}
+
+		constexpr const_iterator end() const noexcept
+		{
+			return dt + sz;
+		}
+
+		[[nodiscard]] constexpr bool empty() const noexcept
+		{
+			return sz == 0;
+		}
+
+		constexpr size_type size() const noexcept
+		{
+			return sz;
+		}
+
+	private:
+		const_pointer dt;
+		size_type sz;
+	} __attribute__((packed));
+
+	template<typename T>
+	using u8view = slice_view<T, std::uint8_t>; /* up to 255 elements; 9 bytes storage */
+
+	template<typename T>
+	using u16view = slice_view<T>; /* up to 65535 elements; 10 bytes storage */
 }
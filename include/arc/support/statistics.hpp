@@ -0,0 +1,158 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace arc
+{
+	/**
+	 * @brief Snapshot of one counter
+	 */
+	struct StatisticValue
+	{
+		std::string group;
+		std::string name;
+		std::string description;
+		std::uint64_t value = 0;
+	};
+
+	/**
+	 * @brief Named event counter that registers itself at static initialization
+	 *
+	 * Counters are meant to be declared in an anonymous namespace through
+	 * `ARC_STATISTIC` and bumped from hot code; an increment is a single relaxed
+	 * atomic add. Declared counters are kept in an intrusive list, so there is
+	 * no allocation and no lock on either path. Every thread adds to the same
+	 * counter, so counting is off unless Arc is configured with
+	 * `ARC_ENABLE_STATISTICS`.
+	 */
+	class Statistic
+	{
+	public:
+		/**
+		 * @param group Group the counter is reported under, usually the pass name
+		 * @param name Name of the counter within its group
+		 * @param description One-line description printed with the value
+		 */
+		Statistic(const char *group, const char *name, const char *description);
+
+		Statistic(const Statistic &) = delete;
+		Statistic &operator=(const Statistic &) = delete;
+		Statistic(Statistic &&) = delete;
+		Statistic &operator=(Statistic &&) = delete;
+
+		Statistic &operator++()
+		{
+			count.fetch_add(1, std::memory_order_relaxed);
+			return *this;
+		}
+
+		Statistic &operator+=(const std::uint64_t n)
+		{
+			count.fetch_add(n, std::memory_order_relaxed);
+			return *this;
+		}
+
+		[[nodiscard]] std::uint64_t value() const
+		{
+			return count.load(std::memory_order_relaxed);
+		}
+
+		[[nodiscard]] const char *group() const
+		{
+			return group_name;
+		}
+
+		[[nodiscard]] const char *name() const
+		{
+			return counter_name;
+		}
+
+		[[nodiscard]] const char *description() const
+		{
+			return desc;
+		}
+
+	private:
+		friend void reset_statistics();
+		friend std::vector<StatisticValue> statistics();
+
+		const char *group_name;
+		const char *counter_name;
+		const char *desc;
+		std::atomic<std::uint64_t> count = 0;
+		Statistic *next = nullptr;
+	};
+
+	/**
+	 * @brief Stand-in for `Statistic` when statistics are compiled out; every operation is a no-op
+	 */
+	class NoopStatistic
+	{
+	public:
+		constexpr NoopStatistic(const char *, const char *, const char *) {}
+
+		constexpr NoopStatistic &operator++()
+		{
+			return *this;
+		}
+
+		constexpr NoopStatistic &operator+=(std::uint64_t)
+		{
+			return *this;
+		}
+
+		[[nodiscard]] constexpr std::uint64_t value() const
+		{
+			return 0;
+		}
+	};
+
+	/** @brief Whether this build counts statistics (`ARC_ENABLE_STATISTICS`) */
+	[[nodiscard]] constexpr bool statistics_enabled()
+	{
+#ifdef ARC_ENABLE_STATISTICS
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/**
+	 * @brief Read every registered counter
+	 * @return Counters sorted by group then name; empty when statistics are compiled out
+	 */
+	[[nodiscard]] std::vector<StatisticValue> statistics();
+
+	/** @brief Set every registered counter back to zero */
+	void reset_statistics();
+
+	/**
+	 * @brief Print the non-zero counters as a table grouped by pass
+	 * @param os Stream to print to
+	 */
+	void print_statistics(std::ostream &os);
+
+	/**
+	 * @brief Print every counter as a JSON object keyed by group, then counter name
+	 * @param os Stream to print to
+	 */
+	void print_statistics_json(std::ostream &os);
+}
+
+/**
+ * @brief Declare a counter in an anonymous namespace
+ * @param var Variable name, also used as the counter name
+ * @param group Group the counter is reported under
+ * @param description One-line description
+ */
+#ifdef ARC_ENABLE_STATISTICS
+#define ARC_STATISTIC(var, group, description) static ::arc::Statistic var(group, #var, description)
+#else
+#define ARC_STATISTIC(var, group, description) [[maybe_unused]] static constinit ::arc::NoopStatistic var(group, #var, description)
+#endif
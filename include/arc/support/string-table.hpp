@@ -46,6 +46,12 @@ namespace arc
 		 */
 		[[nodiscard]] bool contains(std::string_view str) const;
 
+		/**
+		 * @param str String to find
+		 * @return String index or `INVALID_STRING_ID` if `str` was never interned
+		 */
+		[[nodiscard]] StringId find(std::string_view str) const;
+
 		/**
 		 * @return Current size of the table
 		 */
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <queue>
 #include <unordered_set>
 #include <arc/foundation/pass.hpp>
@@ -45,10 +46,21 @@ namespace arc
 		 */
 		std::vector<Region*> run(Module& module, PassManager& pm) override;
 
+		/**
+		 * @brief Folding records its edits, so later runs only revisit what changed
+		 * @return true
+		 */
+		bool tracks_changes() const override
+		{
+			return true;
+		}
+
 	private:
 		std::queue<Node*> worklist;
 		std::unordered_set<Node*> in_worklist;
 		std::unordered_set<Region*> modified_regions;
+		const Module* tracked = nullptr; /* module of the last run */
+		std::uint64_t epoch = 0;         /* checkpoint taken at the end of the last run */
 
 		/**
 		 * @brief Process all regions using worklist algorithm
@@ -63,6 +75,12 @@ namespace arc
 		 */
 		void collect_nodes(Region* region);
 
+		/**
+		 * @brief Seed the worklist with nodes changed since the last run and their users
+		 * @param changes Changes recorded in the module's journal
+		 */
+		void collect_changes(const ChangeSet& changes);
+
 		/**
 		 * @brief Add node to worklist if not already present
 		 * @param node Node to add
@@ -13,6 +13,7 @@ namespace arc
 {
 	class Module;
 	class PassManager;
+	struct ChangeSet;
 	struct Node;
 	class Region;
 
@@ -24,6 +25,12 @@ namespace arc
 	 * Eliminates redundant computations by identifying expressions that compute the same value
 	 * and reusing previously computed results. Uses hash-based value numbering combined with
 	 * type-based alias analysis to safely eliminate redundant memory operations.
+	 *
+	 * Value numbers are built from ordinals and operand values, never from node
+	 * addresses, and every function only sees its own expressions and those of
+	 * the global region. What gets merged therefore depends on neither where
+	 * nodes were allocated nor which other functions share the module, so a
+	 * module split into partitions is optimized the same as a whole one.
 	 */
 	class CommonSubexpressionEliminationPass final : public TransformPass
 	{
@@ -54,10 +61,20 @@ namespace arc
 		 */
 		std::vector<Region *> run(Module &module, PassManager &pm) override;
 
+		/**
+		 * @brief Replacements are recorded, so later runs only renumber functions that changed
+		 * @return true
+		 */
+		[[nodiscard]] bool tracks_changes() const override;
+
 	private:
 		std::unordered_map<Node *, ValueNumber> value_numbers;
-		std::unordered_map<ValueNumber, Node *> expression_to_node;
+		std::unordered_map<ValueNumber, Node *> expression_to_node;  /* expressions of the function being processed */
+		std::unordered_map<ValueNumber, Node *> global_expressions;  /* expressions of the global region, visible everywhere */
+		std::unordered_map<const Node *, ValueNumber> site_numbers;  /* allocation site -> ordinal */
 		ValueNumber next_value_number = 1;
+		const Module *tracked = nullptr; /* module of the last run */
+		std::uint64_t epoch = 0;         /* checkpoint taken at the end of the last run */
 
 		/**
 		 * @brief Process all functions in the module
@@ -67,13 +84,30 @@ namespace arc
 		 */
 		std::size_t process_module(Module &module, const TypeBasedAliasResult &tbaa_result);
 
+		/**
+		 * @brief Find the body region of every function, in module order
+		 * @param module Module to search
+		 * @return Function regions
+		 */
+		static std::vector<Region *> function_regions(Module &module);
+
+		/**
+		 * @brief Find the function regions holding changed nodes
+		 * @param module Module the changes were recorded in
+		 * @param changes Changes recorded in the module's journal
+		 * @param regions Output function regions to renumber, in module order
+		 * @return false if a change outside any function requires a full run
+		 */
+		static bool changed_functions(Module &module, const ChangeSet &changes, std::vector<Region *> &regions);
+
 		/**
 		 * @brief Process a single region using worklist algorithm
 		 * @param region Region to process
 		 * @param tbaa_result TBAA analysis result for alias queries
+		 * @param nested Whether child regions are processed too
 		 * @return Number of expressions eliminated in this region
 		 */
-		std::size_t process_region(Region *region, const TypeBasedAliasResult &tbaa_result);
+		std::size_t process_region(Region *region, const TypeBasedAliasResult &tbaa_result, bool nested = true);
 
 		/**
 		 * @brief Compute value number for a node
@@ -112,6 +146,13 @@ namespace arc
 		 */
 		ValueNumber compute_veclv(Node *node);
 
+		/**
+		 * @brief Ordinal of an allocation site, assigned the first time it is seen
+		 * @param site Allocation site
+		 * @return Value number standing for the site
+		 */
+		ValueNumber site_number(const Node *site);
+
 		/**
 		 * @brief Check if a node represents a memory load operation
 		 * @param node Node to check
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <unordered_set>
 #include <vector>
 #include <arc/foundation/module.hpp>
@@ -41,9 +42,17 @@ namespace arc
 		 */
 		std::vector<Region *> run(Module &module, PassManager &pm) override;
 
+		/**
+		 * @brief Deletions are recorded, so later runs only revisit what changed
+		 * @return true
+		 */
+		[[nodiscard]] bool tracks_changes() const override;
+
 	private:
 		std::unordered_set<Node *> alive_nodes;
 		std::unordered_set<Node *> dead_nodes;
+		const Module *tracked = nullptr; /* module of the last run */
+		std::uint64_t epoch = 0;         /* checkpoint taken at the end of the last run */
 
 		/**
 		 * @brief Find all live nodes starting from root nodes
@@ -51,6 +60,17 @@ namespace arc
 		 */
 		void find_live_nodes(Region *region);
 
+		/**
+		 * @brief Mark the dead nodes of the functions changed since the last run
+		 *
+		 * Marks and sweeps the bodies holding a changed node or operand of one
+		 * like a full run, so dead cycles are found the same way; functions
+		 * nothing changed in are not looked at.
+		 *
+		 * @param changes Changes recorded in the module's journal
+		 */
+		void find_dead_changes(const ChangeSet &changes);
+
 		/**
 		 * @brief Mark nodes not in alive set as dead
 		 * @param region Region to analyze
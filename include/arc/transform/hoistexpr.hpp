@@ -9,8 +9,10 @@
 
 namespace arc
 {
+	class BlockFrequencyResult;
 	class Module;
 	class PassManager;
+	class ProfileResult;
 	struct Node;
 	class Region;
 
@@ -41,6 +43,11 @@ namespace arc
 	 * region and safely relocates them to parent regions that dominate the loop.
 	 * Memory operations are handled conservatively using TBAA to ensure no
 	 * aliasing violations occur during hoisting.
+	 *
+	 * When a profile-analysis result is cached, candidates are ranked by the
+	 * profiled trip count of their loop and loops that never ran are skipped.
+	 * without one, cached block frequencies estimate the trip count instead of
+	 * the loop nesting depth.
 	 */
 	class HoistExpr final : public TransformPass
 	{
@@ -102,5 +109,11 @@ namespace arc
 		 * @return Vector of regions that were modified by hoisting
 		 */
 		std::vector<Region *> hoist_candidates(const std::vector<HoistCandidate> &candidates);
+
+		/** @brief Profile of the current run or nullptr without one */
+		const ProfileResult *profile = nullptr;
+
+		/** @brief Estimated block frequencies of the current run or nullptr without them */
+		const BlockFrequencyResult *frequencies = nullptr;
 	};
 }
@@ -12,6 +12,8 @@ namespace arc
 	class Module;
 	class Region;
 	class CallGraphResult;
+	class ProfileResult;
+	class Transaction;
 
 	/**
 	 * @brief Component for inlining function calls within modules
@@ -76,9 +78,11 @@ namespace arc
 		 * @param call_site Call or invoke node to potentially inline
 		 * @param callee Function being called
 		 * @param cg Call graph analysis for enhanced heuristics (optional)
+		 * @param profile Execution profile to weigh hot and cold call sites (optional)
 		 * @return Decision with reasoning about whether to inline
 		 */
-		Decision evaluate(Node *call_site, Node *callee, const CallGraphResult *cg = nullptr) const;
+		Decision evaluate(Node *call_site, Node *callee, const CallGraphResult *cg = nullptr,
+		                  const ProfileResult *profile = nullptr) const;
 
 		/**
 		 * @brief Perform function inlining at the specified call site
@@ -92,10 +96,14 @@ namespace arc
 		 * @param callee Function to inline
 		 * @param module Module containing both caller and callee
 		 * @param cg Call graph analysis for enhanced heuristics (optional)
+		 * @param profile Execution profile to weigh hot and cold call sites (optional)
+		 * @param tx Transaction to record the edits in, leaving the caller free to
+		 *           roll the inlining back (optional; edits are kept otherwise)
 		 * @return Result indicating success and what was modified
 		 */
 		Result inline_call(Node *call_site, Node *callee, Module &module,
-		                   const CallGraphResult *cg = nullptr) const;
+		                   const CallGraphResult *cg = nullptr, const ProfileResult *profile = nullptr,
+		                   Transaction *tx = nullptr) const;
 
 	private:
 		Config config;
@@ -112,9 +120,11 @@ namespace arc
 		 * @param call_site Call node being analyzed
 		 * @param callee Function being called
 		 * @param cg Call graph analysis for enhanced scoring (optional)
+		 * @param profile Execution profile for call site frequencies (optional)
 		 * @return Benefit score (higher is better)
 		 */
-		static float calc_benefit(Node *call_site, Node *callee, const CallGraphResult *cg);
+		static float calc_benefit(Node *call_site, Node *callee, const CallGraphResult *cg,
+		                          const ProfileResult *profile);
 
 		/**
 		 * @brief Check if a function is suitable for inlining
@@ -126,42 +136,40 @@ namespace arc
 
 		/**
 		 * @brief Clone a function's body for inlining
-		 * @param callee Function whose body to clone
-		 * @param target_module Module to create cloned nodes in
+		 * @param source_region Region holding the callee's body
 		 * @param node_mapping Output mapping from original to cloned nodes
-		 * @return Region containing cloned function body
+		 * @param tx Transaction that owns the clones
+		 * @return Cloned originals in body order, excluding ENTRY, EXIT, PARAM and RET
 		 */
-		static Region *clone_function_body(Node *callee, Module &target_module,
-		                                   std::unordered_map<Node *, Node *> &node_mapping);
-
-		/**
-		 * @brief Clone a single node for inlining
-		 * @param original Node to clone
-		 * @return Cloned node with same properties as original
-		 */
-		static Node *clone_node(Node *original);
+		static std::vector<Node *> clone_function_body(Region *source_region,
+		                                               std::unordered_map<Node *, Node *> &node_mapping,
+		                                               Transaction &tx);
 
 		/**
 		 * @brief Establish connections between cloned nodes
+		 * @param originals Nodes that were cloned
 		 * @param node_mapping Mapping from original to cloned nodes
+		 * @param tx Transaction to record the new edges in
 		 */
-		static void patch_connections(const std::unordered_map<Node *, Node *> &node_mapping);
+		static void patch_connections(const std::vector<Node *> &originals,
+		                              const std::unordered_map<Node *, Node *> &node_mapping, Transaction &tx);
 
 		/**
-		 * @brief Replace function parameters with call arguments
-		 * @param inlined_region Region containing inlined function body
+		 * @brief Map function parameters to call arguments
+		 * @param source_region Region holding the callee's body
 		 * @param call_site Call node providing arguments
-		 * @param node_mapping Mapping from original to cloned nodes
+		 * @param node_mapping Mapping from original to cloned nodes, extended with parameters
 		 */
-		static void substitute_parameters(Region *inlined_region, Node *call_site,
-		                                  const std::unordered_map<Node *, Node *> &node_mapping);
+		static void substitute_parameters(Region *source_region, Node *call_site,
+		                                  std::unordered_map<Node *, Node *> &node_mapping);
 
 		/**
-		 * @brief Find the return value in an inlined function body
-		 * @param inlined_region Region containing inlined code
+		 * @brief Find the value an inlined function body returns
+		 * @param source_region Region holding the callee's body
+		 * @param node_mapping Mapping from original to cloned nodes
 		 * @return Node representing the return value, or nullptr if not found
 		 */
-		static Node *find_return_value(Region *inlined_region);
+		static Node *find_return_value(Region *source_region, const std::unordered_map<Node *, Node *> &node_mapping);
 
 		/**
 		 * @brief Find the region containing a function's implementation
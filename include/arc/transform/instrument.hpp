@@ -0,0 +1,87 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <arc/foundation/node.hpp>
+#include <arc/foundation/pass.hpp>
+
+namespace arc
+{
+	class Module;
+	class PassManager;
+	class Region;
+
+	/**
+	 * @brief Edge profiling instrumentation pass
+	 *
+	 * Adds a global array of UINT64 counters to the root region and increments
+	 * one counter on every function entry and one per outgoing edge of every
+	 * BRANCH node, laid out as described by ProfileLayout. branch edges are
+	 * counted before the branch by selecting the counter with the branch
+	 * condition, so no edge has to be split.
+	 *
+	 * Increments are plain loads and stores; concurrent runs of instrumented
+	 * code may lose counts. after running the instrumented module, read the
+	 * counter array and pass it to Profile::from_counters.
+	 */
+	class EdgeInstrumentation final : public TransformPass
+	{
+	public:
+		/**
+		 * @brief Get the pass name
+		 * @return Pass identifier for dependency resolution
+		 */
+		[[nodiscard]] std::string name() const override;
+
+		/**
+		 * @brief Get analyses invalidated by this pass
+		 * @return Vector of analysis names that become stale after instrumentation
+		 */
+		[[nodiscard]] std::vector<std::string> invalidates() const override;
+
+		/**
+		 * @brief Instrument every function with a body
+		 * @param module Module to instrument; left untouched if already instrumented
+		 * @param pm Pass manager for accessing cached analyses
+		 * @return Vector of regions that were modified
+		 */
+		std::vector<Region *> run(Module &module, PassManager &pm) override;
+
+		/**
+		 * @brief Find the counter array of an instrumented module
+		 * @param module Module to search
+		 * @return ALLOC node of the counters or nullptr if the module is not instrumented
+		 */
+		static Node *counters(Module &module);
+
+	private:
+		/**
+		 * @brief Insert a node into a region
+		 * @param type Node type
+		 * @param result_type Result data type
+		 * @param region Region receiving the node
+		 * @param before Node to insert in front of; appended if nullptr
+		 * @param inputs Input nodes
+		 * @return The inserted node
+		 */
+		static Node *emit(NodeType type, DataType result_type, Region *region, Node *before,
+		                  const std::vector<Node *> &inputs);
+
+		/**
+		 * @brief Insert the increment of one counter
+		 * @param array Counter array
+		 * @param offset UINT64 node holding the byte offset of the counter
+		 * @param region Region receiving the increment
+		 * @param before Node to insert in front of; appended if nullptr
+		 */
+		static void increment(Node *array, Node *offset, Region *region, Node *before);
+
+		/**
+		 * @brief Insert a UINT64 literal
+		 */
+		static Node *constant(std::uint64_t value, Region *region, Node *before);
+	};
+}
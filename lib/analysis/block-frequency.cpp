@@ -0,0 +1,379 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <arc/analysis/block-frequency.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/support/algorithm.hpp>
+#include <arc/support/inference.hpp>
+#include <arc/support/statistics.hpp>
+
+namespace arc
+{
+	namespace
+	{
+		ARC_STATISTIC(functions_estimated, "block-frequency-analysis", "functions given block frequencies");
+		ARC_STATISTIC(functions_profiled, "block-frequency-analysis", "functions weighted by profile data instead of heuristics");
+
+		/* Ball & Larus / Wu & Larus heuristic hit rates */
+		constexpr float loop_branch_taken = 0.88f;
+		constexpr float loop_exit_taken = 0.2f;
+		constexpr float equality_holds = 0.375f;
+		constexpr float negative_holds = 0.16f;
+		constexpr float handler_taken = 1.0f / 16.0f;
+		constexpr float unwind_taken = 1.0f / (1 << 20);
+
+		/* a loop is never assumed to run forever; caps a header at 2^12 trips */
+		constexpr float max_cyclic = 1.0f - 1.0f / (1 << 12);
+
+		struct Edge
+		{
+			Region *from;
+			Region *to;
+			float probability;
+			bool back = false;
+		};
+
+		/* combine two independent predictions of the same event */
+		float combine(const float p, const float q)
+		{
+			const float agree = p * q;
+			const float disagree = (1.0f - p) * (1.0f - q);
+			return agree + disagree > 0.0f ? agree / (agree + disagree) : 0.5f;
+		}
+
+		bool is_null(Node *node)
+		{
+			return node && node->ir_type == NodeType::LIT && extract_literal_value(node) == 0;
+		}
+
+		/* probability of `cond` being true from its opcode alone */
+		std::optional<float> opcode_heuristic(Node *cond)
+		{
+			if (!cond || cond->inputs.size() < 2)
+				return std::nullopt;
+
+			Node *lhs = cond->inputs[0];
+			Node *rhs = cond->inputs[1];
+			const bool pointer = lhs->type_kind == DataType::POINTER || rhs->type_kind == DataType::POINTER;
+			const bool integer = is_integer_t(lhs->type_kind) && is_integer_t(rhs->type_kind);
+
+			switch (cond->ir_type)
+			{
+				/* pointers rarely compare equal and integers rarely hit one
+				 * exact value, which is what null and error code checks test */
+				case NodeType::EQ:
+					return pointer || integer ? std::optional(equality_holds) : std::nullopt;
+				case NodeType::NEQ:
+					return pointer || integer ? std::optional(1.0f - equality_holds) : std::nullopt;
+				/* negative values are usually errors */
+				case NodeType::LT:
+				case NodeType::LTE:
+					return integer && is_null(rhs) ? std::optional(negative_holds) : std::nullopt;
+				case NodeType::GT:
+				case NodeType::GTE:
+					return integer && is_null(lhs) ? std::optional(negative_holds) : std::nullopt;
+				default:
+					return std::nullopt;
+			}
+		}
+	}
+
+	std::optional<float> BlockFrequencyResult::branch_probability(Node *branch) const
+	{
+		if (const auto it = branches.find(branch);
+			it != branches.end())
+			return it->second;
+		return std::nullopt;
+	}
+
+	float BlockFrequencyResult::edge_probability(Region *from, Region *to) const
+	{
+		const auto it = successors.find(from);
+		if (it == successors.end())
+			return 0.0f;
+
+		float total = 0.0f;
+		for (const auto &[target, probability]: it->second)
+		{
+			if (target == to)
+				total += probability;
+		}
+		return total;
+	}
+
+	std::optional<float> BlockFrequencyResult::frequency(Region *region) const
+	{
+		if (const auto it = frequencies.find(region);
+			it != frequencies.end())
+			return it->second;
+		return std::nullopt;
+	}
+
+	bool BlockFrequencyResult::loop_header(Region *region) const
+	{
+		return headers.contains(region);
+	}
+
+	BlockFrequencyAnalysisPass::BlockFrequencyAnalysisPass(std::unordered_map<Node *, BranchWeights> weights) :
+		annotations(std::move(weights)) {}
+
+	BlockFrequencyAnalysisPass::BlockFrequencyAnalysisPass(Profile profile) : data(std::move(profile)) {}
+
+	std::string BlockFrequencyAnalysisPass::name() const
+	{
+		return "block-frequency-analysis";
+	}
+
+	Analysis *BlockFrequencyAnalysisPass::run(const Module &module)
+	{
+		auto *result = allocate_result<BlockFrequencyResult>();
+		std::unordered_map<Node *, BranchWeights> weights = annotations;
+		for (const auto &fn: ProfileLayout::of(module).functions)
+		{
+			/* profile weights apply only if the function kept its shape */
+			const auto it = data.functions.find(std::string(module.strtable().get(fn.node->str_id)));
+			if (it != data.functions.end() && it->second.branches.size() == fn.branches.size())
+			{
+				for (std::size_t i = 0; i < fn.branches.size(); ++i)
+					weights.try_emplace(fn.branches[i], it->second.branches[i]);
+				++functions_profiled;
+			}
+			analyze(result, fn, weights);
+			++functions_estimated;
+		}
+		return result;
+	}
+
+	void BlockFrequencyAnalysisPass::analyze(BlockFrequencyResult *result, const ProfileLayout::Function &fn,
+	                                         const std::unordered_map<Node *, BranchWeights> &weights) const
+	{
+		const std::vector<Region *> regions = fn.body->dominated_regions();
+		const std::unordered_set owned(regions.begin(), regions.end());
+		const auto target = [&](Node *entry) -> Region *
+		{
+			return entry && entry->ir_type == NodeType::ENTRY && owned.contains(entry->parent) ? entry->parent : nullptr;
+		};
+
+		/* exception handlers are the except targets of INVOKE nodes */
+		std::unordered_set<Region *> handlers;
+		for (Region *region: regions)
+		{
+			for (Node *node: region->nodes())
+			{
+				if (node->ir_type == NodeType::INVOKE && node->inputs.size() >= 3)
+				{
+					if (Region *handler = target(node->inputs[2]))
+						handlers.insert(handler);
+				}
+			}
+		}
+
+		/* build the region CFG; branch probabilities are filled in once back
+		 * edges are known since the loop heuristics depend on them */
+		std::vector<Edge> edges;
+		std::unordered_map<Region *, std::vector<std::size_t> > succs;
+		std::unordered_map<Region *, std::vector<std::size_t> > preds;
+		std::vector<std::pair<Node *, std::size_t> > branch_edges; /* branch -> index of its true edge */
+		const auto add_edge = [&](Region *from, Region *to, const float probability)
+		{
+			succs[from].push_back(edges.size());
+			preds[to].push_back(edges.size());
+			edges.push_back({ from, to, probability });
+		};
+
+		for (Region *region: regions)
+		{
+			for (Node *node: region->nodes())
+			{
+				switch (node->ir_type)
+				{
+					case NodeType::JUMP:
+						if (Region *to = node->inputs.empty() ? nullptr : target(node->inputs[0]))
+							add_edge(region, to, 1.0f);
+						break;
+					case NodeType::BRANCH:
+					{
+						Region *on_true = node->inputs.size() >= 3 ? target(node->inputs[1]) : nullptr;
+						Region *on_false = node->inputs.size() >= 3 ? target(node->inputs[2]) : nullptr;
+						if (!on_true || !on_false)
+							break;
+						branch_edges.emplace_back(node, edges.size());
+						add_edge(region, on_true, 0.5f);
+						add_edge(region, on_false, 0.5f);
+						break;
+					}
+					case NodeType::INVOKE:
+					{
+						Region *normal = node->inputs.size() >= 3 ? target(node->inputs[1]) : nullptr;
+						Region *except = node->inputs.size() >= 3 ? target(node->inputs[2]) : nullptr;
+						if (normal)
+							add_edge(region, normal, except ? 1.0f - unwind_taken : 1.0f);
+						if (except)
+							add_edge(region, except, normal ? unwind_taken : 1.0f);
+						break;
+					}
+					default:
+						break;
+				}
+			}
+		}
+
+		/* depth-first search from the body finds back edges and a reverse
+		 * post-order in which every forward edge points forward */
+		std::vector<Region *> rpo;
+		std::unordered_set<Region *> visited;
+		std::unordered_set<Region *> on_stack;
+		const auto dfs = [&](const auto &self, Region *region) -> void
+		{
+			visited.insert(region);
+			on_stack.insert(region);
+			for (const std::size_t e: succs[region])
+			{
+				Region *to = edges[e].to;
+				if (on_stack.contains(to))
+					edges[e].back = true;
+				else if (!visited.contains(to))
+					self(self, to);
+			}
+			on_stack.erase(region);
+			rpo.push_back(region);
+		};
+		dfs(dfs, fn.body);
+		std::ranges::reverse(rpo);
+
+		/* natural loop of every header: the regions reaching one of its back
+		 * edges without passing through the header */
+		std::unordered_map<Region *, std::unordered_set<Region *> > loops;
+		for (const Edge &edge: edges)
+		{
+			if (!edge.back)
+				continue;
+
+			auto &body = loops[edge.to];
+			body.insert(edge.to);
+			std::vector<Region *> worklist;
+			if (body.insert(edge.from).second)
+				worklist.push_back(edge.from);
+			while (!worklist.empty())
+			{
+				Region *region = worklist.back();
+				worklist.pop_back();
+				for (const std::size_t e: preds[region])
+				{
+					if (visited.contains(edges[e].from) && body.insert(edges[e].from).second)
+						worklist.push_back(edges[e].from);
+				}
+			}
+		}
+
+		const auto innermost = [&](Region *region) -> const std::unordered_set<Region *> *
+		{
+			const std::unordered_set<Region *> *best = nullptr;
+			for (const auto &[header, body]: loops)
+			{
+				if (body.contains(region) && (!best || body.size() < best->size()))
+					best = &body;
+			}
+			return best;
+		};
+
+		for (const auto &[branch, first]: branch_edges)
+		{
+			Edge &on_true = edges[first];
+			Edge &on_false = edges[first + 1];
+
+			float probability = 0.5f;
+			if (const auto it = weights.find(branch);
+				it != weights.end() && it->second.taken + it->second.not_taken > 0)
+			{
+				const auto &[taken, not_taken] = it->second;
+				probability = static_cast<float>(static_cast<double>(taken) / static_cast<double>(taken + not_taken));
+			}
+			else
+			{
+				/* loop branch: staying in the loop is likely */
+				if (on_true.back != on_false.back)
+					probability = combine(probability, on_true.back ? loop_branch_taken : 1.0f - loop_branch_taken);
+				else if (const auto *loop = innermost(on_true.from))
+				{
+					/* loop exit: leaving the innermost loop is unlikely */
+					const bool true_exits = !loop->contains(on_true.to);
+					if (true_exits != !loop->contains(on_false.to))
+						probability = combine(probability, true_exits ? loop_exit_taken : 1.0f - loop_exit_taken);
+				}
+
+				if (const auto opcode = opcode_heuristic(branch->inputs[0]))
+					probability = combine(probability, *opcode);
+
+				/* branching into an exception handler means something went wrong */
+				const bool true_handler = handlers.contains(on_true.to);
+				if (true_handler != handlers.contains(on_false.to))
+					probability = combine(probability, true_handler ? handler_taken : 1.0f - handler_taken);
+			}
+
+			on_true.probability = probability;
+			on_false.probability = 1.0f - probability;
+			result->branches[branch] = probability;
+		}
+
+		/* Wu-Larus propagation; inner loops first so the cyclic probability of
+		 * every nested header is known when its enclosing loop is propagated */
+		std::vector<float> edge_frequency(edges.size(), 0.0f);
+		std::vector<float> back_probability(edges.size());
+		for (std::size_t e = 0; e < edges.size(); ++e)
+			back_probability[e] = edges[e].probability;
+
+		std::unordered_map<Region *, float> frequency;
+		const auto propagate = [&](Region *head, const std::unordered_set<Region *> *members)
+		{
+			for (Region *region: rpo)
+			{
+				if (members && !members->contains(region))
+					continue;
+
+				float incoming = region == head ? 1.0f : 0.0f;
+				float cyclic = 0.0f;
+				for (const std::size_t e: preds[region])
+				{
+					if (!visited.contains(edges[e].from) || (members && !members->contains(edges[e].from)))
+						continue;
+					if (edges[e].back)
+						cyclic += back_probability[e];
+					else if (region != head)
+						incoming += edge_frequency[e];
+				}
+
+				/* the header of the loop being propagated stays at 1 so the
+				 * probability of returning to it can be read off its back edges */
+				const float value = members && region == head ? 1.0f : incoming / (1.0f - std::min(cyclic, max_cyclic));
+				frequency[region] = value;
+				for (const std::size_t e: succs[region])
+				{
+					edge_frequency[e] = edges[e].probability * value;
+					if (members && edges[e].to == head && edges[e].back)
+						back_probability[e] = edge_frequency[e];
+				}
+			}
+		};
+
+		std::vector<Region *> order;
+		for (const auto &[header, body]: loops)
+			order.push_back(header);
+		std::ranges::sort(order, [&](Region *a, Region *b)
+		{
+			return loops[a].size() < loops[b].size();
+		});
+		for (Region *header: order)
+		{
+			propagate(header, &loops[header]);
+			result->headers.insert(header);
+		}
+		propagate(fn.body, nullptr);
+
+		for (Region *region: regions)
+			result->frequencies[region] = visited.contains(region) ? frequency[region] : 0.0f;
+		for (const Edge &edge: edges)
+			result->successors[edge.from].emplace_back(edge.to, edge.probability);
+	}
+}
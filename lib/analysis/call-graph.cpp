@@ -4,23 +4,38 @@
 #include <queue>
 #include <stack>
 #include <arc/analysis/call-graph.hpp>
+#include <arc/foundation/cold-store.hpp>
 #include <arc/foundation/module.hpp>
 #include <arc/foundation/region.hpp>
 #include <arc/support/inference.hpp>
+#include <arc/support/statistics.hpp>
 #include <arc/codegen/regalloc.hpp>
 
 namespace arc
 {
+	namespace
+	{
+		ARC_STATISTIC(call_sites, "call-graph-analysis", "call sites resolved to their callers");
+		ARC_STATISTIC(pure_functions_found, "call-graph-analysis", "functions proven free of side effects");
+
+		/* an evicted body is not brought back for the call graph; its store recorded what is needed */
+		const ColdStore *evicted_by(const Module &module, const Node *func)
+		{
+			const ColdStore *cold = module.cold_store();
+			return cold && cold->evicted(func) ? cold : nullptr;
+		}
+	}
+
 	bool CallGraphResult::update(const std::vector<Region *>&)
 	{
 		/* call graph analysis depends on the structure of function calls and parameter
 		 * flow which rarely changes during optimization passes. most transforms like
-		 * CSE, DCE, or SROA don't modify call relationships, so we can usually just
-		 * return true to indicate the cached result is still valid.
+		 * CSE, DCE, or SROA don't modify call relationships and don't name this
+		 * analysis in their invalidates(), so this is never asked on their behalf.
 		 *
-		 * if a pass actually inlines functions or changes call sites, it should
-		 * explicitly invalidate this analysis rather than relying on incremental updates */
-		return true;
+		 * a pass that does name it inlines functions, changes call sites or replaces
+		 * the nodes the graph is keyed by, so there is nothing to patch up incrementally */
+		return false;
 	}
 
 	Node *CallGraphResult::callee(Node *call_site) const
@@ -218,6 +233,9 @@ namespace arc
 		compute_scc(result);
 		analyze_parameter_flow(result, module);
 		compute_function_purity(result, module);
+
+		call_sites += result->call_site_to_function.size();
+		pure_functions_found += result->pure_functions.size();
 	}
 
 	void CallGraphAnalysisPass::classify_functions(CallGraphResult *result, Module &module)
@@ -231,7 +249,9 @@ namespace arc
 			if (func->ir_type != NodeType::FUNCTION)
 				continue;
 
-			if ((func->traits & NodeTraits::EXTERN) != NodeTraits::NONE)
+			/* a body held outside the module is not an external function */
+			module.load_body(func, BodyUse::WALK);
+			if ((func->traits & NodeTraits::EXTERN) != NodeTraits::NONE && !evicted_by(module, func))
 				result->extern_functions.insert(func);
 
 			if ((func->traits & NodeTraits::EXPORT) != NodeTraits::NONE)
@@ -241,6 +261,17 @@ namespace arc
 
 	void CallGraphAnalysisPass::analyze_function(CallGraphResult *result, Node *func, Module &module)
 	{
+		/* without its body there are no call sites, only the functions it refers to */
+		if (const ColdStore *cold = evicted_by(module, func))
+		{
+			for (Node *callee: cold->referenced_functions(func))
+			{
+				result->caller_map[callee].push_back(func);
+				result->callee_map[func].push_back(callee);
+			}
+			return;
+		}
+
 		Region *func_region = find_function_region(func, module);
 		if (!func_region)
 			return;
@@ -498,6 +529,9 @@ namespace arc
 			if (!func_region)
 				continue;
 
+			/* the uses of an evicted function's parameters are gone with its body */
+			const bool evicted = evicted_by(module, func) != nullptr;
+
 			/* parameters are stored in the function's inputs list, not as separate
 			 * nodes in the region. each input represents a parameter in declaration order */
 			for (std::size_t param_idx = 0; param_idx < func->inputs.size(); ++param_idx)
@@ -507,6 +541,13 @@ namespace arc
 					continue;
 
 				ParamInfo info;
+				if (evicted)
+				{
+					info.escapes = true;
+					info.read_only = false;
+					result->param_info[{ func, param_idx }] = std::move(info);
+					continue;
+				}
 				info.escapes = parameter_escapes_analysis(param_node);
 				info.read_only = true;
 
@@ -713,6 +754,13 @@ namespace arc
 		if (cg.extern_functions.contains(func))
 			return false;
 
+		/* the functions an evicted body refers to stand in for its call targets */
+		if (const ColdStore *cold = evicted_by(m, func))
+		{
+			return !cold->writes_memory(func) && std::ranges::all_of(cold->referenced_functions(func),
+				[&](Node *target) { return cg.pure(target); });
+		}
+
 		Region *func_region = find_function_region(func, m);
 		if (!func_region)
 			return false;
@@ -865,17 +913,7 @@ namespace arc
 	{
 		if (!func || func->ir_type != NodeType::FUNCTION)
 			return nullptr;
-
-		/* find the region corresponding to this function by looking for a child
-		 * region of the module root with the same name as the function */
-		std::string_view func_name = module.strtable().get(func->str_id);
-		for (Region *child: module.root()->children())
-		{
-			if (child->name() == func_name)
-				return child;
-		}
-
-		return nullptr;
+		return module.open_body(func);
 	}
 
 	Node *CallGraphAnalysisPass::find_function_for_region(Region *region, Module &module)
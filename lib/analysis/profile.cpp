@@ -0,0 +1,324 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_set>
+#include <arc/analysis/profile.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/region.hpp>
+
+namespace arc
+{
+	namespace
+	{
+		constexpr std::string_view magic = "arc-profile";
+		constexpr int version = 1;
+
+		std::string function_name(const Module &module, const Node *fn)
+		{
+			return std::string(module.strtable().get(fn->str_id));
+		}
+	}
+
+	ProfileLayout ProfileLayout::of(const Module &module)
+	{
+		ProfileLayout layout;
+		const auto bodies = module.bodies();
+		for (Node *fn: module.functions())
+		{
+			if ((fn->traits & NodeTraits::EXTERN) != NodeTraits::NONE)
+				continue;
+
+			const auto body = bodies.find(module.strtable().get(fn->str_id));
+			if (body == bodies.end())
+				continue;
+
+			Function entry = { .node = fn, .body = body->second, .offset = layout.counters };
+			for (Region *region: body->second->dominated_regions())
+			{
+				for (Node *node: region->nodes())
+				{
+					if (node->ir_type == NodeType::BRANCH)
+						entry.branches.push_back(node);
+				}
+			}
+
+			layout.counters += 1 + 2 * static_cast<std::uint32_t>(entry.branches.size());
+			layout.functions.push_back(std::move(entry));
+		}
+		return layout;
+	}
+
+	Profile Profile::from_counters(const Module &module, std::span<const std::uint64_t> counters)
+	{
+		const ProfileLayout layout = ProfileLayout::of(module);
+		if (counters.size() != layout.counters)
+		{
+			throw std::invalid_argument("profile counters do not match the module: expected " +
+			                            std::to_string(layout.counters) + ", got " + std::to_string(counters.size()));
+		}
+
+		Profile profile;
+		for (const auto &fn: layout.functions)
+		{
+			FunctionProfile &entry = profile.functions[function_name(module, fn.node)];
+			entry.entry_count = counters[fn.offset];
+			for (std::size_t i = 0; i < fn.branches.size(); ++i)
+				entry.branches.push_back({ counters[fn.offset + 1 + 2 * i], counters[fn.offset + 2 + 2 * i] });
+		}
+		return profile;
+	}
+
+	Profile Profile::read(std::istream &in)
+	{
+		std::string header;
+		int file_version = 0;
+		if (!(in >> header >> file_version) || header != magic)
+			throw std::runtime_error("not an arc profile");
+		if (file_version != version)
+			throw std::runtime_error("unsupported profile version " + std::to_string(file_version));
+
+		Profile profile;
+		std::string keyword;
+		while (in >> keyword)
+		{
+			if (keyword != "function")
+				throw std::runtime_error("unexpected '" + keyword + "' in profile");
+
+			std::string name;
+			FunctionProfile entry;
+			std::size_t branch_count = 0;
+			if (!(in >> name >> entry.entry_count >> branch_count))
+				throw std::runtime_error("malformed function record in profile");
+
+			entry.branches.resize(branch_count);
+			for (BranchWeights &weights: entry.branches)
+			{
+				if (!(in >> weights.taken >> weights.not_taken))
+					throw std::runtime_error("missing branch weights for '" + name + "' in profile");
+			}
+
+			if (!profile.functions.emplace(std::move(name), std::move(entry)).second)
+				throw std::runtime_error("duplicate function in profile");
+		}
+		return profile;
+	}
+
+	void Profile::write(std::ostream &out) const
+	{
+		/* sorted by name so the same profile always serializes the same way */
+		std::vector<const decltype(functions)::value_type *> sorted;
+		for (const auto &entry: functions)
+			sorted.push_back(&entry);
+		std::ranges::sort(sorted, {}, [](const auto *entry) { return entry->first; });
+
+		out << magic << ' ' << version << '\n';
+		for (const auto *entry: sorted)
+		{
+			const auto &[name, fn] = *entry;
+			out << "function " << name << ' ' << fn.entry_count << ' ' << fn.branches.size() << '\n';
+			for (const BranchWeights &weights: fn.branches)
+				out << weights.taken << ' ' << weights.not_taken << '\n';
+		}
+	}
+
+	void Profile::merge(const Profile &other)
+	{
+		for (const auto &[name, fn]: other.functions)
+		{
+			auto [it, inserted] = functions.try_emplace(name, fn);
+			if (inserted)
+				continue;
+
+			/* a function that changed shape between runs cannot be summed edge by edge */
+			FunctionProfile &mine = it->second;
+			if (mine.branches.size() != fn.branches.size())
+				throw std::invalid_argument("profiles of '" + name + "' have different branch counts");
+
+			mine.entry_count += fn.entry_count;
+			for (std::size_t i = 0; i < fn.branches.size(); ++i)
+			{
+				mine.branches[i].taken += fn.branches[i].taken;
+				mine.branches[i].not_taken += fn.branches[i].not_taken;
+			}
+		}
+	}
+
+	bool ProfileResult::update(const std::vector<Region *> &)
+	{
+		/* counts describe past executions and stay attached to the nodes they
+		 * were collected for; regions created by later transforms simply have
+		 * no count */
+		return true;
+	}
+
+	std::optional<BranchWeights> ProfileResult::branch_weights(Node *branch) const
+	{
+		if (const auto it = branches.find(branch);
+			it != branches.end())
+			return it->second;
+		return std::nullopt;
+	}
+
+	std::optional<std::uint64_t> ProfileResult::entry_count(Node *function) const
+	{
+		if (const auto it = entries.find(function);
+			it != entries.end())
+			return it->second;
+		return std::nullopt;
+	}
+
+	std::optional<std::uint64_t> ProfileResult::count(Region *region) const
+	{
+		if (const auto it = regions.find(region);
+			it != regions.end())
+			return it->second;
+		return std::nullopt;
+	}
+
+	std::optional<std::uint64_t> ProfileResult::call_count(Node *call_site) const
+	{
+		if (!call_site || (call_site->ir_type != NodeType::CALL && call_site->ir_type != NodeType::INVOKE))
+			return std::nullopt;
+		return count(call_site->parent);
+	}
+
+	std::optional<float> ProfileResult::frequency(Region *region) const
+	{
+		const auto executed = count(region);
+		const auto fn = region_function.find(region);
+		if (!executed || fn == region_function.end())
+			return std::nullopt;
+
+		const std::uint64_t calls = entries.at(fn->second);
+		if (calls == 0)
+			return std::nullopt;
+		return static_cast<float>(static_cast<double>(*executed) / static_cast<double>(calls));
+	}
+
+	bool ProfileResult::cold(Region *region) const
+	{
+		const auto executed = count(region);
+		return executed && *executed == 0;
+	}
+
+	bool ProfileResult::empty() const
+	{
+		return entries.empty();
+	}
+
+	ProfileAnalysisPass::ProfileAnalysisPass(Profile profile) : data(std::move(profile)) {}
+
+	std::string ProfileAnalysisPass::name() const
+	{
+		return "profile-analysis";
+	}
+
+	Analysis *ProfileAnalysisPass::run(const Module &module)
+	{
+		auto *result = allocate_result<ProfileResult>();
+		for (const auto &fn: ProfileLayout::of(module).functions)
+		{
+			const auto it = data.functions.find(function_name(module, fn.node));
+			if (it == data.functions.end() || it->second.branches.size() != fn.branches.size())
+				continue;
+
+			result->entries[fn.node] = it->second.entry_count;
+			for (std::size_t i = 0; i < fn.branches.size(); ++i)
+				result->branches[fn.branches[i]] = it->second.branches[i];
+			propagate(result, fn, it->second);
+		}
+		return result;
+	}
+
+	void ProfileAnalysisPass::propagate(ProfileResult *result, const ProfileLayout::Function &fn,
+	                                    const FunctionProfile &profile)
+	{
+		/* incoming edges of every region; a branch edge carries its profiled
+		 * weight while jumps and invoke edges forward the count of their source */
+		struct Edge
+		{
+			Region *from;
+			std::optional<std::uint64_t> weight;
+		};
+
+		const std::vector<Region *> regions = fn.body->dominated_regions();
+		const std::unordered_set owned(regions.begin(), regions.end());
+
+		std::unordered_map<Region *, std::vector<Edge> > incoming;
+		std::size_t branch = 0;
+		const auto edge = [&](Node *target, Region *from, std::optional<std::uint64_t> weight)
+		{
+			if (target && target->ir_type == NodeType::ENTRY && owned.contains(target->parent))
+				incoming[target->parent].push_back({ from, weight });
+		};
+
+		for (Region *region: regions)
+		{
+			for (Node *node: region->nodes())
+			{
+				switch (node->ir_type)
+				{
+					case NodeType::BRANCH:
+					{
+						const BranchWeights &weights = profile.branches[branch++];
+						if (node->inputs.size() >= 3)
+						{
+							edge(node->inputs[1], region, weights.taken);
+							edge(node->inputs[2], region, weights.not_taken);
+						}
+						break;
+					}
+					case NodeType::JUMP:
+						if (!node->inputs.empty())
+							edge(node->inputs[0], region, std::nullopt);
+						break;
+					case NodeType::INVOKE:
+					{
+						/* exceptions are not counted; assume the normal path */
+						bool normal = true;
+						for (Node *input: node->inputs)
+						{
+							if (input && input->ir_type == NodeType::ENTRY)
+							{
+								edge(input, region, normal ? std::nullopt : std::optional<std::uint64_t>(0));
+								normal = false;
+							}
+						}
+						break;
+					}
+					default:
+						break;
+				}
+			}
+		}
+
+		/* a cycle made of jumps alone can only be entered through one of its
+		 * branch edges, so it contributes nothing beyond them */
+		std::unordered_set<Region *> active;
+		const auto solve = [&](const auto &self, Region *region) -> std::uint64_t
+		{
+			if (const auto it = result->regions.find(region);
+				it != result->regions.end())
+				return it->second;
+			if (!active.insert(region).second)
+				return 0;
+
+			std::uint64_t total = region == fn.body ? profile.entry_count : 0;
+			for (const Edge &in: incoming[region])
+				total += in.weight ? *in.weight : self(self, in.from);
+
+			active.erase(region);
+			result->regions[region] = total;
+			return total;
+		};
+
+		for (Region *region: regions)
+		{
+			solve(solve, region);
+			result->region_function[region] = fn.node;
+		}
+	}
+}
@@ -6,9 +6,20 @@
 #include <arc/foundation/node.hpp>
 #include <arc/foundation/region.hpp>
 #include <arc/support/inference.hpp>
+#include <arc/support/statistics.hpp>
 
 namespace arc
 {
+	namespace
+	{
+		ARC_STATISTIC(accesses_tracked, "type-based-alias-analysis", "memory accesses given a location");
+		ARC_STATISTIC(alias_queries, "type-based-alias-analysis", "alias queries answered");
+		ARC_STATISTIC(no_alias_results, "type-based-alias-analysis", "queries answered NO_ALIAS");
+		ARC_STATISTIC(must_alias_results, "type-based-alias-analysis", "queries answered MUST_ALIAS");
+		ARC_STATISTIC(partial_alias_results, "type-based-alias-analysis", "queries answered PARTIAL_ALIAS");
+		ARC_STATISTIC(may_alias_results, "type-based-alias-analysis", "queries answered MAY_ALIAS");
+	}
+
 	static bool types_compatible(DataType type1, DataType type2)
 	{
 		if (type1 == type2)
@@ -71,6 +82,28 @@ namespace arc
 	}
 
 	TBAAResult TypeBasedAliasResult::alias(Node *access1, Node *access2) const
+	{
+		const TBAAResult result = classify(access1, access2);
+		++alias_queries;
+		switch (result)
+		{
+			case TBAAResult::NO_ALIAS:
+				++no_alias_results;
+				break;
+			case TBAAResult::MUST_ALIAS:
+				++must_alias_results;
+				break;
+			case TBAAResult::PARTIAL_ALIAS:
+				++partial_alias_results;
+				break;
+			case TBAAResult::MAY_ALIAS:
+				++may_alias_results;
+				break;
+		}
+		return result;
+	}
+
+	TBAAResult TypeBasedAliasResult::classify(Node *access1, Node *access2) const
 	{
 		if (!access1 || !access2)
 			return TBAAResult::MAY_ALIAS;
@@ -195,22 +228,14 @@ namespace arc
 			if (func->ir_type == NodeType::FUNCTION)
 				analyze_function(result, func, const_cast<Module &>(module));
 		}
+		accesses_tracked += result->memory_accesses().size();
 		return result;
 	}
 
 	void TypeBasedAliasAnalysisPass::analyze_function(TypeBasedAliasResult *result, Node *func, Module &module)
 	{
-		const std::string_view func_name = module.strtable().get(func->str_id);
-
-		/* find the function's region */
-		for (Region *child: module.root()->children())
-		{
-			if (child->name() == func_name)
-			{
-				analyze_region(result, child);
-				break;
-			}
-		}
+		if (Region *body = module.open_body(func))
+			analyze_region(result, body);
 	}
 
 	void TypeBasedAliasAnalysisPass::analyze_region(TypeBasedAliasResult *result, Region *region) // NOLINT(*-no-recursion)
@@ -426,33 +451,16 @@ namespace arc
 								if (container->value.type() != DataType::STRUCT)
 									throw std::runtime_error("struct node missing type information");
 
-								const auto &struct_data = container->value.get<DataType::STRUCT>();
-								std::uint64_t offset_accumulator = 0;
-								std::size_t current_logical_index = 0;
 								auto &m = index_node->parent->module(); /* note: hacky but works */
+								const StructLayout &layout = m.layout().of(container->value.get<DataType::STRUCT>());
 
-								for (const auto &[name_id, field_type, field_data]: struct_data.fields)
-								{
-									std::string field_name(m.strtable().get(name_id));
-									if (field_name.starts_with("__pad"))
-									{
-										/* add to offset but don't increment logical index */
-										offset_accumulator += elem_sz(field_type);
-										continue;
-									}
-
-									if (current_logical_index == logical_field_index)
-									{
-										offset += offset_accumulator;
-										break;
-									}
-
-									offset_accumulator += elem_sz(field_type);
-									current_logical_index++;
-								}
-
-								if (current_logical_index > logical_field_index)
+								/* padding is skipped by the logical index but still counted in offsets */
+								const auto field_offset = logical_field_index >= 0
+									                          ? layout.offset_of(static_cast<std::size_t>(logical_field_index))
+									                          : std::nullopt;
+								if (!field_offset)
 									throw std::runtime_error("struct field index out of bounds");
+								offset += static_cast<std::int64_t>(*field_offset);
 							}
 							else if (container->type_kind == DataType::ARRAY)
 							{
@@ -0,0 +1,450 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <queue>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <arc/codegen/legalize.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/pass-manager.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/support/algorithm.hpp>
+#include <arc/support/inference.hpp>
+#include <arc/support/statistics.hpp>
+
+namespace arc
+{
+	namespace
+	{
+		ARC_STATISTIC(vectors_split, "vector-legalization", "vector values rewritten into legal register widths");
+
+		bool is_elementwise(const NodeType type)
+		{
+			switch (type)
+			{
+				case NodeType::ADD:
+				case NodeType::SUB:
+				case NodeType::MUL:
+				case NodeType::DIV:
+				case NodeType::MOD:
+				case NodeType::BAND:
+				case NodeType::BOR:
+				case NodeType::BXOR:
+				case NodeType::BNOT:
+				case NodeType::BSHL:
+				case NodeType::BSHR:
+					return true;
+				default:
+					return false;
+			}
+		}
+
+		Node *emit(NodeType type, DataType result_type, Node *before, const std::vector<Node *> &inputs)
+		{
+			Node *node = before->parent->module().create_node(type, result_type);
+			for (Node *input: inputs)
+			{
+				node->inputs.push_back(input);
+				input->users.push_back(node);
+			}
+
+			before->parent->insert_before(before, node);
+			return node;
+		}
+
+		void set_vector(Node *node, DataType elem, std::uint32_t lane_count)
+		{
+			DataTraits<DataType::VECTOR>::value vec_data = {};
+			vec_data.elem_type = elem;
+			vec_data.lane_count = lane_count;
+			node->value.set<decltype(vec_data), DataType::VECTOR>(vec_data);
+			node->parent->module().intern_t(node);
+		}
+
+		Node *emit_lane_index(std::uint32_t lane, Node *before)
+		{
+			Node *index = emit(NodeType::LIT, DataType::UINT32, before, {});
+			index->value.set<std::uint32_t, DataType::UINT32>(lane);
+			return index;
+		}
+
+		void detach(Node *node)
+		{
+			for (Node *input: node->inputs)
+			{
+				if (input)
+					erase(input->users, node);
+			}
+			node->inputs.clear();
+
+			if (node->parent)
+			{
+				Module &module = node->parent->module();
+				node->parent->remove(node);
+				module.retire(node);
+			}
+		}
+	}
+
+	bool VectorCapabilities::legal(DataType elem, std::uint32_t lane_count) const
+	{
+		const auto it = lanes.find(elem);
+		return it != lanes.end() && std::ranges::find(it->second, lane_count) != it->second.end();
+	}
+
+	DataType VectorCapabilities::promote(DataType elem) const
+	{
+		if (lanes.contains(elem))
+			return elem;
+
+		const auto it = promotions.find(elem);
+		return it != promotions.end() ? it->second : elem;
+	}
+
+	VectorCapabilities VectorCapabilities::from_widths(const std::vector<std::uint32_t> &register_bytes,
+	                                                   const std::vector<DataType> &elements)
+	{
+		VectorCapabilities caps;
+		for (DataType elem: elements)
+		{
+			const std::uint32_t size = elem_sz(elem);
+			if (size == 0)
+				continue;
+
+			auto &counts = caps.lanes[elem];
+			for (std::uint32_t width: register_bytes)
+			{
+				/* a register holding a single lane is just a scalar register */
+				if (width / size >= 2)
+					counts.push_back(width / size);
+			}
+
+			std::ranges::sort(counts);
+			counts.erase(std::ranges::unique(counts).begin(), counts.end());
+		}
+		return caps;
+	}
+
+	VectorCapabilities VectorCapabilities::of(TargetArch arch)
+	{
+		const std::vector elements = {
+			DataType::INT8, DataType::INT16, DataType::INT32, DataType::INT64,
+			DataType::UINT8, DataType::UINT16, DataType::UINT32, DataType::UINT64,
+			DataType::FLOAT32, DataType::FLOAT64
+		};
+
+		VectorCapabilities caps;
+		switch (arch)
+		{
+			case TargetArch::AARCH64:
+				/* NEON 64-bit d and 128-bit q registers */
+				caps = from_widths({ 8, 16 }, elements);
+				break;
+			case TargetArch::X86_64:
+				/* SSE xmm and AVX2 ymm registers */
+				caps = from_widths({ 16, 32 }, elements);
+				break;
+			case TargetArch::RISCV64:
+				/* V extension with the minimum VLEN of 128 bits */
+				caps = from_widths({ 16 }, elements);
+				break;
+		}
+
+		/* boolean vectors are byte masks on every supported target */
+		caps.promotions[DataType::BOOL] = DataType::UINT8;
+		return caps;
+	}
+
+	VectorLegalizationPass::VectorLegalizationPass(VectorCapabilities capabilities) : caps(std::move(capabilities)) {}
+
+	std::string VectorLegalizationPass::name() const
+	{
+		return "vector-legalization";
+	}
+
+	std::vector<std::string> VectorLegalizationPass::invalidates() const
+	{
+		/* legalized nodes are replaced by new ones, so facts keyed by node go stale */
+		return { "call-graph-analysis", "type-based-alias-analysis" };
+	}
+
+	std::vector<Region *> VectorLegalizationPass::run(Module &module, PassManager &)
+	{
+		legalized.clear();
+		std::vector<Region *> modified_regions;
+		std::vector<Region *> visited;
+
+		/* parents before children so values flowing into nested regions are
+		 * already split when their users are reached */
+		std::queue<Region *> worklist;
+		worklist.push(module.root());
+		while (!worklist.empty())
+		{
+			Region *current = worklist.front();
+			worklist.pop();
+
+			visited.push_back(current);
+			if (process_region(current))
+				modified_regions.push_back(current);
+
+			for (Region *child: current->children())
+				worklist.push(child);
+		}
+
+		/* originals can only be dropped once users in every region were rewritten */
+		for (auto it = visited.rbegin(); it != visited.rend(); ++it)
+			remove_dead(*it);
+
+		/* an illegal vector left behind would reach SelectionDAG, which cannot select it */
+		for (Region *region: visited)
+		{
+			for (const Node *node: region->nodes())
+			{
+				if (needs_legalization(node))
+				{
+					throw std::runtime_error("cannot legalize " +
+						std::to_string(node->value.get<DataType::VECTOR>().lane_count) + "-lane vector in '" +
+						std::string(region->name()) + "': its producer or one of its users has no part-wise form");
+				}
+			}
+		}
+
+		vectors_split += legalized.size();
+		return modified_regions;
+	}
+
+	bool VectorLegalizationPass::needs_legalization(const Node *node) const
+	{
+		if (node->type_kind != DataType::VECTOR || node->value.type() != DataType::VECTOR)
+			return false;
+
+		const auto &vec = node->value.get<DataType::VECTOR>();
+		const DataType elem = caps.promote(vec.elem_type);
+		return elem != vec.elem_type || !caps.legal(elem, vec.lane_count);
+	}
+
+	std::vector<VectorLegalizationPass::Part> VectorLegalizationPass::layout(DataType elem, std::uint32_t lane_count) const
+	{
+		std::vector<std::uint32_t> widths;
+		if (const auto it = caps.lanes.find(elem);
+			it != caps.lanes.end())
+		{
+			widths = it->second;
+		}
+		std::ranges::sort(widths, std::greater {});
+
+		std::vector<Part> parts;
+		std::uint32_t offset = 0;
+		while (offset < lane_count)
+		{
+			const std::uint32_t remaining = lane_count - offset;
+
+			/* split off the widest register that is filled completely */
+			if (const auto fit = std::ranges::find_if(widths, [&](std::uint32_t w) { return w <= remaining; });
+				fit != widths.end())
+			{
+				parts.push_back({ .offset = offset, .lanes = *fit, .width = *fit });
+				offset += *fit;
+				continue;
+			}
+
+			/* a single leftover lane or an element type without vector support
+			 * is cheaper in scalar registers than in a mostly empty vector */
+			if (remaining == 1 || widths.empty())
+			{
+				for (; offset < lane_count; ++offset)
+					parts.push_back({ .offset = offset, .lanes = 1, .width = 1 });
+				break;
+			}
+
+			/* widen the remainder to the narrowest register that holds it */
+			parts.push_back({ .offset = offset, .lanes = remaining, .width = widths.back() });
+			offset = lane_count;
+		}
+
+		return parts;
+	}
+
+	bool VectorLegalizationPass::process_region(Region *region)
+	{
+		bool modified = false;
+
+		/* copy since new parts are inserted while iterating */
+		for (auto nodes = region->nodes();
+		     Node *node: nodes)
+		{
+			if (node->ir_type == NodeType::VECTOR_EXTRACT)
+				modified |= legalize_extract(node);
+			else if (node->type_kind == DataType::VECTOR)
+				modified |= legalize_vector(node);
+		}
+
+		return modified;
+	}
+
+	bool VectorLegalizationPass::legalize_vector(Node *node)
+	{
+		if (!needs_legalization(node))
+			return false;
+
+		const auto vec = node->value.get<DataType::VECTOR>();
+		const DataType elem = caps.promote(vec.elem_type);
+
+		std::vector<Part> parts = layout(elem, vec.lane_count);
+		auto make_part = [&](NodeType type, const Part &part, const std::vector<Node *> &inputs)
+		{
+			if (part.width == 1)
+				return emit(type, elem, node, inputs);
+
+			Node *n = emit(type, DataType::VECTOR, node, inputs);
+			set_vector(n, elem, part.width);
+			return n;
+		};
+
+		auto promote_scalar = [&](Node *scalar)
+		{
+			return scalar->type_kind == elem ? scalar : emit(NodeType::CAST, elem, node, { scalar });
+		};
+
+		switch (node->ir_type)
+		{
+			case NodeType::VECTOR_BUILD:
+			{
+				std::vector<Node *> elements;
+				for (Node *input: node->inputs)
+					elements.push_back(promote_scalar(input));
+
+				for (Part &part: parts)
+				{
+					if (part.width == 1)
+					{
+						part.node = elements[part.offset];
+						continue;
+					}
+
+					/* pad widened parts with the last lane rather than zero so
+					 * padding lanes can never trap in a division */
+					std::vector lanes(elements.begin() + part.offset, elements.begin() + part.offset + part.lanes);
+					lanes.resize(part.width, lanes.back());
+					part.node = make_part(NodeType::VECTOR_BUILD, part, lanes);
+				}
+				break;
+			}
+			case NodeType::VECTOR_SPLAT:
+			{
+				if (node->inputs.empty())
+					return false;
+
+				Node *scalar = promote_scalar(node->inputs[0]);
+				for (Part &part: parts)
+					part.node = part.width == 1 ? scalar : make_part(NodeType::VECTOR_SPLAT, part, { scalar });
+				break;
+			}
+			default:
+			{
+				if (!is_elementwise(node->ir_type))
+					return false;
+
+				/* operands share the type of the result and therefore its layout;
+				 * a vector that could not be split keeps the whole node as is */
+				std::vector<const std::vector<Part> *> operands;
+				for (Node *input: node->inputs)
+				{
+					const auto it = legalized.find(input);
+					if (it == legalized.end() || it->second.size() != parts.size())
+						return false;
+					operands.push_back(&it->second);
+				}
+
+				for (std::size_t i = 0; i < parts.size(); ++i)
+				{
+					std::vector<Node *> inputs;
+					for (const auto *operand: operands)
+						inputs.push_back((*operand)[i].node);
+					parts[i].node = make_part(node->ir_type, parts[i], inputs);
+				}
+				break;
+			}
+		}
+
+		legalized[node] = std::move(parts);
+		return true;
+	}
+
+	bool VectorLegalizationPass::legalize_extract(Node *extract)
+	{
+		if (extract->inputs.size() < 2)
+			return false;
+
+		const auto it = legalized.find(extract->inputs[0]);
+		if (it == legalized.end())
+			return false;
+
+		Node *index = extract->inputs[1];
+		Node *replacement = nullptr;
+		if (index->ir_type == NodeType::LIT)
+		{
+			const auto lane = static_cast<std::uint32_t>(extract_literal_value(index));
+			const auto part = std::ranges::find_if(it->second, [&](const Part &p)
+			{
+				return lane >= p.offset && lane < p.offset + p.lanes;
+			});
+			if (part == it->second.end())
+				return false;
+
+			replacement = lane_of(*part, lane, extract);
+		}
+		else
+		{
+			/* a lane picked at run time is scalarized: every lane is read and the
+			 * one matching the index is selected */
+			if (index->type_kind != DataType::UINT32)
+				index = emit(NodeType::CAST, DataType::UINT32, extract, { index });
+
+			for (const Part &part: it->second)
+			{
+				for (std::uint32_t lane = part.offset; lane < part.offset + part.lanes; ++lane)
+				{
+					Node *value = lane_of(part, lane, extract);
+					if (!replacement)
+					{
+						replacement = value;
+						continue;
+					}
+
+					Node *match = emit(NodeType::EQ, DataType::BOOL, extract, { index, emit_lane_index(lane, extract) });
+					replacement = emit(NodeType::SELECT, value->type_kind, extract, { match, value, replacement });
+				}
+			}
+		}
+
+		/* promoted lanes are narrowed back to the type users expect */
+		if (replacement->type_kind != extract->type_kind)
+			replacement = emit(NodeType::CAST, extract->type_kind, extract, { replacement });
+
+		update_all_connections(extract, replacement);
+		detach(extract);
+		return true;
+	}
+
+	Node *VectorLegalizationPass::lane_of(const Part &part, std::uint32_t lane, Node *before)
+	{
+		if (part.width == 1)
+			return part.node;
+
+		const DataType elem = part.node->value.get<DataType::VECTOR>().elem_type;
+		return emit(NodeType::VECTOR_EXTRACT, elem, before, { part.node, emit_lane_index(lane - part.offset, before) });
+	}
+
+	void VectorLegalizationPass::remove_dead(Region *region)
+	{
+		/* walk backwards so chains of legalized nodes fall away in one sweep */
+		for (auto nodes = region->nodes();
+		     Node *node: nodes | std::views::reverse)
+		{
+			if (legalized.contains(node) && node->users.empty())
+				detach(node);
+		}
+	}
+}
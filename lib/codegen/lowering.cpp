@@ -7,11 +7,14 @@
 #include <arc/foundation/region.hpp>
 #include <arc/support/algorithm.hpp>
 #include <arc/support/inference.hpp>
+#include <arc/support/statistics.hpp>
 
 namespace arc
 {
 	namespace
 	{
+		ARC_STATISTIC(nodes_lowered, "ir-lowering", "aggregate accesses lowered to address arithmetic");
+
 		bool needs_lowering(const Node* node)
 		{
 			if (!node)
@@ -34,31 +37,12 @@ namespace arc
 			if (struct_node->value.type() != DataType::STRUCT)
 				return 0;
 
-			const auto& struct_data = struct_node->value.get<DataType::STRUCT>();
-			std::uint64_t offset = 0;
-			std::uint64_t actual_field_count = 0;
-
-			for (const auto& [name_id, field_type, field_data] : struct_data.fields)
-			{
-				if (struct_node->parent)
-				{
-					Module& mod = struct_node->parent->module();
-					std::string field_name(mod.strtable().get(name_id));
-					if (field_name.starts_with("__pad"))
-					{
-						offset += elem_sz(field_type);
-						continue;
-					}
-				}
-
-				if (actual_field_count == field_index)
-					return offset;
-
-				offset += elem_sz(field_type);
-				actual_field_count++;
-			}
+			if (!struct_node->parent)
+				return 0;
 
-			return offset;
+			/* the index is logical; padding fields are not counted */
+			const StructLayout& layout = struct_node->parent->module().layout().of(struct_node->value.get<DataType::STRUCT>());
+			return layout.offset_of(field_index).value_or(layout.size);
 		}
 
 		Node* create_addr_of_node(Node* container, Region* parent_region, Node* insert_before)
@@ -98,7 +82,10 @@ namespace arc
 			offset_node->users.push_back(ptr_add);
 
 			if (base_addr->value.type() == DataType::POINTER)
+			{
 				ptr_add->value = base_addr->value;
+				ptr_add->type_id = base_addr->type_id;
+			}
 
 			/* we don't insert it here; the caller will do that via `Region::replace` */
 			return ptr_add;
@@ -143,6 +130,7 @@ namespace arc
 		if (const std::size_t lowered_count = process_module(module);
 			lowered_count > 0)
 		{
+			nodes_lowered += lowered_count;
 			std::queue<Region*> region_worklist;
 			region_worklist.push(module.root());
 
@@ -178,20 +166,10 @@ namespace arc
 
 		total_lowered += process_region(module.root());
 
-		for (const Node* func_node : module.functions())
+		for (Node* func_node : module.functions())
 		{
-			if (func_node->ir_type != NodeType::FUNCTION)
-				continue;
-
-			const std::string_view func_name = module.strtable().get(func_node->str_id);
-			for (Region* child : module.root()->children())
-			{
-				if (child->name() == func_name)
-				{
-					total_lowered += process_region(child);
-					break;
-				}
-			}
+			if (func_node->ir_type == NodeType::FUNCTION)
+				total_lowered += process_region(module.open_body(func_node));
 		}
 
 		return total_lowered;
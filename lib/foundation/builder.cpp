@@ -4,7 +4,6 @@
 #include <arc/foundation/builder.hpp>
 #include <arc/foundation/module.hpp>
 #include <arc/foundation/region.hpp>
-#include <arc/support/allocator.hpp>
 #include <arc/support/inference.hpp>
 
 namespace arc
@@ -25,6 +24,7 @@ namespace arc
 	{
 		Node *node = create_node(NodeType::ALLOC, type_def.type());
 		node->value = type_def;
+		module.intern_t(node);
 		return node;
 	}
 
@@ -81,6 +81,7 @@ namespace arc
 			if (type_source->value.type() != DataType::VOID)
 			{
 				node->value = type_source->value;
+				module.intern_t(node);
 			}
 		}
 
@@ -122,6 +123,7 @@ namespace arc
 				 pointer->type_kind == DataType::ARRAY || pointer->type_kind == DataType::VECTOR))
 			{
 				node->value = pointer->value;
+				module.intern_t(node);
 			}
 
 			connect_inputs(node, { pointer });
@@ -218,7 +220,10 @@ namespace arc
 
 		Node *node = create_node(op, result_type);
 		if (result_type == DataType::VECTOR && lhs->value.type() == DataType::VECTOR)
+		{
 			node->value = lhs->value;
+			module.intern_t(node);
+		}
 		connect_inputs(node, { lhs, rhs });
 		return node;
 	}
@@ -362,6 +367,7 @@ namespace arc
 		     return_type == DataType::ARRAY || return_type == DataType::VECTOR))
 		{
 			node->value = *return_type_data;
+			module.intern_t(node);
 		}
 
 		std::vector<Node *> inputs = { function };
@@ -423,7 +429,10 @@ namespace arc
 
 		Node *node = create_node(NodeType::INVOKE, return_type);
 		if (return_type != DataType::VOID && fn_data.return_type)
+		{
 			node->value = *fn_data.return_type;
+			module.intern_t(node);
+		}
 
 		std::vector inputs = { function, normal_target, except_target };
 		inputs.insert(inputs.end(), args.begin(), args.end());
@@ -465,6 +474,7 @@ namespace arc
 		vec_data.elem_type = elem_type;
 		vec_data.lane_count = static_cast<std::uint32_t>(elements.size());
 		node->value.set<decltype(vec_data), DataType::VECTOR>(vec_data);
+		module.intern_t(node);
 
 		connect_inputs(node, elements);
 		return node;
@@ -483,6 +493,7 @@ namespace arc
 		vec_data.elem_type = scalar->type_kind;
 		vec_data.lane_count = lane_count;
 		node->value.set<decltype(vec_data), DataType::VECTOR>(vec_data);
+		module.intern_t(node);
 
 		connect_inputs(node, { scalar });
 		return node;
@@ -530,6 +541,7 @@ namespace arc
 					{
 						/* then update the ACCESS node with proper type info for future operations */
 						struct_obj->value = it->second;
+						module.intern_t(struct_obj);
 						struct_data = &struct_obj->value.get<DataType::STRUCT>();
 					}
 					else
@@ -580,34 +592,19 @@ namespace arc
 			throw std::invalid_argument("struct_field requires struct type, pointer-to-struct, or struct ACCESS node");
 		}
 
-		/* find the field in the struct definition */
-		DataType field_type = DataType::VOID;
-		std::size_t field_index = 0;
-		TypedData field_type_data = {};
-		bool found_field = false;
-
-		for (std::uint8_t i = 0; i < struct_data->fields.size(); ++i)
-		{
-			const auto &[name_id, ftype, fdata] = struct_data->fields[i];
-			std::string_view current_field_name = module.strtable().get(name_id);
-
-			/* skip compiler-generated padding fields */
-			if (current_field_name.starts_with("__pad"))
-				continue;
-
-			if (current_field_name == field_name)
-			{
-				field_type = ftype;
-				field_index = i; /* use actual index including padding for offset calculation */
-				field_type_data = fdata;
-				found_field = true;
-				break;
-			}
-		}
-
+		/* find the field in the struct definition; padding fields are never named
+		 * by the user so the layout's name map only holds real fields */
+		const StringTable::StringId name_id = module.strtable().find(field_name);
+		const auto found_field = name_id != StringTable::INVALID_STRING_ID
+			                         ? module.layout().of(*struct_data).index_of(name_id)
+			                         : std::nullopt;
 		if (!found_field)
 			throw std::invalid_argument("field not found: " + field_name);
 
+		/* use actual index including padding for offset calculation */
+		const std::size_t field_index = *found_field;
+		const auto &[field_name_id, field_type, field_type_data] = struct_data->fields[field_index];
+
 		Node *field_index_node = lit(static_cast<std::uint32_t>(field_index));
 		Node *node = create_node(NodeType::ACCESS, field_type);
 
@@ -617,6 +614,7 @@ namespace arc
 			field_type == DataType::FUNCTION)
 		{
 			node->value = field_type_data;
+			module.intern_t(node);
 		}
 
 		/* for struct fields, also store the struct name for type registry lookup */
@@ -660,6 +658,7 @@ namespace arc
 				{
 					node->value = it->second;
 					node->str_id = array->str_id;
+					module.intern_t(node);
 				}
 			}
 		}
@@ -673,11 +672,7 @@ namespace arc
 		if (!current_region)
 			throw std::runtime_error("no current region set for node creation");
 
-		ach::shared_allocator<Node> alloc;
-		Node *node = alloc.allocate(1);
-		std::construct_at(node);
-		node->ir_type = type;
-		node->type_kind = result_type;
+		Node *node = module.create_node(type, result_type);
 		node->parent = current_region;
 		current_region->append(node);
 		return node;
@@ -721,6 +716,7 @@ namespace arc
 		arr_data.count = count;
 		arr_data.elements = {};
 		alloc_node->value.set<decltype(arr_data), DataType::ARRAY>(arr_data);
+		module.intern_t(alloc_node);
 
 		alloc_node->str_id = struct_type.get<DataType::STRUCT>().name;
 
@@ -783,7 +779,7 @@ namespace arc
 		struct_data.alignment = is_packed ? 1 : alignment;
 		struct_data.name = struct_name_id;
 
-		u8slice<std::tuple<StringTable::StringId, DataType, TypedData> > final_fields = {};
+		std::vector<TypeContext::Field> final_fields;
 		std::size_t current_offset = 0;
 		for (const auto &[name_id, type, type_data]: fields)
 		{
@@ -820,9 +816,9 @@ namespace arc
 			}
 		}
 
-		struct_data.fields = std::move(final_fields);
-		TypedData type_def;
-		type_def.set<decltype(struct_data), DataType::STRUCT>(std::move(struct_data));
+		/* the field list is stored once in the module; every node of this
+		 * type only views it */
+		TypedData type_def = builder.module.types().struct_t(struct_data.name, final_fields, struct_data.alignment);
 		builder.module.add_t(builder.module.strtable().get(struct_data.name).data(), type_def);
 		return type_def;
 	}
@@ -0,0 +1,825 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <arc/foundation/cold-store.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/support/algorithm.hpp>
+#include <arc/support/allocator.hpp>
+#include <arc/support/inference.hpp>
+
+namespace arc
+{
+	namespace
+	{
+		bool has(const Node *node, const NodeTraits trait)
+		{
+			return (node->traits & trait) != NodeTraits::NONE;
+		}
+
+		/* what an evicted function keeps of its body: enough to stand as a declaration */
+		bool kept(const Node *node)
+		{
+			return node->ir_type == NodeType::ENTRY || node->ir_type == NodeType::PARAM;
+		}
+
+		/* what keeps a function from being pure, as the call graph sees it */
+		bool writes(Node *node)
+		{
+			switch (node->ir_type)
+			{
+				case NodeType::STORE:
+				case NodeType::PTR_STORE:
+					return node->inputs.size() < 2 || !is_writeonly_pointer(node->inputs[1]);
+				case NodeType::ATOMIC_STORE:
+				case NodeType::ATOMIC_CAS:
+					return true;
+				default:
+					return false;
+			}
+		}
+
+		std::size_t footprint(const std::vector<Region *> &regions)
+		{
+			std::size_t bytes = 0;
+			for (const Region *region: regions)
+			{
+				for (const Node *node: region->nodes())
+					bytes += sizeof(Node) + (node->inputs.capacity() + node->users.capacity()) * sizeof(Node *);
+			}
+			return bytes;
+		}
+
+		std::uint64_t zigzag(const std::int64_t value)
+		{
+			return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+		}
+
+		std::int64_t unzigzag(const std::uint64_t value)
+		{
+			return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+		}
+
+		/*
+		 * layout of an evicted body, every number a LEB128 varint:
+		 *
+		 *   region count, then per region in `regions_of` order its node count and
+		 *   per node either 0 and the external index of a node that was kept, or
+		 *   ir_type + 1, type_kind, traits, str_id and type_id of a node that was
+		 *   evicted;
+		 *
+		 *   then per evicted node in the same order its value and its inputs.
+		 *
+		 * A reference is 0 for none, odd for an evicted node as the zigzagged
+		 * distance from the node being written, which keeps most of them to a
+		 * single byte, and even for an entry of the external table.
+		 */
+		class Encoder
+		{
+		public:
+			Encoder(std::vector<Node *> &externals, std::vector<TypedData> &values) : externals(externals),
+				values(values) {}
+
+			std::vector<std::uint8_t> encode(const std::vector<Region *> &regions)
+			{
+				std::vector<Node *> evicted;
+				varint(regions.size());
+				for (const Region *region: regions)
+				{
+					varint(region->nodes().size());
+					for (Node *node: region->nodes())
+					{
+						if (kept(node))
+						{
+							varint(0);
+							varint(external(node));
+							continue;
+						}
+
+						local.emplace(node, evicted.size());
+						evicted.push_back(node);
+						varint(static_cast<std::uint64_t>(node->ir_type) + 1);
+						varint(static_cast<std::uint64_t>(node->type_kind));
+						varint(static_cast<std::uint64_t>(node->traits));
+						varint(node->str_id);
+						varint(node->type_id);
+					}
+				}
+
+				for (; current < evicted.size(); ++current)
+				{
+					const Node *node = evicted[current];
+					value(node->value);
+					varint(node->inputs.size());
+					for (Node *input: node->inputs)
+						ref(input);
+				}
+				return std::move(bytes);
+			}
+
+		private:
+			std::vector<std::uint8_t> bytes;
+			std::unordered_map<const Node *, std::size_t> local;    /* evicted node -> position */
+			std::unordered_map<const Node *, std::size_t> outside;  /* other node -> external index */
+			std::vector<Node *> &externals;
+			std::vector<TypedData> &values;
+			std::size_t current = 0;
+
+			void varint(std::uint64_t value)
+			{
+				while (value >= 0x80)
+				{
+					bytes.push_back(static_cast<std::uint8_t>(value | 0x80));
+					value >>= 7;
+				}
+				bytes.push_back(static_cast<std::uint8_t>(value));
+			}
+
+			std::size_t external(Node *node)
+			{
+				const auto [it, inserted] = outside.try_emplace(node, externals.size());
+				if (inserted)
+					externals.push_back(node);
+				return it->second;
+			}
+
+			void ref(Node *node)
+			{
+				if (!node)
+					varint(0);
+				else if (const auto it = local.find(node); it != local.end())
+					varint(zigzag(static_cast<std::int64_t>(current) - static_cast<std::int64_t>(it->second)) * 2 + 1);
+				else
+					varint(external(node) * 2 + 2);
+			}
+
+			template<DataType T>
+			void number(const TypedData &data)
+			{
+				using V = typename DataTraits<T>::value;
+				const V value = data.get<T>();
+				if constexpr (std::is_floating_point_v<V>)
+				{
+					const std::size_t at = bytes.size();
+					bytes.resize(at + sizeof(V));
+					std::memcpy(bytes.data() + at, &value, sizeof(V));
+				}
+				else if constexpr (std::is_signed_v<V>)
+					varint(zigzag(value));
+				else
+					varint(value);
+			}
+
+			void value(const TypedData &data)
+			{
+				varint(static_cast<std::uint64_t>(data.type()));
+				switch (data.type())
+				{
+					case DataType::VOID:
+						break;
+					case DataType::BOOL: number<DataType::BOOL>(data); break;
+					case DataType::INT8: number<DataType::INT8>(data); break;
+					case DataType::INT16: number<DataType::INT16>(data); break;
+					case DataType::INT32: number<DataType::INT32>(data); break;
+					case DataType::INT64: number<DataType::INT64>(data); break;
+					case DataType::UINT8: number<DataType::UINT8>(data); break;
+					case DataType::UINT16: number<DataType::UINT16>(data); break;
+					case DataType::UINT32: number<DataType::UINT32>(data); break;
+					case DataType::UINT64: number<DataType::UINT64>(data); break;
+					case DataType::FLOAT32: number<DataType::FLOAT32>(data); break;
+					case DataType::FLOAT64: number<DataType::FLOAT64>(data); break;
+					case DataType::POINTER:
+					{
+						const auto &ptr = data.get<DataType::POINTER>();
+						ref(ptr.pointee);
+						varint(ptr.addr_space);
+						varint(static_cast<std::uint64_t>(ptr.qualifier));
+						break;
+					}
+					case DataType::ARRAY:
+					{
+						const auto &arr = data.get<DataType::ARRAY>();
+						varint(static_cast<std::uint64_t>(arr.elem_type));
+						varint(arr.count);
+						varint(arr.elements.size());
+						for (Node *element: arr.elements)
+							ref(element);
+						break;
+					}
+					case DataType::VECTOR:
+					{
+						const auto &vec = data.get<DataType::VECTOR>();
+						varint(static_cast<std::uint64_t>(vec.elem_type));
+						varint(vec.lane_count);
+						break;
+					}
+					case DataType::STRUCT:
+					case DataType::FUNCTION:
+						/* views into the type context and owned return types are kept whole */
+						varint(values.size());
+						values.push_back(data);
+						break;
+				}
+			}
+		};
+
+		class Decoder
+		{
+		public:
+			Decoder(const std::vector<std::uint8_t> &bytes, const std::vector<Node *> &externals,
+			        const std::vector<TypedData> &values) : bytes(bytes), externals(externals), values(values) {}
+
+			std::uint64_t varint()
+			{
+				std::uint64_t value = 0;
+				for (unsigned shift = 0; shift < 64; shift += 7)
+				{
+					if (pos >= bytes.size())
+						break;
+					const std::uint8_t byte = bytes[pos++];
+					value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+					if (!(byte & 0x80))
+						return value;
+				}
+				throw std::logic_error("encoded function body is corrupt");
+			}
+
+			Node *external(const std::uint64_t index) const
+			{
+				if (index >= externals.size())
+					throw std::logic_error("encoded function body is corrupt");
+				return externals[index];
+			}
+
+			void connect(const std::vector<Node *> &evicted)
+			{
+				nodes = &evicted;
+				for (current = 0; current < evicted.size(); ++current)
+				{
+					Node *node = evicted[current];
+					node->value = value();
+					for (std::uint64_t count = varint(); count > 0; --count)
+					{
+						Node *input = ref();
+						node->inputs.push_back(input);
+						if (input)
+							input->users.push_back(node);
+					}
+				}
+			}
+
+		private:
+			const std::vector<std::uint8_t> &bytes;
+			const std::vector<Node *> &externals;
+			const std::vector<TypedData> &values;
+			const std::vector<Node *> *nodes = nullptr;
+			std::size_t pos = 0;
+			std::size_t current = 0;
+
+			Node *ref()
+			{
+				const std::uint64_t code = varint();
+				if (code == 0)
+					return nullptr;
+				if ((code & 1) == 0)
+					return external(code / 2 - 1);
+
+				const std::int64_t at = static_cast<std::int64_t>(current) - unzigzag(code / 2);
+				if (at < 0 || static_cast<std::size_t>(at) >= nodes->size())
+					throw std::logic_error("encoded function body is corrupt");
+				return (*nodes)[at];
+			}
+
+			template<DataType T>
+			TypedData number()
+			{
+				using V = typename DataTraits<T>::value;
+				V value {};
+				if constexpr (std::is_floating_point_v<V>)
+				{
+					if (pos + sizeof(V) > bytes.size())
+						throw std::logic_error("encoded function body is corrupt");
+					std::memcpy(&value, bytes.data() + pos, sizeof(V));
+					pos += sizeof(V);
+				}
+				else if constexpr (std::is_signed_v<V>)
+					value = static_cast<V>(unzigzag(varint()));
+				else
+					value = static_cast<V>(varint());
+
+				TypedData data;
+				data.set<V, T>(value);
+				return data;
+			}
+
+			TypedData value()
+			{
+				switch (static_cast<DataType>(varint()))
+				{
+					case DataType::VOID:
+						return {};
+					case DataType::BOOL: return number<DataType::BOOL>();
+					case DataType::INT8: return number<DataType::INT8>();
+					case DataType::INT16: return number<DataType::INT16>();
+					case DataType::INT32: return number<DataType::INT32>();
+					case DataType::INT64: return number<DataType::INT64>();
+					case DataType::UINT8: return number<DataType::UINT8>();
+					case DataType::UINT16: return number<DataType::UINT16>();
+					case DataType::UINT32: return number<DataType::UINT32>();
+					case DataType::UINT64: return number<DataType::UINT64>();
+					case DataType::FLOAT32: return number<DataType::FLOAT32>();
+					case DataType::FLOAT64: return number<DataType::FLOAT64>();
+					case DataType::POINTER:
+					{
+						DataTraits<DataType::POINTER>::value ptr;
+						ptr.pointee = ref();
+						ptr.addr_space = static_cast<std::uint32_t>(varint());
+						ptr.qualifier = static_cast<DataTraits<DataType::POINTER>::PtrQualifier>(varint());
+						TypedData data;
+						data.set<decltype(ptr), DataType::POINTER>(ptr);
+						return data;
+					}
+					case DataType::ARRAY:
+					{
+						DataTraits<DataType::ARRAY>::value arr;
+						arr.elem_type = static_cast<DataType>(varint());
+						arr.count = static_cast<std::uint32_t>(varint());
+						u16slice<Node *> elements;
+						for (std::uint64_t count = varint(); count > 0; --count)
+							elements.push_back(ref());
+						arr.elements = std::move(elements);
+						TypedData data;
+						data.set<decltype(arr), DataType::ARRAY>(arr);
+						return data;
+					}
+					case DataType::VECTOR:
+					{
+						DataTraits<DataType::VECTOR>::value vec;
+						vec.elem_type = static_cast<DataType>(varint());
+						vec.lane_count = static_cast<std::uint32_t>(varint());
+						TypedData data;
+						data.set<decltype(vec), DataType::VECTOR>(vec);
+						return data;
+					}
+					case DataType::STRUCT:
+					case DataType::FUNCTION:
+					{
+						const std::uint64_t index = varint();
+						if (index >= values.size())
+							throw std::logic_error("encoded function body is corrupt");
+						return values[index];
+					}
+				}
+				throw std::logic_error("encoded function body is corrupt");
+			}
+		};
+	}
+
+	ColdStore::ColdStore(Module &module, const ColdMedium medium) : mod(module), medium(medium)
+	{
+		outer = std::exchange(mod.cold, this);
+
+		/* code looking into an evicted function gets its body back first */
+		fallback = mod.lazy_bodies([this](Node *fn, const BodyUse use)
+		{
+			/* passes walking the module leave evicted functions alone; that is what evicting is for */
+			if (!records.contains(fn) || use == BodyUse::WALK)
+				return fallback && fallback(fn, use);
+			rehydrate(fn);
+			return true;
+		});
+	}
+
+	ColdStore::~ColdStore()
+	{
+		mod.lazy_bodies(std::move(fallback));
+		mod.cold = outer;
+
+		/* a body that cannot be read back is lost; a destructor must not throw.
+		 * whoever needs to know calls rehydrate_all before */
+		try
+		{
+			rehydrate_all();
+		}
+		catch (const std::exception &)
+		{
+		}
+		if (file)
+			std::fclose(file);
+	}
+
+	bool ColdStore::evict(Node *fn)
+	{
+		return evict(std::vector { fn }) == 1;
+	}
+
+	std::size_t ColdStore::evict(const std::vector<Node *> &fns)
+	{
+		/* a safe point; retired nodes still around after it are in use by someone */
+		mod.reclaim();
+
+		const auto bodies = mod.bodies();
+		std::unordered_map<const Node *, const Node *> owner; /* evicted node -> its function */
+		std::vector<std::pair<Node *, std::vector<Region *> > > candidates;
+		std::unordered_set<const Node *> seen;
+		for (Node *fn: fns)
+		{
+			if (!fn || fn->ir_type != NodeType::FUNCTION || has(fn, NodeTraits::EXTERN) || !mod.contains(fn))
+				continue;
+
+			const auto body = bodies.find(mod.strtable().get(fn->str_id));
+			if (body == bodies.end() || !seen.insert(fn).second)
+				continue;
+
+			std::vector<Region *> regions = body->second->dominated_regions();
+			for (const Region *region: regions)
+			{
+				for (const Node *node: region->nodes())
+				{
+					if (!kept(node))
+						owner.emplace(node, fn);
+				}
+			}
+			candidates.emplace_back(fn, std::move(regions));
+		}
+		if (candidates.empty())
+			return 0;
+
+		/* a body stays if anything outside it refers to one of its nodes; edges go both ways,
+		 * so looking at users as well catches nodes that were taken out of their region */
+		std::unordered_set<const Node *> pinned;
+		const auto refer = [&](const Node *from, const Node *to)
+		{
+			const auto it = to ? owner.find(to) : owner.end();
+			if (it == owner.end())
+				return;
+			if (const auto from_it = owner.find(from); from_it == owner.end() || from_it->second != it->second)
+				pinned.insert(it->second);
+		};
+
+		std::vector<const Region *> worklist = { mod.root(), mod.rodata() };
+		while (!worklist.empty())
+		{
+			const Region *region = worklist.back();
+			worklist.pop_back();
+			worklist.insert(worklist.end(), region->children().begin(), region->children().end());
+
+			for (const Node *node: region->nodes())
+			{
+				for (const Node *input: node->inputs)
+					refer(node, input);
+				for (const Node *user: node->users)
+					refer(user, node);
+
+				if (node->value.type() == DataType::POINTER)
+					refer(node, node->value.get<DataType::POINTER>().pointee);
+				else if (node->value.type() == DataType::ARRAY)
+				{
+					for (const Node *element: node->value.get<DataType::ARRAY>().elements)
+						refer(node, element);
+				}
+			}
+		}
+		for (const auto &[fn, record]: records)
+		{
+			for (const Node *external: record.externals)
+				refer(nullptr, external);
+		}
+
+		std::size_t count = 0;
+		ach::shared_allocator<Node> alloc;
+		for (auto &[fn, regions]: candidates)
+		{
+			if (pinned.contains(fn))
+				continue;
+
+			/* stored before anything is freed, so a failed write leaves the body as it was */
+			Record record;
+			record.traits = fn->traits;
+			record.writes = std::ranges::any_of(regions, [](const Region *region)
+			{
+				return std::ranges::any_of(region->nodes(), writes);
+			});
+			record.bytes = Encoder(record.externals, record.values).encode(regions);
+			store(record);
+
+			/* only the declaration is left: the nodes that stay forget the ones that go */
+			std::vector<Node *> evicted;
+			for (Region *region: regions)
+			{
+				for (Node *node: region->nodes())
+				{
+					if (!kept(node))
+						evicted.push_back(node);
+				}
+				std::erase_if(region->ns, [](const Node *node) { return !kept(node); });
+			}
+			for (Node *node: evicted)
+			{
+				for (Node *input: node->inputs)
+				{
+					if (!input)
+						continue;
+					if (const auto it = owner.find(input); it == owner.end() || it->second != fn)
+						erase(input->users, node);
+				}
+			}
+
+			mod.forget(evicted);
+			for (Node *node: evicted)
+			{
+				std::destroy_at(node);
+				alloc.deallocate(node, 1);
+			}
+
+			fn->traits = NodeTraits::EXTERN;
+			records.emplace(fn, std::move(record));
+			ages.erase(fn);
+			++count;
+		}
+		return count;
+	}
+
+	void ColdStore::rehydrate(Node *fn)
+	{
+		const auto it = records.find(fn);
+		if (it == records.end())
+			return;
+		Record &record = it->second;
+
+		const std::string_view name = mod.strtable().get(fn->str_id);
+		const auto bodies = mod.bodies();
+		const auto body = bodies.find(name);
+		if (body == bodies.end())
+			throw std::logic_error(std::format("body of evicted function '{}' is gone", name));
+		const std::vector<Region *> regions = body->second->dominated_regions();
+
+		std::vector<std::uint8_t> from_file;
+		if (medium == ColdMedium::FILE)
+			from_file = read(record);
+		Decoder in(medium == ColdMedium::FILE ? from_file : record.bytes, record.externals, record.values);
+
+		/* what is left of every region must be exactly what eviction left there,
+		 * which is checked before anything is rebuilt */
+		struct Slot
+		{
+			Node *kept = nullptr;
+			NodeType type = NodeType::ENTRY;
+			DataType kind = DataType::VOID;
+			NodeTraits traits = NodeTraits::NONE;
+			StringTable::StringId str_id = {};
+			TypeContext::TypeId type_id = TypeContext::invalid;
+		};
+		const auto changed = [&]
+		{
+			return std::logic_error(std::format("declaration of evicted function '{}' was changed", name));
+		};
+
+		if (in.varint() != regions.size())
+			throw changed();
+
+		std::vector<std::vector<Slot> > layout(regions.size());
+		for (std::size_t i = 0; i < regions.size(); ++i)
+		{
+			std::vector<Node *> left;
+			for (std::uint64_t count = in.varint(); count > 0; --count)
+			{
+				Slot slot;
+				if (const std::uint64_t type = in.varint(); type == 0)
+				{
+					slot.kept = in.external(in.varint());
+					left.push_back(slot.kept);
+				}
+				else
+				{
+					slot.type = static_cast<NodeType>(type - 1);
+					slot.kind = static_cast<DataType>(in.varint());
+					slot.traits = static_cast<NodeTraits>(in.varint());
+					slot.str_id = static_cast<StringTable::StringId>(in.varint());
+					slot.type_id = static_cast<TypeContext::TypeId>(in.varint());
+				}
+				layout[i].push_back(slot);
+			}
+			if (regions[i]->ns != left)
+				throw changed();
+		}
+
+		std::vector<Node *> evicted;
+		for (std::size_t i = 0; i < regions.size(); ++i)
+		{
+			std::vector<Node *> &ns = regions[i]->ns;
+			ns.clear();
+			ns.reserve(layout[i].size());
+			for (const Slot &slot: layout[i])
+			{
+				if (slot.kept)
+				{
+					ns.push_back(slot.kept);
+					continue;
+				}
+
+				Node *node = mod.create_node(slot.type, slot.kind);
+				node->traits = slot.traits;
+				node->str_id = slot.str_id;
+				node->type_id = slot.type_id;
+				node->parent = regions[i];
+				ns.push_back(node);
+				evicted.push_back(node);
+			}
+		}
+		in.connect(evicted);
+
+		fn->traits = record.traits;
+		stored -= record.size;
+		records.erase(it);
+
+		/* the nodes are new to the journal; incremental passes have to look at them again */
+		for (Region *region: regions)
+			mod.touch(region);
+	}
+
+	std::size_t ColdStore::rehydrate_all()
+	{
+		std::size_t count = 0;
+		for (Node *fn: mod.functions())
+		{
+			if (records.contains(fn))
+			{
+				rehydrate(fn);
+				++count;
+			}
+		}
+		return count;
+	}
+
+	bool ColdStore::evicted(const Node *fn) const
+	{
+		return records.contains(fn);
+	}
+
+	std::size_t ColdStore::evicted_count() const
+	{
+		return records.size();
+	}
+
+	std::vector<Node *> ColdStore::referenced_functions(const Node *fn) const
+	{
+		const auto it = records.find(fn);
+		if (it == records.end())
+			return {};
+
+		/* the functions it calls or takes the address of are outside the body, so among its externals */
+		std::vector<Node *> functions;
+		for (Node *external: it->second.externals)
+		{
+			if (external->ir_type == NodeType::FUNCTION)
+				functions.push_back(external);
+		}
+		return functions;
+	}
+
+	bool ColdStore::writes_memory(const Node *fn) const
+	{
+		const auto it = records.find(fn);
+		return it != records.end() && it->second.writes;
+	}
+
+	std::size_t ColdStore::resident_bytes(const Node *fn) const
+	{
+		if (!fn)
+			return 0;
+
+		const Region *body = mod.body(fn);
+		return body ? footprint(body->dominated_regions()) : 0;
+	}
+
+	std::size_t ColdStore::resident_bytes() const
+	{
+		const auto bodies = mod.bodies();
+		std::size_t bytes = 0;
+		for (const Node *fn: mod.functions())
+		{
+			if (const auto it = bodies.find(mod.strtable().get(fn->str_id)); it != bodies.end())
+				bytes += footprint(it->second->dominated_regions());
+		}
+		return bytes;
+	}
+
+	std::size_t ColdStore::stored_bytes() const
+	{
+		return stored;
+	}
+
+	std::size_t ColdStore::enforce(const EvictionPolicy &policy)
+	{
+		if (policy.budget == 0)
+			return 0;
+
+		struct Candidate
+		{
+			Node *fn;
+			std::uint64_t stamp;
+			std::size_t bytes;
+		};
+
+		const auto bodies = mod.bodies();
+		std::vector<Candidate> candidates;
+		std::size_t total = 0;
+		for (Node *fn: mod.functions())
+		{
+			if (fn->ir_type != NodeType::FUNCTION || has(fn, NodeTraits::EXTERN))
+				continue;
+
+			const auto body = bodies.find(mod.strtable().get(fn->str_id));
+			if (body == bodies.end())
+				continue;
+
+			const std::vector<Region *> regions = body->second->dominated_regions();
+			std::uint64_t stamp = 0;
+			for (const Region *region: regions)
+				stamp = std::max(stamp, region->modified());
+			const std::size_t bytes = footprint(regions);
+			total += bytes;
+
+			const auto [age, first] = ages.try_emplace(fn, Age { stamp, 0 });
+			if (!first)
+			{
+				if (age->second.stamp == stamp)
+					++age->second.unchanged;
+				else
+					age->second = { stamp, 0 };
+			}
+			if (age->second.unchanged >= policy.cold_after)
+				candidates.push_back({ fn, stamp, bytes });
+		}
+
+		/* whatever the next pass changes is stamped after everything seen above */
+		mod.checkpoint();
+		if (total <= policy.budget)
+			return 0;
+
+		/* least recently changed first; the sort is stable so ties keep the module's order */
+		std::ranges::stable_sort(candidates, {}, &Candidate::stamp);
+
+		std::size_t count = 0;
+		for (auto next = candidates.begin(); next != candidates.end() && total > policy.budget;)
+		{
+			/* take what should be enough, then find out which of them could actually go */
+			const auto first = next;
+			std::vector<Node *> batch;
+			for (std::size_t expected = total; next != candidates.end() && expected > policy.budget; ++next)
+			{
+				batch.push_back(next->fn);
+				expected -= std::min(expected, next->bytes);
+			}
+
+			count += evict(batch);
+			for (auto it = first; it != next; ++it)
+			{
+				if (records.contains(it->fn))
+					total -= std::min(total, it->bytes);
+			}
+		}
+		return count;
+	}
+
+	void ColdStore::store(Record &record)
+	{
+		record.size = record.bytes.size();
+		stored += record.size;
+		if (medium == ColdMedium::MEMORY)
+		{
+			record.bytes.shrink_to_fit();
+			return;
+		}
+
+		if (!file && !(file = std::tmpfile()))
+			throw std::system_error(errno, std::generic_category(), "cannot create file for evicted functions");
+
+		if (std::fseek(file, 0, SEEK_END) != 0 || (record.offset = std::ftell(file)) < 0 ||
+		    std::fwrite(record.bytes.data(), 1, record.size, file) != record.size)
+		{
+			stored -= record.size;
+			throw std::system_error(errno, std::generic_category(), "cannot write evicted function");
+		}
+		record.bytes = {};
+	}
+
+	std::vector<std::uint8_t> ColdStore::read(const Record &record) const
+	{
+		std::vector<std::uint8_t> bytes(record.size);
+		if (std::fseek(file, record.offset, SEEK_SET) != 0 ||
+		    std::fread(bytes.data(), 1, record.size, file) != record.size)
+			throw std::system_error(errno, std::generic_category(), "cannot read evicted function");
+		return bytes;
+	}
+}
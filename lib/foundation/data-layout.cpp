@@ -0,0 +1,140 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <mutex>
+#include <arc/foundation/data-layout.hpp>
+#include <arc/support/inference.hpp>
+
+namespace arc
+{
+	std::optional<std::uint8_t> StructLayout::index_of(const StringTable::StringId name) const
+	{
+		if (const auto it = names.find(name); it != names.end())
+			return it->second;
+		return std::nullopt;
+	}
+
+	std::optional<std::uint64_t> StructLayout::offset_of(const std::size_t logical) const
+	{
+		if (logical >= fields.size())
+			return std::nullopt;
+		return offsets[fields[logical]];
+	}
+
+	bool StructLayout::padding_at(const std::size_t raw) const
+	{
+		/* `fields` is sorted, so raw indices missing from it are padding */
+		return raw < offsets.size() && !std::ranges::binary_search(fields, static_cast<std::uint8_t>(raw));
+	}
+
+	DataLayout::DataLayout(const StringTable &strings, const TypeContext &types) : strtb(strings), ctx(types) {}
+
+	const StructLayout &DataLayout::of(const DataTraits<DataType::STRUCT>::value &type)
+	{
+		const TypeContext::Field *key = type.fields.data();
+		if (!ctx.owns(key))
+		{
+			/* one per thread; nested structs may reuse it while this one is computed */
+			thread_local StructLayout scratch;
+			StructLayout layout;
+			compute(type, layout);
+			scratch = std::move(layout);
+			return scratch;
+		}
+
+		{
+			std::shared_lock lock(mutex);
+			if (const auto it = structs.find(key); it != structs.end())
+				return it->second;
+		}
+
+		/* computed unlocked since nested structs come back through here; if another
+		 * thread got there first its layout is kept and this one is dropped */
+		StructLayout layout;
+		compute(type, layout);
+		std::unique_lock lock(mutex);
+		return structs.try_emplace(key, std::move(layout)).first->second;
+	}
+
+	ArrayLayout DataLayout::of(const DataTraits<DataType::ARRAY>::value &type) const
+	{
+		/* array types only record a scalar element type */
+		ArrayLayout layout;
+		layout.element_size = elem_sz(type.elem_type);
+		layout.size = layout.element_size * type.count;
+		layout.alignment = align_t(type.elem_type);
+		return layout;
+	}
+
+	std::uint64_t DataLayout::size_of(const DataType type, const TypedData &data)
+	{
+		switch (type)
+		{
+			case DataType::STRUCT:
+				return data.type() == DataType::STRUCT ? of(data.get<DataType::STRUCT>()).size : 0;
+			case DataType::ARRAY:
+				return data.type() == DataType::ARRAY ? of(data.get<DataType::ARRAY>()).size : 0;
+			case DataType::VECTOR:
+			{
+				if (data.type() != DataType::VECTOR)
+					return 0;
+				const auto &vec = data.get<DataType::VECTOR>();
+				return static_cast<std::uint64_t>(vec.lane_count) * elem_sz(vec.elem_type);
+			}
+			default:
+				return elem_sz(type);
+		}
+	}
+
+	std::uint32_t DataLayout::align_of(const DataType type, const TypedData &data)
+	{
+		switch (type)
+		{
+			case DataType::STRUCT:
+				return data.type() == DataType::STRUCT ? of(data.get<DataType::STRUCT>()).alignment : 1;
+			case DataType::ARRAY:
+				return data.type() == DataType::ARRAY ? of(data.get<DataType::ARRAY>()).alignment : 1;
+			case DataType::VECTOR:
+				return data.type() == DataType::VECTOR ? align_t(data.get<DataType::VECTOR>().elem_type) : 1;
+			default:
+				return align_t(type);
+		}
+	}
+
+	std::size_t DataLayout::size() const
+	{
+		std::shared_lock lock(mutex);
+		return structs.size();
+	}
+
+	void DataLayout::clear()
+	{
+		std::unique_lock lock(mutex);
+		structs.clear();
+	}
+
+	void DataLayout::compute(const DataTraits<DataType::STRUCT>::value &type, StructLayout &layout)
+	{
+		layout.alignment = std::max<std::uint32_t>(1, type.alignment);
+		layout.offsets.reserve(type.fields.size());
+		layout.fields.reserve(type.fields.size());
+
+		for (std::uint8_t i = 0; i < type.fields.size(); ++i)
+		{
+			const auto &[name_id, field_type, field_data] = type.fields[i];
+			const std::uint64_t field_size = size_of(field_type, field_data);
+
+			layout.offsets.push_back(layout.size);
+			layout.size += field_size;
+
+			if (strtb.get(name_id).starts_with("__pad"))
+			{
+				layout.padding += field_size;
+				continue;
+			}
+
+			layout.fields.push_back(i);
+			layout.names.emplace(name_id, i);
+		}
+	}
+}
@@ -0,0 +1,615 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <format>
+#include <arc/foundation/linker.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/support/algorithm.hpp>
+#include <arc/support/allocator.hpp>
+
+namespace arc
+{
+	namespace
+	{
+		bool has(const Node *node, const NodeTraits trait)
+		{
+			return (node->traits & trait) != NodeTraits::NONE;
+		}
+
+		bool is_composite(const DataType type)
+		{
+			return type == DataType::STRUCT || type == DataType::ARRAY ||
+			       type == DataType::FUNCTION || type == DataType::VECTOR;
+		}
+
+		const TypedData *return_type(const Node *fn)
+		{
+			if (fn->value.type() != DataType::FUNCTION)
+				return nullptr;
+			return fn->value.get<DataType::FUNCTION>().return_type;
+		}
+	}
+
+	LinkError::LinkError(std::string symbol, const std::string &message) : std::runtime_error(message),
+		sym(std::move(symbol)) {}
+
+	const std::string &LinkError::symbol() const
+	{
+		return sym;
+	}
+
+	Linker::Linker(Module &dest) : dest(dest) {}
+
+	Linker &Linker::add(Module &source)
+	{
+		if (&source == &dest)
+			throw std::invalid_argument("cannot link a module into itself");
+		if (std::ranges::find(sources, &source) != sources.end())
+			return *this;
+
+		for (Node *fn: source.functions())
+		{
+			if (fn->ir_type != NodeType::FUNCTION || has(fn, NodeTraits::EXTERN) || !has(fn, NodeTraits::EXPORT))
+				continue;
+
+			std::string name(source.strtable().get(fn->str_id));
+			if (const auto [it, inserted] = exports.try_emplace(name, fn); !inserted && it->second != fn)
+			{
+				throw LinkError(name, std::format("'{}' is exported by both '{}' and '{}'", name,
+				                                  it->second->parent->module().name(), source.name()));
+			}
+		}
+
+		sources.push_back(&source);
+		return *this;
+	}
+
+	Node *Linker::import(const std::string_view name)
+	{
+		const auto it = exports.find(std::string(name));
+		if (it == exports.end())
+			throw LinkError(std::string(name), std::format("no linked module exports '{}'", name));
+
+		index_dest();
+		Node *fn = import_function(it->second);
+		drain();
+		return fn;
+	}
+
+	Node *Linker::import(Node *fn)
+	{
+		if (!fn || fn->ir_type != NodeType::FUNCTION || !fn->parent ||
+		    std::ranges::find(sources, &fn->parent->module()) == sources.end())
+			throw std::invalid_argument("function does not belong to a linked module");
+
+		index_dest();
+		Node *copy = import_function(fn);
+		drain();
+		return copy;
+	}
+
+	std::vector<Node *> Linker::import(const std::vector<Node *> &fns)
+	{
+		for (const Node *fn: fns)
+		{
+			if (!fn || fn->ir_type != NodeType::FUNCTION || !fn->parent ||
+			    std::ranges::find(sources, &fn->parent->module()) == sources.end())
+				throw std::invalid_argument("function does not belong to a linked module");
+		}
+
+		/* bodies are only copied once every function is declared, so callees cannot jump the queue */
+		index_dest();
+		std::vector<Node *> copies;
+		copies.reserve(fns.size());
+		for (Node *fn: fns)
+			copies.push_back(import_function(fn));
+		drain();
+		return copies;
+	}
+
+	Linker &Linker::declare_if(std::function<bool(const Node *)> predicate)
+	{
+		declared = std::move(predicate);
+		return *this;
+	}
+
+	std::vector<Node *> Linker::declare(const std::vector<Node *> &fns)
+	{
+		for (const Node *fn: fns)
+		{
+			if (!fn || fn->ir_type != NodeType::FUNCTION || !fn->parent ||
+			    std::ranges::find(sources, &fn->parent->module()) == sources.end())
+				throw std::invalid_argument("function does not belong to a linked module");
+		}
+
+		index_dest();
+		std::vector<Node *> declarations;
+		declarations.reserve(fns.size());
+		for (Node *fn: fns)
+			declarations.push_back(declare(fn));
+		return declarations;
+	}
+
+	void Linker::import_globals()
+	{
+		index_dest();
+		for (Module *source: sources)
+		{
+			merge_typedefs(*source);
+			for (Region *section: { source->root(), source->rodata() })
+			{
+				for (Node *node: section->nodes())
+				{
+					if (node->ir_type != NodeType::ENTRY && node->ir_type != NodeType::FUNCTION)
+						import_global(*source, node);
+				}
+			}
+		}
+		drain();
+	}
+
+	std::size_t Linker::resolve()
+	{
+		index_dest();
+
+		/* collected first since importing adds functions to the destination */
+		std::vector<Node *> definitions;
+		for (const Node *fn: dest.functions())
+		{
+			if (fn->ir_type != NodeType::FUNCTION || !has(fn, NodeTraits::EXTERN) || in_place.contains(fn))
+				continue;
+			if (const auto it = exports.find(std::string(dest.strtable().get(fn->str_id))); it != exports.end())
+				definitions.push_back(it->second);
+		}
+
+		for (Node *definition: definitions)
+			import_function(definition);
+		drain();
+		return definitions.size();
+	}
+
+	void Linker::link()
+	{
+		index_dest();
+		for (Module *source: sources)
+		{
+			merge_typedefs(*source);
+			for (Node *fn: source->functions())
+			{
+				if (fn->ir_type == NodeType::FUNCTION)
+					import_function(fn);
+			}
+
+			for (Region *section: { source->root(), source->rodata() })
+			{
+				for (Node *node: section->nodes())
+				{
+					if (node->ir_type != NodeType::ENTRY && node->ir_type != NodeType::FUNCTION)
+						import_global(*source, node);
+				}
+			}
+		}
+		drain();
+		resolve();
+	}
+
+	std::vector<std::string> Linker::unresolved() const
+	{
+		std::vector<std::string> names;
+		for (const Node *fn: dest.functions())
+		{
+			if (fn->ir_type == NodeType::FUNCTION && has(fn, NodeTraits::EXTERN) && !in_place.contains(fn))
+				names.emplace_back(dest.strtable().get(fn->str_id));
+		}
+		return names;
+	}
+
+	void Linker::index_dest()
+	{
+		/* the destination may have grown since the last call */
+		dest_fns.clear();
+		for (Node *fn: dest.functions())
+		{
+			if (fn->ir_type == NodeType::FUNCTION)
+				dest_fns.try_emplace(std::string(dest.strtable().get(fn->str_id)), fn);
+		}
+	}
+
+	void Linker::drain()
+	{
+		while (!pending.empty())
+		{
+			const auto [src_fn, dest_fn] = pending.front();
+			pending.pop_front();
+			copy_body(src_fn, dest_fn);
+		}
+	}
+
+	void Linker::merge_typedefs(Module &from)
+	{
+		if (!merged_typedefs.insert(&from).second)
+			return;
+
+		for (const auto &[name, type]: from.typemap())
+		{
+			TypedData imported = import_value(from, type, {});
+			if (const auto it = dest.typemap().find(name); it != dest.typemap().end())
+			{
+				const TypedData &existing = it->second;
+				const bool same = is_composite(existing.type()) && is_composite(imported.type())
+					                  ? dest.types().same(existing, imported)
+					                  : existing.type() == imported.type();
+				if (!same)
+					throw LinkError(name, std::format("type '{}' of '{}' conflicts with the definition in '{}'",
+					                                  name, from.name(), dest.name()));
+				continue;
+			}
+			dest.add_t(name, std::move(imported));
+		}
+	}
+
+	Node *Linker::import_function(Node *src_fn)
+	{
+		if (const auto it = functions.find(src_fn); it != functions.end())
+			return it->second;
+
+		Module &from = src_fn->parent->module();
+		merge_typedefs(from);
+
+		const std::string name(from.strtable().get(src_fn->str_id));
+
+		/* a callee declared earlier is defined after all; fill in its declaration */
+		if (const auto it = stubs.find(src_fn); it != stubs.end() && has(it->second, NodeTraits::EXTERN) &&
+		                                        !in_place.contains(it->second))
+		{
+			in_place.insert(it->second);
+			functions.emplace(src_fn, it->second);
+			pending.emplace_back(src_fn, it->second);
+			return it->second;
+		}
+
+		const auto existing = dest_fns.find(name);
+		Node *dest_fn = existing != dest_fns.end() ? existing->second : nullptr;
+
+		/* a declaration of the source binds to whatever the name means in the destination */
+		if (has(src_fn, NodeTraits::EXTERN))
+		{
+			if (!dest_fn)
+			{
+				if (const auto it = exports.find(name); it != exports.end())
+					dest_fn = import_function(it->second);
+				else
+					dest_fn = create_function(from, src_fn, name);
+			}
+			check_signature(from, src_fn, dest_fn);
+			functions.emplace(src_fn, dest_fn);
+			return dest_fn;
+		}
+
+		if (!has(src_fn, NodeTraits::EXPORT))
+		{
+			dest_fn = create_function(from, src_fn, private_name(from, name));
+		}
+		else if (dest_fn)
+		{
+			if (!has(dest_fn, NodeTraits::EXTERN) || in_place.contains(dest_fn))
+				throw LinkError(name, std::format("'{}' of '{}' is already defined in '{}'", name, from.name(),
+				                                  dest.name()));
+
+			check_signature(from, src_fn, dest_fn);
+			in_place.insert(dest_fn);
+		}
+		else
+		{
+			dest_fn = create_function(from, src_fn, name);
+		}
+
+		functions.emplace(src_fn, dest_fn);
+		pending.emplace_back(src_fn, dest_fn);
+		return dest_fn;
+	}
+
+	Node *Linker::declare(Node *src_fn)
+	{
+		if (const auto it = stubs.find(src_fn); it != stubs.end())
+			return it->second;
+
+		Module &from = src_fn->parent->module();
+		merge_typedefs(from);
+
+		const std::string name(from.strtable().get(src_fn->str_id));
+		Node *fn = nullptr;
+		if (const auto it = dest_fns.find(name); it != dest_fns.end())
+		{
+			fn = it->second;
+			check_signature(from, src_fn, fn);
+		}
+		else
+		{
+			fn = create_function(from, src_fn, name);
+			fn->traits = NodeTraits::EXTERN;
+		}
+
+		stubs.emplace(src_fn, fn);
+		return fn;
+	}
+
+	Node *Linker::create_function(Module &from, Node *src_fn, const std::string_view name)
+	{
+		Node *fn = shell(from, src_fn);
+		fn->str_id = dest.intern_str(name);
+		fn->value = import_value(from, src_fn->value, {});
+		dest.intern_t(fn);
+		dest.root()->append(fn);
+		dest.add_fn(fn);
+		dest_fns.try_emplace(std::string(name), fn);
+
+		Region *region = dest.create_region(name);
+		for (Node *src_param: src_fn->inputs)
+		{
+			Node *param = shell(from, src_param);
+			param->value = import_value(from, src_param->value, {});
+			dest.intern_t(param);
+			region->append(param);
+			fn->inputs.push_back(param);
+			param->users.push_back(fn);
+		}
+		return fn;
+	}
+
+	void Linker::copy_body(Node *src_fn, Node *dest_fn)
+	{
+		Module &from = src_fn->parent->module();
+		Region *src_body = from.body(src_fn);
+		Region *dest_body = dest.body(dest_fn);
+		if (!src_body || !dest_body)
+			return;
+
+		const std::string_view name = dest.strtable().get(dest_fn->str_id);
+		if (in_place.contains(dest_fn))
+		{
+			if (!dest_body->children().empty())
+				throw LinkError(std::string(name), std::format("declaration of '{}' has a body", name));
+
+			/* drop the stub a declaration is built with; only ENTRY and the parameters stay */
+			for (const auto stub = dest_body->nodes(); Node *node: stub)
+			{
+				if (node->ir_type == NodeType::ENTRY || node->ir_type == NodeType::PARAM)
+					continue;
+				for (Node *input: node->inputs)
+				{
+					if (input)
+						erase(input->users, node);
+				}
+				dest_body->remove(node);
+			}
+			dest_fn->traits = src_fn->traits;
+		}
+
+		NodeMap local;
+		for (std::size_t i = 0; i < src_fn->inputs.size() && i < dest_fn->inputs.size(); ++i)
+			local.emplace(src_fn->inputs[i], dest_fn->inputs[i]);
+
+		/* first every node is created so forward references, jumps to later
+		 * regions and values flowing into nested regions all have a target */
+		std::vector<std::pair<const Node *, Node *> > created;
+		std::vector<std::pair<Region *, Region *> > worklist = { { src_body, dest_body } };
+		while (!worklist.empty())
+		{
+			const auto [src_region, dest_region] = worklist.back();
+			worklist.pop_back();
+
+			for (Node *node: src_region->nodes())
+			{
+				if (node->ir_type == NodeType::ENTRY)
+				{
+					local.emplace(node, dest_region->entry());
+					continue;
+				}
+				if (local.contains(node))
+					continue;
+
+				Node *copy = shell(from, node);
+				dest_region->append(copy);
+				local.emplace(node, copy);
+				created.emplace_back(node, copy);
+			}
+
+			for (Region *child: src_region->children())
+				worklist.emplace_back(child, dest.create_region(child->name(), dest_region));
+		}
+
+		/* then connected, which may import callees, globals and types */
+		for (const auto &[node, copy]: created)
+		{
+			copy->value = import_value(from, node->value, local);
+			dest.intern_t(copy);
+			for (Node *input: node->inputs)
+			{
+				Node *mapped = input ? resolve(from, input, local, false) : nullptr;
+				copy->inputs.push_back(mapped);
+				if (mapped)
+					mapped->users.push_back(copy);
+			}
+		}
+	}
+
+	Node *Linker::import_global(Module &from, Node *node)
+	{
+		if (const auto it = globals.find(node); it != globals.end())
+			return it->second;
+
+		const bool readonly = node->parent == from.rodata();
+		Region *section = readonly ? dest.rodata() : dest.root();
+
+		/* named globals are shared by name, like functions */
+		if (!readonly && node->str_id != 0)
+		{
+			const StringTable::StringId id = remap(from, node->str_id);
+			for (Node *candidate: section->nodes())
+			{
+				if (candidate->ir_type == node->ir_type && candidate->str_id == id)
+				{
+					globals.emplace(node, candidate);
+					return candidate;
+				}
+			}
+		}
+
+		Node *copy = shell(from, node);
+		section->append(copy);
+		globals.emplace(node, copy);
+
+		copy->value = import_value(from, node->value, {});
+		dest.intern_t(copy);
+		for (Node *input: node->inputs)
+		{
+			Node *mapped = input ? resolve(from, input, {}, false) : nullptr;
+			copy->inputs.push_back(mapped);
+			if (mapped)
+				mapped->users.push_back(copy);
+		}
+		return copy;
+	}
+
+	Node *Linker::carrier(Module &from, Node *node)
+	{
+		if (const auto it = globals.find(node); it != globals.end())
+			return it->second;
+
+		/* detached nodes only describe a type, e.g. the pointee of a pointer */
+		Node *copy = shell(from, node);
+		globals.emplace(node, copy);
+		copy->value = import_value(from, node->value, {});
+		dest.intern_t(copy);
+		return copy;
+	}
+
+	Node *Linker::resolve(Module &from, Node *node, const NodeMap &local, const bool type_only)
+	{
+		if (const auto it = local.find(node); it != local.end())
+			return it->second;
+
+		if (node->ir_type == NodeType::FUNCTION && node->parent == from.root())
+		{
+			if (declared && !functions.contains(node) && !has(node, NodeTraits::EXTERN) && declared(node))
+				return declare(node);
+			return import_function(node);
+		}
+		if (!node->parent)
+			return carrier(from, node);
+		if (node->parent == from.root() || node->parent == from.rodata())
+			return import_global(from, node);
+
+		/* a pointer may name a value of another function for its type alone */
+		if (type_only)
+			return carrier(from, node);
+
+		throw LinkError(std::string(from.name()),
+		                std::format("a node of '{}' uses a value of another function", from.name()));
+	}
+
+	Node *Linker::shell(Module &from, const Node *node)
+	{
+		ach::shared_allocator<Node> alloc;
+		Node *copy = std::construct_at(alloc.allocate(1));
+		copy->ir_type = node->ir_type;
+		copy->type_kind = node->type_kind;
+		copy->traits = node->traits;
+		copy->str_id = remap(from, node->str_id);
+		return copy;
+	}
+
+	TypedData Linker::import_value(Module &from, const TypedData &value, const NodeMap &local)
+	{
+		switch (value.type())
+		{
+			case DataType::STRUCT:
+				return import_struct(from, value);
+			case DataType::ARRAY:
+			{
+				TypedData copy = value;
+				for (Node *&element: copy.get<DataType::ARRAY>().elements)
+				{
+					if (element)
+						element = resolve(from, element, local, true);
+				}
+				return copy;
+			}
+			case DataType::POINTER:
+			{
+				TypedData copy = value;
+				if (Node *&pointee = copy.get<DataType::POINTER>().pointee)
+					pointee = resolve(from, pointee, local, true);
+				return copy;
+			}
+			case DataType::FUNCTION:
+			{
+				TypedData copy = value;
+				/* the copy owns its own return type already */
+				if (TypedData *ret = copy.get<DataType::FUNCTION>().return_type)
+					*ret = import_value(from, *ret, local);
+				return copy;
+			}
+			default:
+				return value;
+		}
+	}
+
+	TypedData Linker::import_struct(Module &from, const TypedData &type)
+	{
+		const auto &data = type.get<DataType::STRUCT>();
+		if (const auto it = structs.find(data.fields.data()); it != structs.end())
+			return it->second;
+
+		/* nested structs are rebuilt first since the context interns them by identity */
+		std::vector<TypeContext::Field> fields;
+		fields.reserve(data.fields.size());
+		for (const auto &[name, kind, field_type]: data.fields)
+			fields.emplace_back(remap(from, name), kind, import_value(from, field_type, {}));
+
+		TypedData rebuilt = dest.types().struct_t(remap(from, data.name), fields, data.alignment);
+		structs.emplace(data.fields.data(), rebuilt);
+		return rebuilt;
+	}
+
+	StringTable::StringId Linker::remap(Module &from, const StringTable::StringId id)
+	{
+		return dest.intern_str(from.strtable().get(id));
+	}
+
+	std::string Linker::private_name(Module &from, const std::string_view name) const
+	{
+		const auto taken = [&](const std::string &candidate)
+		{
+			return dest_fns.contains(candidate) || exports.contains(candidate);
+		};
+
+		std::string candidate(name);
+		if (!taken(candidate))
+			return candidate;
+
+		candidate = std::format("{}.{}", name, from.name());
+		for (std::size_t n = 1; taken(candidate); ++n)
+			candidate = std::format("{}.{}.{}", name, from.name(), n);
+		return candidate;
+	}
+
+	void Linker::check_signature(Module &from, const Node *src_fn, const Node *dest_fn) const
+	{
+		bool same = src_fn->inputs.size() == dest_fn->inputs.size();
+		for (std::size_t i = 0; same && i < src_fn->inputs.size(); ++i)
+			same = src_fn->inputs[i]->type_kind == dest_fn->inputs[i]->type_kind;
+
+		const TypedData *src_ret = return_type(src_fn);
+		const TypedData *dest_ret = return_type(dest_fn);
+		if (src_ret && dest_ret)
+			same = same && src_ret->type() == dest_ret->type();
+
+		if (!same)
+		{
+			const std::string name(dest.strtable().get(dest_fn->str_id));
+			throw LinkError(name, std::format("signature of '{}' in '{}' does not match '{}'", name, from.name(),
+			                                  dest.name()));
+		}
+	}
+}
@@ -1,15 +1,55 @@
 /* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <unordered_set>
+#include <utility>
 #include <arc/foundation/module.hpp>
 #include <arc/foundation/region.hpp>
+#include <arc/support/allocator.hpp>
 
 namespace arc
 {
-	Module::Module(std::string_view name)
+	namespace
 	{
-		/* note: the allocator share the same thread local storage
-		 * the point of declaring both is specifically for semantics */
-		ach::allocator<Region> region_alloc;
+		/* shared by every module so epochs are unique across modules */
+		std::atomic<std::uint64_t> clock = 0;
+
+		/* past this many entries the journal is dropped and older epochs fall back to a full rescan */
+		constexpr std::size_t journal_limit = 1 << 16;
+
+		std::uint64_t tick()
+		{
+			return clock.fetch_add(1, std::memory_order_relaxed) + 1;
+		}
+
+		/* back to a default node, keeping the edge buffers for whoever gets it next */
+		void recycle(Node *node)
+		{
+			node->inputs.clear();
+			node->users.clear();
+			node->parent = nullptr;
+			node->ir_type = NodeType::ENTRY;
+			node->traits = NodeTraits::NONE;
+			node->value = TypedData();
+			node->type_kind = DataType::VOID;
+			node->str_id = {};
+			node->type_id = TypeContext::invalid;
+		}
+	}
+
+	void mark_dirty(Node *node)
+	{
+		if (node && node->parent)
+			node->parent->module().touch(node);
+	}
+
+	Module::Module(std::string_view name) : generation(tick()), floor(generation)
+	{
+		/* shared, since a module may be built on one thread and freed on another
+		 * after the first has exited and taken its thread local pools with it */
+		ach::shared_allocator<Region> region_alloc;
 		auto* root_mem = region_alloc.allocate(1);
 		root_region = std::construct_at(root_mem, ".__global", *this, nullptr);
 		regions.push_back(root_region);
@@ -20,7 +60,31 @@ namespace arc
 		mod_id = strtb.intern(name);
 	}
 
-	Module::~Module() = default;
+	Module::~Module()
+	{
+		/* the module owns every node placed in one of its regions, every function
+		 * it lists and every node handed back through `retire`; a node may be
+		 * several of these at once but is freed once */
+		std::unordered_set<Node *> owned(free_nodes.begin(), free_nodes.end());
+		owned.insert(retired.begin(), retired.end());
+		owned.insert(fns.begin(), fns.end());
+		for (const Region *region: regions)
+			owned.insert(region->nodes().begin(), region->nodes().end());
+
+		ach::shared_allocator<Node> alloc;
+		for (Node *node: owned)
+		{
+			std::destroy_at(node);
+			alloc.deallocate(node, 1);
+		}
+
+		ach::shared_allocator<Region> region_alloc;
+		for (Region *region: regions)
+		{
+			std::destroy_at(region);
+			region_alloc.deallocate(region, 1);
+		}
+	}
 
 	std::string_view Module::name() const
 	{
@@ -37,7 +101,7 @@ namespace arc
 		if (!parent)
 			parent = root_region;
 
-		ach::allocator<Region> region_alloc;
+		ach::shared_allocator<Region> region_alloc;
 		auto* mem = region_alloc.allocate(1);
 		auto* region = std::construct_at(mem, name, *this, parent);
 		regions.push_back(region);
@@ -56,6 +120,34 @@ namespace arc
 		return nullptr;
 	}
 
+	Region *Module::body(const Node *fn) const
+	{
+		if (!fn)
+			return nullptr;
+
+		const std::string_view name = strtb.get(fn->str_id);
+		for (Region *child: root()->children())
+		{
+			if (child->name() == name)
+				return child;
+		}
+		return nullptr;
+	}
+
+	std::unordered_map<std::string_view, Region *> Module::bodies() const
+	{
+		std::unordered_map<std::string_view, Region *> by_name;
+		for (Region *child: root()->children())
+			by_name.try_emplace(child->name(), child);
+		return by_name;
+	}
+
+	Region *Module::open_body(Node *fn)
+	{
+		load_body(fn, BodyUse::WALK);
+		return body(fn);
+	}
+
 	void Module::add_fn(Node *fn)
 	{
 		if (!fn || fn->ir_type != NodeType::FUNCTION)
@@ -65,6 +157,29 @@ namespace arc
 			fns.push_back(fn);
 	}
 
+	Module::BodyLoader Module::lazy_bodies(BodyLoader loader)
+	{
+		std::lock_guard lock(loader_mutex);
+		return std::exchange(body_loader, std::move(loader));
+	}
+
+	bool Module::load_body(Node *fn, const BodyUse use)
+	{
+		if (!fn || fn->ir_type != NodeType::FUNCTION || (fn->traits & NodeTraits::EXTERN) == NodeTraits::NONE)
+			return false;
+
+		/* checked again, another thread may have loaded it while this one waited */
+		std::lock_guard lock(loader_mutex);
+		if ((fn->traits & NodeTraits::EXTERN) == NodeTraits::NONE)
+			return false;
+		return body_loader && body_loader(fn, use);
+	}
+
+	const ColdStore *Module::cold_store() const
+	{
+		return cold;
+	}
+
 	void Module::add_rodata(Node *node)
 	{
 		if (!node)
@@ -106,15 +221,45 @@ namespace arc
 		return strtb;
 	}
 
+	const StringTable &Module::strtable() const
+	{
+		return strtb;
+	}
+
+	TypeContext &Module::types()
+	{
+		return type_ctx;
+	}
+
+	DataLayout &Module::layout()
+	{
+		return data_layout;
+	}
+
 	const TypedData &Module::add_t(const std::string& name, TypedData tdef)
 	{
 		if (typedefs.contains(name))
 			throw std::runtime_error("type '" + name + "' already defined");
 
+		/* typedefs share the canonical descriptor so the registry never holds
+		 * a second copy of a struct's fields */
+		const DataType kind = tdef.type();
+		if (kind == DataType::STRUCT || kind == DataType::ARRAY || kind == DataType::FUNCTION || kind == DataType::VECTOR)
+			tdef = type_ctx.get(type_ctx.intern(tdef));
+
 		auto [it, inserted] = typedefs.emplace(name, std::move(tdef));
 		return it->second;
 	}
 
+	TypeContext::TypeId Module::intern_t(Node *node)
+	{
+		const DataType kind = node->value.type();
+		const bool composite = kind == DataType::STRUCT || kind == DataType::ARRAY ||
+		                       kind == DataType::FUNCTION || kind == DataType::VECTOR;
+		node->type_id = composite ? type_ctx.intern(node->value) : TypeContext::invalid;
+		return node->type_id;
+	}
+
 	TypedData& Module::at_t(std::string_view name)
 	{
 		const auto it = typedefs.find(std::string(name));
@@ -127,4 +272,164 @@ namespace arc
 	{
 		return typedefs;
 	}
+
+	std::uint64_t Module::checkpoint()
+	{
+		std::lock_guard lock(journal_mutex);
+		const std::uint64_t epoch = generation;
+		generation = tick();
+		return epoch;
+	}
+
+	void Module::touch(Node *node)
+	{
+		if (!node)
+			return;
+
+		std::lock_guard lock(journal_mutex);
+		if (node->parent)
+			node->parent->stamp.store(generation, std::memory_order_relaxed);
+		record({ node, nullptr, generation });
+	}
+
+	void Module::touch(Region *region)
+	{
+		if (!region)
+			return;
+
+		std::lock_guard lock(journal_mutex);
+		region->stamp.store(generation, std::memory_order_relaxed);
+		record({ nullptr, region, generation });
+	}
+
+	void Module::forget(const std::vector<Node *> &nodes)
+	{
+		if (nodes.empty())
+			return;
+
+		const std::unordered_set<const Node *> freed(nodes.begin(), nodes.end());
+		std::lock_guard lock(journal_mutex);
+		std::erase_if(journal, [&](const Change &change) { return freed.contains(change.node); });
+	}
+
+	ChangeSet Module::changes_since(const std::uint64_t epoch) const
+	{
+		ChangeSet changes;
+		std::lock_guard lock(journal_mutex);
+		if (epoch < floor || epoch > generation)
+			return changes;
+
+		changes.complete = true;
+		std::unordered_set<const void *> seen;
+		for (auto it = std::ranges::upper_bound(journal, epoch, {}, &Change::generation); it != journal.end(); ++it)
+		{
+			if (it->node && seen.insert(it->node).second)
+				changes.nodes.push_back(it->node);
+			else if (it->region && seen.insert(it->region).second)
+				changes.regions.push_back(it->region);
+		}
+		return changes;
+	}
+
+	void Module::record(const Change &change)
+	{
+		/* nobody holds an epoch of this generation yet, so there is no one to tell */
+		if (generation == floor)
+			return;
+
+		if (journal.size() >= journal_limit)
+		{
+			journal.clear();
+			floor = generation;
+			return;
+		}
+		journal.push_back(change);
+	}
+
+	Node *Module::create_node(const NodeType type, const DataType kind)
+	{
+		Node *node = nullptr;
+		{
+			std::lock_guard lock(pool_mutex);
+			if (!free_nodes.empty())
+			{
+				node = free_nodes.back();
+				free_nodes.pop_back();
+			}
+		}
+
+		if (!node)
+		{
+			ach::shared_allocator<Node> alloc;
+			node = std::construct_at(alloc.allocate(1));
+		}
+		node->ir_type = type;
+		node->type_kind = kind;
+		return node;
+	}
+
+	void Module::retire(Node *node)
+	{
+		if (!node)
+			return;
+
+		std::lock_guard lock(pool_mutex);
+		retired.push_back(node);
+	}
+
+	std::size_t Module::reclaim()
+	{
+		std::vector<Node *> pending;
+		{
+			std::lock_guard lock(pool_mutex);
+			if (retired.empty())
+				return 0;
+			pending = std::move(retired);
+			retired.clear();
+		}
+
+		/* a node retired twice or placed again since is not ours to free */
+		std::unordered_set<const Node *> waiting;
+		std::erase_if(pending, [&](const Node *node) { return node->parent || !waiting.insert(node).second; });
+
+		/* a retired node is only garbage once nothing uses it; freeing one
+		 * drops it from its inputs, which may free retired inputs in turn */
+		std::vector<Node *> worklist;
+		for (Node *node: pending)
+		{
+			if (node->users.empty())
+				worklist.push_back(node);
+		}
+
+		std::vector<Node *> dead;
+		while (!worklist.empty())
+		{
+			Node *node = worklist.back();
+			worklist.pop_back();
+			if (!waiting.erase(node))
+				continue;
+
+			for (Node *input: node->inputs)
+			{
+				if (!input)
+					continue;
+				if (const auto it = std::ranges::find(input->users, node); it != input->users.end())
+					input->users.erase(it);
+				if (input->users.empty() && waiting.contains(input))
+					worklist.push_back(input);
+			}
+			dead.push_back(node);
+		}
+		std::erase_if(pending, [&](const Node *node) { return !waiting.contains(node); });
+
+		forget(dead);
+		for (Node *node: dead)
+			recycle(node);
+
+		std::lock_guard lock(pool_mutex);
+		free_nodes.insert(free_nodes.end(), dead.begin(), dead.end());
+		/* still in use by a detached node that may be retired later */
+		retired.insert(retired.end(), pending.begin(), pending.end());
+		return dead.size();
+	}
 }
@@ -0,0 +1,359 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <format>
+#include <map>
+#include <numeric>
+#include <thread>
+#include <arc/analysis/block-frequency.hpp>
+#include <arc/foundation/linker.hpp>
+#include <arc/foundation/partition.hpp>
+#include <arc/foundation/region.hpp>
+
+namespace arc
+{
+	namespace
+	{
+		/* functions a node refers to, as a call target, an operand or through a pointer */
+		template<typename F>
+		void referenced_functions(const Node *node, const Region *root, F &&visit)
+		{
+			const auto check = [&](const Node *ref)
+			{
+				if (ref && ref->ir_type == NodeType::FUNCTION && ref->parent == root)
+					visit(ref);
+			};
+
+			for (const Node *input: node->inputs)
+				check(input);
+			if (node->value.type() == DataType::POINTER)
+				check(node->value.get<DataType::POINTER>().pointee);
+			else if (node->value.type() == DataType::ARRAY)
+			{
+				for (const Node *element: node->value.get<DataType::ARRAY>().elements)
+					check(element);
+			}
+		}
+
+		std::size_t find(std::vector<std::size_t> &leader, std::size_t i)
+		{
+			while (leader[i] != i)
+			{
+				leader[i] = leader[leader[i]];
+				i = leader[i];
+			}
+			return i;
+		}
+	}
+
+	Partitioner::Partitioner(Module &module, const PartitionConfig config, const BlockFrequencyResult *frequencies)
+		: module(module), config(config)
+	{
+		std::size_t count = config.partitions;
+		if (count == 0)
+			count = std::max(1u, std::thread::hardware_concurrency());
+
+		collect(frequencies);
+		cluster(count);
+		refine(count);
+		finalize();
+	}
+
+	const std::vector<std::vector<Node *> > &Partitioner::partitions() const
+	{
+		return parts;
+	}
+
+	std::ptrdiff_t Partitioner::partition_of(const Node *fn) const
+	{
+		const auto it = index.find(fn);
+		return it == index.end() ? -1 : static_cast<std::ptrdiff_t>(assignment[it->second]);
+	}
+
+	double Partitioner::cut_weight() const
+	{
+		double cut = 0.0;
+		for (const auto &[a, b, weight]: edges)
+		{
+			if (assignment[a] != assignment[b])
+				cut += weight;
+		}
+		return cut;
+	}
+
+	std::vector<std::unique_ptr<Module> > Partitioner::split() const
+	{
+		std::vector<std::unique_ptr<Module> > modules;
+		modules.reserve(parts.size());
+
+		for (std::size_t p = 0; p < parts.size(); ++p)
+		{
+			auto part = std::make_unique<Module>(std::format("{}.part{}", module.name(), p));
+			Linker linker(*part);
+			linker.add(module).declare_if([&](const Node *fn)
+			{
+				const auto it = index.find(fn);
+				return it != index.end() && assignment[it->second] != p;
+			});
+
+			for (Node *fn: parts[p])
+			{
+				Node *copy = linker.import(fn);
+				if (promoted.contains(std::string(module.strtable().get(fn->str_id))))
+					copy->traits |= NodeTraits::EXPORT;
+			}
+
+			/* declarations nothing calls would otherwise be lost */
+			if (p == 0)
+			{
+				for (Node *fn: module.functions())
+				{
+					if (fn->ir_type == NodeType::FUNCTION && (fn->traits & NodeTraits::EXTERN) != NodeTraits::NONE)
+						linker.import(fn);
+				}
+			}
+			modules.push_back(std::move(part));
+		}
+		return modules;
+	}
+
+	std::unique_ptr<Module> Partitioner::merge(std::vector<std::unique_ptr<Module> > &parts) const
+	{
+		auto merged = std::make_unique<Module>(module.name());
+		Linker linker(*merged);
+		for (const std::unique_ptr<Module> &part: parts)
+			linker.add(*part);
+
+		/* functions come back in the order of the source module rather than
+		 * partition by partition, so the result does not depend on how many
+		 * partitions there were */
+		std::vector<Node *> ordered;
+		ordered.reserve(functions.size());
+		for (std::size_t i = 0; i < functions.size(); ++i)
+		{
+			if (assignment[i] >= parts.size() || !parts[assignment[i]])
+				continue;
+			Module &part = *parts[assignment[i]];
+			if (Node *fn = part.find_fn(module.strtable().get(functions[i]->str_id));
+			    fn && (fn->traits & NodeTraits::EXTERN) == NodeTraits::NONE)
+				ordered.push_back(fn);
+		}
+		linker.import(ordered);
+		linker.link();
+
+		for (Node *fn: merged->functions())
+		{
+			if (promoted.contains(std::string(merged->strtable().get(fn->str_id))))
+				fn->traits &= ~NodeTraits::EXPORT;
+		}
+		return merged;
+	}
+
+	std::unique_ptr<Module> Partitioner::run(const Pipeline &pipeline) const
+	{
+		std::vector<std::unique_ptr<Module> > modules = split();
+		std::vector<std::exception_ptr> errors(modules.size());
+		std::vector<std::thread> workers;
+		workers.reserve(modules.size());
+
+		/* partitions share nothing, so each one is compiled on its own thread */
+		for (std::size_t i = 0; i < modules.size(); ++i)
+		{
+			workers.emplace_back([&, i]
+			{
+				try
+				{
+					pipeline(*modules[i]);
+				}
+				catch (...)
+				{
+					errors[i] = std::current_exception();
+				}
+			});
+		}
+
+		for (std::thread &worker: workers)
+			worker.join();
+
+		for (const std::exception_ptr &error: errors)
+		{
+			if (error)
+				std::rethrow_exception(error);
+		}
+		return merge(modules);
+	}
+
+	void Partitioner::collect(const BlockFrequencyResult *frequencies)
+	{
+		for (Node *fn: module.functions())
+		{
+			if (fn->ir_type != NodeType::FUNCTION || (fn->traits & NodeTraits::EXTERN) != NodeTraits::NONE)
+				continue;
+			index.emplace(fn, functions.size());
+			functions.push_back(fn);
+		}
+
+		sizes.assign(functions.size(), 0);
+		std::map<std::pair<std::size_t, std::size_t>, double> weights; /* ordered, so edges come out deterministic */
+		const auto bodies = module.bodies();
+		for (std::size_t i = 0; i < functions.size(); ++i)
+		{
+			const auto body = bodies.find(module.strtable().get(functions[i]->str_id));
+			if (body == bodies.end())
+				continue;
+
+			body->second->walk_dominated_regions([&](Region *region)
+			{
+				for (const Node *node: region->nodes())
+				{
+					++sizes[i];
+					referenced_functions(node, module.root(), [&](const Node *target)
+					{
+						const auto it = index.find(target);
+						if (it == index.end() || it->second == i)
+							return;
+
+						double weight = 1.0;
+						if (frequencies)
+							weight = frequencies->frequency(region).value_or(1.0f);
+						weights[{ i, it->second }] += weight;
+					});
+				}
+			});
+		}
+
+		edges.reserve(weights.size());
+		for (const auto &[pair, weight]: weights)
+			edges.push_back({ pair.first, pair.second, weight });
+	}
+
+	void Partitioner::cluster(const std::size_t count)
+	{
+		assignment.assign(functions.size(), 0);
+		if (functions.empty() || count <= 1)
+			return;
+
+		/* calls in both directions count towards keeping a pair together */
+		std::map<std::pair<std::size_t, std::size_t>, double> combined;
+		for (const auto &[a, b, weight]: edges)
+			combined[std::minmax(a, b)] += weight;
+
+		std::vector<Edge> order;
+		order.reserve(combined.size());
+		for (const auto &[pair, weight]: combined)
+			order.push_back({ pair.first, pair.second, weight });
+		std::ranges::stable_sort(order, std::greater {}, &Edge::weight);
+
+		/* clusters are capped at the mean so they can still be spread evenly */
+		const std::size_t total = std::accumulate(sizes.begin(), sizes.end(), std::size_t {});
+		const std::size_t cap = std::max(*std::ranges::max_element(sizes), (total + count - 1) / count);
+
+		std::vector<std::size_t> leader(functions.size());
+		std::iota(leader.begin(), leader.end(), 0);
+		std::vector<std::size_t> cluster_size = sizes;
+		for (const auto &[a, b, weight]: order)
+		{
+			const std::size_t ra = find(leader, a);
+			const std::size_t rb = find(leader, b);
+			if (ra == rb || cluster_size[ra] + cluster_size[rb] > cap)
+				continue;
+
+			leader[std::max(ra, rb)] = std::min(ra, rb);
+			cluster_size[std::min(ra, rb)] += cluster_size[std::max(ra, rb)];
+		}
+
+		/* largest clusters first, each into the least loaded partition */
+		std::vector<std::size_t> roots;
+		for (std::size_t i = 0; i < functions.size(); ++i)
+		{
+			if (find(leader, i) == i)
+				roots.push_back(i);
+		}
+		std::ranges::stable_sort(roots, std::greater {}, [&](const std::size_t root) { return cluster_size[root]; });
+
+		std::vector<std::size_t> loads(count, 0);
+		std::vector<std::size_t> cluster_part(functions.size(), 0);
+		for (const std::size_t root: roots)
+		{
+			const std::size_t target = std::ranges::min_element(loads) - loads.begin();
+			cluster_part[root] = target;
+			loads[target] += cluster_size[root];
+		}
+
+		for (std::size_t i = 0; i < functions.size(); ++i)
+			assignment[i] = cluster_part[find(leader, i)];
+	}
+
+	void Partitioner::refine(const std::size_t count)
+	{
+		if (functions.empty() || count <= 1)
+			return;
+
+		std::vector<std::vector<std::pair<std::size_t, double> > > adjacent(functions.size());
+		for (const auto &[a, b, weight]: edges)
+		{
+			adjacent[a].emplace_back(b, weight);
+			adjacent[b].emplace_back(a, weight);
+		}
+
+		const std::size_t total = std::accumulate(sizes.begin(), sizes.end(), std::size_t {});
+		const auto limit = static_cast<std::size_t>(std::ceil(static_cast<double>(total) / count * config.imbalance));
+
+		std::vector<std::size_t> loads(count, 0);
+		for (std::size_t i = 0; i < functions.size(); ++i)
+			loads[assignment[i]] += sizes[i];
+
+		/* greedy boundary moves; each one strictly lowers the cut, so this terminates */
+		std::vector<double> connection(count);
+		for (std::size_t round = 0; round < config.refine_rounds; ++round)
+		{
+			bool moved = false;
+			for (std::size_t i = 0; i < functions.size(); ++i)
+			{
+				std::ranges::fill(connection, 0.0);
+				for (const auto &[other, weight]: adjacent[i])
+					connection[assignment[other]] += weight;
+
+				const std::size_t from = assignment[i];
+				std::size_t best = from;
+				for (std::size_t p = 0; p < count; ++p)
+				{
+					if (p != from && connection[p] > connection[best] && loads[p] + sizes[i] <= limit)
+						best = p;
+				}
+				if (best == from)
+					continue;
+
+				loads[from] -= sizes[i];
+				loads[best] += sizes[i];
+				assignment[i] = best;
+				moved = true;
+			}
+			if (!moved)
+				break;
+		}
+	}
+
+	void Partitioner::finalize()
+	{
+		/* drop empty partitions and number the rest densely, in order of first function */
+		std::unordered_map<std::size_t, std::size_t> renumber;
+		for (std::size_t i = 0; i < functions.size(); ++i)
+		{
+			const auto [it, inserted] = renumber.try_emplace(assignment[i], parts.size());
+			if (inserted)
+				parts.emplace_back();
+			assignment[i] = it->second;
+			parts[it->second].push_back(functions[i]);
+		}
+
+		for (const auto &[caller, callee, weight]: edges)
+		{
+			const Node *fn = functions[callee];
+			if (assignment[caller] != assignment[callee] && (fn->traits & NodeTraits::EXPORT) == NodeTraits::NONE)
+				promoted.emplace(module.strtable().get(fn->str_id));
+		}
+	}
+}
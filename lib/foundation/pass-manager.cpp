@@ -1,11 +1,16 @@
 /* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
 
+#include <algorithm>
 #include <exception>
 #include <format>
+#include <optional>
+#include <utility>
+#include <arc/foundation/cold-store.hpp>
 #include <arc/foundation/module.hpp>
 #include <arc/foundation/pass-manager.hpp>
 #include <arc/foundation/region.hpp>
 #include <arc/foundation/taskgraph.hpp>
+#include <arc/support/perf-counters.hpp>
 
 namespace arc
 {
@@ -34,19 +39,49 @@ namespace arc
 
 	void PassManager::run(Module& module)
 	{
+		/* the store rehydrates whatever it still holds if a pass throws */
+		std::optional<ColdStore> cold;
+		if (eviction.budget > 0)
+			cold.emplace(module, eviction.medium);
+		ColdStore* store = cold ? &*cold : nullptr;
+		verifier.reset();
+
 		if (execution_batches.empty())
 		{
 			/* standard sequential execution for manually added passes */
-			run_sequential(module);
+			run_sequential(module, store);
 		}
 		else
 		{
 			/* batch execution from TaskGraph */
-			if (exec_policy == ExecutionPolicy::PARALLEL)
-				run_parallel(module);
+			if (exec_policy == ExecutionPolicy::SEQUENTIAL)
+				run_sequential(module, store);
 			else
-				run_sequential(module);
+				run_parallel(module, store);
 		}
+
+		/* analyses cached since the evictions saw declarations where the bodies are back now */
+		if (store && store->rehydrate_all() > 0)
+			refresh_analyses(module);
+		verifier.reset();
+	}
+
+	PassManager& PassManager::verify(const VerifyMode mode)
+	{
+		verify_mode = mode;
+		return *this;
+	}
+
+	PassManager& PassManager::profile(PerfProfile& profile)
+	{
+		perf_profile = &profile;
+		return *this;
+	}
+
+	PassManager& PassManager::memory_budget(const EvictionPolicy& policy)
+	{
+		eviction = policy;
+		return *this;
 	}
 
 	bool PassManager::has_analysis(const std::string& name) const
@@ -66,36 +101,104 @@ namespace arc
 		 * when thread lifetime ends anyway so we just clear the map */
 		std::unique_lock lock(analyses_mutex);
 		analyses.clear();
+		stale_analyses.clear();
 	}
 
-	void PassManager::run_sequential(Module& module)
+	void PassManager::run_sequential(Module& module, ColdStore* cold)
 	{
+		/* nodes retired by one pass are recycled before the next one starts
+		 * unless a cached analysis may still refer to them; whatever the last
+		 * pass retired stays valid for the caller until the module's next safe point */
+		bool first = true;
+		const auto step = [&](Pass* pass)
+		{
+			if (!std::exchange(first, false))
+				safe_point(module, cold);
+			execute_single_pass(pass, module);
+		};
+
 		if (!execution_batches.empty())
 		{
 			for (const auto& batch : execution_batches)
 			{
 				for (Pass* pass : batch)
-					execute_single_pass(pass, module);
+					step(pass);
 			}
 		}
 		else
 		{
 			for (Pass* pass : passes)
-				execute_single_pass(pass, module);
+				step(pass);
 		}
 	}
 
-	void PassManager::run_parallel(Module& module)
+	void PassManager::run_parallel(Module& module, ColdStore* cold)
 	{
+		/* passes of a batch run side by side, so only the boundaries between batches are safe points */
+		bool first = true;
 		for (const auto& batch : execution_batches)
 		{
+			if (!std::exchange(first, false))
+				safe_point(module, cold);
+
 			if (batch.size() == 1)
 				execute_single_pass(batch[0], module);
+			else if (exec_policy == ExecutionPolicy::DETERMINISTIC)
+				execute_ordered(batch, module);
 			else
 				execute_batch(batch, module);
 		}
 	}
 
+	void PassManager::safe_point(Module& module, ColdStore* cold)
+	{
+		/* a recycled node can come back under the same address with other facts,
+		 * so retired nodes wait while an analysis cached across their removal is */
+		{
+			std::shared_lock lock(analyses_mutex);
+			if (!stale_analyses.empty())
+				return;
+		}
+		module.reclaim();
+		if (!cold)
+			return;
+
+		/* computing such an analysis again would bring back whatever was evicted */
+		const std::vector<AnalysisPass*> cached = cached_analyses();
+		if (std::ranges::any_of(cached, &AnalysisPass::loads_bodies))
+			return;
+
+		/* evicting frees nodes as well; analyses computed since may point into the bodies */
+		if (cold->enforce(eviction) > 0)
+			refresh_analyses(module);
+	}
+
+	std::vector<AnalysisPass*> PassManager::cached_analyses() const
+	{
+		std::vector<AnalysisPass*> cached;
+		std::shared_lock lock(analyses_mutex);
+		for (const auto& [pass_name, result_name] : pass_to_result)
+		{
+			const auto it = pass_registry.find(pass_name);
+			if (it != pass_registry.end() && analyses.contains(result_name))
+			{
+				if (auto* analysis = dynamic_cast<AnalysisPass*>(it->second))
+					cached.push_back(analysis);
+			}
+		}
+		return cached;
+	}
+
+	void PassManager::refresh_analyses(Module& module)
+	{
+		const std::vector<AnalysisPass*> cached = cached_analyses();
+
+		/* passes after this point still find the analyses they require */
+		clear_analyses();
+		for (AnalysisPass* analysis : cached)
+			run_analysis(analysis, module);
+	}
+
 	void PassManager::execute_single_pass(Pass* pass, Module& module)
 	{
 		validate_dependencies(pass);
@@ -135,6 +238,10 @@ namespace arc
 					}
 					else if (auto* transform = dynamic_cast<TransformPass*>(pass))
 					{
+						/* counters follow the thread they were opened on, so each worker opens its own */
+						std::optional<PerfProfile::Scope> scope;
+						if (perf_profile)
+							scope.emplace(*perf_profile, transform->name());
 						worker_data[i].modified_regions = transform->run(module, *this);
 					}
 				}
@@ -155,14 +262,41 @@ namespace arc
 			if (exception)
 				std::rethrow_exception(exception);
 
-			if (!modified_regions.empty())
+			if (const auto* transform = dynamic_cast<TransformPass*>(pass))
 			{
-				if (const auto* transform = dynamic_cast<TransformPass*>(pass))
+				verify_transform(transform, module, modified_regions);
+				journal_transform(transform, module, modified_regions);
+				if (!modified_regions.empty())
 					invalidate_analyses(modified_regions, transform->invalidates());
+				mark_stale_analyses();
 			}
 		}
 	}
 
+	void PassManager::execute_ordered(const std::vector<Pass*>& batch, Module& module)
+	{
+		/* analyses only read the module, so they still run side by side; transforms
+		 * of one batch may touch the same functions, and taking turns in a fixed
+		 * order is what keeps their output identical from run to run */
+		std::vector<Pass*> analyses;
+		std::vector<Pass*> transforms;
+		for (Pass* pass : batch)
+		{
+			if (dynamic_cast<AnalysisPass*>(pass))
+				analyses.push_back(pass);
+			else
+				transforms.push_back(pass);
+		}
+
+		if (analyses.size() > 1)
+			execute_batch(analyses, module);
+		else if (!analyses.empty())
+			execute_single_pass(analyses.front(), module);
+
+		for (Pass* pass : transforms)
+			execute_single_pass(pass, module);
+	}
+
 	void PassManager::invalidate_analyses(const std::vector<Region*>& modified_regions,
 									  const std::vector<std::string>& invalidated_analyses)
 	{
@@ -183,6 +317,7 @@ namespace arc
 			if (!analysis)
 			{
 				analyses.erase(analysis_it);
+				stale_analyses.erase(result_name);
 				continue;
 			}
 
@@ -191,6 +326,7 @@ namespace arc
 			 * from the cache entirely */
 			if (!analysis->update(modified_regions))
 			{
+				stale_analyses.erase(result_name);
 				analyses.erase(analysis_it);
 				pass_to_result.erase(mapping_it); /* also remove mapping */
 			}
@@ -239,7 +375,15 @@ namespace arc
 				return;
 		}
 
-		if (Analysis* result = analysis->run(module))
+		Analysis* result = nullptr;
+		{
+			std::optional<PerfProfile::Scope> scope;
+			if (perf_profile)
+				scope.emplace(*perf_profile, pass_name);
+			result = analysis->run(module);
+		}
+
+		if (result)
 		{
 			std::unique_lock lock(analyses_mutex); /* OK for single writer */
 			analyses[result->name()] = result;
@@ -255,10 +399,58 @@ namespace arc
 
 	void PassManager::run_transform(TransformPass* transform, Module& module)
 	{
-		if (const std::vector<Region*> modified_regions = transform->run(module, *this);
-		   !modified_regions.empty())
+		std::vector<Region*> modified_regions;
 		{
-			invalidate_analyses(modified_regions, transform->invalidates());
+			std::optional<PerfProfile::Scope> scope;
+			if (perf_profile)
+				scope.emplace(*perf_profile, transform->name());
+			modified_regions = transform->run(module, *this);
 		}
+		verify_transform(transform, module, modified_regions);
+		journal_transform(transform, module, modified_regions);
+
+		if (!modified_regions.empty())
+			invalidate_analyses(modified_regions, transform->invalidates());
+		mark_stale_analyses();
+	}
+
+	void PassManager::mark_stale_analyses()
+	{
+		/* whatever is still cached was computed before the transform and may
+		 * name nodes it retired */
+		std::unique_lock lock(analyses_mutex);
+		for (const auto& [result_name, analysis] : analyses)
+			stale_analyses.insert(result_name);
+	}
+
+	void PassManager::journal_transform(const TransformPass* transform, Module& module,
+	                                    const std::vector<Region*>& modified_regions)
+	{
+		/* edits of passes that write nodes directly are only known per region */
+		if (transform->tracks_changes())
+			return;
+		for (Region* region : modified_regions)
+			module.touch(region);
+	}
+
+	void PassManager::verify_transform(const TransformPass* transform, Module& module,
+	                                   const std::vector<Region*>& modified_regions)
+	{
+		if (verify_mode == VerifyMode::NONE)
+			return;
+
+		/* a transform that reports nothing modified is trusted in MODIFIED mode */
+		if (!verifier)
+			verifier.emplace(module);
+		std::vector<Diagnostic> found = verify_mode == VerifyMode::FULL
+			                                ? verifier->verify()
+			                                : verifier->verify(modified_regions);
+		if (found.empty())
+			return;
+
+		std::string what = std::format("pass '{}' produced invalid IR: {}", transform->name(), found.front().message);
+		if (found.size() > 1)
+			what += std::format(" (and {} more)", found.size() - 1);
+		throw VerificationError(what, std::move(found));
 	}
 }
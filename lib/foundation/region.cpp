@@ -11,10 +11,7 @@ namespace arc
 	Region::Region(const std::string_view name, Module &mod, Region *parent) : mod(mod), prnt(parent)
 	{
 		region_id = mod.intern_str(name);
-		ach::allocator<Node> a;
-		Node *n = a.allocate(1);
-		std::construct_at(n);
-		n->ir_type = NodeType::ENTRY;
+		Node *n = mod.create_node(NodeType::ENTRY);
 		n->parent = this;
 		ns.push_back(n);
 	}
@@ -41,6 +38,11 @@ namespace arc
 		return mod;
 	}
 
+	std::uint64_t Region::modified() const
+	{
+		return stamp.load(std::memory_order_relaxed);
+	}
+
 	void Region::add_child(Region *child)
 	{
 		if (!child || std::ranges::find(childs, child) != childs.end())
@@ -71,6 +73,7 @@ namespace arc
 			else
 				ns.push_back(node);
 			node->parent = this;
+			mod.touch(node);
 		}
 	}
 
@@ -82,6 +85,7 @@ namespace arc
 		auto it = std::ranges::find(ns, node);
 		if (it != ns.end())
 		{
+			mod.touch(node); /* while it still stamps this region */
 			ns.erase(it);
 			node->parent = nullptr;
 		}
@@ -114,6 +118,7 @@ namespace arc
 			else
 				ns.insert(it, node);
 			node->parent = this;
+			mod.touch(node);
 		}
 	}
 
@@ -130,6 +135,7 @@ namespace arc
 
 			ns.insert(it + 1, node);
 			node->parent = this;
+			mod.touch(node);
 		}
 	}
 
@@ -146,6 +152,7 @@ namespace arc
 		else
 			ns.insert(ns.begin(), node);
 		node->parent = this;
+		mod.touch(node);
 	}
 
 	bool Region::is_terminated() const
@@ -294,9 +301,11 @@ namespace arc
 			return false;
 
 		/* replace in node list */
+		mod.touch(old_n);
 		*it = new_n;
 		new_n->parent = this;
 		old_n->parent = nullptr;
+		mod.touch(new_n);
 
 		if (rewire)
 		{
@@ -312,6 +321,7 @@ namespace arc
 							new_n->users.push_back(user);
 					}
 				}
+				mark_dirty(user);
 			}
 
 			/* transfer inputs from old_n to new_n if new_n has none */
@@ -330,6 +340,7 @@ namespace arc
 					}
 					else
 						input_users.push_back(new_n);
+					mark_dirty(input);
 				}
 			}
 
@@ -384,6 +395,13 @@ namespace arc
 			child->walk_dominated_regions(visitor);
 	}
 
+	std::vector<Region *> Region::dominated_regions() const
+	{
+		std::vector<Region *> order;
+		walk_dominated_regions([&](Region *region) { order.push_back(region); });
+		return order;
+	}
+
 	bool Region::can_reach(Region *target) const
 	{
 		if (!target)
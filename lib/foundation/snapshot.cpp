@@ -0,0 +1,115 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <format>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <arc/foundation/region.hpp>
+#include <arc/foundation/snapshot.hpp>
+
+namespace arc
+{
+	ModuleSnapshot::ModuleSnapshot(std::unique_ptr<Module> module) : base(std::move(module))
+	{
+		if (!base)
+			throw std::invalid_argument("cannot snapshot a null module");
+	}
+
+	const Module &ModuleSnapshot::module() const
+	{
+		return *base;
+	}
+
+	std::unique_ptr<ModuleVariant> ModuleSnapshot::fork(const std::string_view name) const
+	{
+		return std::make_unique<ModuleVariant>(*this, name);
+	}
+
+	ModuleVariant::ModuleVariant(const ModuleSnapshot &snapshot, const std::string_view name) : origin(snapshot),
+		mod(std::make_unique<Module>(name.empty() ? snapshot.base->name() : name)), linker(*mod)
+	{
+		std::lock_guard lock(origin.mutex);
+		Module &base = *origin.base;
+
+		std::vector<Node *> fns;
+		for (Node *fn: base.functions())
+		{
+			if (fn->ir_type == NodeType::FUNCTION)
+				fns.push_back(fn);
+		}
+
+		/* every function is declared before anything is copied, so callees met
+		 * while copying a body or a global bind to their declarations */
+		linker.add(base).declare_if([](const Node *) { return true; });
+		const std::vector<Node *> declarations = linker.declare(fns);
+		for (std::size_t i = 0; i < fns.size(); ++i)
+		{
+			if ((fns[i]->traits & NodeTraits::EXTERN) == NodeTraits::NONE)
+				sources.emplace(declarations[i], fns[i]);
+		}
+		linker.import_globals();
+
+		/* a function is copied out when a pass walks into it or looks into it as a callee */
+		mod->lazy_bodies([this](Node *fn, BodyUse)
+		{
+			if (!shared(fn))
+				return false;
+			return materialize_if([fn](const Node *candidate) { return candidate == fn; }) == 1;
+		});
+	}
+
+	Module &ModuleVariant::module()
+	{
+		return *mod;
+	}
+
+	bool ModuleVariant::shared(const Node *fn) const
+	{
+		return sources.contains(fn);
+	}
+
+	std::size_t ModuleVariant::shared_count() const
+	{
+		return sources.size();
+	}
+
+	Node *ModuleVariant::materialize(const std::string_view name)
+	{
+		Node *fn = mod->find_fn(name);
+		if (!fn)
+			throw std::invalid_argument(std::format("variant '{}' has no function '{}'", mod->name(), name));
+
+		materialize_if([fn](const Node *candidate) { return candidate == fn; });
+		return fn;
+	}
+
+	std::size_t ModuleVariant::materialize_if(const std::function<bool(const Node *)> &predicate)
+	{
+		/* picked in module order so the copies do not depend on how the map is laid out */
+		std::vector<Node *> picked;
+		std::vector<Node *> originals;
+		for (Node *fn: mod->functions())
+		{
+			if (const auto it = sources.find(fn); it != sources.end() && predicate(fn))
+			{
+				picked.push_back(fn);
+				originals.push_back(it->second);
+			}
+		}
+		if (picked.empty())
+			return 0;
+
+		{
+			std::lock_guard lock(origin.mutex);
+			linker.import(originals);
+		}
+		for (const Node *fn: picked)
+			sources.erase(fn);
+		return picked.size();
+	}
+
+	std::size_t ModuleVariant::materialize_all()
+	{
+		return materialize_if([](const Node *) { return true; });
+	}
+}
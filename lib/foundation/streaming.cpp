@@ -0,0 +1,219 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <arc/foundation/linker.hpp>
+#include <arc/foundation/pass-manager.hpp>
+#include <arc/foundation/streaming.hpp>
+
+namespace arc
+{
+	StreamingCompiler::StreamingCompiler(Module &dest, const StreamingConfig config) : dest(dest), config(config)
+	{
+		if (this->config.workers == 0)
+			this->config.workers = std::max(1u, std::thread::hardware_concurrency());
+		if (this->config.queue_depth == 0)
+			this->config.queue_depth = this->config.workers * 2;
+	}
+
+	StreamingCompiler::~StreamingCompiler()
+	{
+		stop();
+	}
+
+	StreamingCompiler &StreamingCompiler::function_passes(Configure configure)
+	{
+		function_config = std::move(configure);
+		return *this;
+	}
+
+	StreamingCompiler &StreamingCompiler::module_passes(Configure configure)
+	{
+		module_config = std::move(configure);
+		return *this;
+	}
+
+	StreamingCompiler &StreamingCompiler::sink(Sink sink)
+	{
+		unit_sink = std::move(sink);
+		return *this;
+	}
+
+	std::unique_ptr<Module> StreamingCompiler::unit(const std::string_view name) const
+	{
+		return std::make_unique<Module>(name);
+	}
+
+	void StreamingCompiler::submit(std::unique_ptr<Module> unit)
+	{
+		if (!unit)
+			throw std::invalid_argument("unit cannot be null");
+
+		std::unique_lock lock(mutex);
+		if (closing)
+			throw std::logic_error("cannot submit to a finished streaming compiler");
+		if (workers.empty())
+			start();
+
+		slot_free.wait(lock, [this] { return in_flight < config.queue_depth; });
+		queue.push_back({ next_seq++, std::move(unit) });
+		++in_flight;
+		work_ready.notify_one();
+	}
+
+	void StreamingCompiler::finish()
+	{
+		if (closed)
+			return;
+
+		stop();
+		closed = true;
+		if (error)
+			std::rethrow_exception(std::exchange(error, nullptr));
+
+		if (module_config)
+		{
+			PassManager pm;
+			module_config(pm);
+			pm.run(dest);
+		}
+	}
+
+	std::size_t StreamingCompiler::submitted() const
+	{
+		std::lock_guard lock(mutex);
+		return next_seq;
+	}
+
+	void StreamingCompiler::start()
+	{
+		workers.reserve(config.workers);
+		for (std::size_t i = 0; i < config.workers; ++i)
+			workers.emplace_back(&StreamingCompiler::work, this);
+	}
+
+	void StreamingCompiler::stop()
+	{
+		{
+			std::lock_guard lock(mutex);
+			closing = true;
+		}
+		work_ready.notify_all();
+
+		for (std::thread &worker: workers)
+			worker.join();
+		workers.clear();
+	}
+
+	void StreamingCompiler::work()
+	{
+		for (;;)
+		{
+			Job job;
+			{
+				std::unique_lock lock(mutex);
+				work_ready.wait(lock, [this] { return closing || !queue.empty(); });
+				if (queue.empty())
+					return;
+				job = std::move(queue.front());
+				queue.pop_front();
+			}
+
+			try
+			{
+				if (function_config)
+				{
+					PassManager pm;
+					function_config(pm);
+					pm.run(*job.unit);
+				}
+				if (unit_sink)
+					unit_sink(*job.unit);
+			}
+			catch (...)
+			{
+				std::lock_guard lock(mutex);
+				if (!error)
+					error = std::current_exception();
+				job.unit.reset(); /* still takes its turn, so later units are not held back */
+			}
+
+			{
+				std::lock_guard lock(mutex);
+				finished.emplace(job.seq, std::move(job.unit));
+			}
+			link_ready();
+		}
+	}
+
+	void StreamingCompiler::link_ready()
+	{
+		/* whichever worker holds the next unit in submission order links it and any that queued up behind it */
+		std::lock_guard link_lock(link_mutex);
+		for (;;)
+		{
+			std::unique_ptr<Module> unit;
+			{
+				std::lock_guard lock(mutex);
+				const auto it = finished.find(next_link);
+				if (it == finished.end())
+					return;
+				unit = std::move(it->second);
+				finished.erase(it);
+				++next_link;
+			}
+
+			if (unit && config.retain)
+			{
+				try
+				{
+					link(*unit);
+				}
+				catch (...)
+				{
+					std::lock_guard lock(mutex);
+					if (!error)
+						error = std::current_exception();
+				}
+			}
+			/* the destination holds its own copy now; the unit's regions and nodes go with it */
+			unit.reset();
+
+			{
+				std::lock_guard lock(mutex);
+				--in_flight;
+			}
+			slot_free.notify_all();
+		}
+	}
+
+	void StreamingCompiler::link(Module &unit)
+	{
+		/* every unit shares one namespace, so private definitions are exported
+		 * for the linker to match them with declarations, then made private again */
+		std::vector<Node *> definitions;
+		std::vector<Node *> promoted;
+		for (Node *fn: unit.functions())
+		{
+			if (fn->ir_type != NodeType::FUNCTION || (fn->traits & NodeTraits::EXTERN) != NodeTraits::NONE)
+				continue;
+			definitions.push_back(fn);
+			if ((fn->traits & NodeTraits::EXPORT) == NodeTraits::NONE)
+			{
+				fn->traits |= NodeTraits::EXPORT;
+				promoted.push_back(fn);
+			}
+		}
+
+		Linker linker(dest);
+		linker.add(unit);
+		for (Node *fn: definitions)
+		{
+			Node *copy = linker.import(fn);
+			if (std::ranges::find(promoted, fn) != promoted.end())
+				copy->traits &= ~NodeTraits::EXPORT;
+		}
+	}
+}
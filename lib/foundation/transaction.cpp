@@ -0,0 +1,332 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/foundation/transaction.hpp>
+#include <arc/support/allocator.hpp>
+
+namespace arc
+{
+	namespace
+	{
+		/* node placed just before `node` in its region, which is where it goes back to */
+		Node *predecessor(const Region *region, const Node *node)
+		{
+			const std::vector<Node *> &ns = region->nodes();
+			const auto it = std::ranges::find(ns, node);
+			return it == ns.end() || it == ns.begin() ? nullptr : *(it - 1);
+		}
+
+		void restore(Region *region, Node *node, Node *prev)
+		{
+			if (prev)
+				region->insert_after(prev, node);
+			else
+				region->insert(node);
+		}
+	}
+
+	Transaction::~Transaction()
+	{
+		rollback();
+	}
+
+	Node *Transaction::create(const NodeType type, const DataType kind)
+	{
+		ach::shared_allocator<Node> alloc;
+		Node *node = std::construct_at(alloc.allocate(1));
+		node->ir_type = type;
+		node->type_kind = kind;
+		log.push_back({ node, nullptr, nullptr, 0, Op::CREATE });
+		return node;
+	}
+
+	Node *Transaction::clone(const Node *node)
+	{
+		/* fields of a node the transaction created need no logging; rollback frees it */
+		Node *copy = create(node->ir_type, node->type_kind);
+		copy->value = node->value;
+		copy->traits = node->traits;
+		copy->str_id = node->str_id;
+		copy->type_id = node->type_id;
+		return copy;
+	}
+
+	void Transaction::append(Region *region, Node *node)
+	{
+		place(region, node, nullptr, false);
+	}
+
+	void Transaction::insert_before(Node *before, Node *node)
+	{
+		if (before && before->parent)
+			place(before->parent, node, before, true);
+	}
+
+	void Transaction::insert_after(Node *after, Node *node)
+	{
+		if (after && after->parent)
+			place(after->parent, node, after, false);
+	}
+
+	void Transaction::remove(Node *node)
+	{
+		if (!node || !node->parent)
+			return;
+
+		Region *region = node->parent;
+		log.push_back({ node, region, predecessor(region, node), 0, Op::UNPLACE });
+		region->remove(node);
+	}
+
+	void Transaction::erase(Node *node)
+	{
+		if (!node)
+			return;
+
+		for (std::size_t i = node->inputs.size(); i-- > 0;)
+		{
+			Node *input = node->inputs[i];
+			log.push_back({ node, input, nullptr, static_cast<std::uint32_t>(i), Op::INPUT_ERASE });
+			node->inputs.erase(node->inputs.begin() + i);
+			if (input)
+				erase_user(input, node);
+		}
+		remove(node);
+	}
+
+	void Transaction::connect(Node *user, Node *input)
+	{
+		if (!user)
+			return;
+
+		log.push_back({ user, nullptr, nullptr, static_cast<std::uint32_t>(user->inputs.size()), Op::INPUT_INSERT });
+		user->inputs.push_back(input);
+		mark_dirty(user);
+		if (input)
+			insert_user(input, user);
+	}
+
+	void Transaction::set_input(Node *user, const std::size_t index, Node *input)
+	{
+		if (!user || index >= user->inputs.size())
+			return;
+
+		Node *old = user->inputs[index];
+		if (old == input)
+			return;
+
+		log.push_back({ user, old, nullptr, static_cast<std::uint32_t>(index), Op::INPUT_SET });
+		user->inputs[index] = input;
+		mark_dirty(user);
+		if (old)
+			erase_user(old, user);
+		if (input)
+			insert_user(input, user);
+	}
+
+	std::size_t Transaction::replace_all_uses(Node *from, Node *to)
+	{
+		if (!from || from == to)
+			return 0;
+
+		std::vector<Node *> users(from->users.begin(), from->users.end());
+		std::ranges::sort(users);
+		const auto [first, last] = std::ranges::unique(users);
+		users.erase(first, last);
+
+		std::size_t replaced = 0;
+		for (Node *user: users)
+		{
+			for (std::size_t i = 0; i < user->inputs.size(); ++i)
+			{
+				if (user->inputs[i] != from)
+					continue;
+				set_input(user, i, to);
+				++replaced;
+			}
+		}
+		return replaced;
+	}
+
+	void Transaction::set_value(Node *node, TypedData value)
+	{
+		log.push_back({ node, nullptr, nullptr, static_cast<std::uint32_t>(values.size()), Op::VALUE });
+		values.push_back(std::move(node->value));
+		node->value = std::move(value);
+		if (node->parent)
+			node->parent->module().intern_t(node);
+		mark_dirty(node);
+	}
+
+	void Transaction::set_type(Node *node, const DataType kind)
+	{
+		log.push_back({ node, nullptr, nullptr, static_cast<std::uint32_t>(node->type_kind), Op::TYPE });
+		node->type_kind = kind;
+		mark_dirty(node);
+	}
+
+	void Transaction::set_traits(Node *node, const NodeTraits traits)
+	{
+		log.push_back({ node, nullptr, nullptr, static_cast<std::uint32_t>(node->traits), Op::TRAITS });
+		node->traits = traits;
+		mark_dirty(node);
+	}
+
+	std::size_t Transaction::mark() const
+	{
+		return log.size();
+	}
+
+	void Transaction::rollback(const std::size_t mark)
+	{
+		while (log.size() > mark)
+		{
+			undo(log.back());
+			log.pop_back();
+		}
+		release();
+	}
+
+	void Transaction::commit()
+	{
+		log.clear();
+		values.clear();
+		departed.clear();
+	}
+
+	std::size_t Transaction::size() const
+	{
+		return log.size();
+	}
+
+	bool Transaction::empty() const
+	{
+		return log.empty();
+	}
+
+	void Transaction::place(Region *region, Node *node, Node *anchor, const bool before)
+	{
+		if (!region || !node)
+			return;
+
+		/* leave the old spot first; the region helpers would otherwise keep a
+		 * node that is already in the target region where it was */
+		Region *old = node->parent;
+		log.push_back({ node, old, old ? predecessor(old, node) : nullptr, 0, Op::PLACE });
+		if (old)
+			old->remove(node);
+
+		if (!anchor)
+			region->append(node);
+		else if (before)
+			region->insert_before(anchor, node);
+		else
+			region->insert_after(anchor, node);
+	}
+
+	void Transaction::insert_user(Node *node, Node *user)
+	{
+		log.push_back({ node, nullptr, nullptr, static_cast<std::uint32_t>(node->users.size()), Op::USER_INSERT });
+		node->users.push_back(user);
+		mark_dirty(node);
+	}
+
+	void Transaction::erase_user(Node *node, const Node *user)
+	{
+		const auto it = std::ranges::find(node->users, user);
+		if (it == node->users.end())
+			return;
+
+		const auto index = static_cast<std::uint32_t>(it - node->users.begin());
+		log.push_back({ node, *it, nullptr, index, Op::USER_ERASE });
+		node->users.erase(it);
+		mark_dirty(node);
+	}
+
+	void Transaction::undo(const Entry &entry)
+	{
+		Node *node = entry.node;
+		switch (entry.op)
+		{
+			case Op::CREATE:
+				if (node->parent)
+					node->parent->remove(node);
+				freed.push_back(node);
+				return;
+			case Op::PLACE:
+				if (node->parent)
+				{
+					if (!entry.a)
+						departed.emplace_back(&node->parent->module(), node);
+					node->parent->remove(node);
+				}
+				if (entry.a)
+					restore(static_cast<Region *>(entry.a), node, static_cast<Node *>(entry.b));
+				return;
+			case Op::UNPLACE:
+				restore(static_cast<Region *>(entry.a), node, static_cast<Node *>(entry.b));
+				return;
+			case Op::INPUT_SET:
+				node->inputs[entry.index] = static_cast<Node *>(entry.a);
+				break;
+			case Op::INPUT_INSERT:
+				node->inputs.erase(node->inputs.begin() + entry.index);
+				break;
+			case Op::INPUT_ERASE:
+				node->inputs.insert(node->inputs.begin() + entry.index, static_cast<Node *>(entry.a));
+				break;
+			case Op::USER_INSERT:
+				node->users.erase(node->users.begin() + entry.index);
+				break;
+			case Op::USER_ERASE:
+				node->users.insert(node->users.begin() + entry.index, static_cast<Node *>(entry.a));
+				break;
+			case Op::VALUE:
+				node->value = std::move(values[entry.index]);
+				values.resize(entry.index);
+				if (node->parent)
+					node->parent->module().intern_t(node);
+				break;
+			case Op::TYPE:
+				node->type_kind = static_cast<DataType>(entry.index);
+				break;
+			case Op::TRAITS:
+				node->traits = static_cast<NodeTraits>(entry.index);
+				break;
+		}
+		mark_dirty(node);
+	}
+
+	void Transaction::release()
+	{
+		if (freed.empty())
+			return;
+
+		/* a freed node may still be in the journal of the module it was placed
+		 * in; it has to leave the journal before its memory can be reused */
+		const std::unordered_set<Node *> gone(freed.begin(), freed.end());
+		std::unordered_map<Module *, std::vector<Node *> > journaled;
+		std::erase_if(departed, [&](const std::pair<Module *, Node *> &d)
+		{
+			if (!gone.contains(d.second))
+				return false;
+			journaled[d.first].push_back(d.second);
+			return true;
+		});
+		for (auto &[module, nodes]: journaled)
+			module->forget(nodes);
+
+		ach::shared_allocator<Node> alloc;
+		for (Node *node: freed)
+		{
+			std::destroy_at(node);
+			alloc.deallocate(node, 1);
+		}
+		freed.clear();
+	}
+}
@@ -0,0 +1,404 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <arc/foundation/node.hpp>
+#include <arc/foundation/type-context.hpp>
+
+namespace arc
+{
+	namespace
+	{
+		void mix(std::size_t &seed, const std::size_t value)
+		{
+			seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+		}
+
+		bool composite(const DataType type)
+		{
+			return type == DataType::STRUCT || type == DataType::ARRAY ||
+			       type == DataType::FUNCTION || type == DataType::VECTOR;
+		}
+
+		template<DataType T>
+		std::size_t hash_value(const TypedData &data)
+		{
+			const auto &value = data.get<T>();
+			std::size_t seed = 0;
+			unsigned char bytes[sizeof(value)];
+			std::memcpy(bytes, &value, sizeof(value));
+			for (const unsigned char byte: bytes)
+				mix(seed, byte);
+			return seed;
+		}
+
+		template<DataType T>
+		bool equal_value(const TypedData &lhs, const TypedData &rhs)
+		{
+			const auto &a = lhs.get<T>();
+			const auto &b = rhs.get<T>();
+			return std::memcmp(&a, &b, sizeof(a)) == 0;
+		}
+	}
+
+	TypedData TypeContext::struct_t(const StringTable::StringId name, const std::span<const Field> fields,
+	                                const std::uint32_t alignment)
+	{
+		std::unique_lock lock(mutex);
+		return entries[intern_struct(name, fields, alignment) - 1].type;
+	}
+
+	TypeContext::TypeId TypeContext::intern(const TypedData &type)
+	{
+		if (!composite(type.type()))
+			throw std::invalid_argument("only composite types can be interned");
+
+		/* most types are already known; only a new one needs the context alone */
+		{
+			std::shared_lock lock(mutex);
+			if (const TypeId id = find_unlocked(type); id != invalid)
+				return id;
+		}
+
+		std::unique_lock lock(mutex);
+		if (const TypeId id = find_unlocked(type); id != invalid)
+			return id;
+
+		if (type.type() == DataType::STRUCT)
+		{
+			/* a struct viewing another context's storage is copied in */
+			const auto &data = type.get<DataType::STRUCT>();
+			return intern_struct(data.name, { data.fields.begin(), data.fields.end() }, data.alignment);
+		}
+
+		/* the elements of an array value are not part of its type */
+		TypedData canonical = type;
+		if (canonical.type() == DataType::ARRAY)
+			canonical.get<DataType::ARRAY>().elements = {};
+
+		Entry &entry = append();
+		entry.hash = hash_of(canonical);
+		entry.type = std::move(canonical);
+
+		const auto id = static_cast<TypeId>(entries.size());
+		by_hash.emplace(entry.hash, id);
+		return id;
+	}
+
+	TypeContext::TypeId TypeContext::find(const TypedData &type) const
+	{
+		std::shared_lock lock(mutex);
+		return find_unlocked(type);
+	}
+
+	const TypedData &TypeContext::get(const TypeId id) const
+	{
+		std::shared_lock lock(mutex);
+		if (id == invalid || id > entries.size())
+			throw std::out_of_range("invalid type id " + std::to_string(id));
+		return entries[id - 1].type;
+	}
+
+	bool TypeContext::same(const TypedData &lhs, const TypedData &rhs) const
+	{
+		if (lhs.type() != rhs.type())
+			return false;
+		if (lhs.type() == DataType::STRUCT)
+			return lhs.get<DataType::STRUCT>() == rhs.get<DataType::STRUCT>() || equal(lhs, rhs);
+
+		std::shared_lock lock(mutex);
+		const TypeId id = find_unlocked(lhs);
+		return id != invalid ? id == find_unlocked(rhs) : equal(lhs, rhs);
+	}
+
+	bool TypeContext::owns(const Field *fields) const
+	{
+		std::shared_lock lock(mutex);
+		return fields && by_fields.contains(fields);
+	}
+
+	std::size_t TypeContext::size() const
+	{
+		std::shared_lock lock(mutex);
+		return entries.size();
+	}
+
+	TypeContext::Entry &TypeContext::append()
+	{
+		if (entries.size() >= std::numeric_limits<TypeId>::max())
+			throw std::length_error("type context holds more than " +
+			                        std::to_string(std::numeric_limits<TypeId>::max()) + " types");
+		return entries.emplace_back();
+	}
+
+	TypeContext::TypeId TypeContext::intern_struct(const StringTable::StringId name, const std::span<const Field> fields,
+	                                               const std::uint32_t alignment)
+	{
+		if (fields.size() > std::numeric_limits<std::uint8_t>::max())
+			throw std::length_error("struct has more than 255 fields");
+
+		/* probe with a view of the caller's fields; they are only copied
+		 * into the context if the struct is new */
+		DataTraits<DataType::STRUCT>::value probe = {};
+		probe.fields = { fields.data(), static_cast<std::uint8_t>(fields.size()) };
+		probe.alignment = alignment;
+		probe.name = name;
+
+		TypedData candidate;
+		candidate.set<decltype(probe), DataType::STRUCT>(probe);
+
+		const std::size_t hash = hash_of(candidate);
+		if (const TypeId id = lookup(candidate, hash); id != invalid)
+			return id;
+
+		Entry &entry = append();
+		entry.fields.assign(fields.begin(), fields.end());
+		entry.hash = hash;
+
+		probe.fields = { entry.fields.data(), static_cast<std::uint8_t>(entry.fields.size()) };
+		entry.type.set<decltype(probe), DataType::STRUCT>(probe);
+
+		const auto id = static_cast<TypeId>(entries.size());
+		by_hash.emplace(hash, id);
+		if (!entry.fields.empty())
+			by_fields.emplace(entry.fields.data(), id);
+		return id;
+	}
+
+	TypeContext::TypeId TypeContext::find_unlocked(const TypedData &type) const
+	{
+		if (!composite(type.type()))
+			return invalid;
+
+		if (type.type() == DataType::STRUCT)
+		{
+			/* structs of this context are found by their storage alone */
+			const auto &data = type.get<DataType::STRUCT>();
+			if (const auto it = by_fields.find(data.fields.data());
+				it != by_fields.end() && entries[it->second - 1].type.get<DataType::STRUCT>() == data)
+				return it->second;
+		}
+
+		return lookup(type, hash_of(type));
+	}
+
+	TypeContext::TypeId TypeContext::lookup(const TypedData &type, const std::size_t hash) const
+	{
+		auto [first, last] = by_hash.equal_range(hash);
+		for (; first != last; ++first)
+		{
+			if (equal(entries[first->second - 1].type, type))
+				return first->second;
+		}
+		return invalid;
+	}
+
+	std::size_t TypeContext::hash_of(const TypedData &type)
+	{
+		std::size_t seed = static_cast<std::size_t>(type.type());
+		switch (type.type())
+		{
+			case DataType::STRUCT:
+			{
+				const auto &data = type.get<DataType::STRUCT>();
+				mix(seed, data.name);
+				mix(seed, data.alignment);
+				for (const auto &[name_id, field_type, field_data]: data.fields)
+				{
+					mix(seed, name_id);
+					mix(seed, static_cast<std::size_t>(field_type));
+					mix(seed, hash_field(field_data));
+				}
+				break;
+			}
+			case DataType::ARRAY:
+			{
+				const auto &data = type.get<DataType::ARRAY>();
+				mix(seed, static_cast<std::size_t>(data.elem_type));
+				mix(seed, data.count);
+				break;
+			}
+			case DataType::VECTOR:
+			{
+				const auto &data = type.get<DataType::VECTOR>();
+				mix(seed, static_cast<std::size_t>(data.elem_type));
+				mix(seed, data.lane_count);
+				break;
+			}
+			case DataType::FUNCTION:
+			{
+				const auto &data = type.get<DataType::FUNCTION>();
+				mix(seed, data.return_type ? hash_of(*data.return_type) : 0);
+				break;
+			}
+			case DataType::POINTER:
+				mix(seed, hash_value<DataType::POINTER>(type));
+				break;
+
+#define ARC_TYPECTX_HASH(dt) \
+			case DataType::dt: \
+				mix(seed, hash_value<DataType::dt>(type)); \
+				break;
+
+			ARC_TYPECTX_HASH(BOOL)
+			ARC_TYPECTX_HASH(INT8)
+			ARC_TYPECTX_HASH(INT16)
+			ARC_TYPECTX_HASH(INT32)
+			ARC_TYPECTX_HASH(INT64)
+			ARC_TYPECTX_HASH(UINT8)
+			ARC_TYPECTX_HASH(UINT16)
+			ARC_TYPECTX_HASH(UINT32)
+			ARC_TYPECTX_HASH(UINT64)
+			ARC_TYPECTX_HASH(FLOAT32)
+			ARC_TYPECTX_HASH(FLOAT64)
+
+#undef ARC_TYPECTX_HASH
+
+			default:
+				break;
+		}
+		return seed;
+	}
+
+	bool TypeContext::equal(const TypedData &lhs, const TypedData &rhs)
+	{
+		if (lhs.type() != rhs.type())
+			return false;
+
+		switch (lhs.type())
+		{
+			case DataType::STRUCT:
+			{
+				const auto &a = lhs.get<DataType::STRUCT>();
+				const auto &b = rhs.get<DataType::STRUCT>();
+				if (a == b)
+					return true;
+				if (a.name != b.name || a.alignment != b.alignment || a.fields.size() != b.fields.size())
+					return false;
+
+				for (std::uint8_t i = 0; i < a.fields.size(); ++i)
+				{
+					const auto &[a_name, a_type, a_data] = a.fields[i];
+					const auto &[b_name, b_type, b_data] = b.fields[i];
+					if (a_name != b_name || a_type != b_type || !equal_field(a_data, b_data))
+						return false;
+				}
+				return true;
+			}
+			case DataType::ARRAY:
+			{
+				const auto &a = lhs.get<DataType::ARRAY>();
+				const auto &b = rhs.get<DataType::ARRAY>();
+				return a.elem_type == b.elem_type && a.count == b.count;
+			}
+			case DataType::VECTOR:
+			{
+				const auto &a = lhs.get<DataType::VECTOR>();
+				const auto &b = rhs.get<DataType::VECTOR>();
+				return a.elem_type == b.elem_type && a.lane_count == b.lane_count;
+			}
+			case DataType::FUNCTION:
+			{
+				const auto &a = lhs.get<DataType::FUNCTION>();
+				const auto &b = rhs.get<DataType::FUNCTION>();
+				if (!a.return_type || !b.return_type)
+					return a.return_type == b.return_type;
+				return equal(*a.return_type, *b.return_type);
+			}
+
+#define ARC_TYPECTX_EQUAL(dt) \
+			case DataType::dt: \
+				return equal_value<DataType::dt>(lhs, rhs);
+
+			ARC_TYPECTX_EQUAL(POINTER)
+			ARC_TYPECTX_EQUAL(BOOL)
+			ARC_TYPECTX_EQUAL(INT8)
+			ARC_TYPECTX_EQUAL(INT16)
+			ARC_TYPECTX_EQUAL(INT32)
+			ARC_TYPECTX_EQUAL(INT64)
+			ARC_TYPECTX_EQUAL(UINT8)
+			ARC_TYPECTX_EQUAL(UINT16)
+			ARC_TYPECTX_EQUAL(UINT32)
+			ARC_TYPECTX_EQUAL(UINT64)
+			ARC_TYPECTX_EQUAL(FLOAT32)
+			ARC_TYPECTX_EQUAL(FLOAT64)
+
+#undef ARC_TYPECTX_EQUAL
+
+			default:
+				return true;
+		}
+	}
+
+	std::size_t TypeContext::hash_field(const TypedData &field)
+	{
+		switch (field.type())
+		{
+			case DataType::STRUCT:
+				/* nested structs are already interned; their identity suffices */
+				return std::hash<const void *> {}(field.get<DataType::STRUCT>().fields.data());
+			case DataType::POINTER:
+			{
+				/* a pointer is typed by what it points to, not by the node carrying that */
+				const auto &ptr = field.get<DataType::POINTER>();
+				std::size_t seed = 0;
+				mix(seed, ptr.addr_space);
+				mix(seed, static_cast<std::size_t>(ptr.qualifier));
+				if (const Node *pointee = ptr.pointee)
+				{
+					mix(seed, static_cast<std::size_t>(pointee->type_kind));
+					if (pointee->value.type() == DataType::STRUCT)
+						mix(seed, std::hash<const void *> {}(pointee->value.get<DataType::STRUCT>().fields.data()));
+					else if (composite(pointee->value.type()))
+						mix(seed, hash_of(pointee->value));
+				}
+				return seed;
+			}
+			case DataType::ARRAY:
+			case DataType::VECTOR:
+			case DataType::FUNCTION:
+				return hash_of(field);
+			default:
+				/* a scalar field is typed by its DataType alone, whatever value it holds */
+				return 0;
+		}
+	}
+
+	bool TypeContext::equal_field(const TypedData &lhs, const TypedData &rhs)
+	{
+		if (lhs.type() != rhs.type())
+			return false;
+
+		switch (lhs.type())
+		{
+			case DataType::STRUCT:
+				return lhs.get<DataType::STRUCT>() == rhs.get<DataType::STRUCT>();
+			case DataType::POINTER:
+			{
+				const auto &a = lhs.get<DataType::POINTER>();
+				const auto &b = rhs.get<DataType::POINTER>();
+				if (a.addr_space != b.addr_space || a.qualifier != b.qualifier || !a.pointee != !b.pointee)
+					return false;
+				if (!a.pointee || a.pointee == b.pointee)
+					return true;
+				if (a.pointee->type_kind != b.pointee->type_kind)
+					return false;
+
+				const TypedData &a_value = a.pointee->value;
+				const TypedData &b_value = b.pointee->value;
+				if (!composite(a_value.type()) && !composite(b_value.type()))
+					return true;
+				return equal_field(a_value, b_value);
+			}
+			case DataType::ARRAY:
+			case DataType::VECTOR:
+			case DataType::FUNCTION:
+				return equal(lhs, rhs);
+			default:
+				return true;
+		}
+	}
+}
@@ -0,0 +1,406 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <format>
+#include <queue>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/foundation/verifier.hpp>
+#include <arc/support/inference.hpp>
+
+namespace arc
+{
+	namespace
+	{
+		bool is_terminator(const NodeType type)
+		{
+			return type == NodeType::RET || type == NodeType::JUMP ||
+			       type == NodeType::BRANCH || type == NodeType::INVOKE;
+		}
+
+		bool is_comparison(const NodeType type)
+		{
+			return type == NodeType::EQ || type == NodeType::NEQ ||
+			       type == NodeType::LT || type == NodeType::LTE ||
+			       type == NodeType::GT || type == NodeType::GTE;
+		}
+
+		bool is_arithmetic(const NodeType type)
+		{
+			switch (type)
+			{
+				case NodeType::ADD:
+				case NodeType::SUB:
+				case NodeType::MUL:
+				case NodeType::DIV:
+				case NodeType::MOD:
+				case NodeType::BAND:
+				case NodeType::BOR:
+				case NodeType::BXOR:
+				case NodeType::BSHL:
+				case NodeType::BSHR:
+					return true;
+				default:
+					return false;
+			}
+		}
+
+		/* the non-mutating half of `infer_binary_t`; the common type of both
+		 * operands or VOID if the builder would have rejected them */
+		DataType common_t(const Node *lhs, const Node *rhs)
+		{
+			const DataType lt = lhs->type_kind;
+			const DataType rt = rhs->type_kind;
+			if (lt == DataType::VECTOR || rt == DataType::VECTOR)
+			{
+				if (lt != rt || lhs->value.type() != DataType::VECTOR || rhs->value.type() != DataType::VECTOR)
+					return DataType::VOID;
+
+				const auto &lv = lhs->value.get<DataType::VECTOR>();
+				const auto &rv = rhs->value.get<DataType::VECTOR>();
+				return infer_primitive_types(lv.elem_type, rv.elem_type) == DataType::VOID ? DataType::VOID : DataType::VECTOR;
+			}
+
+			if (lt == rt)
+				return lt;
+			return infer_primitive_types(lt, rt);
+		}
+
+		template<typename T>
+		bool contains(const T &range, const Node *node)
+		{
+			return std::ranges::find(range, node) != range.end();
+		}
+	}
+
+	VerificationError::VerificationError(const std::string &what, std::vector<Diagnostic> diagnostics) :
+		std::runtime_error(what), diags(std::move(diagnostics)) {}
+
+	const std::vector<Diagnostic> &VerificationError::diagnostics() const
+	{
+		return diags;
+	}
+
+	Verifier::Verifier(Module &module) : mod(module) {}
+
+	std::vector<Diagnostic> Verifier::verify()
+	{
+		diags.clear();
+		preds.clear();
+		index();
+
+		std::queue<const Region *> worklist;
+		worklist.push(mod.root());
+		worklist.push(mod.rodata());
+		while (!worklist.empty())
+		{
+			const Region *region = worklist.front();
+			worklist.pop();
+
+			verify_region(region);
+			for (const Region *child: region->children())
+				worklist.push(child);
+		}
+
+		return std::move(diags);
+	}
+
+	std::vector<Diagnostic> Verifier::verify(const std::vector<Region *> &regions)
+	{
+		diags.clear();
+		preds.clear();
+		refresh(regions);
+
+		std::unordered_set<const Region *> seen;
+		for (const Region *region: regions)
+		{
+			if (region && seen.insert(region).second)
+				verify_region(region);
+		}
+
+		return std::move(diags);
+	}
+
+	void Verifier::check()
+	{
+		if (std::vector<Diagnostic> found = verify(); !found.empty())
+		{
+			std::string what = found.front().message;
+			if (found.size() > 1)
+				what += std::format(" (and {} more)", found.size() - 1);
+			throw VerificationError(what, std::move(found));
+		}
+	}
+
+	void Verifier::check(const std::vector<Region *> &regions)
+	{
+		if (std::vector<Diagnostic> found = verify(regions); !found.empty())
+		{
+			std::string what = found.front().message;
+			if (found.size() > 1)
+				what += std::format(" (and {} more)", found.size() - 1);
+			throw VerificationError(what, std::move(found));
+		}
+	}
+
+	void Verifier::index()
+	{
+		bodies.clear();
+
+		const auto by_name = mod.bodies();
+		for (Node *fn: mod.functions())
+		{
+			if (const auto it = by_name.find(mod.strtable().get(fn->str_id)); it != by_name.end())
+				bodies.emplace(it->second, fn);
+		}
+
+		indexed = true;
+		indexed_functions = mod.functions().size();
+		indexed_children = mod.root()->children().size();
+	}
+
+	void Verifier::refresh(const std::vector<Region *> &regions)
+	{
+		/* a function added or removed moves entries that were not handed to us */
+		if (!indexed || indexed_functions != mod.functions().size() ||
+		    indexed_children != mod.root()->children().size())
+			return index();
+
+		/* otherwise only a body whose FUNCTION node was replaced can be stale */
+		for (const Region *region: regions)
+		{
+			const auto it = region ? bodies.find(region) : bodies.end();
+			if (it == bodies.end())
+				continue;
+
+			if (const Node *fn = it->second;
+				fn->ir_type != NodeType::FUNCTION || mod.strtable().get(fn->str_id) != region->name())
+				return index();
+		}
+	}
+
+	void Verifier::verify_region(const Region *region)
+	{
+		const std::vector<Node *> &nodes = region->nodes();
+		if (nodes.empty() || !nodes.front() || nodes.front()->ir_type != NodeType::ENTRY)
+			report(region, nullptr, "region does not begin with an ENTRY node");
+
+		const Region *function = function_of(region);
+		bool has_code = false;
+		for (std::size_t i = 0; i < nodes.size(); ++i)
+		{
+			const Node *node = nodes[i];
+			if (!node)
+			{
+				report(region, nullptr, std::format("null node at position {}", i));
+				continue;
+			}
+
+			if (i > 0 && node->ir_type == NodeType::ENTRY)
+				report(region, node, "ENTRY node after the start of the region");
+			if (function && i + 1 < nodes.size() && is_terminator(node->ir_type))
+				report(region, node, "terminator before the end of the region");
+
+			has_code |= node->ir_type != NodeType::ENTRY && node->ir_type != NodeType::PARAM;
+			verify_node(region, node, function);
+		}
+
+		/* extern declarations and regions that only group their children have no code */
+		if (function && has_code)
+		{
+			const Node *fn = bodies.at(function);
+			if ((fn->traits & NodeTraits::EXTERN) == NodeTraits::NONE &&
+			    (!nodes.back() || !is_terminator(nodes.back()->ir_type)))
+				report(region, nodes.back(), "region does not end with a terminator");
+		}
+	}
+
+	void Verifier::verify_node(const Region *region, const Node *node, const Region *function)
+	{
+		if (node->parent != region)
+			report(region, node, "node's parent is not the region containing it");
+
+		for (const Node *input: node->inputs)
+		{
+			if (!input)
+			{
+				report(region, node, "null input");
+				continue;
+			}
+			if (!contains(input->users, node))
+				report(region, node, "input does not list the node as a user");
+			if (!input->parent)
+				report(region, node, "input was removed from its region");
+		}
+
+		for (const Node *user: node->users)
+		{
+			if (!user)
+			{
+				report(region, node, "null user");
+				continue;
+			}
+			/* removed users are dead and only their stale back edge remains */
+			if (user->parent && !contains(user->inputs, node))
+				report(region, node, "user does not list the node as an input");
+		}
+
+		verify_types(region, node);
+
+		switch (node->ir_type)
+		{
+			case NodeType::JUMP:
+				if (node->inputs.empty())
+					report(region, node, "JUMP without a target");
+				else
+					verify_target(region, node, node->inputs[0], function);
+				break;
+			case NodeType::BRANCH:
+			case NodeType::INVOKE:
+				if (node->inputs.size() < 3)
+				{
+					report(region, node, "BRANCH or INVOKE without both targets");
+					break;
+				}
+				verify_target(region, node, node->inputs[1], function);
+				verify_target(region, node, node->inputs[2], function);
+				break;
+			case NodeType::FROM:
+			{
+				if (node->inputs.empty())
+				{
+					report(region, node, "FROM without inputs");
+					break;
+				}
+				if (!function)
+					break;
+
+				/* one value per incoming edge; a region nothing jumps to is
+				 * entered from its parent and is not checked */
+				if (const auto &incoming = predecessors(function, region);
+					!incoming.empty() && node->inputs.size() > incoming.size())
+				{
+					report(region, node, std::format("FROM has more inputs ({}) than the region has predecessors ({})",
+					                                 node->inputs.size(), incoming.size()));
+				}
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	void Verifier::verify_types(const Region *region, const Node *node)
+	{
+		const NodeType type = node->ir_type;
+		if (is_arithmetic(type) || is_comparison(type))
+		{
+			if (node->inputs.size() != 2 || !node->inputs[0] || !node->inputs[1])
+				return report(region, node, "binary operation does not have two operands");
+
+			const Node *lhs = node->inputs[0];
+			const Node *rhs = node->inputs[1];
+			const DataType common = common_t(lhs, rhs);
+			if (common == DataType::VOID)
+				return report(region, node, "incompatible operand types");
+
+			if (is_comparison(type))
+			{
+				if (node->type_kind != DataType::BOOL)
+					report(region, node, "comparison does not produce BOOL");
+			}
+			/* shift amounts do not take part in the result type */
+			else if (node->type_kind != common &&
+			         !((type == NodeType::BSHL || type == NodeType::BSHR) && node->type_kind == lhs->type_kind))
+			{
+				report(region, node, "result type differs from the promoted operand type");
+			}
+		}
+		else if (type == NodeType::BNOT)
+		{
+			if (node->inputs.size() != 1 || !node->inputs[0])
+				return report(region, node, "BNOT does not have one operand");
+			if (node->inputs[0]->type_kind != node->type_kind)
+				report(region, node, "BNOT result type differs from its operand");
+		}
+		else if (type == NodeType::FROM)
+		{
+			for (const Node *input: node->inputs)
+			{
+				if (input && input->type_kind != node->type_kind &&
+				    infer_primitive_types(node->type_kind, input->type_kind) != node->type_kind)
+				{
+					report(region, node, "FROM input does not promote to the FROM type");
+				}
+			}
+		}
+	}
+
+	void Verifier::verify_target(const Region *region, const Node *node, const Node *target, const Region *function)
+	{
+		if (!target || target->ir_type != NodeType::ENTRY)
+			return report(region, node, "control flow does not target an ENTRY node");
+		if (!target->parent)
+			return report(region, node, "control flow targets a removed region entry");
+		if (function_of(target->parent) != function)
+			report(region, node, "control flow leaves the function");
+	}
+
+	const Region *Verifier::function_of(const Region *region) const
+	{
+		const Region *root = mod.root();
+		while (region && region->parent() && region->parent() != root)
+			region = region->parent();
+
+		if (!region || region->parent() != root)
+			return nullptr;
+		return bodies.contains(region) ? region : nullptr;
+	}
+
+	const std::unordered_set<const Region *> &Verifier::predecessors(const Region *function, const Region *region)
+	{
+		auto [it, inserted] = preds.try_emplace(function);
+		if (inserted)
+		{
+			/* only terminators create edges and they can only be last, so
+			 * building the edge map costs one node per region */
+			auto &edges = it->second;
+			std::queue<const Region *> worklist;
+			worklist.push(function);
+			while (!worklist.empty())
+			{
+				const Region *current = worklist.front();
+				worklist.pop();
+				for (const Region *child: current->children())
+					worklist.push(child);
+
+				const Node *last = current->nodes().empty() ? nullptr : current->nodes().back();
+				if (!last)
+					continue;
+
+				auto add = [&](const Node *target)
+				{
+					if (target && target->ir_type == NodeType::ENTRY && target->parent)
+						edges[target->parent].insert(current);
+				};
+
+				if (last->ir_type == NodeType::JUMP && !last->inputs.empty())
+					add(last->inputs[0]);
+				else if ((last->ir_type == NodeType::BRANCH || last->ir_type == NodeType::INVOKE) && last->inputs.size() >= 3)
+				{
+					add(last->inputs[1]);
+					add(last->inputs[2]);
+				}
+			}
+		}
+
+		static const std::unordered_set<const Region *> none;
+		const auto found = it->second.find(region);
+		return found != it->second.end() ? found->second : none;
+	}
+
+	void Verifier::report(const Region *region, const Node *node, std::string message)
+	{
+		diags.push_back({ node, region, std::format("region '{}': {}", region->name(), message) });
+	}
+}
@@ -0,0 +1,1881 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <unordered_set>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/interp/interpreter.hpp>
+#include <arc/support/algorithm.hpp>
+#include <arc/support/inference.hpp>
+
+namespace arc
+{
+	namespace
+	{
+		using Op = Interpreter::Opcode;
+		using Instruction = Interpreter::Instruction;
+
+		constexpr std::uint32_t NONE = std::numeric_limits<std::uint32_t>::max();
+		constexpr std::size_t max_host_args = 16;
+
+		/* slot normalization; see Value for the representation of each type */
+		constexpr std::uint64_t sx8(const std::uint64_t v)
+		{
+			return static_cast<std::uint64_t>(static_cast<std::int64_t>(static_cast<std::int8_t>(v)));
+		}
+
+		constexpr std::uint64_t sx16(const std::uint64_t v)
+		{
+			return static_cast<std::uint64_t>(static_cast<std::int64_t>(static_cast<std::int16_t>(v)));
+		}
+
+		constexpr std::uint64_t sx32(const std::uint64_t v)
+		{
+			return static_cast<std::uint64_t>(static_cast<std::int64_t>(static_cast<std::int32_t>(v)));
+		}
+
+		constexpr std::int64_t i64(const std::uint64_t v)
+		{
+			return static_cast<std::int64_t>(v);
+		}
+
+		constexpr std::uint32_t u32(const std::uint64_t v)
+		{
+			return static_cast<std::uint32_t>(v);
+		}
+
+		constexpr float f32(const std::uint64_t v)
+		{
+			return std::bit_cast<float>(static_cast<std::uint32_t>(v));
+		}
+
+		constexpr double f64(const std::uint64_t v)
+		{
+			return std::bit_cast<double>(v);
+		}
+
+		template<typename T>
+		constexpr std::uint64_t pack(const T v)
+		{
+			return Value(v).bits();
+		}
+
+		template<typename T, typename F>
+		std::uint64_t saturate(const F v)
+		{
+			/* float to integer conversion is undefined out of range in C++;
+			 * clamp like the conversion instructions of most targets do */
+			if (std::isnan(v))
+				return 0;
+			if (v <= static_cast<F>(std::numeric_limits<T>::min()))
+				return pack(std::numeric_limits<T>::min());
+			if (v >= static_cast<F>(std::numeric_limits<T>::max()))
+				return pack(std::numeric_limits<T>::max());
+			return pack(static_cast<T>(v));
+		}
+
+		std::byte *address(const std::uint64_t v)
+		{
+			return reinterpret_cast<std::byte *>(static_cast<std::uintptr_t>(v));
+		}
+
+		template<typename T>
+		T read(const std::byte *p)
+		{
+			T v;
+			std::memcpy(&v, p, sizeof(T));
+			return v;
+		}
+
+		template<typename T>
+		void write(std::byte *p, const T v)
+		{
+			std::memcpy(p, &v, sizeof(T));
+		}
+
+		/* lanes of a vector are packed at their natural size into the bytes of
+		 * consecutive slots; these convert between a lane and a scalar slot */
+		std::uint64_t load_lane(const DataType elem, const std::byte *p)
+		{
+			switch (elem)
+			{
+				case DataType::BOOL:
+					return read<std::uint8_t>(p) & 1;
+				case DataType::INT8:
+					return pack(read<std::int8_t>(p));
+				case DataType::INT16:
+					return pack(read<std::int16_t>(p));
+				case DataType::INT32:
+					return pack(read<std::int32_t>(p));
+				case DataType::UINT8:
+					return read<std::uint8_t>(p);
+				case DataType::UINT16:
+					return read<std::uint16_t>(p);
+				case DataType::UINT32:
+				case DataType::FLOAT32:
+					return read<std::uint32_t>(p);
+				default:
+					return read<std::uint64_t>(p);
+			}
+		}
+
+		void store_lane(const DataType elem, std::byte *p, const std::uint64_t v)
+		{
+			switch (elem_sz(elem))
+			{
+				case 1:
+					write(p, static_cast<std::uint8_t>(v));
+					break;
+				case 2:
+					write(p, static_cast<std::uint16_t>(v));
+					break;
+				case 4:
+					write(p, static_cast<std::uint32_t>(v));
+					break;
+				default:
+					write(p, v);
+					break;
+			}
+		}
+
+		template<typename T>
+		bool apply(const NodeType op, const T x, const T y, T &r)
+		{
+			if constexpr (std::is_floating_point_v<T>)
+			{
+				switch (op)
+				{
+					case NodeType::ADD:
+						r = x + y;
+						return true;
+					case NodeType::SUB:
+						r = x - y;
+						return true;
+					case NodeType::MUL:
+						r = x * y;
+						return true;
+					case NodeType::DIV:
+						r = x / y;
+						return true;
+					case NodeType::MOD:
+						r = std::fmod(x, y);
+						return true;
+					default:
+						return false;
+				}
+			}
+			else
+			{
+				/* wrap around in the unsigned type like the scalar operations do */
+				using U = std::make_unsigned_t<T>;
+				constexpr auto bits = static_cast<U>(sizeof(T) * 8 - 1);
+				switch (op)
+				{
+					case NodeType::ADD:
+						r = static_cast<T>(static_cast<U>(x) + static_cast<U>(y));
+						return true;
+					case NodeType::SUB:
+						r = static_cast<T>(static_cast<U>(x) - static_cast<U>(y));
+						return true;
+					case NodeType::MUL:
+						r = static_cast<T>(static_cast<U>(x) * static_cast<U>(y));
+						return true;
+					case NodeType::DIV:
+						if (y == 0 || (std::is_signed_v<T> && x == std::numeric_limits<T>::min() && y == static_cast<T>(-1)))
+							return false;
+						r = static_cast<T>(x / y);
+						return true;
+					case NodeType::MOD:
+						if (y == 0)
+							return false;
+						r = std::is_signed_v<T> && y == static_cast<T>(-1) ? T {} : static_cast<T>(x % y);
+						return true;
+					case NodeType::BAND:
+						r = static_cast<T>(x & y);
+						return true;
+					case NodeType::BOR:
+						r = static_cast<T>(x | y);
+						return true;
+					case NodeType::BXOR:
+						r = static_cast<T>(x ^ y);
+						return true;
+					case NodeType::BNOT:
+						r = static_cast<T>(~x);
+						return true;
+					case NodeType::BSHL:
+						r = static_cast<T>(static_cast<U>(x) << (static_cast<U>(y) & bits));
+						return true;
+					case NodeType::BSHR:
+						r = static_cast<T>(x >> (static_cast<U>(y) & bits));
+						return true;
+					default:
+						return false;
+				}
+			}
+		}
+
+		template<typename T>
+		bool lanewise(const NodeType op, const std::uint16_t lanes, std::byte *dst, const std::byte *a, const std::byte *b)
+		{
+			for (std::size_t i = 0; i < lanes; ++i)
+			{
+				const std::size_t at = i * sizeof(T);
+				T r {};
+				if (!apply(op, read<T>(a + at), read<T>(b + at), r))
+					return false;
+				write(dst + at, r);
+			}
+			return true;
+		}
+
+		bool vector_op(const NodeType op, const DataType elem, const std::uint16_t lanes,
+		               std::byte *dst, const std::byte *a, const std::byte *b)
+		{
+			switch (elem)
+			{
+				case DataType::BOOL:
+				{
+					if (!lanewise<std::uint8_t>(op, lanes, dst, a, b))
+						return false;
+					for (std::size_t i = 0; i < lanes; ++i)
+						dst[i] &= std::byte { 1 };
+					return true;
+				}
+				case DataType::INT8:
+					return lanewise<std::int8_t>(op, lanes, dst, a, b);
+				case DataType::INT16:
+					return lanewise<std::int16_t>(op, lanes, dst, a, b);
+				case DataType::INT32:
+					return lanewise<std::int32_t>(op, lanes, dst, a, b);
+				case DataType::INT64:
+					return lanewise<std::int64_t>(op, lanes, dst, a, b);
+				case DataType::UINT8:
+					return lanewise<std::uint8_t>(op, lanes, dst, a, b);
+				case DataType::UINT16:
+					return lanewise<std::uint16_t>(op, lanes, dst, a, b);
+				case DataType::UINT32:
+					return lanewise<std::uint32_t>(op, lanes, dst, a, b);
+				case DataType::UINT64:
+				case DataType::POINTER:
+					return lanewise<std::uint64_t>(op, lanes, dst, a, b);
+				case DataType::FLOAT32:
+					return lanewise<float>(op, lanes, dst, a, b);
+				case DataType::FLOAT64:
+					return lanewise<double>(op, lanes, dst, a, b);
+				default:
+					return false;
+			}
+		}
+
+		/* host calls live outside the dispatch loop so the exception handling
+		 * they need does not interfere with the threaded code */
+		const char *call_host(const Interpreter::Function &callee, const std::uint64_t *s,
+		                      const std::uint32_t *args, const std::uint16_t argc, std::uint64_t &result) noexcept
+		{
+			if (!callee.host)
+				return "unresolved external function";
+			if (argc > max_host_args)
+				return "too many arguments for an external function";
+
+			std::array<Value, max_host_args> values;
+			for (std::size_t i = 0; i < argc; ++i)
+				values[i] = Value::from_bits(s[args[i]]);
+
+			try
+			{
+				result = callee.host(std::span<const Value>(values.data(), argc)).bits();
+				return nullptr;
+			}
+			catch (...)
+			{
+				return "external function threw an exception";
+			}
+		}
+
+		std::uint32_t type_size(DataType type, const TypedData &data);
+
+		std::uint32_t struct_size(const DataTraits<DataType::STRUCT>::value &layout)
+		{
+			std::uint32_t size = 0;
+			for (const auto &[name_id, field_type, field_data]: layout.fields)
+				size += type_size(field_type, field_data);
+			return size;
+		}
+
+		std::uint32_t type_size(const DataType type, const TypedData &data)
+		{
+			switch (type)
+			{
+				case DataType::STRUCT:
+					return data.type() == DataType::STRUCT ? struct_size(data.get<DataType::STRUCT>()) : 0;
+				case DataType::ARRAY:
+				{
+					if (data.type() != DataType::ARRAY)
+						return 0;
+					const auto &arr = data.get<DataType::ARRAY>();
+					return arr.count * elem_sz(arr.elem_type);
+				}
+				case DataType::VECTOR:
+				{
+					if (data.type() != DataType::VECTOR)
+						return 0;
+					const auto &vec = data.get<DataType::VECTOR>();
+					return vec.lane_count * elem_sz(vec.elem_type);
+				}
+				case DataType::FUNCTION:
+					return sizeof(std::uint64_t);
+				default:
+					return elem_sz(type);
+			}
+		}
+
+		/* nodes whose slot holds a memory address rather than the value itself */
+		bool is_address(const Node *node)
+		{
+			switch (node->ir_type)
+			{
+				case NodeType::ALLOC:
+				case NodeType::ACCESS:
+				case NodeType::ADDR_OF:
+				case NodeType::PTR_ADD:
+					return true;
+				default:
+					return node->type_kind == DataType::POINTER;
+			}
+		}
+
+		std::uint16_t width(const Node *node)
+		{
+			if (node->type_kind == DataType::VOID)
+				return 0;
+
+			switch (node->ir_type)
+			{
+				case NodeType::ENTRY:
+				case NodeType::EXIT:
+				case NodeType::RET:
+				case NodeType::JUMP:
+				case NodeType::BRANCH:
+				case NodeType::STORE:
+				case NodeType::PTR_STORE:
+				case NodeType::ATOMIC_STORE:
+					return 0;
+				default:
+					break;
+			}
+
+			if (is_address(node) || node->type_kind == DataType::FUNCTION)
+				return 1;
+
+			const std::uint32_t bytes = type_size(node->type_kind, node->value);
+			return static_cast<std::uint16_t>(std::max<std::uint32_t>(1, (bytes + 7) / 8));
+		}
+
+		enum class Kind : std::uint8_t { I32, U32, I64, U64, F32, F64 };
+
+		std::optional<Kind> kind_of(const DataType type)
+		{
+			switch (type)
+			{
+				case DataType::INT8:
+				case DataType::INT16:
+				case DataType::INT32:
+					return Kind::I32;
+				case DataType::BOOL:
+				case DataType::UINT8:
+				case DataType::UINT16:
+				case DataType::UINT32:
+					return Kind::U32;
+				case DataType::INT64:
+					return Kind::I64;
+				case DataType::UINT64:
+				case DataType::POINTER:
+					return Kind::U64;
+				case DataType::FLOAT32:
+					return Kind::F32;
+				case DataType::FLOAT64:
+					return Kind::F64;
+				default:
+					return std::nullopt;
+			}
+		}
+
+		bool is_signed(const DataType type)
+		{
+			return type == DataType::INT8 || type == DataType::INT16 || type == DataType::INT32 || type == DataType::INT64;
+		}
+
+		/* re-normalization of 8- and 16-bit results computed in 32 bits */
+		std::optional<Op> narrow(const DataType type)
+		{
+			switch (type)
+			{
+				case DataType::BOOL:
+					return Op::ZEXT1;
+				case DataType::INT8:
+					return Op::SEXT8;
+				case DataType::INT16:
+					return Op::SEXT16;
+				case DataType::UINT8:
+					return Op::ZEXT8;
+				case DataType::UINT16:
+					return Op::ZEXT16;
+				default:
+					return std::nullopt;
+			}
+		}
+
+		/* full normalization of any integer into the slot form of type */
+		std::optional<Op> extend(const DataType type)
+		{
+			if (type == DataType::INT32)
+				return Op::SEXT32;
+			if (type == DataType::UINT32)
+				return Op::ZEXT32;
+			return narrow(type);
+		}
+
+		std::optional<Op> arithmetic(const NodeType type, const Kind kind)
+		{
+			constexpr auto none = std::nullopt;
+			const bool flt = kind == Kind::F32 || kind == Kind::F64;
+			const auto pick = [&](Op i32, Op u32, Op i64, Op u64, Op fp32, Op fp64) -> std::optional<Op>
+			{
+				switch (kind)
+				{
+					case Kind::I32:
+						return i32;
+					case Kind::U32:
+						return u32;
+					case Kind::I64:
+						return i64;
+					case Kind::U64:
+						return u64;
+					case Kind::F32:
+						return fp32;
+					case Kind::F64:
+						return fp64;
+				}
+				return std::nullopt;
+			};
+
+			switch (type)
+			{
+				case NodeType::ADD:
+					return pick(Op::ADD_I32, Op::ADD_U32, Op::ADD_I64, Op::ADD_I64, Op::ADD_F32, Op::ADD_F64);
+				case NodeType::SUB:
+					return pick(Op::SUB_I32, Op::SUB_U32, Op::SUB_I64, Op::SUB_I64, Op::SUB_F32, Op::SUB_F64);
+				case NodeType::MUL:
+					return pick(Op::MUL_I32, Op::MUL_U32, Op::MUL_I64, Op::MUL_I64, Op::MUL_F32, Op::MUL_F64);
+				case NodeType::DIV:
+					return pick(Op::DIV_I32, Op::DIV_U64, Op::DIV_I64, Op::DIV_U64, Op::DIV_F32, Op::DIV_F64);
+				case NodeType::MOD:
+					return pick(Op::MOD_I32, Op::MOD_U64, Op::MOD_I64, Op::MOD_U64, Op::MOD_F32, Op::MOD_F64);
+				case NodeType::BAND:
+					return flt ? none : std::optional(Op::AND);
+				case NodeType::BOR:
+					return flt ? none : std::optional(Op::OR);
+				case NodeType::BXOR:
+					return flt ? none : std::optional(Op::XOR);
+				case NodeType::BNOT:
+					return flt ? none : pick(Op::NOT_I32, Op::NOT_U32, Op::NOT_I64, Op::NOT_I64, Op::NOT_I64, Op::NOT_I64);
+				case NodeType::BSHL:
+					return flt ? none : pick(Op::SHL_I32, Op::SHL_U32, Op::SHL_I64, Op::SHL_I64, Op::SHL_I64, Op::SHL_I64);
+				case NodeType::BSHR:
+					return flt ? none : pick(Op::SHR_I32, Op::SHR_U32, Op::SHR_I64, Op::SHR_U64, Op::SHR_I64, Op::SHR_I64);
+				default:
+					return std::nullopt;
+			}
+		}
+
+		std::optional<Op> comparison(const NodeType type, const Kind kind)
+		{
+			const bool sgn = kind == Kind::I32 || kind == Kind::I64;
+			switch (type)
+			{
+				case NodeType::EQ:
+					return kind == Kind::F32 ? Op::EQ_F32 : kind == Kind::F64 ? Op::EQ_F64 : Op::EQ_I;
+				case NodeType::NEQ:
+					return kind == Kind::F32 ? Op::NE_F32 : kind == Kind::F64 ? Op::NE_F64 : Op::NE_I;
+				case NodeType::LT:
+				case NodeType::GT:
+					return kind == Kind::F32 ? Op::LT_F32 : kind == Kind::F64 ? Op::LT_F64 : sgn ? Op::LT_S : Op::LT_U;
+				case NodeType::LTE:
+				case NodeType::GTE:
+					return kind == Kind::F32 ? Op::LE_F32 : kind == Kind::F64 ? Op::LE_F64 : sgn ? Op::LE_S : Op::LE_U;
+				default:
+					return std::nullopt;
+			}
+		}
+
+		std::memory_order load_order(const AtomicOrdering ordering)
+		{
+			switch (ordering)
+			{
+				case AtomicOrdering::RELAXED:
+					return std::memory_order_relaxed;
+				case AtomicOrdering::ACQUIRE:
+				case AtomicOrdering::EXCLUSIVE:
+					return std::memory_order_acquire;
+				default:
+					return std::memory_order_seq_cst;
+			}
+		}
+
+		std::memory_order store_order(const AtomicOrdering ordering)
+		{
+			switch (ordering)
+			{
+				case AtomicOrdering::RELAXED:
+					return std::memory_order_relaxed;
+				case AtomicOrdering::RELEASE:
+				case AtomicOrdering::EXCLUSIVE:
+					return std::memory_order_release;
+				default:
+					return std::memory_order_seq_cst;
+			}
+		}
+
+		std::memory_order rmw_order(const AtomicOrdering ordering)
+		{
+			switch (ordering)
+			{
+				case AtomicOrdering::RELAXED:
+					return std::memory_order_relaxed;
+				case AtomicOrdering::ACQUIRE:
+					return std::memory_order_acquire;
+				case AtomicOrdering::RELEASE:
+					return std::memory_order_release;
+				case AtomicOrdering::EXCLUSIVE:
+				case AtomicOrdering::ACQ_REL:
+					return std::memory_order_acq_rel;
+				default:
+					return std::memory_order_seq_cst;
+			}
+		}
+
+		AtomicOrdering ordering_of(Node *node)
+		{
+			if (!node || node->ir_type != NodeType::LIT)
+				return AtomicOrdering::SEQ_CST;
+			return static_cast<AtomicOrdering>(extract_literal_value(node));
+		}
+
+		std::uint64_t literal_bits(const Node *node)
+		{
+			switch (node->type_kind)
+			{
+				case DataType::BOOL:
+					return pack(node->value.get<DataType::BOOL>());
+				case DataType::INT8:
+					return pack(node->value.get<DataType::INT8>());
+				case DataType::INT16:
+					return pack(node->value.get<DataType::INT16>());
+				case DataType::INT32:
+					return pack(node->value.get<DataType::INT32>());
+				case DataType::INT64:
+					return pack(node->value.get<DataType::INT64>());
+				case DataType::UINT8:
+					return pack(node->value.get<DataType::UINT8>());
+				case DataType::UINT16:
+					return pack(node->value.get<DataType::UINT16>());
+				case DataType::UINT32:
+					return pack(node->value.get<DataType::UINT32>());
+				case DataType::UINT64:
+					return pack(node->value.get<DataType::UINT64>());
+				case DataType::FLOAT32:
+					return pack(node->value.get<DataType::FLOAT32>());
+				case DataType::FLOAT64:
+					return pack(node->value.get<DataType::FLOAT64>());
+				default:
+					return 0;
+			}
+		}
+
+		/**
+		 * @brief Translates the region tree of one function into bytecode
+		 */
+		class Compiler
+		{
+		public:
+			Compiler(Interpreter::Function &function, Module &module,
+			         const std::unordered_map<Node *, Interpreter::Function *> &compiled,
+			         const std::unordered_map<Node *, std::uint64_t> &addresses) : fn(function), mod(module),
+				callees(compiled), globals(addresses) {}
+
+			void run(Region *body)
+			{
+				collect(body);
+
+				/* parameters occupy the first slots in declaration order */
+				for (Node *param: fn.node->inputs)
+				{
+					if (param->ir_type == NodeType::PARAM)
+						fn.params.emplace_back(slot(param), std::max<std::uint16_t>(1, width(param)));
+				}
+
+				for (Region *region: regions)
+				{
+					blocks[region] = static_cast<std::uint32_t>(fn.code.size());
+					bool terminated = false;
+					for (Node *node: region->nodes())
+					{
+						/* nodes after a terminator can never execute */
+						if ((terminated = lower(region, node)))
+							break;
+					}
+					if (!terminated)
+						emit(Op::RETV);
+
+					for (const auto &[target, patch]: trampolines)
+					{
+						patch.write(fn, static_cast<std::uint32_t>(fn.code.size()));
+						copies(region, target);
+						jump(target);
+					}
+					trampolines.clear();
+				}
+
+				for (const auto &[target, patch]: fixups)
+					patch.write(fn, blocks.at(target));
+			}
+
+		private:
+			/**
+			 * @brief Location of a jump target inside the emitted code
+			 */
+			struct Patch
+			{
+				std::size_t index = 0;
+				std::uint32_t Instruction::*field = nullptr; /* null for operand table entries */
+
+				void write(Interpreter::Function &f, const std::uint32_t pc) const
+				{
+					if (field)
+						f.code[index].*field = pc;
+					else
+						f.operands[index] = pc;
+				}
+			};
+
+			struct Copy
+			{
+				std::uint32_t dst;
+				std::uint32_t src;
+				std::uint16_t width;
+			};
+
+			Interpreter::Function &fn;
+			Module &mod;
+			const std::unordered_map<Node *, Interpreter::Function *> &callees;
+			const std::unordered_map<Node *, std::uint64_t> &globals;
+
+			std::vector<Region *> regions;
+			std::unordered_set<Region *> owned;
+			std::unordered_map<Node *, std::uint32_t> slots;
+			std::unordered_map<Region *, std::uint32_t> blocks;
+			std::vector<std::pair<Region *, Patch> > fixups;
+			std::vector<std::pair<Region *, Patch> > trampolines;
+			std::uint32_t scratch = NONE;
+			std::uint16_t scratch_width = 0;
+
+			void collect(Region *region)
+			{
+				regions.push_back(region);
+				owned.insert(region);
+				for (Region *child: region->children())
+					collect(child);
+			}
+
+			std::uint32_t fresh(const std::uint16_t count)
+			{
+				const auto base = static_cast<std::uint32_t>(fn.frame.size());
+				fn.frame.resize(fn.frame.size() + count, 0);
+				return base;
+			}
+
+			std::uint32_t slot(Node *node)
+			{
+				if (const auto it = slots.find(node);
+					it != slots.end())
+					return it->second;
+
+				const bool local = node->parent && owned.contains(node->parent);
+				std::optional<std::uint64_t> constant;
+				if (node->ir_type == NodeType::LIT)
+					constant = literal_bits(node);
+				else if (node->ir_type == NodeType::FUNCTION)
+				{
+					const auto it = callees.find(node);
+					if (it == callees.end())
+						throw std::invalid_argument("reference to a function outside of the module");
+					constant = reinterpret_cast<std::uintptr_t>(it->second);
+				}
+				else if (const auto it = globals.find(node);
+					it != globals.end())
+					constant = it->second;
+				else if (!local)
+					throw std::invalid_argument("value defined outside of function '" + fn.name + "'");
+
+				const std::uint32_t base = fresh(std::max<std::uint16_t>(1, width(node)));
+				if (constant)
+					fn.frame[base] = *constant;
+				slots[node] = base;
+				return base;
+			}
+
+			std::uint32_t result(Node *node)
+			{
+				return width(node) ? slot(node) : NONE;
+			}
+
+			void emit(const Op op, const std::uint32_t dst = 0, const std::uint32_t a = 0, const std::uint32_t b = 0,
+			          const std::uint32_t c = 0, const std::uint16_t n = 0)
+			{
+				fn.code.push_back({ .op = op, .n = n, .dst = dst, .a = a, .b = b, .c = c });
+			}
+
+			void move(const std::uint32_t dst, const std::uint32_t src, const std::uint16_t count)
+			{
+				if (dst == src)
+					return;
+				if (count > 1)
+					emit(Op::MOVN, dst, src, 0, 0, count);
+				else
+					emit(Op::MOV, dst, src);
+			}
+
+			Region *target_of(Node *entry) const
+			{
+				if (!entry || entry->ir_type != NodeType::ENTRY || !owned.contains(entry->parent))
+					throw std::invalid_argument("control flow leaves function '" + fn.name + "'");
+				return entry->parent;
+			}
+
+			std::vector<Copy> edge(Region *pred, Region *succ)
+			{
+				std::vector<Copy> moves;
+				for (Node *node: succ->nodes())
+				{
+					if (node->ir_type != NodeType::FROM)
+						continue;
+					if (Node *source = incoming_value(node, pred);
+						source && source != node)
+						moves.push_back({ slot(node), slot(source), std::max<std::uint16_t>(1, width(node)) });
+				}
+				return moves;
+			}
+
+			/* sequentialize the parallel copy of an edge; a cycle is broken by
+			 * saving one destination in the scratch slots first */
+			void copies(Region *pred, Region *succ)
+			{
+				const auto save = [&](const Copy &blocked) -> std::optional<std::uint32_t>
+				{
+					if (scratch == NONE || scratch_width < blocked.width)
+					{
+						scratch = fresh(blocked.width);
+						scratch_width = blocked.width;
+					}
+					return scratch;
+				};
+				sequence_copies(edge(pred, succ), save, [&](const Copy &c, bool)
+				{
+					move(c.dst, c.src, c.width);
+				});
+			}
+
+			void jump(Region *target)
+			{
+				fixups.push_back({ target, { fn.code.size(), &Instruction::a } });
+				emit(Op::JMP);
+			}
+
+			/* branch targets needing copies go through a trampoline emitted after the region */
+			void target(Region *pred, Region *succ, const Patch &patch)
+			{
+				if (edge(pred, succ).empty())
+					fixups.push_back({ succ, patch });
+				else
+					trampolines.push_back({ succ, patch });
+			}
+
+			std::uint32_t base_address(Node *node)
+			{
+				if (is_address(node))
+					return slot(node);
+
+				/* aggregates held in slots are addressed in place */
+				const std::uint32_t tmp = fresh(1);
+				emit(Op::ADDR, tmp, slot(node));
+				return tmp;
+			}
+
+			const DataTraits<DataType::STRUCT>::value *struct_of(Node *node)
+			{
+				if (node->type_kind == DataType::POINTER && node->value.type() == DataType::POINTER)
+				{
+					const Node *pointee = node->value.get<DataType::POINTER>().pointee;
+					if (pointee && pointee->type_kind == DataType::STRUCT && pointee->value.type() == DataType::STRUCT)
+						return &pointee->value.get<DataType::STRUCT>();
+					return nullptr;
+				}
+
+				if (node->type_kind != DataType::STRUCT)
+					return nullptr;
+				if (node->value.type() == DataType::STRUCT)
+					return &node->value.get<DataType::STRUCT>();
+
+				if (node->str_id != 0)
+				{
+					const auto &types = mod.typemap();
+					if (const auto it = types.find(std::string(mod.strtable().get(node->str_id)));
+						it != types.end() && it->second.type() == DataType::STRUCT)
+						return &it->second.get<DataType::STRUCT>();
+				}
+				return nullptr;
+			}
+
+			std::uint32_t alloc_size(Node *node)
+			{
+				if (node->type_kind == DataType::ARRAY && node->value.type() == DataType::ARRAY)
+				{
+					/* arrays of structs name their element type through str_id */
+					const auto &arr = node->value.get<DataType::ARRAY>();
+					if (arr.elem_type == DataType::STRUCT && node->str_id != 0)
+					{
+						const auto &types = mod.typemap();
+						if (const auto it = types.find(std::string(mod.strtable().get(node->str_id)));
+							it != types.end())
+							return arr.count * type_size(DataType::STRUCT, it->second);
+					}
+				}
+				return type_size(node->type_kind, node->value);
+			}
+
+			bool lower(Region *region, Node *node)
+			{
+				switch (node->ir_type)
+				{
+					case NodeType::ENTRY:
+					case NodeType::EXIT:
+					case NodeType::PARAM:
+					case NodeType::LIT:
+					case NodeType::FUNCTION:
+					case NodeType::FROM:
+						return false;
+					case NodeType::ADD:
+					case NodeType::SUB:
+					case NodeType::MUL:
+					case NodeType::DIV:
+					case NodeType::MOD:
+					case NodeType::BAND:
+					case NodeType::BOR:
+					case NodeType::BXOR:
+					case NodeType::BNOT:
+					case NodeType::BSHL:
+					case NodeType::BSHR:
+						lower_arithmetic(node);
+						return false;
+					case NodeType::GT:
+					case NodeType::GTE:
+					case NodeType::LT:
+					case NodeType::LTE:
+					case NodeType::EQ:
+					case NodeType::NEQ:
+						lower_comparison(node);
+						return false;
+					case NodeType::RET:
+						if (node->inputs.empty() || !width(node->inputs[0]))
+							emit(Op::RETV);
+						else
+							emit(Op::RET, 0, slot(node->inputs[0]), 0, 0, width(node->inputs[0]));
+						return true;
+					case NodeType::CALL:
+						lower_call(node);
+						return false;
+					case NodeType::INVOKE:
+						lower_invoke(region, node);
+						return true;
+					case NodeType::ALLOC:
+						lower_alloc(node);
+						return false;
+					case NodeType::LOAD:
+					case NodeType::PTR_LOAD:
+						lower_load(node);
+						return false;
+					case NodeType::STORE:
+					case NodeType::PTR_STORE:
+						lower_store(node);
+						return false;
+					case NodeType::ADDR_OF:
+					{
+						Node *var = node->inputs[0];
+						if (is_address(var) || var->ir_type == NodeType::FUNCTION)
+							move(slot(node), slot(var), 1);
+						else
+							emit(Op::ADDR, slot(node), slot(var));
+						return false;
+					}
+					case NodeType::PTR_ADD:
+					{
+						Node *offset = node->inputs[1];
+						const std::int64_t value = extract_literal_value(offset);
+						if (offset->ir_type == NodeType::LIT && value >= std::numeric_limits<std::int32_t>::min() &&
+						    value <= std::numeric_limits<std::int32_t>::max())
+							emit(Op::ADDI, slot(node), slot(node->inputs[0]), 0, static_cast<std::uint32_t>(value));
+						else
+							emit(Op::LEA, slot(node), slot(node->inputs[0]), slot(offset), 1);
+						return false;
+					}
+					case NodeType::CAST:
+						lower_cast(node);
+						return false;
+					case NodeType::ATOMIC_LOAD:
+					case NodeType::ATOMIC_STORE:
+					case NodeType::ATOMIC_CAS:
+						lower_atomic(node);
+						return false;
+					case NodeType::JUMP:
+					{
+						Region *succ = target_of(node->inputs[0]);
+						copies(region, succ);
+						jump(succ);
+						return true;
+					}
+					case NodeType::BRANCH:
+					{
+						const std::size_t at = fn.code.size();
+						emit(Op::BR, 0, slot(node->inputs[0]));
+						target(region, target_of(node->inputs[1]), { at, &Instruction::b });
+						target(region, target_of(node->inputs[2]), { at, &Instruction::c });
+						return true;
+					}
+					case NodeType::SELECT:
+					{
+						const std::uint16_t w = width(node);
+						emit(w > 1 ? Op::SELN : Op::SEL, slot(node), slot(node->inputs[0]), slot(node->inputs[1]),
+						     slot(node->inputs[2]), w);
+						return false;
+					}
+					case NodeType::VECTOR_BUILD:
+					case NodeType::VECTOR_SPLAT:
+					case NodeType::VECTOR_EXTRACT:
+						lower_vector(node);
+						return false;
+					case NodeType::ACCESS:
+						lower_access(node);
+						return false;
+				}
+				return false;
+			}
+
+			void lower_arithmetic(Node *node)
+			{
+				if (node->type_kind == DataType::VECTOR)
+				{
+					const auto &vec = node->value.get<DataType::VECTOR>();
+					const std::uint32_t code = static_cast<std::uint32_t>(node->ir_type) << 8 |
+					                           static_cast<std::uint32_t>(vec.elem_type);
+					const auto lanes = static_cast<std::uint16_t>(vec.lane_count);
+					if (node->ir_type == NodeType::BNOT)
+						emit(Op::VNOT, slot(node), slot(node->inputs[0]), slot(node->inputs[0]), code, lanes);
+					else
+						emit(Op::VBIN, slot(node), slot(node->inputs[0]), slot(node->inputs[1]), code, lanes);
+					return;
+				}
+
+				const auto kind = kind_of(node->type_kind);
+				const auto op = kind ? arithmetic(node->ir_type, *kind) : std::nullopt;
+				if (!op)
+					throw std::invalid_argument("unsupported operand type in function '" + fn.name + "'");
+
+				const std::uint32_t dst = slot(node);
+				const std::uint32_t rhs = node->ir_type == NodeType::BNOT ? 0 : slot(node->inputs[1]);
+				emit(*op, dst, slot(node->inputs[0]), rhs);
+				if (const auto fix = narrow(node->type_kind);
+					fix && node->ir_type != NodeType::BAND && node->ir_type != NodeType::BOR &&
+					node->ir_type != NodeType::BXOR)
+					emit(*fix, dst, dst);
+			}
+
+			void lower_comparison(Node *node)
+			{
+				const auto kind = kind_of(node->inputs[0]->type_kind);
+				const auto op = kind ? comparison(node->ir_type, *kind) : std::nullopt;
+				if (!op)
+					throw std::invalid_argument("unsupported comparison in function '" + fn.name + "'");
+
+				/* a > b is b < a, which also holds for unordered floats */
+				std::uint32_t lhs = slot(node->inputs[0]);
+				std::uint32_t rhs = slot(node->inputs[1]);
+				if (node->ir_type == NodeType::GT || node->ir_type == NodeType::GTE)
+					std::swap(lhs, rhs);
+				emit(*op, slot(node), lhs, rhs);
+			}
+
+			void lower_cast(Node *node)
+			{
+				const DataType from = node->inputs[0]->type_kind;
+				const DataType to = node->type_kind;
+				const std::uint32_t dst = slot(node);
+				const std::uint32_t src = slot(node->inputs[0]);
+				if (from == to)
+					return move(dst, src, width(node));
+
+				const auto in = kind_of(from);
+				const auto out = kind_of(to);
+				if (!in || !out)
+					throw std::invalid_argument("unsupported cast in function '" + fn.name + "'");
+
+				const bool from_float = *in == Kind::F32 || *in == Kind::F64;
+				if (to == DataType::BOOL)
+					return emit(*in == Kind::F32 ? Op::NEZ_F32 : *in == Kind::F64 ? Op::NEZ_F64 : Op::NEZ, dst, src);
+
+				if (*out == Kind::F32 || *out == Kind::F64)
+				{
+					const bool wide = *out == Kind::F64;
+					if (from_float)
+						return emit(wide ? Op::F32_F64 : Op::F64_F32, dst, src);
+					if (is_signed(from))
+						return emit(wide ? Op::S2F64 : Op::S2F32, dst, src);
+					return emit(wide ? Op::U2F64 : Op::U2F32, dst, src);
+				}
+
+				if (from_float)
+				{
+					const bool sgn = is_signed(to);
+					if (*in == Kind::F32)
+						emit(sgn ? Op::F32_S : Op::F32_U, dst, src);
+					else
+						emit(sgn ? Op::F64_S : Op::F64_U, dst, src);
+					if (const auto fix = extend(to))
+						emit(*fix, dst, dst);
+					return;
+				}
+
+				if (const auto fix = extend(to))
+					emit(*fix, dst, src);
+				else
+					move(dst, src, 1);
+			}
+
+			void lower_call(Node *node)
+			{
+				Node *callee = node->inputs[0];
+				if (callee->ir_type == NodeType::FUNCTION)
+				{
+					const auto it = callees.find(callee);
+					if (it != callees.end() && !it->second->external &&
+					    node->inputs.size() - 1 != it->second->node->inputs.size())
+						throw std::invalid_argument("argument count mismatch calling '" + it->second->name + "'");
+				}
+
+				const auto args = static_cast<std::uint32_t>(fn.operands.size());
+				for (Node *arg: node->inputs | std::views::drop(1))
+					fn.operands.push_back(slot(arg));
+
+				emit(Op::CALL, result(node), slot(callee), args, 0, static_cast<std::uint16_t>(node->inputs.size() - 1));
+			}
+
+			void lower_invoke(Region *region, Node *node)
+			{
+				/* targets are the ENTRY operands, everything after the callee else is an argument */
+				std::vector<Node *> targets;
+				const auto args = static_cast<std::uint32_t>(fn.operands.size());
+				for (Node *input: node->inputs | std::views::drop(1))
+				{
+					if (input->ir_type == NodeType::ENTRY)
+						targets.push_back(input);
+					else
+						fn.operands.push_back(slot(input));
+				}
+				if (targets.size() != 2)
+					throw std::invalid_argument("invoke requires a normal and an except target");
+
+				const auto argc = static_cast<std::uint16_t>(fn.operands.size() - args);
+				const std::size_t normal = fn.operands.size();
+				fn.operands.push_back(0);
+				fn.operands.push_back(0);
+
+				emit(Op::INVOKE, result(node), slot(node->inputs[0]), args, 0, argc);
+				target(region, target_of(targets[0]), { normal, nullptr });
+				target(region, target_of(targets[1]), { normal + 1, nullptr });
+			}
+
+			void lower_alloc(Node *node)
+			{
+				const std::uint32_t size = std::max<std::uint32_t>(1, alloc_size(node));
+				if (node->inputs.empty())
+					return emit(Op::ALLOCA, slot(node), 0, 0, size);
+
+				Node *count = node->inputs[0];
+				if (count->ir_type == NodeType::LIT)
+				{
+					const auto total = static_cast<std::uint64_t>(std::max<std::int64_t>(1, extract_literal_value(count))) * size;
+					if (total > std::numeric_limits<std::uint32_t>::max())
+						throw std::invalid_argument("allocation too large in function '" + fn.name + "'");
+					return emit(Op::ALLOCA, slot(node), 0, 0, static_cast<std::uint32_t>(total));
+				}
+				emit(Op::ALLOCA_N, slot(node), slot(count), 0, size);
+			}
+
+			static Op load_op(const DataType type)
+			{
+				switch (type)
+				{
+					case DataType::INT8:
+						return Op::LD8S;
+					case DataType::BOOL:
+					case DataType::UINT8:
+						return Op::LD8U;
+					case DataType::INT16:
+						return Op::LD16S;
+					case DataType::UINT16:
+						return Op::LD16U;
+					case DataType::INT32:
+						return Op::LD32S;
+					case DataType::UINT32:
+					case DataType::FLOAT32:
+						return Op::LD32U;
+					default:
+						return Op::LD64;
+				}
+			}
+
+			static Op store_op(const std::uint32_t size)
+			{
+				switch (size)
+				{
+					case 1:
+						return Op::ST8;
+					case 2:
+						return Op::ST16;
+					case 4:
+						return Op::ST32;
+					default:
+						return Op::ST64;
+				}
+			}
+
+			void lower_load(Node *node)
+			{
+				Node *location = node->inputs[0];
+				const std::uint16_t w = width(node);
+				if (!w)
+					return;
+
+				/* a location that is not memory is a variable living in its slot */
+				if (!is_address(location))
+					return move(slot(node), slot(location), w);
+
+				const DataType type = node->type_kind;
+				if (type == DataType::VECTOR || type == DataType::STRUCT || type == DataType::ARRAY)
+					return emit(Op::LDN, slot(node), slot(location), 0, type_size(type, node->value), w);
+				emit(load_op(type), slot(node), slot(location));
+			}
+
+			void lower_store(Node *node)
+			{
+				Node *value = node->inputs[0];
+				Node *location = node->inputs[1];
+				const std::uint16_t w = std::max<std::uint16_t>(1, width(value));
+				if (!is_address(location))
+					return move(slot(location), slot(value), w);
+
+				const DataType type = value->type_kind;
+				if (type == DataType::VECTOR || type == DataType::STRUCT || type == DataType::ARRAY)
+					return emit(Op::STN, 0, slot(value), slot(location), type_size(type, value->value), w);
+				emit(store_op(is_address(value) ? 8 : elem_sz(type)), 0, slot(value), slot(location));
+			}
+
+			void lower_atomic(Node *node)
+			{
+				static constexpr std::array loads = { Op::ALD8, Op::ALD16, Op::ALD32, Op::ALD64 };
+				static constexpr std::array stores = { Op::AST8, Op::AST16, Op::AST32, Op::AST64 };
+				static constexpr std::array swaps = { Op::ACAS8, Op::ACAS16, Op::ACAS32, Op::ACAS64 };
+				const auto index = [&](const DataType type)
+				{
+					const std::uint32_t size = elem_sz(type);
+					if (size == 0)
+						throw std::invalid_argument("unsupported atomic type in function '" + fn.name + "'");
+					return static_cast<std::size_t>(std::countr_zero(size));
+				};
+
+				switch (node->ir_type)
+				{
+					case NodeType::ATOMIC_LOAD:
+					{
+						const auto order = load_order(ordering_of(node->inputs.size() > 1 ? node->inputs[1] : nullptr));
+						emit(loads[index(node->type_kind)], slot(node), slot(node->inputs[0]), 0, 0,
+						     static_cast<std::uint16_t>(order));
+						break;
+					}
+					case NodeType::ATOMIC_STORE:
+					{
+						const auto order = store_order(ordering_of(node->inputs.size() > 2 ? node->inputs[2] : nullptr));
+						emit(stores[index(node->inputs[0]->type_kind)], 0, slot(node->inputs[0]), slot(node->inputs[1]), 0,
+						     static_cast<std::uint16_t>(order));
+						return;
+					}
+					default:
+					{
+						/* pointer, expected, desired and an optional ordering; yields the old value */
+						const auto order = rmw_order(ordering_of(node->inputs.size() > 3 ? node->inputs[3] : nullptr));
+						emit(swaps[index(node->type_kind)], slot(node), slot(node->inputs[0]), slot(node->inputs[1]),
+						     slot(node->inputs[2]), static_cast<std::uint16_t>(order));
+						break;
+					}
+				}
+
+				/* atomics load zero-extended bits */
+				if (is_signed(node->type_kind))
+				{
+					if (const auto fix = extend(node->type_kind))
+						emit(*fix, slot(node), slot(node));
+				}
+			}
+
+			void lower_vector(Node *node)
+			{
+				if (node->ir_type == NodeType::VECTOR_EXTRACT)
+				{
+					const auto &vec = node->inputs[0]->value.get<DataType::VECTOR>();
+					emit(Op::VEXT, slot(node), slot(node->inputs[0]), slot(node->inputs[1]),
+					     static_cast<std::uint32_t>(vec.elem_type), static_cast<std::uint16_t>(vec.lane_count));
+					return;
+				}
+
+				const auto &vec = node->value.get<DataType::VECTOR>();
+				const auto lanes = static_cast<std::uint16_t>(vec.lane_count);
+				const auto elem = static_cast<std::uint32_t>(vec.elem_type);
+				if (node->ir_type == NodeType::VECTOR_SPLAT)
+					return emit(Op::VSPLAT, slot(node), slot(node->inputs[0]), 0, elem, lanes);
+
+				const auto elements = static_cast<std::uint32_t>(fn.operands.size());
+				for (Node *input: node->inputs)
+					fn.operands.push_back(slot(input));
+				emit(Op::VBUILD, slot(node), elements, 0, elem, lanes);
+			}
+
+			void lower_access(Node *node)
+			{
+				Node *container = node->inputs[0];
+				Node *index = node->inputs[1];
+				const std::uint32_t base = base_address(container);
+
+				std::uint64_t offset = 0;
+				if (const auto *layout = struct_of(container))
+				{
+					/* the index counts padding fields, matching Builder::struct_field */
+					const auto field = static_cast<std::size_t>(extract_literal_value(index));
+					const StructLayout &offsets = mod.layout().of(*layout);
+					offset = field < offsets.offsets.size() ? offsets.offsets[field] : offsets.size;
+				}
+				else
+				{
+					const std::uint32_t size = std::max<std::uint32_t>(1, type_size(node->type_kind, node->value));
+					if (index->ir_type != NodeType::LIT)
+						return emit(Op::LEA, slot(node), base, slot(index), size);
+					offset = static_cast<std::uint64_t>(extract_literal_value(index)) * size;
+				}
+
+				if (offset > static_cast<std::uint64_t>(std::numeric_limits<std::int32_t>::max()))
+					throw std::invalid_argument("access offset too large in function '" + fn.name + "'");
+				emit(Op::ADDI, slot(node), base, 0, static_cast<std::uint32_t>(offset));
+			}
+		};
+	}
+
+	Interpreter::Interpreter(Module &module) : Interpreter(module, Config {}) {}
+
+	Interpreter::Interpreter(Module &module, const Config config) : mod(module), cfg(config)
+	{
+		/* fetch the handler table of the dispatch loop */
+		execute(nullptr, {});
+
+		for (Node *node: module.functions())
+		{
+			auto fn = std::make_unique<Function>();
+			fn->node = node;
+			fn->name = std::string(module.strtable().get(node->str_id));
+			by_node[node] = fn.get();
+			by_name.try_emplace(fn->name, fn.get());
+			functions.push_back(std::move(fn));
+		}
+
+		/* ALLOC nodes of the root region are globals shared by every call */
+		std::vector<std::pair<Node *, std::size_t> > layout;
+		std::size_t words = 0;
+		for (Node *node: module.root()->nodes())
+		{
+			if (node->ir_type != NodeType::ALLOC)
+				continue;
+			layout.emplace_back(node, words);
+			words += (std::max<std::uint32_t>(1, type_size(node->type_kind, node->value)) + 7) / 8;
+		}
+		globals.assign(words, 0);
+
+		for (const auto &[node, offset]: layout)
+			addresses[node] = reinterpret_cast<std::uintptr_t>(globals.data() + offset);
+
+		for (const auto &fn: functions)
+		{
+			Region *body = nullptr;
+			for (Region *child: module.root()->children())
+			{
+				if (child->name() == fn->name)
+				{
+					body = child;
+					break;
+				}
+			}
+
+			if (!body || (fn->node->traits & NodeTraits::EXTERN) != NodeTraits::NONE)
+			{
+				fn->external = true;
+				continue;
+			}
+
+			Compiler(*fn, module, by_node, addresses).run(body);
+			for (Instruction &insn: fn->code)
+				insn.handler = handlers[static_cast<std::size_t>(insn.op)];
+		}
+
+		stack.assign(cfg.stack_slots, 0);
+		frames.resize(cfg.max_depth);
+		arena.assign((cfg.arena_bytes + 7) / 8, 0);
+	}
+
+	Interpreter::~Interpreter() = default;
+
+	void Interpreter::bind(const std::string_view name, HostFunction fn)
+	{
+		const auto it = by_name.find(std::string(name));
+		if (it == by_name.end() || !it->second->external)
+			throw std::invalid_argument("no external function named '" + std::string(name) + "'");
+		it->second->host = std::move(fn);
+	}
+
+	Value Interpreter::call(const std::string_view name, const std::span<const Value> args)
+	{
+		const auto it = by_name.find(std::string(name));
+		if (it == by_name.end())
+			throw std::invalid_argument("no function named '" + std::string(name) + "'");
+		return Value::from_bits(execute(it->second, args));
+	}
+
+	Value Interpreter::call(const std::string_view name, const std::initializer_list<Value> args)
+	{
+		return call(name, std::span(args.begin(), args.size()));
+	}
+
+	const Interpreter::Function *Interpreter::function(const std::string_view name) const
+	{
+		const auto it = by_name.find(std::string(name));
+		return it != by_name.end() ? it->second : nullptr;
+	}
+
+	void *Interpreter::global(Node *node) const
+	{
+		const auto it = addresses.find(node);
+		return it != addresses.end() ? reinterpret_cast<void *>(static_cast<std::uintptr_t>(it->second)) : nullptr;
+	}
+
+	/* labels as values are a GNU extension shared by every compiler Arc supports */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+
+	std::uint64_t Interpreter::execute(const Function *entry, const std::span<const Value> args)
+	{
+#define ARC_INTERP_LABEL(name) &&op_##name,
+		static const void *const table[] = { ARC_INTERP_OPCODES(ARC_INTERP_LABEL) };
+#undef ARC_INTERP_LABEL
+
+		if (!entry)
+		{
+			handlers = table;
+			return 0;
+		}
+
+		if (entry->external)
+		{
+			std::array<std::uint32_t, max_host_args> indices {};
+			std::array<std::uint64_t, max_host_args> bits {};
+			const std::size_t argc = std::min(args.size(), max_host_args);
+			for (std::size_t i = 0; i < argc; ++i)
+			{
+				indices[i] = static_cast<std::uint32_t>(i);
+				bits[i] = args[i].bits();
+			}
+
+			std::uint64_t result = 0;
+			if (const char *why = call_host(*entry, bits.data(), indices.data(), static_cast<std::uint16_t>(args.size()), result))
+				throw std::runtime_error("trap in function '" + entry->name + "': " + why);
+			return result;
+		}
+
+		const std::size_t floor = depth;
+		std::uint64_t *top = depth ? frames[depth - 1].slots + frames[depth - 1].fn->frame.size() : stack.data();
+		if (depth == frames.size() || top + entry->frame.size() > stack.data() + stack.size())
+			throw std::runtime_error("trap in function '" + entry->name + "': stack overflow");
+
+		std::ranges::copy(entry->frame, top);
+		for (std::size_t i = 0; i < args.size() && i < entry->params.size(); ++i)
+			top[entry->params[i].first] = args[i].bits();
+		frames[depth++] = { .fn = entry, .slots = top, .arena = arena_top, .dst = NONE };
+
+		const Function *fn = entry;
+		const Instruction *code = fn->code.data();
+		const Instruction *pc = code;
+		std::uint64_t *s = top;
+		const char *reason = nullptr;
+
+		/* push a frame for a bytecode callee and continue at its first instruction */
+		const auto enter = [&](const Function *callee, const std::uint32_t *argv, const std::uint16_t argc,
+		                       const Instruction *ret, const Instruction *unwind, const std::uint32_t dst)
+		{
+			std::uint64_t *base = s + fn->frame.size();
+			if (depth == frames.size() || base + callee->frame.size() > stack.data() + stack.size())
+				return false;
+
+			std::memcpy(base, callee->frame.data(), callee->frame.size() * sizeof(std::uint64_t));
+			const std::size_t count = std::min<std::size_t>(argc, callee->params.size());
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				const auto &[param, w] = callee->params[i];
+				std::memcpy(base + param, s + argv[i], w * sizeof(std::uint64_t));
+			}
+
+			frames[depth++] = { .fn = callee, .ret = ret, .unwind = unwind, .slots = base, .arena = arena_top, .dst = dst };
+			fn = callee;
+			code = callee->code.data();
+			pc = code;
+			s = base;
+			return true;
+		};
+
+		/* pop the current frame and resume its caller */
+		const auto leave = [&]
+		{
+			const Frame &done = frames[--depth];
+			const Frame &caller = frames[depth - 1];
+			arena_top = done.arena;
+			fn = caller.fn;
+			code = fn->code.data();
+			s = caller.slots;
+			return done;
+		};
+
+#define ARC_DISPATCH() goto *pc->handler
+#define ARC_NEXT() do { ++pc; ARC_DISPATCH(); } while (false)
+#define ARC_TRAP(why) do { reason = why; goto trap; } while (false)
+#define ARC_UNARY(name, expr) op_##name: { const std::uint64_t x = s[pc->a]; s[pc->dst] = (expr); } ARC_NEXT();
+#define ARC_BINARY(name, expr) \
+	op_##name: { const std::uint64_t x = s[pc->a]; const std::uint64_t y = s[pc->b]; s[pc->dst] = (expr); } ARC_NEXT();
+#define ARC_LOAD(name, T) \
+	op_##name: \
+	{ \
+		const std::byte *p = address(s[pc->a]); \
+		if (!p) \
+			ARC_TRAP("load from null pointer"); \
+		s[pc->dst] = pack(read<T>(p)); \
+	} \
+	ARC_NEXT();
+#define ARC_STORE(name, T) \
+	op_##name: \
+	{ \
+		std::byte *p = address(s[pc->b]); \
+		if (!p) \
+			ARC_TRAP("store to null pointer"); \
+		write(p, static_cast<T>(s[pc->a])); \
+	} \
+	ARC_NEXT();
+#define ARC_ATOMIC(bits) \
+	op_ALD##bits: \
+	{ \
+		std::byte *p = address(s[pc->a]); \
+		if (!p) \
+			ARC_TRAP("atomic load from null pointer"); \
+		std::atomic_ref ref(*reinterpret_cast<std::uint##bits##_t *>(p)); \
+		s[pc->dst] = ref.load(static_cast<std::memory_order>(pc->n)); \
+	} \
+	ARC_NEXT(); \
+	op_AST##bits: \
+	{ \
+		std::byte *p = address(s[pc->b]); \
+		if (!p) \
+			ARC_TRAP("atomic store to null pointer"); \
+		std::atomic_ref ref(*reinterpret_cast<std::uint##bits##_t *>(p)); \
+		ref.store(static_cast<std::uint##bits##_t>(s[pc->a]), static_cast<std::memory_order>(pc->n)); \
+	} \
+	ARC_NEXT(); \
+	op_ACAS##bits: \
+	{ \
+		std::byte *p = address(s[pc->a]); \
+		if (!p) \
+			ARC_TRAP("atomic compare-exchange on null pointer"); \
+		std::atomic_ref ref(*reinterpret_cast<std::uint##bits##_t *>(p)); \
+		auto expected = static_cast<std::uint##bits##_t>(s[pc->b]); \
+		ref.compare_exchange_strong(expected, static_cast<std::uint##bits##_t>(s[pc->c]), \
+		                            static_cast<std::memory_order>(pc->n)); \
+		s[pc->dst] = expected; \
+	} \
+	ARC_NEXT();
+
+		ARC_DISPATCH();
+
+		op_MOV: s[pc->dst] = s[pc->a]; ARC_NEXT();
+		op_MOVN: std::memmove(s + pc->dst, s + pc->a, pc->n * sizeof(std::uint64_t)); ARC_NEXT();
+		op_ADDR: s[pc->dst] = reinterpret_cast<std::uintptr_t>(s + pc->a); ARC_NEXT();
+
+		ARC_BINARY(ADD_I32, sx32(u32(x) + u32(y)))
+		ARC_BINARY(ADD_U32, u32(x) + u32(y))
+		ARC_BINARY(ADD_I64, x + y)
+		ARC_BINARY(ADD_F32, pack(f32(x) + f32(y)))
+		ARC_BINARY(ADD_F64, pack(f64(x) + f64(y)))
+		ARC_BINARY(SUB_I32, sx32(u32(x) - u32(y)))
+		ARC_BINARY(SUB_U32, u32(x) - u32(y))
+		ARC_BINARY(SUB_I64, x - y)
+		ARC_BINARY(SUB_F32, pack(f32(x) - f32(y)))
+		ARC_BINARY(SUB_F64, pack(f64(x) - f64(y)))
+		ARC_BINARY(MUL_I32, sx32(u32(x) * u32(y)))
+		ARC_BINARY(MUL_U32, u32(x) * u32(y))
+		ARC_BINARY(MUL_I64, x * y)
+		ARC_BINARY(MUL_F32, pack(f32(x) * f32(y)))
+		ARC_BINARY(MUL_F64, pack(f64(x) * f64(y)))
+
+		op_DIV_I32:
+		{
+			const std::int64_t x = i64(s[pc->a]);
+			const std::int64_t y = i64(s[pc->b]);
+			if (y == 0)
+				ARC_TRAP("integer division by zero");
+			if (y == -1 && x == std::numeric_limits<std::int32_t>::min())
+				ARC_TRAP("integer division overflow");
+			s[pc->dst] = static_cast<std::uint64_t>(x / y);
+		}
+		ARC_NEXT();
+		op_DIV_I64:
+		{
+			const std::int64_t x = i64(s[pc->a]);
+			const std::int64_t y = i64(s[pc->b]);
+			if (y == 0)
+				ARC_TRAP("integer division by zero");
+			if (y == -1 && x == std::numeric_limits<std::int64_t>::min())
+				ARC_TRAP("integer division overflow");
+			s[pc->dst] = static_cast<std::uint64_t>(x / y);
+		}
+		ARC_NEXT();
+		op_DIV_U64:
+		{
+			if (s[pc->b] == 0)
+				ARC_TRAP("integer division by zero");
+			s[pc->dst] = s[pc->a] / s[pc->b];
+		}
+		ARC_NEXT();
+		ARC_BINARY(DIV_F32, pack(f32(x) / f32(y)))
+		ARC_BINARY(DIV_F64, pack(f64(x) / f64(y)))
+
+		op_MOD_I32:
+		{
+			const std::int64_t y = i64(s[pc->b]);
+			if (y == 0)
+				ARC_TRAP("integer division by zero");
+			s[pc->dst] = static_cast<std::uint64_t>(i64(s[pc->a]) % y);
+		}
+		ARC_NEXT();
+		op_MOD_I64:
+		{
+			const std::int64_t y = i64(s[pc->b]);
+			if (y == 0)
+				ARC_TRAP("integer division by zero");
+			s[pc->dst] = y == -1 ? 0 : static_cast<std::uint64_t>(i64(s[pc->a]) % y);
+		}
+		ARC_NEXT();
+		op_MOD_U64:
+		{
+			if (s[pc->b] == 0)
+				ARC_TRAP("integer division by zero");
+			s[pc->dst] = s[pc->a] % s[pc->b];
+		}
+		ARC_NEXT();
+		ARC_BINARY(MOD_F32, pack(std::fmod(f32(x), f32(y))))
+		ARC_BINARY(MOD_F64, pack(std::fmod(f64(x), f64(y))))
+
+		/* bitwise operations keep normalized operands normalized */
+		ARC_BINARY(AND, x & y)
+		ARC_BINARY(OR, x | y)
+		ARC_BINARY(XOR, x ^ y)
+		ARC_UNARY(NOT_I32, sx32(~u32(x)))
+		ARC_UNARY(NOT_U32, static_cast<std::uint32_t>(~u32(x)))
+		ARC_UNARY(NOT_I64, ~x)
+		ARC_BINARY(SHL_I32, sx32(u32(x) << (y & 31)))
+		ARC_BINARY(SHL_U32, static_cast<std::uint32_t>(u32(x) << (y & 31)))
+		ARC_BINARY(SHL_I64, x << (y & 63))
+		ARC_BINARY(SHR_I32, static_cast<std::uint64_t>(i64(x) >> (y & 31)))
+		ARC_BINARY(SHR_U32, x >> (y & 31))
+		ARC_BINARY(SHR_I64, static_cast<std::uint64_t>(i64(x) >> (y & 63)))
+		ARC_BINARY(SHR_U64, x >> (y & 63))
+
+		ARC_BINARY(EQ_I, x == y)
+		ARC_BINARY(NE_I, x != y)
+		ARC_BINARY(EQ_F32, f32(x) == f32(y))
+		ARC_BINARY(NE_F32, f32(x) != f32(y))
+		ARC_BINARY(EQ_F64, f64(x) == f64(y))
+		ARC_BINARY(NE_F64, f64(x) != f64(y))
+		ARC_BINARY(LT_S, i64(x) < i64(y))
+		ARC_BINARY(LE_S, i64(x) <= i64(y))
+		ARC_BINARY(LT_U, x < y)
+		ARC_BINARY(LE_U, x <= y)
+		ARC_BINARY(LT_F32, f32(x) < f32(y))
+		ARC_BINARY(LE_F32, f32(x) <= f32(y))
+		ARC_BINARY(LT_F64, f64(x) < f64(y))
+		ARC_BINARY(LE_F64, f64(x) <= f64(y))
+
+		ARC_UNARY(SEXT8, sx8(x))
+		ARC_UNARY(SEXT16, sx16(x))
+		ARC_UNARY(SEXT32, sx32(x))
+		ARC_UNARY(ZEXT1, x & 1)
+		ARC_UNARY(ZEXT8, x & 0xff)
+		ARC_UNARY(ZEXT16, x & 0xffff)
+		ARC_UNARY(ZEXT32, x & 0xffffffff)
+		ARC_UNARY(NEZ, x != 0)
+		ARC_UNARY(S2F32, pack(static_cast<float>(i64(x))))
+		ARC_UNARY(S2F64, pack(static_cast<double>(i64(x))))
+		ARC_UNARY(U2F32, pack(static_cast<float>(x)))
+		ARC_UNARY(U2F64, pack(static_cast<double>(x)))
+		ARC_UNARY(F32_S, saturate<std::int64_t>(f32(x)))
+		ARC_UNARY(F32_U, saturate<std::uint64_t>(f32(x)))
+		ARC_UNARY(F64_S, saturate<std::int64_t>(f64(x)))
+		ARC_UNARY(F64_U, saturate<std::uint64_t>(f64(x)))
+		ARC_UNARY(F32_F64, pack(static_cast<double>(f32(x))))
+		ARC_UNARY(F64_F32, pack(static_cast<float>(f64(x))))
+		ARC_UNARY(NEZ_F32, f32(x) != 0.0f)
+		ARC_UNARY(NEZ_F64, f64(x) != 0.0)
+
+		op_SEL: s[pc->dst] = s[pc->a] ? s[pc->b] : s[pc->c]; ARC_NEXT();
+		op_SELN:
+			std::memmove(s + pc->dst, s + (s[pc->a] ? pc->b : pc->c), pc->n * sizeof(std::uint64_t));
+			ARC_NEXT();
+
+		op_ALLOCA:
+		{
+			const std::size_t words = (pc->c + std::size_t { 7 }) / 8;
+			if (words > arena.size() - arena_top)
+				ARC_TRAP("out of ALLOC memory");
+			std::fill_n(arena.data() + arena_top, words, 0);
+			s[pc->dst] = reinterpret_cast<std::uintptr_t>(arena.data() + arena_top);
+			arena_top += words;
+		}
+		ARC_NEXT();
+		op_ALLOCA_N:
+		{
+			const std::int64_t count = i64(s[pc->a]);
+			if (count < 0 || static_cast<std::uint64_t>(count) > (arena.size() - arena_top) * 8 / std::max<std::uint32_t>(pc->c, 1))
+				ARC_TRAP("out of ALLOC memory");
+			const std::size_t words = (static_cast<std::size_t>(count) * pc->c + 7) / 8;
+			std::fill_n(arena.data() + arena_top, words, 0);
+			s[pc->dst] = reinterpret_cast<std::uintptr_t>(arena.data() + arena_top);
+			arena_top += words;
+		}
+		ARC_NEXT();
+		op_LEA: s[pc->dst] = s[pc->a] + s[pc->b] * pc->c; ARC_NEXT();
+		op_ADDI: s[pc->dst] = s[pc->a] + sx32(pc->c); ARC_NEXT();
+
+		ARC_LOAD(LD8S, std::int8_t)
+		ARC_LOAD(LD8U, std::uint8_t)
+		ARC_LOAD(LD16S, std::int16_t)
+		ARC_LOAD(LD16U, std::uint16_t)
+		ARC_LOAD(LD32S, std::int32_t)
+		ARC_LOAD(LD32U, std::uint32_t)
+		ARC_LOAD(LD64, std::uint64_t)
+		op_LDN:
+		{
+			const std::byte *p = address(s[pc->a]);
+			if (!p)
+				ARC_TRAP("load from null pointer");
+			std::fill_n(s + pc->dst, pc->n, 0);
+			std::memcpy(s + pc->dst, p, pc->c);
+		}
+		ARC_NEXT();
+		ARC_STORE(ST8, std::uint8_t)
+		ARC_STORE(ST16, std::uint16_t)
+		ARC_STORE(ST32, std::uint32_t)
+		ARC_STORE(ST64, std::uint64_t)
+		op_STN:
+		{
+			std::byte *p = address(s[pc->b]);
+			if (!p)
+				ARC_TRAP("store to null pointer");
+			std::memcpy(p, s + pc->a, pc->c);
+		}
+		ARC_NEXT();
+
+		ARC_ATOMIC(8)
+		ARC_ATOMIC(16)
+		ARC_ATOMIC(32)
+		ARC_ATOMIC(64)
+
+		op_VBIN:
+		op_VNOT:
+		{
+			const auto op = static_cast<NodeType>(pc->c >> 8);
+			const auto elem = static_cast<DataType>(pc->c & 0xff);
+			if (!vector_op(op, elem, pc->n, reinterpret_cast<std::byte *>(s + pc->dst),
+			               reinterpret_cast<const std::byte *>(s + pc->a), reinterpret_cast<const std::byte *>(s + pc->b)))
+				ARC_TRAP("invalid vector operation");
+		}
+		ARC_NEXT();
+		op_VBUILD:
+		{
+			const auto elem = static_cast<DataType>(pc->c);
+			const std::uint32_t size = elem_sz(elem);
+			const std::uint32_t *lanes = fn->operands.data() + pc->a;
+			auto *dst = reinterpret_cast<std::byte *>(s + pc->dst);
+			std::fill_n(s + pc->dst, (pc->n * size + 7) / 8, 0);
+			for (std::size_t i = 0; i < pc->n; ++i)
+				store_lane(elem, dst + i * size, s[lanes[i]]);
+		}
+		ARC_NEXT();
+		op_VSPLAT:
+		{
+			const auto elem = static_cast<DataType>(pc->c);
+			const std::uint32_t size = elem_sz(elem);
+			const std::uint64_t value = s[pc->a];
+			auto *dst = reinterpret_cast<std::byte *>(s + pc->dst);
+			std::fill_n(s + pc->dst, (pc->n * size + 7) / 8, 0);
+			for (std::size_t i = 0; i < pc->n; ++i)
+				store_lane(elem, dst + i * size, value);
+		}
+		ARC_NEXT();
+		op_VEXT:
+		{
+			const auto elem = static_cast<DataType>(pc->c);
+			const std::uint64_t lane = s[pc->b];
+			if (lane >= pc->n)
+				ARC_TRAP("vector lane out of range");
+			s[pc->dst] = load_lane(elem, reinterpret_cast<const std::byte *>(s + pc->a) + lane * elem_sz(elem));
+		}
+		ARC_NEXT();
+
+		op_JMP: pc = code + pc->a; ARC_DISPATCH();
+		op_BR: pc = code + (s[pc->a] ? pc->b : pc->c); ARC_DISPATCH();
+
+		op_CALL:
+		{
+			const auto *callee = reinterpret_cast<const Function *>(static_cast<std::uintptr_t>(s[pc->a]));
+			const std::uint32_t *argv = fn->operands.data() + pc->b;
+			if (!callee)
+				ARC_TRAP("call through null function pointer");
+
+			if (callee->external)
+			{
+				std::uint64_t value = 0;
+				if (const char *why = call_host(*callee, s, argv, pc->n, value))
+					ARC_TRAP(why);
+				if (pc->dst != NONE)
+					s[pc->dst] = value;
+				ARC_NEXT();
+			}
+
+			if (!enter(callee, argv, pc->n, pc + 1, nullptr, pc->dst))
+				ARC_TRAP("stack overflow");
+		}
+		ARC_DISPATCH();
+		op_INVOKE:
+		{
+			const auto *callee = reinterpret_cast<const Function *>(static_cast<std::uintptr_t>(s[pc->a]));
+			const std::uint32_t *argv = fn->operands.data() + pc->b;
+			const Instruction *normal = code + argv[pc->n];
+			const Instruction *except = code + argv[pc->n + 1];
+
+			if (!callee)
+				pc = except;
+			else if (callee->external)
+			{
+				std::uint64_t value = 0;
+				if (call_host(*callee, s, argv, pc->n, value))
+					pc = except;
+				else
+				{
+					if (pc->dst != NONE)
+						s[pc->dst] = value;
+					pc = normal;
+				}
+			}
+			else if (!enter(callee, argv, pc->n, normal, except, pc->dst))
+				pc = except;
+		}
+		ARC_DISPATCH();
+
+		op_RET:
+		{
+			if (depth - 1 == floor)
+			{
+				const std::uint64_t value = s[pc->a];
+				arena_top = frames[--depth].arena;
+				return value;
+			}
+
+			const std::uint64_t *value = s + pc->a;
+			const std::uint16_t count = pc->n;
+			const Frame &done = leave();
+			if (done.dst != NONE)
+				std::memcpy(s + done.dst, value, count * sizeof(std::uint64_t));
+			pc = done.ret;
+		}
+		ARC_DISPATCH();
+		op_RETV:
+		{
+			if (depth - 1 == floor)
+			{
+				arena_top = frames[--depth].arena;
+				return 0;
+			}
+
+			const Frame &done = leave();
+			if (done.dst != NONE)
+				s[done.dst] = 0;
+			pc = done.ret;
+		}
+		ARC_DISPATCH();
+
+	trap:
+		{
+			/* unwind to the innermost frame entered through an INVOKE */
+			const Function *where = fn;
+			while (depth - 1 > floor)
+			{
+				const Frame &done = leave();
+				if (done.unwind)
+				{
+					pc = done.unwind;
+					ARC_DISPATCH();
+				}
+			}
+
+			arena_top = frames[--depth].arena;
+			throw std::runtime_error("trap in function '" + where->name + "': " + reason);
+		}
+
+#undef ARC_ATOMIC
+#undef ARC_STORE
+#undef ARC_LOAD
+#undef ARC_BINARY
+#undef ARC_UNARY
+#undef ARC_TRAP
+#undef ARC_NEXT
+#undef ARC_DISPATCH
+	}
+
+#pragma GCC diagnostic pop
+}
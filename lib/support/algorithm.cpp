@@ -1,6 +1,8 @@
 /* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
 
+#include <arc/foundation/module.hpp>
 #include <arc/foundation/node.hpp>
+#include <arc/foundation/region.hpp>
 #include <arc/support/algorithm.hpp>
 
 namespace arc
@@ -22,6 +24,9 @@ namespace arc
 				if (std::ranges::find(new_input->users, node) == new_input->users.end())
 					new_input->users.push_back(node);
 
+				mark_dirty(node);
+				mark_dirty(old_input);
+				mark_dirty(new_input);
 				return true;
 			}
 		}
@@ -46,6 +51,7 @@ namespace arc
 
 		/* clear old_node's user list since all connections have been transferred */
 		old_node->users.clear();
+		mark_dirty(old_node);
 		return updated_count;
 	}
 
@@ -76,4 +82,21 @@ namespace arc
 				return 0;
 		}
 	}
+
+	Node *incoming_value(const Node *from, const Region *pred)
+	{
+		/* prefer a value defined in the predecessor itself; otherwise the value
+		 * passes through it from a dominating region */
+		for (Node *input: from->inputs)
+		{
+			if (input && input->parent == pred)
+				return input;
+		}
+		for (Node *input: from->inputs)
+		{
+			if (input && input->parent && input->parent->dominates(pred))
+				return input;
+		}
+		return nullptr;
+	}
 }
@@ -0,0 +1,414 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <new>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/pass-manager.hpp>
+#include <arc/support/compile-server.hpp>
+#include <arc/support/generator.hpp>
+#include <arc/support/output-buffer.hpp>
+#include <arc/support/parser.hpp>
+#include <arc/support/printer.hpp>
+
+namespace arc
+{
+	namespace
+	{
+		/* how often `serve` looks for finished jobs while it has nothing to accept */
+		constexpr int reap_interval_ms = 10;
+
+		/* status byte and u32 length in front of every reply */
+		constexpr std::size_t reply_header = 1 + sizeof(std::uint32_t);
+
+		/* closes the descriptor when the scope ends */
+		struct Descriptor
+		{
+			int fd;
+
+			~Descriptor()
+			{
+				if (fd >= 0)
+					::close(fd);
+			}
+		};
+
+		sockaddr_un address(const std::string &path)
+		{
+			sockaddr_un addr {};
+			addr.sun_family = AF_UNIX;
+			if (path.empty() || path.size() >= sizeof(addr.sun_path))
+				throw std::system_error(ENAMETOOLONG, std::generic_category(), "invalid compile server socket path: " + path);
+			std::memcpy(addr.sun_path, path.data(), path.size());
+			return addr;
+		}
+
+		void send_all(const int fd, const char *data, std::size_t size, const int flags = 0)
+		{
+			while (size > 0)
+			{
+				const ssize_t sent = ::send(fd, data, size, flags | MSG_NOSIGNAL);
+				if (sent < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					throw std::system_error(errno, std::generic_category(), "failed to send to compile server peer");
+				}
+				data += sent;
+				size -= static_cast<std::size_t>(sent);
+			}
+		}
+
+		/* false if the peer hung up before `size` bytes arrived */
+		bool receive_all(const int fd, char *data, std::size_t size)
+		{
+			while (size > 0)
+			{
+				const ssize_t received = ::recv(fd, data, size, 0);
+				if (received < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					throw std::system_error(errno, std::generic_category(), "failed to receive from compile server peer");
+				}
+				if (received == 0)
+					return false;
+				data += received;
+				size -= static_cast<std::size_t>(received);
+			}
+			return true;
+		}
+
+		void reply(const int fd, const JobStatus status, const std::string_view output, const int flags = 0)
+		{
+			char header[reply_header];
+			const auto size = static_cast<std::uint32_t>(std::min<std::size_t>(output.size(), std::numeric_limits<std::uint32_t>::max()));
+			header[0] = static_cast<char>(status);
+			std::memcpy(header + 1, &size, sizeof size);
+			send_all(fd, header, sizeof header, flags);
+			send_all(fd, output.data(), size, flags);
+		}
+
+		/* bytes of address space the process has mapped, or 0 if that cannot be told */
+		std::size_t mapped_bytes()
+		{
+			std::ifstream statm("/proc/self/statm");
+			std::size_t pages = 0;
+			if (!(statm >> pages))
+				return 0;
+			return pages * static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+		}
+
+		/* answer for a job whose process ended without replying */
+		std::string describe_exit(const int status)
+		{
+			if (WIFSIGNALED(status))
+				return std::format("job was killed by signal {}", WTERMSIG(status));
+			return std::format("job exited with status {} without replying", WEXITSTATUS(status));
+		}
+	}
+
+	CompileServer::CompileServer(ServerConfig config) : config(std::move(config))
+	{
+		const sockaddr_un addr = address(this->config.socket_path);
+		const auto fail = [this](const char *what)
+		{
+			const int error = errno;
+			for (const int fd: { listener, wake[0], wake[1] })
+			{
+				if (fd >= 0)
+					::close(fd);
+			}
+			throw std::system_error(error, std::generic_category(), what);
+		};
+
+		listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+		if (listener < 0)
+			fail("failed to create compile server socket");
+		if (::pipe2(wake, O_CLOEXEC | O_NONBLOCK) < 0)
+			fail("failed to create compile server wake-up pipe");
+
+		/* a socket left behind by a server that did not shut down cleanly is replaced; anything else is not touched */
+		struct stat existing {};
+		if (::lstat(this->config.socket_path.c_str(), &existing) == 0 && S_ISSOCK(existing.st_mode))
+			::unlink(this->config.socket_path.c_str());
+
+		if (::bind(listener, reinterpret_cast<const sockaddr *>(&addr), sizeof addr) < 0)
+			fail("failed to bind compile server socket");
+		if (::listen(listener, SOMAXCONN) < 0)
+			fail("failed to listen on compile server socket");
+	}
+
+	CompileServer::~CompileServer()
+	{
+		::close(listener);
+		::close(wake[0]);
+		::close(wake[1]);
+		::unlink(config.socket_path.c_str());
+	}
+
+	CompileServer &CompileServer::pipeline(Configure configure)
+	{
+		this->configure = std::move(configure);
+		return *this;
+	}
+
+	void CompileServer::serve()
+	{
+		warm_up();
+
+		const std::size_t workers = config.workers ? config.workers : std::max(1u, std::thread::hardware_concurrency());
+		std::unordered_map<pid_t, int> running; /* job process -> its connection, kept to answer for it if it dies */
+		const auto reap = [&running](bool block)
+		{
+			for (;;)
+			{
+				int status = 0;
+				const pid_t pid = ::waitpid(-1, &status, block ? 0 : WNOHANG);
+				if (pid < 0 && errno == EINTR)
+					continue;
+				if (pid < 0 && errno == ECHILD)
+				{
+					/* someone else collected the jobs; nothing is left to wait for */
+					for (const auto &[job, connection]: running)
+						::close(connection);
+					running.clear();
+				}
+				if (pid <= 0)
+					return;
+
+				const auto it = running.find(pid);
+				if (it == running.end())
+					continue;
+				if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+				{
+					/* the job may have died mid-reply or its client may be gone; either way the server moves on */
+					try
+					{
+						reply(it->second, JobStatus::CRASHED, describe_exit(status), MSG_DONTWAIT);
+					}
+					catch (const std::system_error &) {}
+				}
+				::close(it->second);
+				running.erase(it);
+				block = false;
+			}
+		};
+
+		bool stopping = false;
+		while (!stopping || !running.empty())
+		{
+			reap(stopping || running.size() >= workers);
+			if (stopping || running.size() >= workers)
+				continue;
+
+			pollfd fds[] = { { listener, POLLIN, 0 }, { wake[0], POLLIN, 0 } };
+			if (::poll(fds, 2, running.empty() ? -1 : reap_interval_ms) < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				throw std::system_error(errno, std::generic_category(), "failed to wait for compile jobs");
+			}
+
+			if (fds[1].revents & POLLIN)
+			{
+				char drained[16];
+				while (::read(wake[0], drained, sizeof drained) > 0) {}
+				stopping = true;
+				continue;
+			}
+			if (!(fds[0].revents & POLLIN))
+				continue;
+
+			const int connection = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+			if (connection < 0)
+			{
+				if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNABORTED)
+					continue;
+				throw std::system_error(errno, std::generic_category(), "failed to accept compile job");
+			}
+			++accepted;
+
+			const pid_t pid = ::fork();
+			if (pid == 0)
+			{
+				::close(listener);
+				::close(wake[0]);
+				::close(wake[1]);
+				run_job(connection);
+			}
+			if (pid < 0)
+			{
+				try
+				{
+					reply(connection, JobStatus::FAILED, std::format("could not start job: {}", std::strerror(errno)), MSG_DONTWAIT);
+				}
+				catch (const std::system_error &) {}
+				::close(connection);
+				continue;
+			}
+			running.emplace(pid, connection);
+		}
+	}
+
+	void CompileServer::stop()
+	{
+		constexpr char byte = 0;
+		[[maybe_unused]] const ssize_t written = ::write(wake[1], &byte, 1);
+	}
+
+	std::size_t CompileServer::jobs() const
+	{
+		return accepted;
+	}
+
+	void CompileServer::warm_up()
+	{
+		pm = std::make_unique<PassManager>();
+		if (configure)
+			configure(*pm);
+		if (config.warm_up_nodes == 0)
+			return;
+
+		/* a job goes through the parser, the pipeline and the printer, so the warm-up does too */
+		OutputBuffer out;
+		Printer(*generate({ .nodes = config.warm_up_nodes })).print(out);
+		const std::unique_ptr<Module> module = parse(out.str());
+		pm->run(*module);
+		out.clear();
+		Printer(*module).print(out);
+		pm->clear_analyses();
+	}
+
+	void CompileServer::run_job(const int connection) const
+	{
+		/* only ever runs in the job's own process; the server learns how it went from the exit status */
+		int code = 0;
+		try
+		{
+			CompileResult result;
+			std::uint32_t size = 0;
+			if (!receive_all(connection, reinterpret_cast<char *>(&size), sizeof size))
+				result = { JobStatus::REJECTED, "request ended before its length" };
+			else if (size > config.max_request)
+				result = { JobStatus::REJECTED, std::format("request of {} bytes is over the limit of {}", size, config.max_request) };
+			else
+			{
+				if (const std::size_t base = mapped_bytes(); config.memory_limit != 0 && base != 0)
+				{
+					const rlimit limit { base + config.memory_limit, base + config.memory_limit };
+					::setrlimit(RLIMIT_AS, &limit);
+				}
+
+				std::string text(size, '\0');
+				if (!receive_all(connection, text.data(), size))
+					result = { JobStatus::REJECTED, "request ended before its text" };
+				else
+					result = compile(text);
+			}
+			reply(connection, result.status, result.output);
+		}
+		catch (const std::bad_alloc &)
+		{
+			try
+			{
+				reply(connection, JobStatus::OUT_OF_MEMORY, "job went over its memory limit");
+			}
+			catch (...)
+			{
+				code = 1;
+			}
+		}
+		catch (...)
+		{
+			code = 1;
+		}
+		::_exit(code);
+	}
+
+	CompileResult CompileServer::compile(const std::string_view text) const
+	{
+		try
+		{
+			const std::unique_ptr<Module> module = parse(text);
+			pm->run(*module);
+			OutputBuffer out;
+			Printer(*module).print(out);
+			return { JobStatus::OK, out.str() };
+		}
+		catch (const ParseError &e)
+		{
+			return { JobStatus::PARSE_ERROR, e.what() };
+		}
+		catch (const std::bad_alloc &)
+		{
+			return { JobStatus::OUT_OF_MEMORY, std::format("job went over its memory limit of {} bytes", config.memory_limit) };
+		}
+		catch (const std::exception &e)
+		{
+			return { JobStatus::FAILED, e.what() };
+		}
+	}
+
+	CompileClient::CompileClient(std::string socket_path) : path(std::move(socket_path)) {}
+
+	CompileResult CompileClient::compile(const std::string_view text) const
+	{
+		if (text.size() > std::numeric_limits<std::uint32_t>::max())
+			throw std::length_error("module text is too large for one compile request");
+
+		const sockaddr_un addr = address(path);
+		const Descriptor server { ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0) };
+		if (server.fd < 0)
+			throw std::system_error(errno, std::generic_category(), "failed to create compile client socket");
+		if (::connect(server.fd, reinterpret_cast<const sockaddr *>(&addr), sizeof addr) < 0)
+			throw std::system_error(errno, std::generic_category(), "failed to connect to compile server at " + path);
+
+		/* a rejected request is answered before the server has read all of it,
+		 * so a failed send still leaves a reply to read */
+		std::exception_ptr unsent;
+		try
+		{
+			const auto size = static_cast<std::uint32_t>(text.size());
+			send_all(server.fd, reinterpret_cast<const char *>(&size), sizeof size);
+			send_all(server.fd, text.data(), text.size());
+		}
+		catch (const std::system_error &)
+		{
+			unsent = std::current_exception();
+		}
+
+		char header[reply_header];
+		if (!receive_all(server.fd, header, sizeof header))
+		{
+			if (unsent)
+				std::rethrow_exception(unsent);
+			throw std::system_error(ECONNRESET, std::generic_category(), "compile server hung up without replying");
+		}
+
+		CompileResult result;
+		std::uint32_t length = 0;
+		result.status = static_cast<JobStatus>(header[0]);
+		std::memcpy(&length, header + 1, sizeof length);
+		result.output.resize(length);
+		if (!receive_all(server.fd, result.output.data(), length))
+			throw std::system_error(ECONNRESET, std::generic_category(), "compile server hung up in the middle of a reply");
+		return result;
+	}
+}
@@ -0,0 +1,382 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <vector>
+#include <arc/foundation/builder.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/support/generator.hpp>
+
+namespace arc
+{
+	namespace
+	{
+		/* splitmix64; unlike the standard distributions it gives the same
+		 * sequence with every standard library */
+		class Random
+		{
+		public:
+			explicit Random(const std::uint64_t seed) : state(seed) {}
+
+			std::uint64_t next()
+			{
+				std::uint64_t z = state += 0x9e3779b97f4a7c15ULL;
+				z = (z ^ z >> 30) * 0xbf58476d1ce4e5b9ULL;
+				z = (z ^ z >> 27) * 0x94d049bb133111ebULL;
+				return z ^ z >> 31;
+			}
+
+			std::size_t below(const std::size_t n)
+			{
+				return n == 0 ? 0 : static_cast<std::size_t>(next() % n);
+			}
+
+			bool chance(const double p)
+			{
+				return static_cast<double>(next() >> 11) * 0x1.0p-53 < p;
+			}
+
+		private:
+			std::uint64_t state;
+		};
+
+		enum class Kind : std::uint8_t
+		{
+			ARITHMETIC,
+			MEMORY,
+			CALL,
+			VECTOR,
+			ATOMIC
+		};
+
+		/* stack slots every generated function starts with */
+		constexpr std::size_t slot_count = 4;
+
+		class Generator
+		{
+		public:
+			Generator(Module &module, const GeneratorOptions &options) :
+				opts(options), rng(options.seed), builder(module) {}
+
+			void run();
+
+		private:
+			const GeneratorOptions &opts;
+			Random rng;
+			Builder builder;
+			TypedData record;
+			std::vector<Node *> functions;
+
+			/* per function */
+			std::vector<Node *> values;
+			std::array<Node *, slot_count> slots = {};
+			std::array<Node *, slot_count> addresses = {};
+			Node *object = nullptr;
+			Node *counter = nullptr;
+			Node *limit = nullptr;
+			std::size_t emitted = 0;
+			std::size_t blocks = 0;
+
+			void function(std::size_t index, std::size_t budget);
+
+			void region(Builder &b, std::uint32_t depth, std::size_t budget, Node *self, Node *next);
+
+			void fill(Builder &b, std::size_t budget);
+
+			Kind pick();
+
+			Node *operand(Builder &b);
+
+			void push(Node *value);
+
+			void arithmetic(Builder &b);
+
+			void memory(Builder &b);
+
+			void call(Builder &b);
+
+			void vector(Builder &b);
+
+			void atomic(Builder &b);
+		};
+
+		void Generator::run()
+		{
+			record = builder.struct_type("Record")
+				.field("id", DataType::INT32)
+				.field("count", DataType::INT64)
+				.field("flags", DataType::UINT8)
+				.field("value", DataType::INT32)
+				.build();
+
+			const std::size_t count = opts.functions != 0
+				                          ? opts.functions
+				                          : std::max<std::size_t>(1, opts.nodes / std::max<std::size_t>(1, opts.nodes_per_function));
+			const std::size_t budget = std::max<std::size_t>(1, opts.nodes / count);
+
+			functions.reserve(count);
+			for (std::size_t i = 0; i < count; ++i)
+				function(i, budget);
+
+			/* the last function calls into the rest, like an entry point would */
+			functions.back()->traits |= NodeTraits::EXPORT;
+		}
+
+		void Generator::function(const std::size_t index, const std::size_t budget)
+		{
+			values.clear();
+			emitted = 0;
+			blocks = 0;
+
+			Node *fn = builder.function<DataType::INT32>("fn" + std::to_string(index))
+				.param<DataType::INT32>("a")
+				.param<DataType::INT32>("b")
+				.body([&](Builder &fb, Node *a, Node *b)
+				{
+					push(a);
+					push(b);
+					limit = b;
+
+					for (std::size_t i = 0; i < slot_count; ++i)
+					{
+						slots[i] = fb.alloc<DataType::INT32>(fb.lit(1));
+						addresses[i] = fb.addr_of(slots[i]);
+						fb.store(a, slots[i]);
+					}
+					object = fb.alloc(record);
+					counter = fb.alloc<DataType::INT32>(fb.lit(1));
+					fb.store(fb.lit(0), counter);
+					emitted += slot_count * 4 + 4;
+
+					region(fb, 0, budget > emitted ? budget - emitted : 0, nullptr, nullptr);
+					return nullptr;
+				});
+
+			functions.push_back(fn);
+		}
+
+		/* the budget of a region is split between its own nodes and its children;
+		 * `next` is the entry of the block control continues in, or null to return */
+		void Generator::region(Builder &b, const std::uint32_t depth, const std::size_t budget, Node *self, Node *next) // NOLINT(*-no-recursion)
+		{
+			const std::uint32_t fan_out = depth < opts.depth ? opts.fan_out : 0;
+			const std::size_t own = fan_out == 0 ? budget : budget / (fan_out + 1);
+			fill(b, own);
+
+			if (fan_out == 0)
+			{
+				/* innermost blocks end the chain or loop back on the shared counter */
+				if (self && next && rng.chance(opts.loops))
+				{
+					Node *i = b.add(b.load(counter), b.lit(1));
+					b.store(i, counter);
+					b.branch(b.lt(i, limit), self, next);
+					emitted += 6;
+				}
+				else if (next)
+				{
+					b.jump(next);
+					++emitted;
+				}
+				else
+				{
+					b.ret(values.back());
+					++emitted;
+				}
+				return;
+			}
+
+			std::vector<BlockBuilder<DataType::VOID> > children;
+			children.reserve(fan_out);
+			for (std::uint32_t i = 0; i < fan_out; ++i)
+				children.push_back(b.block<DataType::VOID>("b" + std::to_string(blocks++)));
+
+			/* values of a block are out of scope in its siblings */
+			const std::size_t scope = values.size();
+			const std::size_t share = (budget - own) / fan_out;
+			for (std::uint32_t i = 0; i < fan_out; ++i)
+			{
+				Node *after = i + 1 < fan_out ? children[i + 1].entry() : next;
+				Node *entry = children[i].entry();
+				children[i]([&](Builder &cb)
+				{
+					region(cb, depth + 1, share, entry, after);
+					return nullptr;
+				});
+				values.resize(scope);
+			}
+
+			b.jump(children.front().entry());
+			++emitted;
+		}
+
+		void Generator::fill(Builder &b, const std::size_t budget)
+		{
+			for (const std::size_t end = emitted + budget; emitted < end;)
+			{
+				switch (pick())
+				{
+					case Kind::ARITHMETIC:
+						arithmetic(b);
+						break;
+					case Kind::MEMORY:
+						memory(b);
+						break;
+					case Kind::CALL:
+						call(b);
+						break;
+					case Kind::VECTOR:
+						vector(b);
+						break;
+					case Kind::ATOMIC:
+						atomic(b);
+						break;
+				}
+			}
+		}
+
+		Kind Generator::pick()
+		{
+			const NodeMix &mix = opts.mix;
+			const std::uint64_t total = static_cast<std::uint64_t>(mix.arithmetic) + mix.memory + mix.calls + mix.vectors + mix.atomics;
+			std::uint64_t r = total == 0 ? 0 : rng.next() % total;
+
+			if (r < mix.arithmetic || total == 0)
+				return Kind::ARITHMETIC;
+			r -= mix.arithmetic;
+			if (r < mix.memory)
+				return Kind::MEMORY;
+			r -= mix.memory;
+			if (r < mix.calls)
+				return Kind::CALL;
+			r -= mix.calls;
+			return r < mix.vectors ? Kind::VECTOR : Kind::ATOMIC;
+		}
+
+		/* mostly recent values, sometimes a fresh literal */
+		Node *Generator::operand(Builder &b)
+		{
+			if (rng.below(4) == 0)
+			{
+				++emitted;
+				return b.lit(static_cast<std::int32_t>(rng.below(64)) + 1);
+			}
+
+			const std::size_t window = std::min<std::size_t>(std::max<std::uint32_t>(opts.window, 1), values.size());
+			return values[values.size() - 1 - rng.below(window)];
+		}
+
+		void Generator::push(Node *value)
+		{
+			values.push_back(value);
+		}
+
+		void Generator::arithmetic(Builder &b)
+		{
+			static constexpr std::array ops = {
+				NodeType::ADD, NodeType::SUB, NodeType::MUL, NodeType::BAND,
+				NodeType::BOR, NodeType::BXOR, NodeType::BSHL, NodeType::BSHR
+			};
+
+			Node *lhs = operand(b);
+			Node *rhs = operand(b);
+			if (rng.below(8) == 0)
+			{
+				/* a comparison feeding a select */
+				push(b.select(b.lt(lhs, rhs), lhs, rhs));
+				emitted += 2;
+				return;
+			}
+
+			push(b.binary_op(ops[rng.below(ops.size())], lhs, rhs));
+			++emitted;
+		}
+
+		void Generator::memory(Builder &b)
+		{
+			static constexpr std::array fields = { "id", "value" };
+
+			switch (rng.below(5))
+			{
+				case 0:
+				case 1:
+					push(b.load(slots[rng.below(slot_count)]));
+					++emitted;
+					break;
+				case 2:
+				case 3:
+					b.store(operand(b), slots[rng.below(slot_count)]);
+					++emitted;
+					break;
+				default:
+				{
+					Node *field = b.struct_field(object, fields[rng.below(fields.size())]);
+					b.store(operand(b), field);
+					push(b.load(field));
+					emitted += 4;
+					break;
+				}
+			}
+		}
+
+		void Generator::call(Builder &b)
+		{
+			if (functions.empty())
+				return arithmetic(b);
+
+			/* favour recent callees so call chains get deep as well as wide */
+			const std::size_t back = std::min<std::size_t>(functions.size(), 1 + rng.below(8));
+			Node *callee = rng.below(4) == 0 ? functions[rng.below(functions.size())] : functions[functions.size() - back];
+			push(b.call(callee, { operand(b), operand(b) }));
+			++emitted;
+		}
+
+		void Generator::vector(Builder &b)
+		{
+			constexpr std::uint32_t lanes = 4;
+
+			Node *vec = nullptr;
+			if (rng.below(2) == 0)
+			{
+				vec = b.vector_splat(operand(b), lanes);
+				++emitted;
+			}
+			else
+			{
+				std::vector<Node *> elements;
+				for (std::uint32_t i = 0; i < lanes; ++i)
+					elements.push_back(operand(b));
+				vec = b.vector_build(elements);
+				++emitted;
+			}
+
+			push(b.vector_extract(vec, static_cast<std::uint32_t>(rng.below(lanes))));
+			emitted += 2;
+		}
+
+		void Generator::atomic(Builder &b)
+		{
+			const std::size_t slot = rng.below(slot_count);
+			if (rng.below(2) == 0)
+			{
+				b.store(operand(b)).to_atomic(slots[slot], AtomicOrdering::RELEASE);
+				emitted += 2;
+				return;
+			}
+
+			Node *load = b.create_node(NodeType::ATOMIC_LOAD, DataType::INT32);
+			Builder::connect_inputs(load, { addresses[slot], b.lit(static_cast<std::uint8_t>(AtomicOrdering::ACQUIRE)) });
+			push(load);
+			emitted += 2;
+		}
+	}
+
+	std::unique_ptr<Module> generate(const GeneratorOptions &options)
+	{
+		auto module = std::make_unique<Module>("synthetic");
+		Generator(*module, options).run();
+		return module;
+	}
+}
@@ -1,9 +1,22 @@
 /* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
 
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/region.hpp>
 #include <arc/support/inference.hpp>
 
 namespace arc
 {
+	namespace
+	{
+		void set_vector(Node *node, const DataTraits<DataType::VECTOR>::value &vec)
+		{
+			node->value.set<DataTraits<DataType::VECTOR>::value, DataType::VECTOR>(vec);
+			/* the interned type handle follows the value */
+			if (node->parent)
+				node->parent->module().intern_t(node);
+		}
+	}
+
 	bool infer_binary_t(Node *lhs, Node *rhs)
 	{
 		if (!lhs || !rhs)
@@ -32,8 +45,8 @@ namespace arc
 				auto rhs_promoted = rhs_vec;
 				lhs_promoted.elem_type = promoted_elem;
 				rhs_promoted.elem_type = promoted_elem;
-				lhs->value.set<DataTraits<DataType::VECTOR>::value, DataType::VECTOR>(lhs_promoted);
-				rhs->value.set<DataTraits<DataType::VECTOR>::value, DataType::VECTOR>(rhs_promoted);
+				set_vector(lhs, lhs_promoted);
+				set_vector(rhs, rhs_promoted);
 				return true;
 			}
 			/* non-vector types are the same; non-trivial types do not apply for the case */
@@ -65,8 +78,8 @@ namespace arc
 			auto rhs_promoted = rhs_vec;
 			lhs_promoted.elem_type = promoted_elem;
 			rhs_promoted.elem_type = promoted_elem;
-			lhs->value.set<DataTraits<DataType::VECTOR>::value, DataType::VECTOR>(lhs_promoted);
-			rhs->value.set<DataTraits<DataType::VECTOR>::value, DataType::VECTOR>(rhs_promoted);
+			set_vector(lhs, lhs_promoted);
+			set_vector(rhs, rhs_promoted);
 			return true;
 		}
 
@@ -0,0 +1,143 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <unistd.h>
+#include <arc/support/output-buffer.hpp>
+
+namespace arc
+{
+	OutputBuffer &OutputBuffer::operator<<(std::string_view str)
+	{
+		/* fill the tail of the current chunk before starting a new one */
+		if (!chunks.empty())
+		{
+			Chunk &last = chunks.back();
+			const std::size_t n = std::min(str.size(), last.capacity - last.used);
+			std::memcpy(last.data.get() + last.used, str.data(), n);
+			last.used += n;
+			total += n;
+			str.remove_prefix(n);
+		}
+
+		if (!str.empty())
+		{
+			char *dest = reserve(str.size());
+			std::memcpy(dest, str.data(), str.size());
+			commit(str.size());
+		}
+		return *this;
+	}
+
+	OutputBuffer &OutputBuffer::operator<<(const char c)
+	{
+		*reserve(1) = c;
+		commit(1);
+		return *this;
+	}
+
+	OutputBuffer &OutputBuffer::operator<<(const float value)
+	{
+		constexpr std::size_t max_chars = 32;
+		char *first = reserve(max_chars);
+		const auto [last, ec] = std::to_chars(first, first + max_chars, value);
+		commit(static_cast<std::size_t>(last - first));
+		return *this;
+	}
+
+	OutputBuffer &OutputBuffer::operator<<(const double value)
+	{
+		constexpr std::size_t max_chars = 32;
+		char *first = reserve(max_chars);
+		const auto [last, ec] = std::to_chars(first, first + max_chars, value);
+		commit(static_cast<std::size_t>(last - first));
+		return *this;
+	}
+
+	void OutputBuffer::append(OutputBuffer &&other)
+	{
+		if (&other == this)
+			return;
+
+		chunks.reserve(chunks.size() + other.chunks.size());
+		for (Chunk &chunk: other.chunks)
+			chunks.push_back(std::move(chunk));
+		total += other.total;
+
+		other.chunks.clear();
+		other.total = 0;
+	}
+
+	std::size_t OutputBuffer::size() const
+	{
+		return total;
+	}
+
+	bool OutputBuffer::empty() const
+	{
+		return total == 0;
+	}
+
+	std::string OutputBuffer::str() const
+	{
+		std::string result;
+		result.reserve(total);
+		for (const Chunk &chunk: chunks)
+			result.append(chunk.data.get(), chunk.used);
+		return result;
+	}
+
+	void OutputBuffer::write(std::ostream &os) const
+	{
+		for (const Chunk &chunk: chunks)
+			os.write(chunk.data.get(), static_cast<std::streamsize>(chunk.used));
+	}
+
+	void OutputBuffer::write(const int fd) const
+	{
+		for (const Chunk &chunk: chunks)
+		{
+			const char *data = chunk.data.get();
+			std::size_t remaining = chunk.used;
+			while (remaining > 0)
+			{
+				const ssize_t written = ::write(fd, data, remaining);
+				if (written < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					throw std::system_error(errno, std::generic_category(), "failed to write output buffer");
+				}
+
+				data += written;
+				remaining -= static_cast<std::size_t>(written);
+			}
+		}
+	}
+
+	void OutputBuffer::clear()
+	{
+		chunks.clear();
+		total = 0;
+	}
+
+	char *OutputBuffer::reserve(const std::size_t n)
+	{
+		if (chunks.empty() || chunks.back().capacity - chunks.back().used < n)
+		{
+			const std::size_t capacity = std::max(chunk_size, n);
+			chunks.push_back({ std::make_unique_for_overwrite<char[]>(capacity), 0, capacity });
+		}
+
+		Chunk &last = chunks.back();
+		return last.data.get() + last.used;
+	}
+
+	void OutputBuffer::commit(const std::size_t n)
+	{
+		chunks.back().used += n;
+		total += n;
+	}
+}
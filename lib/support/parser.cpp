@@ -0,0 +1,1266 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <cerrno>
+#include <charconv>
+#include <fcntl.h>
+#include <format>
+#include <limits>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/node.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/foundation/typed-data.hpp>
+#include <arc/support/allocator.hpp>
+#include <arc/support/inference.hpp>
+#include <arc/support/parser.hpp>
+
+namespace arc
+{
+	namespace
+	{
+		bool is_scalar(const DataType type)
+		{
+			switch (type)
+			{
+				case DataType::BOOL:
+				case DataType::INT8:
+				case DataType::INT16:
+				case DataType::INT32:
+				case DataType::INT64:
+				case DataType::UINT8:
+				case DataType::UINT16:
+				case DataType::UINT32:
+				case DataType::UINT64:
+				case DataType::FLOAT32:
+				case DataType::FLOAT64:
+					return true;
+				default:
+					return false;
+			}
+		}
+
+		bool is_arithmetic(const NodeType type)
+		{
+			switch (type)
+			{
+				case NodeType::ADD:
+				case NodeType::SUB:
+				case NodeType::MUL:
+				case NodeType::DIV:
+				case NodeType::MOD:
+				case NodeType::BAND:
+				case NodeType::BOR:
+				case NodeType::BXOR:
+				case NodeType::BNOT:
+				case NodeType::BSHL:
+				case NodeType::BSHR:
+					return true;
+				default:
+					return false;
+			}
+		}
+
+		bool is_comparison(const NodeType type)
+		{
+			return type == NodeType::EQ || type == NodeType::NEQ ||
+			       type == NodeType::LT || type == NodeType::LTE ||
+			       type == NodeType::GT || type == NodeType::GTE;
+		}
+
+		/* the spelling `dump` gives each type kind */
+		bool kind_of(const std::string_view name, DataType &kind)
+		{
+			static const std::unordered_map<std::string_view, DataType> kinds = {
+				{ "void", DataType::VOID }, { "bool", DataType::BOOL },
+				{ "i8", DataType::INT8 }, { "i16", DataType::INT16 },
+				{ "i32", DataType::INT32 }, { "i64", DataType::INT64 },
+				{ "u8", DataType::UINT8 }, { "u16", DataType::UINT16 },
+				{ "u32", DataType::UINT32 }, { "u64", DataType::UINT64 },
+				{ "f32", DataType::FLOAT32 }, { "f64", DataType::FLOAT64 },
+				{ "ptr", DataType::POINTER }, { "arr", DataType::ARRAY },
+				{ "struct", DataType::STRUCT }, { "fn", DataType::FUNCTION },
+				{ "vec", DataType::VECTOR }
+			};
+
+			const auto it = kinds.find(name);
+			if (it == kinds.end())
+				return false;
+			kind = it->second;
+			return true;
+		}
+
+		/* the spelling `dump` gives each operation; ENTRY, PARAM, LIT and FUNCTION
+		 * never appear as an operation inside a region */
+		bool op_of(const std::string_view name, NodeType &op)
+		{
+			static const std::unordered_map<std::string_view, NodeType> ops = {
+				{ "exit", NodeType::EXIT }, { "add", NodeType::ADD }, { "sub", NodeType::SUB },
+				{ "mul", NodeType::MUL }, { "div", NodeType::DIV }, { "mod", NodeType::MOD },
+				{ "gt", NodeType::GT }, { "gte", NodeType::GTE }, { "lt", NodeType::LT },
+				{ "lte", NodeType::LTE }, { "eq", NodeType::EQ }, { "neq", NodeType::NEQ },
+				{ "band", NodeType::BAND }, { "bor", NodeType::BOR }, { "bxor", NodeType::BXOR },
+				{ "bnot", NodeType::BNOT }, { "bshl", NodeType::BSHL }, { "bshr", NodeType::BSHR },
+				{ "call", NodeType::CALL }, { "alloc", NodeType::ALLOC }, { "load", NodeType::LOAD },
+				{ "store", NodeType::STORE }, { "addr_of", NodeType::ADDR_OF },
+				{ "ptr_load", NodeType::PTR_LOAD }, { "ptr_store", NodeType::PTR_STORE },
+				{ "ptr_add", NodeType::PTR_ADD }, { "cast", NodeType::CAST },
+				{ "atomic_load", NodeType::ATOMIC_LOAD }, { "atomic_store", NodeType::ATOMIC_STORE },
+				{ "atomic_cas", NodeType::ATOMIC_CAS }, { "jump", NodeType::JUMP },
+				{ "branch", NodeType::BRANCH }, { "select", NodeType::SELECT },
+				{ "invoke", NodeType::INVOKE }, { "vector_build", NodeType::VECTOR_BUILD },
+				{ "vector_extract", NodeType::VECTOR_EXTRACT }, { "vector_splat", NodeType::VECTOR_SPLAT },
+				{ "access", NodeType::ACCESS }, { "from", NodeType::FROM }
+			};
+
+			const auto it = ops.find(name);
+			if (it == ops.end())
+				return false;
+			op = it->second;
+			return true;
+		}
+
+		template<typename T>
+		bool parse_number(const std::string_view text, T &out)
+		{
+			const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+			return ec == std::errc() && ptr == text.data() + text.size();
+		}
+
+		/* widened to int64 first since `dump` prints i8 and u8 as integers */
+		template<DataType T>
+		bool set_integer(Node &node, const std::string_view text)
+		{
+			using V = typename DataTraits<T>::value;
+			if constexpr (std::is_signed_v<V>)
+			{
+				std::int64_t wide = 0;
+				if (!parse_number(text, wide) || wide < std::numeric_limits<V>::min() || wide > std::numeric_limits<V>::max())
+					return false;
+				node.value.set<V, T>(static_cast<V>(wide));
+			}
+			else
+			{
+				std::uint64_t wide = 0;
+				if (!parse_number(text, wide) || wide > std::numeric_limits<V>::max())
+					return false;
+				node.value.set<V, T>(static_cast<V>(wide));
+			}
+			return true;
+		}
+
+		template<DataType T>
+		bool set_float(Node &node, const std::string_view text)
+		{
+			using V = typename DataTraits<T>::value;
+			V value = 0;
+			if (!parse_number(text, value))
+				return false;
+			node.value.set<V, T>(value);
+			return true;
+		}
+
+		/* store `text` in `node` as a literal of `type`; false if it is not one */
+		bool set_literal(Node &node, const std::string_view text, const DataType type)
+		{
+			bool ok = false;
+			switch (type)
+			{
+				case DataType::BOOL:
+					ok = text == "true" || text == "false";
+					if (ok)
+						node.value.set<bool, DataType::BOOL>(text == "true");
+					break;
+				case DataType::INT8:
+					ok = set_integer<DataType::INT8>(node, text);
+					break;
+				case DataType::INT16:
+					ok = set_integer<DataType::INT16>(node, text);
+					break;
+				case DataType::INT32:
+					ok = set_integer<DataType::INT32>(node, text);
+					break;
+				case DataType::INT64:
+					ok = set_integer<DataType::INT64>(node, text);
+					break;
+				case DataType::UINT8:
+					ok = set_integer<DataType::UINT8>(node, text);
+					break;
+				case DataType::UINT16:
+					ok = set_integer<DataType::UINT16>(node, text);
+					break;
+				case DataType::UINT32:
+					ok = set_integer<DataType::UINT32>(node, text);
+					break;
+				case DataType::UINT64:
+					ok = set_integer<DataType::UINT64>(node, text);
+					break;
+				case DataType::FLOAT32:
+					ok = set_float<DataType::FLOAT32>(node, text);
+					break;
+				case DataType::FLOAT64:
+					ok = set_float<DataType::FLOAT64>(node, text);
+					break;
+				default:
+					break;
+			}
+
+			if (ok)
+				node.type_kind = type;
+			return ok;
+		}
+
+		/* the type a literal has when nothing around it says otherwise */
+		DataType default_literal_t(const std::string_view text)
+		{
+			if (text == "true" || text == "false")
+				return DataType::BOOL;
+			if (text.find_first_of(".eEn") != std::string_view::npos)
+				return DataType::FLOAT64;
+
+			std::int64_t wide = 0;
+			if (!parse_number(text, wide))
+				return DataType::UINT64;
+			return wide >= std::numeric_limits<std::int32_t>::min() && wide <= std::numeric_limits<std::int32_t>::max()
+				       ? DataType::INT32
+				       : DataType::INT64;
+		}
+
+		/* the values of one numbering scope; slots are indexed by value number */
+		struct Values
+		{
+			const Values *outer = nullptr;
+			std::vector<Node *> nodes;
+			std::vector<std::uint32_t> used;
+			std::size_t undefined = 0;
+
+			void reset()
+			{
+				for (const std::uint32_t n: used)
+					nodes[n] = nullptr;
+				used.clear();
+				undefined = 0;
+			}
+		};
+
+		struct ParsedType
+		{
+			DataType kind = DataType::VOID;
+			TypedData value;
+		};
+
+		struct Operand
+		{
+			Node *node = nullptr;
+			std::string_view literal;
+			std::string_view target; /* region name of a not yet defined jump target */
+		};
+
+		struct PendingField
+		{
+			std::string_view name;   /* empty for padding */
+			std::string_view type;   /* text of the type, or bytes of padding */
+			std::string_view line;
+			std::size_t line_no = 0;
+			std::size_t padding = 0;
+		};
+
+		struct PendingStruct
+		{
+			std::string_view name;
+			std::uint32_t alignment = 8;
+			std::vector<PendingField> fields;
+			std::uint8_t state = 0; /* 0 unbuilt, 1 building, 2 built */
+		};
+
+		class Parser
+		{
+		public:
+			explicit Parser(const std::string_view text) : src(text) {}
+
+			std::unique_ptr<Module> run();
+
+		private:
+			std::string_view src;
+			std::size_t pos = 0;
+			std::size_t line_no = 0;
+			std::string_view line;
+			std::string_view cur;
+
+			std::unique_ptr<Module> mod;
+			Values rodata_values;
+			Values local_values;
+			Values *values = &rodata_values;
+
+			std::unordered_map<std::string_view, Node *> functions;
+			std::unordered_map<std::string_view, Region *> regions;
+			std::unordered_map<std::string_view, std::size_t> pending_index;
+			std::vector<PendingStruct> pending;
+			std::unordered_map<std::uint64_t, Node *> carriers;
+
+			struct Fixup
+			{
+				Node *user;
+				std::size_t index;
+				std::string_view name;
+				std::size_t line_no;
+			};
+
+			std::vector<Fixup> fixups;
+			std::vector<Operand> ops;
+			std::vector<Node *> params;
+			DataType return_kind = DataType::VOID;
+
+			[[noreturn]] void fail(const std::string &message) const
+			{
+				const bool inside = cur.data() >= line.data() && cur.data() <= line.data() + line.size();
+				throw ParseError(line_no, inside ? static_cast<std::size_t>(cur.data() - line.data()) + 1 : 1, message);
+			}
+
+			bool next_line();
+
+			bool next_content_line();
+
+			bool accept(std::string_view text);
+
+			void expect(std::string_view text);
+
+			std::size_t indent();
+
+			std::string_view take_until(std::string_view stops);
+
+			template<typename T>
+			T number();
+
+			void definitions();
+
+			void build_struct(PendingStruct &st);
+
+			void rodata();
+
+			void function();
+
+			void statement(Region *region);
+
+			ParsedType type(StringTable::StringId self = StringTable::INVALID_STRING_ID);
+
+			const TypedData *lookup_struct(std::string_view name);
+
+			Node *carrier(DataType kind, const TypedData *struct_type);
+
+			Node *function_node(std::string_view name);
+
+			Node *use(std::uint32_t n);
+
+			Node *define(std::uint32_t n);
+
+			void operand();
+
+			void target();
+
+			void operands(char close);
+
+			DataType context_of(const Node *node, std::size_t index, const Node *callee) const;
+
+			void finish(Node *node, Region *region, const Node *callee);
+
+			void end_function();
+		};
+
+		bool Parser::next_line()
+		{
+			if (pos >= src.size())
+				return false;
+
+			const std::size_t eol = src.find('\n', pos);
+			line = src.substr(pos, eol == std::string_view::npos ? std::string_view::npos : eol - pos);
+			if (!line.empty() && line.back() == '\r')
+				line.remove_suffix(1);
+			pos = eol == std::string_view::npos ? src.size() : eol + 1;
+			++line_no;
+			cur = line;
+			return true;
+		}
+
+		bool Parser::next_content_line()
+		{
+			while (next_line())
+			{
+				if (line.find_first_not_of(" \t") != std::string_view::npos)
+					return true;
+			}
+			return false;
+		}
+
+		bool Parser::accept(const std::string_view text)
+		{
+			if (!cur.starts_with(text))
+				return false;
+			cur.remove_prefix(text.size());
+			return true;
+		}
+
+		void Parser::expect(const std::string_view text)
+		{
+			if (!accept(text))
+				fail(std::format("expected '{}'", text));
+		}
+
+		std::size_t Parser::indent()
+		{
+			const std::size_t n = std::min(cur.find_first_not_of(' '), cur.size());
+			cur.remove_prefix(n);
+			return n;
+		}
+
+		std::string_view Parser::take_until(const std::string_view stops)
+		{
+			const std::size_t n = std::min(cur.find_first_of(stops), cur.size());
+			const std::string_view result = cur.substr(0, n);
+			cur.remove_prefix(n);
+			return result;
+		}
+
+		template<typename T>
+		T Parser::number()
+		{
+			T value = 0;
+			const auto [ptr, ec] = std::from_chars(cur.data(), cur.data() + cur.size(), value);
+			if (ec != std::errc())
+				fail("expected a number");
+			cur.remove_prefix(static_cast<std::size_t>(ptr - cur.data()));
+			return value;
+		}
+
+		std::unique_ptr<Module> Parser::run()
+		{
+			if (!next_line() || !accept("#! module: "))
+				fail("expected '#! module: <name>'");
+			mod = std::make_unique<Module>(cur);
+			local_values.outer = &rodata_values;
+
+			while (next_content_line())
+			{
+				if (accept("section .__def"))
+					definitions();
+				else if (accept("section .__rodata"))
+					rodata();
+				else
+					function();
+			}
+
+			for (const auto &[name, fn]: functions)
+			{
+				if (fn->ir_type != NodeType::FUNCTION)
+					throw ParseError(line_no, 1, std::format("call to undefined function '@{}'", name));
+			}
+			return std::move(mod);
+		}
+
+		void Parser::definitions()
+		{
+			while (true)
+			{
+				if (!next_content_line())
+					fail("unterminated section .__def");
+				if (accept("end .__def"))
+					break;
+
+				indent();
+				const std::string_view name = take_until(" ");
+				expect(" = ");
+				if (!accept("struct"))
+				{
+					DataType kind;
+					if (!kind_of(take_until(";"), kind))
+						fail("expected a type");
+					expect(";");
+
+					TypedData data;
+					set_t(data, kind);
+					mod->add_t(std::string(name), data);
+					continue;
+				}
+
+				PendingStruct st { .name = name };
+				if (accept(" alignas("))
+				{
+					st.alignment = number<std::uint32_t>();
+					expect(")");
+				}
+				expect(" {");
+
+				while (true)
+				{
+					if (!next_content_line())
+						fail("unterminated struct definition");
+					indent();
+					if (accept("};"))
+						break;
+
+					if (accept("/* "))
+					{
+						const std::size_t bytes = number<std::size_t>();
+						expect(" bytes padding */");
+						st.fields.push_back({ .line = line, .line_no = line_no, .padding = bytes });
+						continue;
+					}
+
+					const std::string_view field_name = take_until(":");
+					expect(": ");
+					if (!cur.ends_with(','))
+						fail("expected ',' after the field type");
+					st.fields.push_back({ field_name, cur.substr(0, cur.size() - 1), line, line_no, 0 });
+				}
+
+				pending_index.emplace(name, pending.size());
+				pending.push_back(std::move(st));
+			}
+
+			/* structs refer to each other by name in any order; build them
+			 * depth-first once the whole section has been read */
+			for (PendingStruct &st: pending)
+				build_struct(st);
+			pending.clear();
+			pending_index.clear();
+		}
+
+		void Parser::build_struct(PendingStruct &st) // NOLINT(*-no-recursion)
+		{
+			if (st.state == 2)
+				return;
+			if (st.state == 1)
+				fail(std::format("struct '{}' contains itself", st.name));
+			st.state = 1;
+
+			const StringTable::StringId name_id = mod->intern_str(st.name);
+			std::vector<TypeContext::Field> fields;
+			fields.reserve(st.fields.size());
+
+			const std::string_view saved_line = line;
+			const std::string_view saved_cur = cur;
+			const std::size_t saved_line_no = line_no;
+			for (std::size_t i = 0; i < st.fields.size(); ++i)
+			{
+				const PendingField &field = st.fields[i];
+				line = field.line;
+				line_no = field.line_no;
+
+				/* the builder names padding after its position, or `__pad_final` at the end */
+				if (field.name.empty())
+				{
+					/* padding runs print as one comment; split them back into fields */
+					for (std::size_t left = field.padding; left > 0;)
+					{
+						const DataType kind = padding_t(left);
+						left -= align_t(kind);
+						TypedData padding;
+						set_t(padding, kind);
+						const std::string padding_name = i + 1 == st.fields.size() && left == 0
+							                                 ? "__pad_final"
+							                                 : "__pad" + std::to_string(fields.size());
+						fields.emplace_back(mod->intern_str(padding_name), kind, padding);
+					}
+					continue;
+				}
+
+				cur = field.type;
+				ParsedType parsed = type(name_id);
+				if (!cur.empty())
+					fail("unexpected text after the field type");
+				fields.emplace_back(mod->intern_str(field.name), parsed.kind, std::move(parsed.value));
+			}
+			line = saved_line;
+			cur = saved_cur;
+			line_no = saved_line_no;
+
+			const TypedData type_def = mod->types().struct_t(name_id, fields, st.alignment);
+			mod->add_t(std::string(st.name), type_def);
+			st.state = 2;
+		}
+
+		const TypedData *Parser::lookup_struct(const std::string_view name) // NOLINT(*-no-recursion)
+		{
+			const auto &typemap = mod->typemap();
+			if (const auto it = typemap.find(std::string(name)); it != typemap.end())
+				return &it->second;
+
+			if (const auto it = pending_index.find(name); it != pending_index.end())
+			{
+				build_struct(pending[it->second]);
+				return &mod->typemap().find(std::string(name))->second;
+			}
+			return nullptr;
+		}
+
+		Node *Parser::carrier(const DataType kind, const TypedData *struct_type)
+		{
+			/* pointers need a node to point at; one stand-in per pointee type */
+			const std::uint64_t key = static_cast<std::uint64_t>(kind) << 32 |
+			                          (struct_type ? struct_type->get<DataType::STRUCT>().name : 0);
+			auto [it, inserted] = carriers.try_emplace(key);
+			if (inserted)
+			{
+				Node *node = mod->create_node(NodeType::ALLOC, kind);
+				if (struct_type)
+				{
+					node->value = *struct_type;
+					node->str_id = struct_type->get<DataType::STRUCT>().name;
+				}
+				it->second = node;
+			}
+			return it->second;
+		}
+
+		ParsedType Parser::type(const StringTable::StringId self) // NOLINT(*-no-recursion)
+		{
+			ParsedType result;
+			const std::string_view word = take_until(" ,;<>()");
+
+			if (word == "ptr" && accept("<"))
+			{
+				result.kind = DataType::POINTER;
+				DataTraits<DataType::POINTER>::value ptr_data = {};
+				if (!accept("unknown"))
+				{
+					const std::string_view pointee = take_until(">");
+					if (DataType kind; kind_of(pointee, kind))
+						ptr_data.pointee = carrier(kind, nullptr);
+					else if (self != StringTable::INVALID_STRING_ID && pointee == mod->strtable().get(self))
+						ptr_data.pointee = nullptr; /* self-referential field */
+					else
+					{
+						const bool bare = pointee.starts_with("struct ");
+						const std::string_view struct_name = bare ? pointee.substr(7) : pointee;
+						if (const TypedData *struct_type = lookup_struct(struct_name))
+							ptr_data.pointee = carrier(DataType::STRUCT, struct_type);
+						else if (bare)
+						{
+							/* a struct without a typedef only has its name printed */
+							const TypedData opaque = mod->types().struct_t(mod->intern_str(struct_name), {}, 8);
+							ptr_data.pointee = carrier(DataType::STRUCT, &opaque);
+						}
+						else
+							fail(std::format("unknown struct '{}'", struct_name));
+					}
+				}
+				expect(">");
+				result.value.set<decltype(ptr_data), DataType::POINTER>(ptr_data);
+				return result;
+			}
+
+			if ((word == "arr" || word == "vec") && accept("<"))
+			{
+				DataType elem;
+				if (!kind_of(take_until(" "), elem))
+					fail("expected an element type");
+				expect(" x ");
+				const auto count = number<std::uint32_t>();
+				expect(">");
+
+				if (word == "arr")
+				{
+					result.kind = DataType::ARRAY;
+					DataTraits<DataType::ARRAY>::value arr_data = {};
+					arr_data.elem_type = elem;
+					arr_data.count = count;
+					result.value.set<decltype(arr_data), DataType::ARRAY>(arr_data);
+				}
+				else
+				{
+					result.kind = DataType::VECTOR;
+					DataTraits<DataType::VECTOR>::value vec_data = {};
+					vec_data.elem_type = elem;
+					vec_data.lane_count = count;
+					result.value.set<decltype(vec_data), DataType::VECTOR>(vec_data);
+				}
+				return result;
+			}
+
+			if (word == "fn" && accept("("))
+			{
+				/* the printed parameter kinds are the node's inputs, which are
+				 * connected separately */
+				take_until(")");
+				expect(") -> ");
+				DataType ret;
+				if (!kind_of(take_until(" ,;>"), ret))
+					fail("expected a return type");
+
+				result.kind = DataType::FUNCTION;
+				DataTraits<DataType::FUNCTION>::value fn_data = {};
+				ach::shared_allocator<TypedData> alloc;
+				fn_data.return_type = std::construct_at(alloc.allocate(1));
+				set_t(*fn_data.return_type, ret);
+				result.value.set<decltype(fn_data), DataType::FUNCTION>(fn_data);
+				return result;
+			}
+
+			if (word == "struct")
+			{
+				/* `struct <name>` for structs without a typedef, a bare `struct` otherwise */
+				result.kind = DataType::STRUCT;
+				if (NodeType op; cur.starts_with(' ') && !op_of(cur.substr(1, cur.find_first_of(" ;<", 1) - 1), op))
+				{
+					cur.remove_prefix(1);
+					const std::string_view name = take_until(" ,;>");
+					if (const TypedData *struct_type = lookup_struct(name))
+						result.value = *struct_type;
+					else
+						result.value = mod->types().struct_t(mod->intern_str(name), {}, 8);
+				}
+				return result;
+			}
+
+			if (kind_of(word, result.kind))
+				return result;
+
+			const TypedData *struct_type = lookup_struct(word);
+			if (!struct_type)
+				fail(std::format("unknown type '{}'", word));
+			result.kind = DataType::STRUCT;
+			result.value = *struct_type;
+			return result;
+		}
+
+		Node *Parser::function_node(const std::string_view name)
+		{
+			/* calls may name a function defined further down */
+			auto [it, inserted] = functions.try_emplace(name);
+			if (inserted)
+				it->second = mod->create_node(NodeType::ENTRY);
+			return it->second;
+		}
+
+		Node *Parser::use(const std::uint32_t n)
+		{
+			if (const Values *outer = values->outer; outer && n < outer->nodes.size() && outer->nodes[n])
+				return outer->nodes[n];
+
+			if (n >= values->nodes.size())
+				values->nodes.resize(std::max<std::size_t>(n + 1, values->nodes.size() * 2));
+
+			Node *&slot = values->nodes[n];
+			if (!slot)
+			{
+				/* a use before the definition; the definition fills this node in */
+				slot = mod->create_node(NodeType::ENTRY);
+				values->used.push_back(n);
+				++values->undefined;
+			}
+			return slot;
+		}
+
+		Node *Parser::define(const std::uint32_t n)
+		{
+			if (const Values *outer = values->outer; outer && n < outer->nodes.size() && outer->nodes[n])
+				fail(std::format("redefinition of %{}", n));
+
+			/* `use` counts a new slot as undefined, so either way one less is */
+			const bool forward = n < values->nodes.size() && values->nodes[n];
+			Node *node = use(n);
+			if (forward && node->ir_type != NodeType::ENTRY)
+				fail(std::format("redefinition of %{}", n));
+			--values->undefined;
+			return node;
+		}
+
+		void Parser::operand()
+		{
+			if (accept("%"))
+				ops.push_back({ .node = use(number<std::uint32_t>()) });
+			else if (accept("#"))
+				ops.push_back({ .literal = take_until(",;) ?") });
+			else if (accept("null"))
+				ops.emplace_back();
+			else
+				fail("expected an operand");
+		}
+
+		void Parser::target()
+		{
+			const std::string_view name = take_until(",; ");
+			if (const auto it = regions.find(name); it != regions.end())
+				ops.push_back({ .node = it->second->entry() });
+			else
+				ops.push_back({ .target = name });
+		}
+
+		void Parser::operands(const char close)
+		{
+			if (cur.empty() || cur.front() == close)
+				return;
+
+			operand();
+			while (accept(", "))
+				operand();
+		}
+
+		DataType Parser::context_of(const Node *node, const std::size_t index, const Node *callee) const
+		{
+			/* a placeholder for a value not yet defined is still an ENTRY */
+			auto known = [&](const std::size_t i) -> const Node *
+			{
+				return i < ops.size() && ops[i].node && ops[i].node->ir_type != NodeType::ENTRY ? ops[i].node : nullptr;
+			};
+
+			const NodeType op = node->ir_type;
+			if (is_arithmetic(op) || op == NodeType::FROM)
+				return node->type_kind;
+			if (is_comparison(op))
+				return known(1 - index) ? known(1 - index)->type_kind : DataType::VOID;
+			if (node->type_kind == DataType::VECTOR && node->value.type() == DataType::VECTOR &&
+			    (op == NodeType::VECTOR_BUILD || op == NodeType::VECTOR_SPLAT))
+				return node->value.get<DataType::VECTOR>().elem_type;
+
+			switch (op)
+			{
+				case NodeType::RET:
+					return return_kind;
+				case NodeType::BRANCH:
+					return index == 0 ? DataType::BOOL : DataType::VOID;
+				case NodeType::SELECT:
+					return index == 0 ? DataType::BOOL : node->type_kind;
+				case NodeType::ACCESS:
+					return index == 1 && !(known(0) && known(0)->type_kind == DataType::ARRAY) ? DataType::UINT32 : DataType::VOID;
+				case NodeType::VECTOR_EXTRACT:
+					return index == 1 ? DataType::UINT32 : DataType::VOID;
+				case NodeType::ALLOC:
+					return node->type_kind == DataType::ARRAY ? DataType::UINT32 : DataType::VOID;
+				case NodeType::ATOMIC_LOAD:
+				case NodeType::ATOMIC_STORE:
+				case NodeType::ATOMIC_CAS:
+					if (index > 0 && index + 1 == ops.size())
+						return DataType::UINT8; /* memory ordering */
+					[[fallthrough]];
+				case NodeType::STORE:
+				case NodeType::PTR_STORE:
+				{
+					const Node *location = known(1);
+					if (index != 0 || !location)
+						return DataType::VOID;
+					if (location->type_kind == DataType::POINTER && location->value.type() == DataType::POINTER &&
+					    location->value.get<DataType::POINTER>().pointee)
+						return location->value.get<DataType::POINTER>().pointee->type_kind;
+					return location->type_kind;
+				}
+				case NodeType::CALL:
+				case NodeType::INVOKE:
+				{
+					const std::size_t first = op == NodeType::CALL ? 1 : 3;
+					if (!callee || callee->ir_type != NodeType::FUNCTION || index < first)
+						return DataType::VOID;
+
+					std::size_t i = index - first;
+					for (const Node *param: callee->inputs)
+					{
+						if (param->ir_type == NodeType::PARAM && i-- == 0)
+							return param->type_kind;
+					}
+					return DataType::VOID;
+				}
+				default:
+					return DataType::VOID;
+			}
+		}
+
+		void Parser::finish(Node *node, Region *region, const Node *callee)
+		{
+			/* inline literals were created right before their user, so they
+			 * go into the region first */
+			for (std::size_t i = 0; i < ops.size(); ++i)
+			{
+				Operand &op = ops[i];
+				if (op.literal.empty())
+					continue;
+
+				Node *lit = mod->create_node(NodeType::LIT);
+				if (const DataType context = context_of(node, i, callee);
+					!(is_scalar(context) && set_literal(*lit, op.literal, context)) &&
+					!set_literal(*lit, op.literal, default_literal_t(op.literal)))
+					fail(std::format("invalid literal '{}'", op.literal));
+				region->append(lit);
+				op.node = lit;
+			}
+
+			mod->intern_t(node);
+			region->append(node);
+			for (std::size_t i = 0; i < ops.size(); ++i)
+			{
+				if (!ops[i].target.empty())
+				{
+					fixups.push_back({ node, node->inputs.size(), ops[i].target, line_no });
+					node->inputs.push_back(nullptr);
+					continue;
+				}
+
+				node->inputs.push_back(ops[i].node);
+				if (!ops[i].node)
+					continue;
+
+				ops[i].node->users.push_back(node);
+			}
+
+			if (node->ir_type == NodeType::ADDR_OF && !node->inputs.empty() &&
+			    node->inputs[0]->ir_type != NodeType::ENTRY && node->value.type() == DataType::POINTER)
+				node->value.get<DataType::POINTER>().pointee = node->inputs[0];
+		}
+
+		void Parser::statement(Region *region)
+		{
+			ops.clear();
+			if (accept("ret"))
+			{
+				Node *node = mod->create_node(NodeType::RET);
+				if (accept(" "))
+					operands(';');
+				expect(";");
+				return finish(node, region, nullptr);
+			}
+
+			expect("%");
+			Node *node = define(number<std::uint32_t>());
+			expect(" = ");
+
+			const Node *callee = nullptr;
+			auto apply = [&](ParsedType &&parsed)
+			{
+				node->type_kind = parsed.kind;
+				if (!is_scalar(parsed.kind) && parsed.kind != DataType::VOID)
+					node->value = std::move(parsed.value);
+			};
+
+			NodeType op = NodeType::ENTRY;
+			if (accept("branch "))
+			{
+				node->ir_type = NodeType::BRANCH;
+				node->type_kind = DataType::VOID;
+				operand();
+				expect(" ? $");
+				target();
+				expect(" : $");
+				target();
+			}
+			else if (accept("jump $"))
+			{
+				node->ir_type = NodeType::JUMP;
+				node->type_kind = DataType::VOID;
+				target();
+			}
+			else if (accept("alloc<"))
+			{
+				node->ir_type = NodeType::ALLOC;
+				apply(type());
+				expect(">");
+				if (accept(" "))
+					operands(';');
+			}
+			else
+			{
+				/* non-void operations print their type first */
+				if (!op_of(cur.substr(0, cur.find_first_of(" ;<")), op))
+				{
+					apply(type());
+					expect(" ");
+				}
+				else
+					node->type_kind = DataType::VOID;
+
+				if (accept("call @"))
+				{
+					node->ir_type = NodeType::CALL;
+					Node *fn = function_node(take_until("("));
+					callee = fn;
+					ops.push_back({ .node = fn });
+					expect("(");
+					operands(')');
+					expect(")");
+				}
+				else if (accept("invoke @"))
+				{
+					node->ir_type = NodeType::INVOKE;
+					Node *fn = function_node(take_until(","));
+					callee = fn;
+					ops.push_back({ .node = fn });
+					expect(", $");
+					target();
+					expect(", $");
+					target();
+					while (accept(", "))
+						operand();
+				}
+				else if (const std::string_view word = cur.substr(0, cur.find_first_of(" ;<")); op_of(word, op))
+				{
+					cur.remove_prefix(word.size());
+					node->ir_type = op;
+					if (op == NodeType::CAST)
+					{
+						expect("<");
+						type();
+						expect(">");
+					}
+					if (accept(" "))
+						operands(';');
+				}
+				else
+				{
+					node->ir_type = NodeType::LIT;
+					const std::string_view text = take_until(";");
+					if (!set_literal(*node, text, node->type_kind))
+						fail(std::format("invalid literal '{}'", text));
+				}
+			}
+
+			expect(";");
+			if (!cur.empty())
+				fail("unexpected text after ';'");
+
+			/* nested struct accesses name their struct like the builder does */
+			if (node->ir_type == NodeType::ACCESS && node->type_kind == DataType::STRUCT &&
+			    node->value.type() == DataType::STRUCT)
+				node->str_id = node->value.get<DataType::STRUCT>().name;
+			finish(node, region, callee);
+		}
+
+		void Parser::rodata()
+		{
+			values = &rodata_values;
+			while (true)
+			{
+				if (!next_content_line())
+					fail("unterminated section .__rodata");
+				if (accept("end .__rodata"))
+					break;
+
+				indent();
+				statement(mod->rodata());
+			}
+
+			if (rodata_values.undefined != 0)
+				fail("use of an undefined value in section .__rodata");
+		}
+
+		void Parser::function()
+		{
+			NodeTraits traits = NodeTraits::NONE;
+			while (true)
+			{
+				if (accept("export "))
+					traits |= NodeTraits::EXPORT;
+				else if (accept("driver "))
+					traits |= NodeTraits::DRIVER;
+				else if (accept("extern "))
+					traits |= NodeTraits::EXTERN;
+				else if (accept("volatile "))
+					traits |= NodeTraits::VOLATILE;
+				else
+					break;
+			}
+
+			expect("fn @");
+			const std::string_view name = take_until("(");
+			Node *fn = function_node(name);
+			if (fn->ir_type == NodeType::FUNCTION)
+				fail(std::format("redefinition of function '{}'", name));
+
+			local_values.reset();
+			values = &local_values;
+			fn->ir_type = NodeType::FUNCTION;
+			fn->type_kind = DataType::FUNCTION;
+			fn->traits = traits;
+			fn->str_id = mod->intern_str(name);
+
+			params.clear();
+			expect("(");
+			while (!accept(")"))
+			{
+				if (!params.empty())
+					expect(", ");
+
+				ParsedType parsed = type();
+				expect(" %");
+				Node *param = define(number<std::uint32_t>());
+				param->ir_type = NodeType::PARAM;
+				param->type_kind = parsed.kind;
+				if (!is_scalar(parsed.kind))
+					param->value = std::move(parsed.value);
+				mod->intern_t(param);
+				param->str_id = mod->intern_str(std::format("arg{}", params.size()));
+
+				fn->inputs.push_back(param);
+				param->users.push_back(fn);
+				params.push_back(param);
+			}
+
+			expect(" -> ");
+			if (!kind_of(cur, return_kind))
+				fail("expected a return type");
+
+			DataTraits<DataType::FUNCTION>::value fn_data = {};
+			ach::shared_allocator<TypedData> alloc;
+			fn_data.return_type = std::construct_at(alloc.allocate(1));
+			set_t(*fn_data.return_type, return_kind);
+			fn->value.set<decltype(fn_data), DataType::FUNCTION>(fn_data);
+			mod->intern_t(fn);
+			mod->root()->append(fn);
+			mod->add_fn(fn);
+
+			if (!next_content_line() || !accept("{") || !cur.empty())
+				fail("expected '{'");
+
+			/* the region of each nesting depth; nodes belong to the last header */
+			std::vector<Region *> stack;
+			while (true)
+			{
+				if (!next_content_line())
+					fail("unterminated function body");
+				if (accept("}"))
+					break;
+
+				const std::size_t spaces = indent();
+				if (accept("$"))
+				{
+					if (spaces < 4 || spaces % 4 != 0 || spaces / 4 - 1 > stack.size())
+						fail("region is not nested under a region");
+
+					const std::size_t depth = spaces / 4 - 1;
+					const std::string_view region_name = take_until(":");
+					expect(":");
+					if (depth == 0 && !stack.empty())
+						fail("function has more than one body region");
+
+					Region *region = mod->create_region(region_name, depth == 0 ? mod->root() : stack[depth - 1]);
+					if (depth == 0)
+					{
+						for (Node *param: params)
+							region->append(param);
+					}
+
+					stack.resize(depth);
+					stack.push_back(region);
+					regions.try_emplace(region_name, region);
+					continue;
+				}
+
+				if (stack.empty())
+					fail("node outside of a region");
+				if (accept("entry"))
+					continue; /* every region is created with its ENTRY */
+				statement(stack.back());
+			}
+
+			end_function();
+		}
+
+		void Parser::end_function()
+		{
+			for (const auto &[user, index, name, at]: fixups)
+			{
+				const auto it = regions.find(name);
+				if (it == regions.end())
+				{
+					line_no = at;
+					cur = line = {};
+					fail(std::format("jump to unknown region '${}'", name));
+				}
+
+				Node *entry = it->second->entry();
+				user->inputs[index] = entry;
+				entry->users.push_back(user);
+			}
+			fixups.clear();
+			regions.clear();
+
+			if (local_values.undefined != 0)
+			{
+				for (const std::uint32_t n: local_values.used)
+				{
+					if (local_values.nodes[n]->ir_type == NodeType::ENTRY)
+						fail(std::format("use of undefined value %{}", n));
+				}
+			}
+		}
+
+		class MappedFile
+		{
+		public:
+			explicit MappedFile(const std::string &path)
+			{
+				fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+				if (fd < 0)
+					throw std::system_error(errno, std::generic_category(), std::format("cannot open '{}'", path));
+
+				struct stat info = {};
+				if (::fstat(fd, &info) != 0)
+				{
+					const int error = errno;
+					::close(fd);
+					throw std::system_error(error, std::generic_category(), std::format("cannot stat '{}'", path));
+				}
+
+				size = static_cast<std::size_t>(info.st_size);
+				if (size == 0)
+					return;
+
+				data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (data == MAP_FAILED)
+				{
+					const int error = errno;
+					::close(fd);
+					throw std::system_error(error, std::generic_category(), std::format("cannot map '{}'", path));
+				}
+				::madvise(data, size, MADV_SEQUENTIAL);
+			}
+
+			~MappedFile()
+			{
+				if (data && data != MAP_FAILED)
+					::munmap(data, size);
+				if (fd >= 0)
+					::close(fd);
+			}
+
+			MappedFile(const MappedFile &) = delete;
+			MappedFile &operator=(const MappedFile &) = delete;
+
+			[[nodiscard]] std::string_view text() const
+			{
+				return data ? std::string_view(static_cast<const char *>(data), size) : std::string_view();
+			}
+
+		private:
+			int fd = -1;
+			void *data = nullptr;
+			std::size_t size = 0;
+		};
+	}
+
+	ParseError::ParseError(const std::size_t line, const std::size_t column, const std::string &message) :
+		std::runtime_error(std::format("{}:{}: {}", line, column, message)), ln(line), col(column) {}
+
+	std::size_t ParseError::line() const
+	{
+		return ln;
+	}
+
+	std::size_t ParseError::column() const
+	{
+		return col;
+	}
+
+	std::unique_ptr<Module> parse(const std::string_view text)
+	{
+		return Parser(text).run();
+	}
+
+	std::unique_ptr<Module> parse_file(const std::string &path)
+	{
+		const MappedFile file(path);
+		return parse(file.text());
+	}
+}
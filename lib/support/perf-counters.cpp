@@ -0,0 +1,261 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <format>
+#include <arc/support/perf-counters.hpp>
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace arc
+{
+	namespace
+	{
+		constexpr std::uint32_t bit(PerfEvent event)
+		{
+			return 1u << static_cast<std::uint32_t>(event);
+		}
+
+		std::string format_count(const PerfSample &sample, PerfEvent event)
+		{
+			return sample.has(event) ? std::format("{}", sample[event]) : "n/a";
+		}
+
+		std::string format_ratio(const double value)
+		{
+			return value < 0 ? "n/a" : std::format("{:.2f}", value);
+		}
+
+#ifdef __linux__
+		perf_event_attr event_attr(const PerfEvent event)
+		{
+			perf_event_attr attr;
+			std::memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.disabled = 1;
+			/* user space only, which `perf_event_paranoid` up to 2 still allows */
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+			constexpr auto cache_miss = [](const std::uint64_t cache)
+			{
+				return cache | PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+			};
+
+			switch (event)
+			{
+				case PerfEvent::CYCLES:
+					attr.type = PERF_TYPE_HARDWARE;
+					attr.config = PERF_COUNT_HW_CPU_CYCLES;
+					break;
+				case PerfEvent::INSTRUCTIONS:
+					attr.type = PERF_TYPE_HARDWARE;
+					attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+					break;
+				case PerfEvent::L1D_MISSES:
+					attr.type = PERF_TYPE_HW_CACHE;
+					attr.config = cache_miss(PERF_COUNT_HW_CACHE_L1D);
+					break;
+				case PerfEvent::LLC_MISSES:
+					attr.type = PERF_TYPE_HARDWARE;
+					attr.config = PERF_COUNT_HW_CACHE_MISSES;
+					break;
+				case PerfEvent::BRANCH_MISSES:
+					attr.type = PERF_TYPE_HARDWARE;
+					attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+					break;
+				case PerfEvent::COUNT:
+					break;
+			}
+			return attr;
+		}
+
+		int open_event(const PerfEvent event)
+		{
+			perf_event_attr attr = event_attr(event);
+			/* calling thread, any cpu, no group */
+			return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+		}
+#endif
+	}
+
+	double PerfSample::ipc() const
+	{
+		if (!has(PerfEvent::CYCLES) || !has(PerfEvent::INSTRUCTIONS))
+			return -1.0;
+		if ((*this)[PerfEvent::CYCLES] == 0)
+			return 0.0;
+		return static_cast<double>((*this)[PerfEvent::INSTRUCTIONS]) / static_cast<double>((*this)[PerfEvent::CYCLES]);
+	}
+
+	double PerfSample::mpki(const PerfEvent event) const
+	{
+		if (!has(event) || !has(PerfEvent::INSTRUCTIONS))
+			return -1.0;
+		if ((*this)[PerfEvent::INSTRUCTIONS] == 0)
+			return 0.0;
+		return static_cast<double>((*this)[event]) * 1000.0 / static_cast<double>((*this)[PerfEvent::INSTRUCTIONS]);
+	}
+
+	PerfSample &PerfSample::operator+=(const PerfSample &other)
+	{
+		for (std::size_t i = 0; i < perf_event_count; ++i)
+			values[i] += other.values[i];
+		present &= other.present;
+		return *this;
+	}
+
+	PerfCounters::PerfCounters()
+	{
+		fds.fill(-1);
+#ifdef __linux__
+		for (std::size_t i = 0; i < perf_event_count; ++i)
+			fds[i] = open_event(static_cast<PerfEvent>(i));
+#endif
+	}
+
+	PerfCounters::~PerfCounters()
+	{
+#ifdef __linux__
+		for (const int fd : fds)
+		{
+			if (fd >= 0)
+				close(fd);
+		}
+#endif
+	}
+
+	bool PerfCounters::available() const
+	{
+		for (const int fd : fds)
+		{
+			if (fd >= 0)
+				return true;
+		}
+		return false;
+	}
+
+	void PerfCounters::start()
+	{
+#ifdef __linux__
+		for (const int fd : fds)
+		{
+			if (fd < 0)
+				continue;
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+
+	PerfSample PerfCounters::stop()
+	{
+		PerfSample sample;
+#ifdef __linux__
+		for (const int fd : fds)
+		{
+			if (fd >= 0)
+				ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+		}
+
+		for (std::size_t i = 0; i < perf_event_count; ++i)
+		{
+			if (fds[i] < 0)
+				continue;
+
+			/* value, time enabled, time running */
+			std::uint64_t data[3] = {};
+			if (read(fds[i], data, sizeof(data)) != sizeof(data))
+				continue;
+			if (data[2] == 0)
+				continue; /* never scheduled onto the pmu */
+
+			std::uint64_t value = data[0];
+			if (data[2] < data[1])
+				value = static_cast<std::uint64_t>(static_cast<double>(value) * static_cast<double>(data[1]) / static_cast<double>(data[2]));
+
+			sample.values[i] = value;
+			sample.present |= bit(static_cast<PerfEvent>(i));
+		}
+#endif
+		return sample;
+	}
+
+	PerfProfile::Scope::Scope(PerfProfile &profile, std::string name) : profile(profile), name(std::move(name))
+	{
+		counters.start();
+	}
+
+	PerfProfile::Scope::~Scope()
+	{
+		profile.record(name, counters.stop());
+	}
+
+	void PerfProfile::record(const std::string &name, const PerfSample &sample)
+	{
+		std::lock_guard lock(mutex);
+		auto [it, inserted] = index.try_emplace(name, rows.size());
+		if (inserted)
+		{
+			rows.push_back({ .name = name, .runs = 1, .sample = sample });
+			return;
+		}
+
+		Entry &entry = rows[it->second];
+		entry.sample += sample;
+		++entry.runs;
+	}
+
+	std::vector<PerfProfile::Entry> PerfProfile::entries() const
+	{
+		std::lock_guard lock(mutex);
+		return rows;
+	}
+
+	bool PerfProfile::available() const
+	{
+		std::lock_guard lock(mutex);
+		for (const Entry &entry : rows)
+		{
+			if (entry.sample.present != 0)
+				return true;
+		}
+		return false;
+	}
+
+	void PerfProfile::print(std::ostream &os) const
+	{
+		const std::vector<Entry> snapshot = entries();
+
+		std::size_t width = 4;
+		for (const Entry &entry : snapshot)
+			width = std::max(width, entry.name.size());
+
+		os << std::format("{:<{}}  {:>6}  {:>14}  {:>14}  {:>6}  {:>9}  {:>9}  {:>11}\n", "pass", width,
+		                  "runs", "cycles", "instructions", "ipc", "l1d mpki", "llc mpki", "branch mpki");
+		for (const auto &[name, runs, sample] : snapshot)
+		{
+			os << std::format("{:<{}}  {:>6}  {:>14}  {:>14}  {:>6}  {:>9}  {:>9}  {:>11}\n", name, width, runs,
+			                  format_count(sample, PerfEvent::CYCLES), format_count(sample, PerfEvent::INSTRUCTIONS),
+			                  format_ratio(sample.ipc()), format_ratio(sample.mpki(PerfEvent::L1D_MISSES)),
+			                  format_ratio(sample.mpki(PerfEvent::LLC_MISSES)),
+			                  format_ratio(sample.mpki(PerfEvent::BRANCH_MISSES)));
+		}
+
+		if (!snapshot.empty() && !available())
+			os << "hardware counters unavailable (no perf_event_open, or perf_event_paranoid too strict)\n";
+	}
+
+	void PerfProfile::clear()
+	{
+		std::lock_guard lock(mutex);
+		rows.clear();
+		index.clear();
+	}
+}
@@ -0,0 +1,877 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <exception>
+#include <format>
+#include <thread>
+#include <vector>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/node.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/foundation/typed-data.hpp>
+#include <arc/support/printer.hpp>
+
+namespace arc
+{
+	namespace
+	{
+		/* tags for the kinds of memoized type strings; the key packs the
+		 * tag, an element kind and a 32-bit payload */
+		enum class TypeKey : std::uint8_t
+		{
+			STRUCT = 1,
+			POINTER,
+			ARRAY,
+			VECTOR
+		};
+
+		std::uint64_t type_key(TypeKey tag, DataType kind, std::uint32_t payload)
+		{
+			return static_cast<std::uint64_t>(tag) << 40 |
+			       static_cast<std::uint64_t>(kind) << 32 |
+			       payload;
+		}
+
+		bool is_padding_field(std::string_view field_name)
+		{
+			return field_name.starts_with("__pad");
+		}
+
+		std::size_t get_padding_size(DataType padding_type)
+		{
+			switch (padding_type)
+			{
+				case DataType::UINT8:
+					return 1;
+				case DataType::UINT16:
+					return 2;
+				case DataType::UINT32:
+					return 4;
+				case DataType::UINT64:
+					return 8;
+				default:
+					return 0;
+			}
+		}
+
+		std::string_view dttstr(DataType type)
+		{
+			switch (type)
+			{
+				case DataType::VOID:
+					return "void";
+				case DataType::BOOL:
+					return "bool";
+				case DataType::INT8:
+					return "i8";
+				case DataType::INT16:
+					return "i16";
+				case DataType::INT32:
+					return "i32";
+				case DataType::INT64:
+					return "i64";
+				case DataType::UINT8:
+					return "u8";
+				case DataType::UINT16:
+					return "u16";
+				case DataType::UINT32:
+					return "u32";
+				case DataType::UINT64:
+					return "u64";
+				case DataType::FLOAT32:
+					return "f32";
+				case DataType::FLOAT64:
+					return "f64";
+				case DataType::POINTER:
+					return "ptr";
+				case DataType::ARRAY:
+					return "arr";
+				case DataType::STRUCT:
+					return "struct";
+				case DataType::FUNCTION:
+					return "fn";
+				case DataType::VECTOR:
+					return "vec";
+				default:
+					return "unknown";
+			}
+		}
+
+		std::string_view ntttstr(NodeType type)
+		{
+			switch (type)
+			{
+				case NodeType::ENTRY:
+					return "entry";
+				case NodeType::EXIT:
+					return "exit";
+				case NodeType::PARAM:
+					return "param";
+				case NodeType::LIT:
+					return "";
+				case NodeType::ADD:
+					return "add";
+				case NodeType::SUB:
+					return "sub";
+				case NodeType::MUL:
+					return "mul";
+				case NodeType::DIV:
+					return "div";
+				case NodeType::MOD:
+					return "mod";
+				case NodeType::GT:
+					return "gt";
+				case NodeType::GTE:
+					return "gte";
+				case NodeType::LT:
+					return "lt";
+				case NodeType::LTE:
+					return "lte";
+				case NodeType::EQ:
+					return "eq";
+				case NodeType::NEQ:
+					return "neq";
+				case NodeType::BAND:
+					return "band";
+				case NodeType::BOR:
+					return "bor";
+				case NodeType::BXOR:
+					return "bxor";
+				case NodeType::BNOT:
+					return "bnot";
+				case NodeType::BSHL:
+					return "bshl";
+				case NodeType::BSHR:
+					return "bshr";
+				case NodeType::RET:
+					return "ret";
+				case NodeType::FUNCTION:
+					return "fn";
+				case NodeType::CALL:
+					return "call";
+				case NodeType::ALLOC:
+					return "alloc";
+				case NodeType::LOAD:
+					return "load";
+				case NodeType::STORE:
+					return "store";
+				case NodeType::ADDR_OF:
+					return "addr_of";
+				case NodeType::PTR_LOAD:
+					return "ptr_load";
+				case NodeType::PTR_STORE:
+					return "ptr_store";
+				case NodeType::PTR_ADD:
+					return "ptr_add";
+				case NodeType::CAST:
+					return "cast";
+				case NodeType::ATOMIC_LOAD:
+					return "atomic_load";
+				case NodeType::ATOMIC_STORE:
+					return "atomic_store";
+				case NodeType::ATOMIC_CAS:
+					return "atomic_cas";
+				case NodeType::JUMP:
+					return "jump";
+				case NodeType::BRANCH:
+					return "branch";
+				case NodeType::SELECT:
+					return "select";
+				case NodeType::INVOKE:
+					return "invoke";
+				case NodeType::VECTOR_BUILD:
+					return "vector_build";
+				case NodeType::VECTOR_EXTRACT:
+					return "vector_extract";
+				case NodeType::VECTOR_SPLAT:
+					return "vector_splat";
+				case NodeType::ACCESS:
+					return "access";
+				case NodeType::FROM:
+					return "from";
+				default:
+					return "unknown";
+			}
+		}
+
+		/* a single-use literal is printed inline at its user instead of on its own line */
+		bool is_inlined(const Node *node)
+		{
+			return node->ir_type == NodeType::LIT && node->users.size() == 1;
+		}
+
+		/* prints into one buffer with one set of caches; one writer per thread */
+		class Writer
+		{
+		public:
+			Writer(Module &module, TypeNames &names, NodeNumbers &numbers, OutputBuffer &out) :
+				mod(module), names(names), numbers(numbers), out(out) {}
+
+			void node(Node &node);
+
+			void region(Region &region);
+
+			void body(Region &region, std::size_t depth = 0);
+
+			void function(Node &fn, Region *body);
+
+			void rodata(Region &rodata);
+
+			void definitions();
+
+		private:
+			Module &mod;
+			TypeNames &names;
+			NodeNumbers &numbers;
+			OutputBuffer &out;
+
+			void type_of(Node &node);
+
+			void struct_name(const TypedData &type_data);
+
+			void pointer(const DataTraits<DataType::POINTER>::value &ptr_data, std::string_view context_struct = {});
+
+			void access_type(Node &node);
+
+			void struct_definition(std::string_view name, const DataTraits<DataType::STRUCT>::value &struct_data);
+
+			void traits(const Node &node);
+
+			void literal(Node &node);
+
+			void operand(Node *node);
+
+			void operands(u8slice<Node *> &inputs, std::size_t first = 0);
+		};
+
+		void Writer::struct_name(const TypedData &type_data)
+		{
+			if (type_data.type() != DataType::STRUCT)
+				out << dttstr(type_data.type());
+			else
+				out << names.structure(type_data.get<DataType::STRUCT>().name);
+		}
+
+		void Writer::pointer(const DataTraits<DataType::POINTER>::value &ptr_data, const std::string_view context_struct)
+		{
+			if (!ptr_data.pointee)
+			{
+				/* self-references have no pointee and are rare enough not to memoize */
+				if (!context_struct.empty())
+					out << "ptr<" << context_struct << '>';
+				else
+					out << "ptr<unknown>";
+				return;
+			}
+
+			if (const Node *pointee = ptr_data.pointee;
+				pointee->type_kind == DataType::STRUCT && pointee->value.type() == DataType::STRUCT)
+				out << names.pointer(DataType::STRUCT, pointee->value.get<DataType::STRUCT>().name);
+			else
+				out << names.pointer(pointee->type_kind);
+		}
+
+		/* lookup field type from ACCESS node by examining the struct definition */
+		void Writer::access_type(Node &node)
+		{
+			if (node.inputs.size() < 2)
+			{
+				out << "unknown";
+				return;
+			}
+
+			const Node *container = node.inputs[0];
+			const Node *index_node = node.inputs[1];
+
+			/* get the field index and the struct type name from the container */
+			if (index_node->ir_type != NodeType::LIT || index_node->type_kind != DataType::UINT32 ||
+			    container->type_kind != DataType::STRUCT || container->value.type() != DataType::STRUCT)
+			{
+				out << "unknown";
+				return;
+			}
+
+			const std::uint32_t field_index = index_node->value.get<DataType::UINT32>();
+			const std::string_view container_name = names.structure(container->value.get<DataType::STRUCT>().name);
+
+			/* look up the struct definition in the module's type registry */
+			const auto &typemap = mod.typemap();
+			const auto it = typemap.find(std::string(container_name));
+			if (it == typemap.end() || it->second.type() != DataType::STRUCT)
+			{
+				out << "unknown";
+				return;
+			}
+
+			/* find the field at the given index. we skip padding fields */
+			std::size_t actual_field_index = 0;
+			for (const auto &[name_id, field_type, field_data]: it->second.get<DataType::STRUCT>().fields)
+			{
+				if (is_padding_field(mod.strtable().get(name_id)))
+					continue;
+
+				if (actual_field_index == field_index)
+				{
+					if (field_type == DataType::POINTER && field_data.type() == DataType::POINTER)
+						pointer(field_data.get<DataType::POINTER>(), container_name);
+					else if (field_type == DataType::STRUCT && field_data.type() == DataType::STRUCT)
+						struct_name(field_data);
+					else
+						out << dttstr(field_type);
+					return;
+				}
+				actual_field_index++;
+			}
+
+			out << "unknown";
+		}
+
+		void Writer::type_of(Node &node) // NOLINT(*-no-recursion)
+		{
+			switch (node.type_kind)
+			{
+				case DataType::POINTER:
+				{
+					/* for ACCESS nodes, use the stored value directly */
+					if (node.ir_type == NodeType::ACCESS && node.value.type() == DataType::POINTER)
+					{
+						const auto &ptr_data = node.value.get<DataType::POINTER>();
+						/* if this is a self-reference [pointee = nullptr],
+						 * we can try to resolve the type from the context */
+						if (!ptr_data.pointee && !node.inputs.empty())
+						{
+							if (const Node *container = node.inputs[0];
+								container->type_kind == DataType::STRUCT && container->value.type() == DataType::STRUCT)
+							{
+								out << names.pointer(DataType::STRUCT, container->value.get<DataType::STRUCT>().name);
+								return;
+							}
+						}
+						return pointer(ptr_data);
+					}
+
+					/* for LOAD nodes, it needs to inherit the type from the source node,
+					 * so we can resolve it directly from the input */
+					if (node.ir_type == NodeType::LOAD && !node.inputs.empty())
+					{
+						if (Node *source = node.inputs[0];
+							source->type_kind == DataType::POINTER)
+							return type_of(*source);
+					}
+
+					/* only fallback to registry lookup only if value is not available
+					 * this happens rarely and the case shouldn't ever hit "ptr<unknown>" */
+					if (node.ir_type == NodeType::ACCESS)
+						return access_type(node);
+
+					if (node.value.type() == DataType::POINTER)
+						return pointer(node.value.get<DataType::POINTER>());
+					out << "ptr<unknown>";
+					return;
+				}
+				case DataType::ARRAY:
+				{
+					const auto &arr_data = node.value.get<DataType::ARRAY>();
+					out << names.array(arr_data.elem_type, arr_data.count);
+					return;
+				}
+				case DataType::VECTOR:
+				{
+					const auto &vec_data = node.value.get<DataType::VECTOR>();
+					out << names.vector(vec_data.elem_type, vec_data.lane_count);
+					return;
+				}
+				case DataType::STRUCT:
+				{
+					if (node.value.type() == DataType::STRUCT)
+						struct_name(node.value);
+					else
+						out << "struct";
+					return;
+				}
+				case DataType::FUNCTION:
+				{
+					out << "fn(";
+					for (std::size_t i = 0; i < node.inputs.size(); ++i)
+					{
+						if (i > 0)
+							out << ", ";
+						out << dttstr(node.inputs[i]->type_kind);
+					}
+
+					const auto &fn_data = node.value.get<DataType::FUNCTION>();
+					const DataType return_type = fn_data.return_type ? fn_data.return_type->type() : DataType::VOID;
+					out << ") -> " << dttstr(return_type);
+					return;
+				}
+				default:
+					out << dttstr(node.type_kind);
+			}
+		}
+
+		void Writer::traits(const Node &node)
+		{
+			if ((node.traits & NodeTraits::EXPORT) != NodeTraits::NONE)
+				out << "export ";
+			if ((node.traits & NodeTraits::DRIVER) != NodeTraits::NONE)
+				out << "driver ";
+			if ((node.traits & NodeTraits::EXTERN) != NodeTraits::NONE)
+				out << "extern ";
+			if ((node.traits & NodeTraits::VOLATILE) != NodeTraits::NONE)
+				out << "volatile ";
+		}
+
+		void Writer::literal(Node &node)
+		{
+			switch (node.type_kind)
+			{
+				case DataType::BOOL:
+					out << (node.value.get<DataType::BOOL>() ? "true" : "false");
+					break;
+				case DataType::INT8:
+					out << static_cast<int>(node.value.get<DataType::INT8>());
+					break;
+				case DataType::INT16:
+					out << node.value.get<DataType::INT16>();
+					break;
+				case DataType::INT32:
+					out << node.value.get<DataType::INT32>();
+					break;
+				case DataType::INT64:
+					out << node.value.get<DataType::INT64>();
+					break;
+				case DataType::UINT8:
+					out << static_cast<unsigned>(node.value.get<DataType::UINT8>());
+					break;
+				case DataType::UINT16:
+					out << node.value.get<DataType::UINT16>();
+					break;
+				case DataType::UINT32:
+					out << node.value.get<DataType::UINT32>();
+					break;
+				case DataType::UINT64:
+					out << node.value.get<DataType::UINT64>();
+					break;
+				case DataType::FLOAT32:
+					out << node.value.get<DataType::FLOAT32>();
+					break;
+				case DataType::FLOAT64:
+					out << node.value.get<DataType::FLOAT64>();
+					break;
+				default:
+					out << '?';
+					break;
+			}
+		}
+
+		void Writer::operand(Node *node)
+		{
+			if (!node)
+				out << "null";
+			else if (is_inlined(node))
+			{
+				out << '#';
+				literal(*node);
+			}
+			else
+				out << '%' << numbers.get(node);
+		}
+
+		void Writer::operands(u8slice<Node *> &inputs, const std::size_t first)
+		{
+			for (std::size_t i = first; i < inputs.size(); ++i)
+			{
+				if (i > first)
+					out << ", ";
+				operand(inputs[i]);
+			}
+		}
+
+		void Writer::struct_definition(const std::string_view name, const DataTraits<DataType::STRUCT>::value &struct_data)
+		{
+			out << "    " << name << " = struct";
+			if (struct_data.alignment != 8)
+				out << " alignas(" << struct_data.alignment << ')';
+			out << " {\n";
+
+			std::size_t pending_padding = 0;
+			for (const auto &[name_id, field_type, field_data]: struct_data.fields)
+			{
+				const std::string_view field_name = mod.strtable().get(name_id);
+				if (is_padding_field(field_name))
+				{
+					pending_padding += get_padding_size(field_type);
+					continue;
+				}
+
+				if (pending_padding > 0)
+				{
+					out << "        /* " << pending_padding << " bytes padding */\n";
+					pending_padding = 0;
+				}
+
+				out << "        " << field_name << ": ";
+				if (field_type == DataType::POINTER && field_data.type() == DataType::POINTER)
+					pointer(field_data.get<DataType::POINTER>(), name);
+				else if (field_type == DataType::STRUCT && field_data.type() == DataType::STRUCT)
+					struct_name(field_data);
+				else
+					out << dttstr(field_type);
+				out << ",\n";
+			}
+
+			if (pending_padding > 0)
+				out << "        /* " << pending_padding << " bytes padding */\n";
+			out << "    };\n";
+		}
+
+		void Writer::node(Node &node)
+		{
+			switch (node.ir_type)
+			{
+				case NodeType::ENTRY:
+					out << "entry";
+					return;
+				case NodeType::RET:
+					out << "ret";
+					if (!node.inputs.empty())
+					{
+						out << ' ';
+						operands(node.inputs);
+					}
+					return;
+				case NodeType::BRANCH:
+				{
+					const std::uint32_t num = numbers.get(&node);
+					out << '%' << num << " = branch ";
+					operand(node.inputs[0]);
+					out << " ? $" << node.inputs[1]->parent->name()
+						<< " : $" << node.inputs[2]->parent->name();
+					return;
+				}
+				case NodeType::JUMP:
+				{
+					const std::uint32_t num = numbers.get(&node);
+					out << '%' << num << " = jump $" << node.inputs[0]->parent->name();
+					return;
+				}
+				case NodeType::CALL:
+				{
+					out << '%' << numbers.get(&node) << " = ";
+					if (node.type_kind != DataType::VOID)
+					{
+						type_of(node);
+						out << ' ';
+					}
+					out << "call @" << mod.strtable().get(node.inputs[0]->str_id) << '(';
+					operands(node.inputs, 1);
+					out << ')';
+					return;
+				}
+				case NodeType::INVOKE:
+				{
+					out << '%' << numbers.get(&node) << " = ";
+					if (node.type_kind != DataType::VOID)
+					{
+						type_of(node);
+						out << ' ';
+					}
+					out << "invoke @" << mod.strtable().get(node.inputs[0]->str_id)
+						<< ", $" << node.inputs[1]->parent->name()
+						<< ", $" << node.inputs[2]->parent->name();
+					for (std::size_t i = 3; i < node.inputs.size(); ++i)
+					{
+						out << ", ";
+						operand(node.inputs[i]);
+					}
+					return;
+				}
+				case NodeType::ALLOC:
+				{
+					out << '%' << numbers.get(&node) << " = alloc<";
+					type_of(node);
+					out << '>';
+					if (!node.inputs.empty())
+					{
+						out << ' ';
+						operands(node.inputs);
+					}
+					return;
+				}
+				default:
+					break;
+			}
+
+			out << '%' << numbers.get(&node) << " = ";
+			if (node.type_kind != DataType::VOID)
+			{
+				type_of(node);
+				out << ' ';
+			}
+
+			out << ntttstr(node.ir_type);
+			if (node.ir_type == NodeType::LIT)
+				literal(node);
+			else if (node.ir_type == NodeType::CAST)
+			{
+				out << '<';
+				type_of(node);
+				out << "> ";
+				operands(node.inputs);
+			}
+			else if (!node.inputs.empty())
+			{
+				out << ' ';
+				operands(node.inputs);
+			}
+		}
+
+		void Writer::region(Region &region) // NOLINT(*-no-recursion)
+		{
+			out << '$' << region.name() << ":\n";
+			for (Node *n: region.nodes())
+			{
+				out << "    ";
+				node(*n);
+				out << ";\n";
+			}
+
+			for (Region *child: region.children())
+			{
+				out << '\n';
+				this->region(*child);
+			}
+		}
+
+		/* child regions are indented one level deeper than their parent so
+		 * the nesting survives a round trip through `parse` */
+		void Writer::body(Region &region, const std::size_t depth) // NOLINT(*-no-recursion)
+		{
+			const std::string indent((depth + 1) * 4, ' ');
+			out << indent << '$' << region.name() << ":\n";
+			for (Node *n: region.nodes())
+			{
+				if (n->ir_type == NodeType::ENTRY)
+					out << indent << "    entry\n";
+				else if (n->ir_type != NodeType::PARAM && !is_inlined(n))
+				{
+					out << indent << "    ";
+					node(*n);
+					out << ";\n";
+				}
+			}
+
+			for (Region *child: region.children())
+				body(*child, depth + 1);
+		}
+
+		void Writer::function(Node &fn, Region *body)
+		{
+			traits(fn);
+			const auto &fn_data = fn.value.get<DataType::FUNCTION>();
+			const DataType return_type = fn_data.return_type ? fn_data.return_type->type() : DataType::VOID;
+
+			out << "fn @" << mod.strtable().get(fn.str_id) << '(';
+			bool first = true;
+			for (Node *param: fn.inputs)
+			{
+				if (param->ir_type != NodeType::PARAM)
+					continue;
+
+				if (!first)
+					out << ", ";
+				first = false;
+				type_of(*param);
+				out << " %" << numbers.get(param);
+			}
+			out << ") -> " << dttstr(return_type) << "\n{\n";
+
+			if (body)
+				this->body(*body);
+			out << "}\n";
+		}
+
+		void Writer::rodata(Region &rodata)
+		{
+			out << "section .__rodata\n";
+			for (Node *n: rodata.nodes())
+			{
+				if (n->ir_type != NodeType::ENTRY)
+				{
+					out << "    ";
+					node(*n);
+					out << ";\n";
+				}
+			}
+			out << "end .__rodata\n\n";
+		}
+
+		void Writer::definitions()
+		{
+			const auto &typedefs = mod.typemap();
+			if (typedefs.empty())
+				return;
+
+			/* the typemap is unordered; sort so equal modules print equally */
+			std::vector<const std::pair<const std::string, TypedData> *> sorted;
+			sorted.reserve(typedefs.size());
+			for (const auto &entry: typedefs)
+				sorted.push_back(&entry);
+			std::ranges::sort(sorted, {}, [](const auto *entry) -> const std::string & { return entry->first; });
+
+			out << "section .__def\n";
+			for (const auto *entry: sorted)
+			{
+				const auto &[name, typedef_data] = *entry;
+				if (typedef_data.type() == DataType::STRUCT)
+					struct_definition(name, typedef_data.get<DataType::STRUCT>());
+				else
+					out << "    " << name << " = " << dttstr(typedef_data.type()) << ";\n";
+			}
+			out << "end .__def\n\n";
+		}
+	}
+
+	std::uint32_t NodeNumbers::get(const Node *node)
+	{
+		if (outer)
+		{
+			if (const auto it = outer->numbers.find(node); it != outer->numbers.end())
+				return it->second;
+		}
+
+		const auto [it, inserted] = numbers.try_emplace(node, next);
+		if (inserted)
+			++next;
+		return it->second;
+	}
+
+	TypeNames::TypeNames(Module &module) : mod(module) {}
+
+	std::string_view TypeNames::structure(const StringTable::StringId name)
+	{
+		auto [it, inserted] = cache.try_emplace(type_key(TypeKey::STRUCT, DataType::STRUCT, name));
+		if (inserted)
+		{
+			std::string struct_name(mod.strtable().get(name));
+			it->second = mod.typemap().contains(struct_name) ? std::move(struct_name) : std::format("struct {}", struct_name);
+		}
+		return it->second;
+	}
+
+	std::string_view TypeNames::pointer(const DataType kind, const StringTable::StringId name)
+	{
+		const std::uint32_t payload = kind == DataType::STRUCT ? name : 0;
+		auto [it, inserted] = cache.try_emplace(type_key(TypeKey::POINTER, kind, payload));
+		if (inserted)
+			it->second = std::format("ptr<{}>", kind == DataType::STRUCT ? structure(name) : dttstr(kind));
+		return it->second;
+	}
+
+	std::string_view TypeNames::array(const DataType elem, const std::uint32_t count)
+	{
+		auto [it, inserted] = cache.try_emplace(type_key(TypeKey::ARRAY, elem, count));
+		if (inserted)
+			it->second = std::format("arr<{} x {}>", dttstr(elem), count);
+		return it->second;
+	}
+
+	std::string_view TypeNames::vector(const DataType elem, const std::uint32_t lanes)
+	{
+		auto [it, inserted] = cache.try_emplace(type_key(TypeKey::VECTOR, elem, lanes));
+		if (inserted)
+			it->second = std::format("vec<{} x {}>", dttstr(elem), lanes);
+		return it->second;
+	}
+
+	Printer::Printer(Module &module, const unsigned threads) :
+		mod(module), workers(std::max(threads, 1u)), names(module) {}
+
+	void Printer::print(OutputBuffer &out)
+	{
+		numbers = {};
+
+		Writer writer(mod, names, numbers, out);
+		out << "#! module: " << mod.name() << '\n';
+		writer.definitions();
+		if (Region *rodata = mod.rodata())
+			writer.rodata(*rodata);
+
+		const auto bodies = mod.bodies();
+
+		std::vector<Node *> functions;
+		for (Node *fn: mod.functions())
+		{
+			if (fn->ir_type == NodeType::FUNCTION)
+				functions.push_back(fn);
+		}
+
+		auto body_of = [&](const Node *fn) -> Region *
+		{
+			const auto it = bodies.find(mod.strtable().get(fn->str_id));
+			return it != bodies.end() ? it->second : nullptr;
+		};
+
+		const std::size_t threads = std::min<std::size_t>(workers, functions.size());
+		if (threads <= 1 || functions.size() < min_parallel_functions)
+		{
+			for (Node *fn: functions)
+			{
+				NodeNumbers local { .outer = &numbers };
+				local.next = numbers.next;
+				Writer(mod, names, local, out).function(*fn, body_of(fn));
+			}
+			return;
+		}
+
+		/* every worker prints a contiguous run of functions into a buffer of its
+		 * own, so there are as many buffers as workers and not as functions */
+		std::vector<OutputBuffer> parts(threads);
+		std::vector<std::exception_ptr> errors(threads);
+		{
+			std::vector<std::jthread> pool;
+			pool.reserve(threads);
+			for (std::size_t t = 0; t < threads; ++t)
+			{
+				pool.emplace_back([&, t]
+				{
+					try
+					{
+						TypeNames local_names(mod);
+						const std::size_t first = functions.size() * t / threads;
+						const std::size_t last = functions.size() * (t + 1) / threads;
+						for (std::size_t i = first; i < last; ++i)
+						{
+							NodeNumbers local { .outer = &numbers };
+							local.next = numbers.next;
+							Writer(mod, local_names, local, parts[t]).function(*functions[i], body_of(functions[i]));
+						}
+					}
+					catch (...)
+					{
+						errors[t] = std::current_exception();
+					}
+				});
+			}
+		}
+
+		for (const std::exception_ptr &error: errors)
+		{
+			if (error)
+				std::rethrow_exception(error);
+		}
+
+		for (OutputBuffer &part: parts)
+			out.append(std::move(part));
+	}
+
+	void Printer::print(Region &region, OutputBuffer &out)
+	{
+		Writer(mod, names, numbers, out).region(region);
+	}
+
+	void Printer::print(Node &node, OutputBuffer &out)
+	{
+		Writer(mod, names, numbers, out).node(node);
+	}
+}
@@ -0,0 +1,113 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <format>
+#include <string_view>
+#include <tuple>
+#include <arc/support/statistics.hpp>
+
+namespace arc
+{
+	namespace
+	{
+		/* constant-initialized, so counters constructed during any translation
+		 * unit's dynamic initialization find it ready */
+		constinit std::atomic<Statistic *> registry = nullptr;
+
+		std::string json_escape(const std::string_view str)
+		{
+			std::string out;
+			out.reserve(str.size());
+			for (const char c : str)
+			{
+				switch (c)
+				{
+					case '"': out += "\\\"";
+						break;
+					case '\\': out += "\\\\";
+						break;
+					case '\n': out += "\\n";
+						break;
+					default: out += c;
+				}
+			}
+			return out;
+		}
+	}
+
+	Statistic::Statistic(const char *group, const char *name, const char *description)
+		: group_name(group), counter_name(name), desc(description)
+	{
+		next = registry.load(std::memory_order_relaxed);
+		while (!registry.compare_exchange_weak(next, this, std::memory_order_release, std::memory_order_relaxed)) {}
+	}
+
+	std::vector<StatisticValue> statistics()
+	{
+		std::vector<StatisticValue> values;
+		for (const Statistic *stat = registry.load(std::memory_order_acquire); stat; stat = stat->next)
+			values.push_back({ stat->group(), stat->name(), stat->description(), stat->value() });
+
+		std::ranges::sort(values, [](const StatisticValue &a, const StatisticValue &b)
+		{
+			return std::tie(a.group, a.name) < std::tie(b.group, b.name);
+		});
+		return values;
+	}
+
+	void reset_statistics()
+	{
+		for (Statistic *stat = registry.load(std::memory_order_acquire); stat; stat = stat->next)
+			stat->count.store(0, std::memory_order_relaxed);
+	}
+
+	void print_statistics(std::ostream &os)
+	{
+		std::vector<StatisticValue> values = statistics();
+		std::erase_if(values, [](const StatisticValue &stat) { return stat.value == 0; });
+		if (values.empty())
+			return;
+
+		std::size_t name_width = 0;
+		std::size_t value_width = 0;
+		for (const StatisticValue &stat : values)
+		{
+			name_width = std::max(name_width, stat.name.size());
+			value_width = std::max(value_width, std::format("{}", stat.value).size());
+		}
+
+		std::string_view group;
+		for (const StatisticValue &stat : values)
+		{
+			if (stat.group != group)
+			{
+				group = stat.group;
+				os << std::format("{}\n", group);
+			}
+			os << std::format("  {:>{}}  {:<{}}  {}\n", stat.value, value_width, stat.name, name_width, stat.description);
+		}
+	}
+
+	void print_statistics_json(std::ostream &os)
+	{
+		const std::vector<StatisticValue> values = statistics();
+
+		os << "{";
+		std::string_view group;
+		bool first_group = true;
+		for (const StatisticValue &stat : values)
+		{
+			if (first_group || stat.group != group)
+			{
+				os << (first_group ? "\n" : "\n\t},\n");
+				os << std::format("\t\"{}\": {{\n", json_escape(stat.group));
+				group = stat.group;
+				first_group = false;
+			}
+			else
+				os << ",\n";
+			os << std::format("\t\t\"{}\": {}", json_escape(stat.name), stat.value);
+		}
+		os << (first_group ? "}\n" : "\n\t}\n}\n");
+	}
+}
@@ -49,6 +49,16 @@ namespace arc
 		return table.contains(str);
 	}
 
+	StringTable::StringId StringTable::find(const std::string_view str) const
+	{
+		if (const auto it = table.find(str);
+			it != table.end())
+		{
+			return it->second;
+		}
+		return INVALID_STRING_ID;
+	}
+
 	std::size_t StringTable::size() const
 	{
 		return strs.size();
@@ -5,13 +5,15 @@
 #include <arc/foundation/pass-manager.hpp>
 #include <arc/foundation/region.hpp>
 #include <arc/support/algorithm.hpp>
-#include <arc/support/allocator.hpp>
+#include <arc/support/statistics.hpp>
 #include <arc/transform/constfold.hpp>
 
 namespace arc
 {
 	namespace
 	{
+		ARC_STATISTIC(nodes_folded, "constant-folding", "nodes folded to a literal");
+
 		/**
 		 * @brief Create a literal node with specified value and type
 		 * @tparam T C++ type of the literal value
@@ -22,11 +24,7 @@ namespace arc
 		template<typename T, DataType DT>
 		Node *create_literal(T value, Region *region)
 		{
-			ach::shared_allocator<Node> alloc;
-			Node *lit = alloc.allocate(1);
-			std::construct_at(lit);
-			lit->ir_type = NodeType::LIT;
-			lit->type_kind = DT;
+			Node *lit = region->module().create_node(NodeType::LIT, DT);
 			lit->parent = region;
 			lit->value.set<T, DT>(value);
 			return lit;
@@ -40,12 +38,7 @@ namespace arc
 		 */
 		Node *create_jump(Node *target, Region *region)
 		{
-			ach::shared_allocator<Node> alloc;
-			Node *jump = alloc.allocate(1);
-			std::construct_at(jump);
-
-			jump->ir_type = NodeType::JUMP;
-			jump->type_kind = DataType::VOID;
+			Node *jump = region->module().create_node(NodeType::JUMP);
 			jump->parent = region;
 			jump->inputs.push_back(target);
 			target->users.push_back(jump);
@@ -215,21 +208,22 @@ namespace arc
 
 	std::size_t ConstantFoldingPass::process_module(Module &module)
 	{
-		/* collect all potentially foldable nodes from module */
-		collect_nodes(module.root());
-		for (const Node *func: module.functions())
+		/* after a run everything left was unfoldable, so a later run on the same
+		 * module only needs to look at what changed since; otherwise collect
+		 * all potentially foldable nodes from module */
+		ChangeSet changes;
+		if (tracked == &module)
+			changes = module.changes_since(epoch);
+
+		if (changes.complete)
+			collect_changes(changes);
+		else
 		{
-			if (func->ir_type != NodeType::FUNCTION)
-				continue;
-
-			const std::string_view func_name = module.strtable().get(func->str_id);
-			for (Region *child: module.root()->children())
+			collect_nodes(module.root());
+			for (Node *func: module.functions())
 			{
-				if (child->name() == func_name)
-				{
-					collect_nodes(child);
-					break;
-				}
+				if (func->ir_type == NodeType::FUNCTION)
+					collect_nodes(module.open_body(func));
 			}
 		}
 
@@ -244,6 +238,9 @@ namespace arc
 				total_folded++;
 		}
 
+		nodes_folded += total_folded;
+		tracked = &module;
+		epoch = module.checkpoint();
 		return total_folded;
 	}
 
@@ -262,6 +259,23 @@ namespace arc
 			collect_nodes(child);
 	}
 
+	void ConstantFoldingPass::collect_changes(const ChangeSet &changes)
+	{
+		/* a node can become foldable when its own operands change or when the
+		 * value of one of them does, so users of changed nodes are revisited too */
+		for (Node *node: changes.nodes)
+		{
+			if (!node->parent)
+				continue;
+			if (is_foldable(node))
+				add_to_worklist(node);
+			add_users(node);
+		}
+
+		for (Region *region: changes.regions)
+			collect_nodes(region);
+	}
+
 	void ConstantFoldingPass::add_to_worklist(Node *node)
 	{
 		if (!node || in_worklist.contains(node))
@@ -318,12 +332,19 @@ namespace arc
 						folded->users.push_back(user);
 				}
 			}
+			mark_dirty(user);
 		}
+		original->users.clear();
 
 		/* removal */
 		for (Node *input: original->inputs)
+		{
 			erase(input->users, original);
-		original->parent->remove(original);
+			mark_dirty(input);
+		}
+		Region *region = original->parent;
+		region->remove(original);
+		region->module().retire(original);
 	}
 
 	bool ConstantFoldingPass::is_foldable(const Node *node) const
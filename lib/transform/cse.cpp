@@ -2,15 +2,24 @@
 
 #include <algorithm>
 #include <cstring>
+#include <iterator>
 #include <print>
 #include <queue>
+#include <unordered_set>
 #include <arc/foundation/module.hpp>
 #include <arc/foundation/pass-manager.hpp>
 #include <arc/foundation/region.hpp>
+#include <arc/support/statistics.hpp>
 #include <arc/transform/cse.hpp>
 
 namespace arc
 {
+	namespace
+	{
+		ARC_STATISTIC(nodes_merged, "common-subexpression-elimination", "expressions replaced by an earlier equivalent");
+		ARC_STATISTIC(loads_kept_aliased, "common-subexpression-elimination", "equivalent loads kept because a store may alias");
+	}
+
 	std::string CommonSubexpressionEliminationPass::name() const
 	{
 		return "common-subexpression-elimination";
@@ -26,11 +35,18 @@ namespace arc
 		return {};
 	}
 
+	bool CommonSubexpressionEliminationPass::tracks_changes() const
+	{
+		return true;
+	}
+
 	std::vector<Region *> CommonSubexpressionEliminationPass::run(Module &module, PassManager &pm)
 	{
 		const auto &tbaa_result = pm.get<TypeBasedAliasResult>();
 		value_numbers.clear();
 		expression_to_node.clear();
+		global_expressions.clear();
+		site_numbers.clear();
 		next_value_number = 1;
 
 		std::vector<Region *> modified_regions;
@@ -72,32 +88,89 @@ namespace arc
 	std::size_t CommonSubexpressionEliminationPass::process_module(Module &module,
 	                                                               const TypeBasedAliasResult &tbaa_result)
 	{
-		std::size_t total_eliminated = 0;
+		/* value numbers are not kept between runs, but a function nothing
+		 * changed in since the last run has nothing left to merge */
+		ChangeSet changes;
+		if (tracked == &module)
+			changes = module.changes_since(epoch);
+
+		std::vector<Region *> functions;
+		if (!changes.complete || !changed_functions(module, changes, functions))
+			functions = function_regions(module);
+
+		/* the global region is never changed incrementally, but its
+		 * expressions are visible to every function */
+		std::size_t total_eliminated = process_region(module.root(), tbaa_result, false);
+		global_expressions = std::move(expression_to_node);
+		for (Region *function: functions)
+		{
+			expression_to_node.clear();
+			total_eliminated += process_region(function, tbaa_result);
+		}
 
-		/* process global region first and then functions */
-		total_eliminated += process_region(module.root(), tbaa_result);
-		for (const Node *func_node: module.functions())
+		tracked = &module;
+		epoch = module.checkpoint();
+		return total_eliminated;
+	}
+
+	std::vector<Region *> CommonSubexpressionEliminationPass::function_regions(Module &module)
+	{
+		std::vector<Region *> regions;
+		for (Node *func_node: module.functions())
 		{
 			if (func_node->ir_type != NodeType::FUNCTION)
 				continue;
 
-			/* find the function's region */
-			const std::string_view func_name = module.strtable().get(func_node->str_id);
-			for (Region *child: module.root()->children())
-			{
-				if (child->name() == func_name)
-				{
-					total_eliminated += process_region(child, tbaa_result);
-					break;
-				}
-			}
+			if (Region *body = module.open_body(func_node))
+				regions.push_back(body);
 		}
 
-		return total_eliminated;
+		/* blocks of the global region that belong to no function go last */
+		const std::unordered_set<const Region *> found(regions.begin(), regions.end());
+		for (Region *child: module.root()->children())
+		{
+			if (!found.contains(child))
+				regions.push_back(child);
+		}
+		return regions;
+	}
+
+	bool CommonSubexpressionEliminationPass::changed_functions(Module &module, const ChangeSet &changes,
+	                                                           std::vector<Region *> &regions)
+	{
+		std::unordered_set<const Region *> changed;
+		const auto add = [&](Region *region)
+		{
+			/* climb to the function body, a direct child of the global region */
+			while (region && region->parent() && region->parent() != module.root())
+				region = region->parent();
+			if (!region || region->parent() != module.root())
+				return false;
+
+			changed.insert(region);
+			return true;
+		};
+
+		for (const Node *node: changes.nodes)
+		{
+			if (node->parent && !add(node->parent))
+				return false;
+		}
+		for (Region *region: changes.regions)
+		{
+			if (!add(region))
+				return false;
+		}
+
+		/* journal order depends on how passes were scheduled; module order does not */
+		std::ranges::copy_if(function_regions(module), std::back_inserter(regions),
+		                     [&](const Region *region) { return changed.contains(region); });
+		return true;
 	}
 
 	std::size_t CommonSubexpressionEliminationPass::process_region(Region *region,
-	                                                               const TypeBasedAliasResult &tbaa_result)
+	                                                               const TypeBasedAliasResult &tbaa_result,
+	                                                               const bool nested)
 	{
 		if (!region)
 			return 0;
@@ -119,16 +192,23 @@ namespace arc
 				if (vn == 0)
 					continue;
 
-				/* check if we've seen this expression before */
-				if (auto it = expression_to_node.find(vn);
-					it != expression_to_node.end())
+				/* check if we've seen this expression before, here or in the global region */
+				Node *existing = nullptr;
+				if (const auto it = expression_to_node.find(vn); it != expression_to_node.end())
+					existing = it->second;
+				else if (const auto global = global_expressions.find(vn); global != global_expressions.end())
+					existing = global->second;
+
+				if (existing)
 				{
-					Node *existing = it->second;
 					/*  check aliasing for load operations */
 					if (is_load_operation(node) && is_load_operation(existing))
 					{
 						if (loads_may_alias(existing, node, tbaa_result))
+						{
+							++loads_kept_aliased;
 							continue;
+						}
 					}
 
 					/* replace all uses with existing equivalent expression */
@@ -143,10 +223,13 @@ namespace arc
 				value_numbers[node] = vn;
 			}
 			/* add child regions to worklist */
+			if (!nested)
+				continue;
 			for (Region *child: current_region->children())
 				worklist.push(child);
 		}
 
+		nodes_merged += eliminated;
 		return eliminated;
 	}
 
@@ -355,7 +438,7 @@ namespace arc
 		hash = hash_combine(hash, addr_vn);
 		if (const MemoryLocation *loc = tbaa_result.memory_location(node))
 		{
-			hash = hash_combine(hash, reinterpret_cast<std::uintptr_t>(loc->allocation_site));
+			hash = hash_combine(hash, site_number(loc->allocation_site));
 			if (loc->offset != -1)
 				hash = hash_combine(hash, static_cast<std::uint64_t>(loc->offset));
 			hash = hash_combine(hash, loc->size);
@@ -377,6 +460,15 @@ namespace arc
 		return hash == 0 ? 1 : hash;
 	}
 
+	ValueNumber CommonSubexpressionEliminationPass::site_number(const Node *site)
+	{
+		/* hashing the address instead would make merges depend on where nodes happened to be allocated */
+		const auto [it, inserted] = site_numbers.try_emplace(site, 0);
+		if (inserted)
+			it->second = next_value_number++;
+		return it->second;
+	}
+
 	bool CommonSubexpressionEliminationPass::is_load_operation(const Node *node)
 	{
 		if (!node)
@@ -509,8 +601,11 @@ namespace arc
 						replacement_node->users.push_back(user);
 				}
 			}
+			mark_dirty(user);
 		}
 		node_to_replace->users.clear();
+		mark_dirty(node_to_replace);
+		mark_dirty(replacement_node);
 		return true;
 	}
 }
@@ -1,13 +1,20 @@
 /* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
 
+#include <algorithm>
 #include <queue>
 #include <arc/foundation/module.hpp>
 #include <arc/foundation/pass-manager.hpp>
 #include <arc/foundation/region.hpp>
+#include <arc/support/statistics.hpp>
 #include <arc/transform/dce.hpp>
 
 namespace arc
 {
+	namespace
+	{
+		ARC_STATISTIC(nodes_deleted, "dead-code-elimination", "unreachable nodes deleted");
+	}
+
 	std::string DeadCodeElimination::name() const
 	{
 		return "dead-code-elimination";
@@ -18,34 +25,42 @@ namespace arc
 		return {}; /* note: to be filled with analysis names */
 	}
 
+	bool DeadCodeElimination::tracks_changes() const
+	{
+		return true;
+	}
+
 	std::vector<Region *> DeadCodeElimination::run(Module &module, PassManager &pm)
 	{
 		alive_nodes.clear();
 		dead_nodes.clear();
 		std::vector<Region *> modified_regions;
 
-		/* find live nodes starting from root region and all function regions */
-		find_live_nodes(module.root());
-		for (const Node *fn: module.functions())
-		{
-			if (fn->ir_type != NodeType::FUNCTION)
-				continue;
+		/* everything a previous run kept was live, so on the same module only
+		 * functions changed since then can hold dead code */
+		ChangeSet changes;
+		if (tracked == &module)
+			changes = module.changes_since(epoch);
 
-			/* find the corresponding function region */
-			const std::string_view fn_name = module.strtable().get(fn->str_id);
-			for (Region *child: module.root()->children())
+		if (changes.complete)
+			find_dead_changes(changes);
+		else
+		{
+			/* find live nodes starting from root region and all function regions */
+			find_live_nodes(module.root());
+			for (Node *fn: module.functions())
 			{
-				if (child->name() == fn_name)
-				{
-					find_live_nodes(child);
-					break;
-				}
+				if (fn->ir_type == NodeType::FUNCTION)
+					find_live_nodes(module.open_body(fn));
 			}
+
+			/* mark dead nodes */
+			find_dead_nodes(module.root());
 		}
 
-		/* mark and remove dead nodes */
-		find_dead_nodes(module.root());
 		remove_dead_nodes(modified_regions);
+		tracked = &module;
+		epoch = module.checkpoint();
 		return modified_regions;
 	}
 
@@ -93,6 +108,69 @@ namespace arc
 		}
 	}
 
+	void DeadCodeElimination::find_dead_changes(const ChangeSet &changes)
+	{
+		/* the function bodies holding a change; removed nodes stay in the journal
+		 * and their operands may have lost their last user */
+		std::unordered_set<Region *> bodies;
+		const auto add_body = [&](Region *region)
+		{
+			while (region && region->parent() && !is_global_scope(region->parent()))
+				region = region->parent();
+			if (region && !is_global_scope(region))
+				bodies.insert(region);
+		};
+		for (Node *node: changes.nodes)
+		{
+			add_body(node->parent);
+			for (Node *input: node->inputs)
+			{
+				if (input)
+					add_body(input->parent);
+			}
+		}
+		for (Region *region: changes.regions)
+			add_body(region);
+
+		std::unordered_set<const Region *> swept;
+		for (Region *body: bodies)
+		{
+			for (Region *region: body->dominated_regions())
+				swept.insert(region);
+		}
+
+		/* mark from the roots of those bodies as a full run does, so dead cycles
+		 * go too; a node used from outside them is live as far as they can tell */
+		std::queue<Node *> worklist;
+		for (const Region *region: swept)
+		{
+			for (Node *node: region->nodes())
+			{
+				const bool used_outside = std::ranges::any_of(node->users, [&](const Node *user)
+				{
+					return user && user->parent && !swept.contains(user->parent);
+				});
+				if ((is_root_node(node) || used_outside) && alive_nodes.insert(node).second)
+					worklist.push(node);
+			}
+		}
+
+		while (!worklist.empty())
+		{
+			Node *current = worklist.front();
+			worklist.pop();
+
+			for (Node *input: current->inputs)
+			{
+				if (input && swept.contains(input->parent) && alive_nodes.insert(input).second)
+					worklist.push(input);
+			}
+		}
+
+		for (Region *body: bodies)
+			find_dead_nodes(body);
+	}
+
 	void DeadCodeElimination::find_dead_nodes(Region *region)
 	{
 		if (!region)
@@ -144,12 +222,14 @@ namespace arc
 						break;
 					}
 				}
+				mark_dirty(input);
 			}
 
 			/* remove from parent region */
 			if (Region *parent = node->parent)
 			{
 				parent->remove(node);
+				parent->module().retire(node);
 				modified_set.insert(parent);
 				removed++;
 			}
@@ -160,6 +240,7 @@ namespace arc
 		for (Region *region: modified_set)
 			modified_regions.push_back(region);
 
+		nodes_deleted += removed;
 		return removed;
 	}
 
@@ -6,12 +6,15 @@
 #include <arc/foundation/module.hpp>
 #include <arc/foundation/pass-manager.hpp>
 #include <arc/foundation/region.hpp>
+#include <arc/support/statistics.hpp>
 #include <arc/transform/dse.hpp>
 
 namespace arc
 {
 	namespace
 	{
+		ARC_STATISTIC(stores_deleted, "dead-store-elimination", "stores overwritten before being read");
+
 		bool is_store_operation(const Node* node)
 		{
 			if (!node)
@@ -60,22 +63,12 @@ namespace arc
 		const auto& tbaa_result = pm.get<TypeBasedAliasResult>();
 		std::vector<Region*> all_modified_regions;
 
-		for (const Node* func_node : module.functions())
+		for (Node* func_node : module.functions())
 		{
 			if (func_node->ir_type != NodeType::FUNCTION)
 				continue;
 
-			const std::string_view func_name = module.strtable().get(func_node->str_id);
-			Region* func_region = nullptr;
-			for (Region* child : module.root()->children())
-			{
-				if (child->name() == func_name)
-				{
-					func_region = child;
-					break;
-				}
-			}
-
+			Region* func_region = module.open_body(func_node);
 			if (!func_region)
 				continue;
 
@@ -213,6 +206,7 @@ namespace arc
 		/* remove dead stores from the region */
 		for (Node* store : final_stores_to_remove)
 			region->remove(store);
+		stores_deleted += final_stores_to_remove.size();
 		return final_stores_to_remove.size();
 	}
 
@@ -1,15 +1,25 @@
 /* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
 
 #include <algorithm>
+#include <limits>
 #include <queue>
 #include <unordered_set>
+#include <arc/analysis/block-frequency.hpp>
+#include <arc/analysis/profile.hpp>
 #include <arc/foundation/module.hpp>
 #include <arc/foundation/pass-manager.hpp>
 #include <arc/foundation/region.hpp>
+#include <arc/support/statistics.hpp>
 #include <arc/transform/hoistexpr.hpp>
 
 namespace arc
 {
+	namespace
+	{
+		ARC_STATISTIC(nodes_hoisted, "hoist-expr", "loop-invariant expressions hoisted");
+		ARC_STATISTIC(loads_kept_aliased, "hoist-expr", "invariant loads kept because a store in the loop may alias");
+	}
+
 	static bool is_loop_region(Region *region)
 	{
 		if (!region)
@@ -218,6 +228,7 @@ namespace arc
 				{
 					/* found a store that might alias with this load,
 					 * making hoisting potentially unsafe */
+					++loads_kept_aliased;
 					return false;
 				}
 			}
@@ -263,7 +274,8 @@ namespace arc
 		return parent;
 	}
 
-	static std::uint32_t compute_benefit(const HoistCandidate &candidate)
+	static std::uint32_t compute_benefit(const HoistCandidate &candidate, const ProfileResult *profile,
+	                                     const BlockFrequencyResult *frequencies)
 	{
 		if (!candidate.expr || !candidate.from || !candidate.to)
 			return 0;
@@ -291,6 +303,36 @@ namespace arc
 				break;
 		}
 
+		/* with a profile the saving is the number of evaluations avoided per
+		 * evaluation of the hoisted copy; a loop that never ran gains nothing */
+		if (profile)
+		{
+			if (profile->cold(candidate.from))
+				return 0;
+
+			const auto from_count = profile->count(candidate.from);
+			const auto to_count = profile->count(candidate.to);
+			if (from_count && to_count)
+			{
+				const std::uint64_t trips = *from_count / std::max<std::uint64_t>(1, *to_count);
+				return static_cast<std::uint32_t>(std::min<std::uint64_t>(
+					static_cast<std::uint64_t>(base_benefit) * std::max<std::uint64_t>(1, trips), std::numeric_limits<std::uint32_t>::max()));
+			}
+		}
+
+		/* estimated frequencies give the same ratio without a profile and
+		 * account for how likely each loop is to iterate */
+		if (frequencies)
+		{
+			const auto from_frequency = frequencies->frequency(candidate.from);
+			const auto to_frequency = frequencies->frequency(candidate.to);
+			if (from_frequency && to_frequency && *to_frequency > 0.0f)
+			{
+				const float trips = std::clamp(*from_frequency / *to_frequency, 1.0f, 4096.0f);
+				return static_cast<std::uint32_t>(static_cast<float>(base_benefit) * trips);
+			}
+		}
+
 		/* estimate loop nesting depth by counting parent regions that are loops.
 		 * deeper nesting means more iterations, making hoisting more valuable */
 		std::uint32_t nesting_depth = 0;
@@ -420,8 +462,16 @@ namespace arc
 	std::vector<Region *> HoistExpr::run(Module &module, PassManager &pm)
 	{
 		const auto &tbaa_result = pm.get<TypeBasedAliasResult>();
+		profile = pm.has_analysis("profile-analysis") ? &pm.get<ProfileResult>() : nullptr;
+		frequencies = pm.has_analysis("block-frequency-analysis") ? &pm.get<BlockFrequencyResult>() : nullptr;
 		std::vector<HoistCandidate> candidates = find_candidates(module, tbaa_result);
 
+		/* candidates in never executed loops are left where they are */
+		std::erase_if(candidates, [](const HoistCandidate &candidate)
+		{
+			return candidate.benefit == 0;
+		});
+
 		if (candidates.empty())
 			return {};
 
@@ -455,17 +505,10 @@ namespace arc
 			if (func->ir_type != NodeType::FUNCTION)
 				continue;
 
-			/* find the function's region using name matching. each function
-			 * has a corresponding region in the module's region hierarchy */
-			const std::string_view func_name = module.strtable().get(func->str_id);
-			for (Region *child: module.root()->children())
+			if (Region *body = module.open_body(func))
 			{
-				if (child->name() == func_name)
-				{
-					auto func_candidates = process_region(child, tbaa_result);
-					candidates.insert(candidates.end(), func_candidates.begin(), func_candidates.end());
-					break;
-				}
+				auto func_candidates = process_region(body, tbaa_result);
+				candidates.insert(candidates.end(), func_candidates.begin(), func_candidates.end());
 			}
 		}
 
@@ -514,7 +557,7 @@ namespace arc
 	                   candidate.expr = node;
 	                   candidate.from = current_region;
 	                   candidate.to = hoist_target;
-	                   candidate.benefit = compute_benefit(candidate);
+	                   candidate.benefit = compute_benefit(candidate, profile, frequencies);
 	                   candidates.push_back(candidate);
 	               }
 	           }
@@ -568,7 +611,7 @@ namespace arc
 	                   candidate.expr = node;
 	                   candidate.from = current_region;
 	                   candidate.to = hoist_target;
-	                   candidate.benefit = compute_benefit(candidate);
+	                   candidate.benefit = compute_benefit(candidate, profile, frequencies);
 	                   candidates.push_back(candidate);
 	                   would_be_hoisted.insert(node);
 	               }
@@ -604,6 +647,7 @@ namespace arc
 			}
 		}
 
+		nodes_hoisted += hoisted_nodes.size();
 		return { modified_regions.begin(), modified_regions.end() };
 	}
 }
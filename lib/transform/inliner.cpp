@@ -1,22 +1,31 @@
 /* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
 
 #include <algorithm>
+#include <cmath>
 #include <sstream>
 #include <arc/analysis/call-graph.hpp>
+#include <arc/analysis/profile.hpp>
 #include <arc/foundation/module.hpp>
 #include <arc/foundation/region.hpp>
-#include <arc/support/algorithm.hpp>
-#include <arc/support/allocator.hpp>
+#include <arc/foundation/transaction.hpp>
+#include <arc/support/statistics.hpp>
 #include <arc/transform/inliner.hpp>
 
 namespace arc
 {
+	namespace
+	{
+		ARC_STATISTIC(calls_inlined, "inliner", "call sites replaced by the callee body");
+		ARC_STATISTIC(calls_rejected, "inliner", "call sites the cost model kept as calls");
+	}
+
 	void Inliner::set_config(const Config &cfg)
 	{
 		config = cfg;
 	}
 
-	Inliner::Decision Inliner::evaluate(Node *call_site, Node *callee, const CallGraphResult *cg) const
+	Inliner::Decision Inliner::evaluate(Node *call_site, Node *callee, const CallGraphResult *cg,
+	                                    const ProfileResult *profile) const
 	{
 		Decision decision;
 
@@ -74,7 +83,7 @@ namespace arc
 
 		/* calculate optimization benefits vs costs; call graph analysis enables
 		 * more sophisticated heuristics based on function usage patterns */
-		decision.benefit = calc_benefit(call_site, callee, cg);
+		decision.benefit = calc_benefit(call_site, callee, cg, profile);
 		if (decision.benefit < config.min_benefit)
 		{
 			std::ostringstream oss;
@@ -90,75 +99,79 @@ namespace arc
 	}
 
 	Inliner::Result Inliner::inline_call(Node *call_site, Node *callee, Module &module,
-	                                     const CallGraphResult *cg) const
+	                                     const CallGraphResult *cg, const ProfileResult *profile,
+	                                     Transaction *tx) const
 	{
 		Result result;
 
 		/* re-verify inlining decision; this ensures consistency between evaluate()
 		 * and inline_call() even if the IR changed between calls */
-		Decision decision = evaluate(call_site, callee, cg);
+		Decision decision = evaluate(call_site, callee, cg, profile);
 		if (!decision.should_inline)
+		{
+			++calls_rejected;
 			return result;
+		}
 
-		/* step 1: clone the callee function body into a temporary region
-		 * this creates a copy of all nodes except structural ones (ENTRY, EXIT)
-		 * that we can then modify without affecting the original function */
-		std::unordered_map<Node *, Node *> node_mapping;
-		Region *inlined_region = clone_function_body(callee, module, node_mapping);
-		if (!inlined_region)
+		Region *source_region = find_function_region(callee, module);
+		if (!source_region)
 			return result;
 
-		/* step 2: establish connections between cloned nodes
+		/* every edit goes through a transaction; without one from the caller a
+		 * local one is committed at the end, or rolled back if anything throws */
+		Transaction local;
+		Transaction &edits = tx ? *tx : local;
+
+		/* step 1: clone the callee function body
+		 * this creates a detached copy of every node except structural ones
+		 * (ENTRY, EXIT, PARAM, RET) that we can then wire up without affecting
+		 * the original function */
+		std::unordered_map<Node *, Node *> node_mapping;
+		const std::vector<Node *> originals = clone_function_body(source_region, node_mapping, edits);
+
+		/* step 2: map function parameters to call site arguments
+		 * this is the key transformation that specializes the cloned function
+		 * body for this specific call site: uses of a parameter are wired
+		 * straight to the actual argument in the next step */
+		substitute_parameters(source_region, call_site, node_mapping);
+
+		/* step 3: establish connections between cloned nodes
 		 * the initial cloning creates nodes with the same properties but no
 		 * connections; this phase rebuilds the use-def chains within the
 		 * cloned subgraph to match the original function's structure */
-		patch_connections(node_mapping);
-
-		/* step 3: replace function parameters with call site arguments
-		 * this is the key transformation that specializes the cloned function
-		 * body for this specific call site by substituting the actual argument
-		 * values for the formal parameters */
-		substitute_parameters(inlined_region, call_site, node_mapping);
+		patch_connections(originals, node_mapping, edits);
 
 		/* step 4: find the return value from the inlined function
 		 * simple functions have exactly one return statement; we extract the
 		 * returned value to replace the call site in the caller */
-		Node *return_value = find_return_value(inlined_region);
+		Node *return_value = find_return_value(source_region, node_mapping);
 		if (return_value)
 		{
 			/* replace all uses of the call site with the return value
 			 * this effectively "returns" the inlined function's result to
 			 * all places that were using the original call */
-			update_all_connections(call_site, return_value);
+			edits.replace_all_uses(call_site, return_value);
 		}
 
 		/* step 5: integrate inlined nodes into caller's region
-		 * move all meaningful nodes from the temporary inlined region into
-		 * the caller's region, placing them just before the original call site
-		 * to maintain execution order */
+		 * place the clones just before the original call site to maintain
+		 * execution order */
 		Region *caller_region = call_site->parent;
-		for (Node *node: inlined_region->nodes())
-		{
-			/* only move actual computation nodes; skip structural nodes that
-			 * don't represent actual operations in the inlined code */
-			if (node->ir_type != NodeType::ENTRY &&
-			    node->ir_type != NodeType::EXIT &&
-			    node->ir_type != NodeType::PARAM &&
-			    node->ir_type != NodeType::RET)
-			{
-				caller_region->insert_before(call_site, node);
-			}
-		}
+		for (Node *original: originals)
+			edits.insert_before(call_site, node_mapping.at(original));
 
 		/* step 6: remove the original call site
 		 * now that the call has been replaced with the inlined function body,
 		 * the original call is no longer needed */
-		caller_region->remove(call_site);
+		edits.remove(call_site);
+		if (!tx)
+			local.commit();
 
 		/* record what was modified for pass manager invalidation */
 		result.return_value = return_value;
 		result.modified.push_back(caller_region);
 		result.success = true;
+		++calls_inlined;
 		return result;
 	}
 
@@ -187,7 +200,8 @@ namespace arc
 		return cost;
 	}
 
-	float Inliner::calc_benefit(Node *call_site, Node *callee, const CallGraphResult *cg)
+	float Inliner::calc_benefit(Node *call_site, Node *callee, const CallGraphResult *cg,
+	                            const ProfileResult *profile)
 	{
 		/* start with base benefit for eliminating function call overhead
 		 * this includes register save/restore, parameter passing, and
@@ -230,14 +244,33 @@ namespace arc
 				benefit += 2.0f;
 		}
 
+		/* measured frequencies override the static guesses above: a call site
+		 * that never ran is not worth the code growth, while one that runs many
+		 * times per call of its caller (i.e. inside a hot loop) is */
+		if (profile)
+		{
+			if (profile->cold(call_site->parent))
+				return std::min(benefit, 1.0f);
+
+			if (const auto frequency = profile->frequency(call_site->parent))
+				benefit += std::min(std::log2(1.0f + *frequency), 6.0f);
+
+			/* the call site receiving most of the callee's calls profits most */
+			const auto site = profile->call_count(call_site);
+			const auto calls = profile->entry_count(callee);
+			if (site && calls && *calls > 0 && *site * 2 >= *calls)
+				benefit += 2.0f;
+		}
+
 		return benefit;
 	}
 
 	bool Inliner::is_inlinable(Node *callee, const CallGraphResult *cg)
 	{
-		/* find the function's implementation region */
+		/* find the function's implementation region; looking it up brings back
+		 * a body held outside the module, a declaration's region is only a stub */
 		Region *func_region = find_function_region(callee, const_cast<Module &>(callee->parent->module()));
-		if (!func_region)
+		if (!func_region || (callee->traits & NodeTraits::EXTERN) != NodeTraits::NONE)
 			return false;
 
 		/* restriction: only inline functions without control flow
@@ -277,106 +310,66 @@ namespace arc
 		return true;
 	}
 
-	Region *Inliner::clone_function_body(Node *callee, Module &target_module,
-	                                     std::unordered_map<Node *, Node *> &node_mapping)
+	std::vector<Node *> Inliner::clone_function_body(Region *source_region,
+	                                                 std::unordered_map<Node *, Node *> &node_mapping,
+	                                                 Transaction &tx)
 	{
-		/* locate the source region containing the function implementation */
-		Region *source_region = find_function_region(callee, target_module);
-		if (!source_region)
-			return nullptr;
-
-		/* create a temporary region to hold the cloned function body
-		 * this region will later be dissolved when we move its nodes into
-		 * the caller's region */
-		std::string inline_name = std::string(target_module.strtable().get(callee->str_id)) + "_inlined";
-		Region *target_region = target_module.create_region(inline_name);
-
 		/* clone all meaningful nodes from the source function
 		 * we skip structural nodes (ENTRY, EXIT) because they represent
-		 * function boundaries that don't make sense in the inlined context */
+		 * function boundaries that don't make sense in the inlined context;
+		 * parameters become the call's arguments and the return its result */
+		std::vector<Node *> originals;
 		for (Node *original: source_region->nodes())
 		{
 			if (original->ir_type == NodeType::ENTRY ||
-			    original->ir_type == NodeType::EXIT)
+			    original->ir_type == NodeType::EXIT ||
+			    original->ir_type == NodeType::PARAM ||
+			    original->ir_type == NodeType::RET)
 			{
-				continue; /* skip function boundary markers */
+				continue;
 			}
 
 			/* create a copy of this node with the same properties but no connections */
-			Node *cloned = clone_node(original);
-			if (cloned)
-			{
-				target_region->append(cloned);
-				node_mapping[original] = cloned; /* record mapping for connection patching */
-			}
+			node_mapping[original] = tx.clone(original);
+			originals.push_back(original);
 		}
 
-		return target_region;
+		return originals;
 	}
 
-	Node *Inliner::clone_node(Node *original)
-	{
-		if (!original)
-			return nullptr;
-
-		/* allocate a new node using shared allocation for consistency with
-		 * other IR node allocation throughout the system */
-		ach::shared_allocator<Node> alloc;
-		Node *cloned = alloc.allocate(1);
-		std::construct_at(cloned);
-
-		/* copy all intrinsic properties of the node
-		 * note: we deliberately don't copy inputs/users as these will be
-		 * patched up later based on the cloned subgraph structure */
-		cloned->ir_type = original->ir_type;     /* operation type */
-		cloned->type_kind = original->type_kind; /* data type */
-		cloned->value = original->value;         /* constant data or type info */
-		cloned->traits = original->traits;       /* optimization hints/constraints */
-		cloned->str_id = original->str_id;       /* string table reference */
-		return cloned;
-	}
-
-	void Inliner::patch_connections(const std::unordered_map<Node *, Node *> &node_mapping)
+	void Inliner::patch_connections(const std::vector<Node *> &originals,
+	                                const std::unordered_map<Node *, Node *> &node_mapping, Transaction &tx)
 	{
 		/* rebuild use-def chains within the cloned subgraph
 		 * this phase establishes the same connectivity pattern as the original
 		 * function, but using the cloned nodes instead of the originals */
-		for (const auto &[original, cloned]: node_mapping)
+		for (Node *original: originals)
 		{
-			/* start with empty input lists but preserve user lists
-			 *
-			 * we clear inputs because they will be rebuilt from scratch based on
-			 * the cloned subgraph. however, we do NOT clear user lists because
-			 * they accumulate as we process other nodes--when node A connects to
-			 * node B, A gets added to B's user list. clearing B's user list later
-			 * would break the bidirectional connection that A already established */
-			cloned->inputs.clear();
-
-			/* rebuild input connections by mapping original inputs to cloned inputs */
+			Node *cloned = node_mapping.at(original);
+
+			/* rebuild input connections by mapping original inputs to cloned inputs;
+			 * parameters map to the call's arguments, so this also links the
+			 * inlined code into the caller */
 			for (Node *original_input: original->inputs)
 			{
-				/* only connect to inputs that are also part of the cloned subgraph
-				 * inputs from outside the function, e.g. parameters, will be handled
-				 * during parameter substitution */
+				/* only connect to inputs that are part of the mapping */
 				if (auto it = node_mapping.find(original_input);
 					it != node_mapping.end())
 				{
-					Node *cloned_input = it->second;
-					cloned->inputs.push_back(cloned_input);
-					cloned_input->users.push_back(cloned); /* maintain bidirectional links */
+					tx.connect(cloned, it->second); /* maintains bidirectional links */
 				}
 			}
 		}
 	}
 
-	void Inliner::substitute_parameters(Region *inlined_region, Node *call_site,
-	                                    const std::unordered_map<Node *, Node *> & /* node_mapping */)
+	void Inliner::substitute_parameters(Region *source_region, Node *call_site,
+	                                    std::unordered_map<Node *, Node *> &node_mapping)
 	{
-		/* collect all parameter nodes from the cloned function body
+		/* collect all parameter nodes from the function body
 		 * parameters represent the formal arguments that need to be replaced
 		 * with the actual arguments from the call site */
 		std::vector<Node *> param_nodes;
-		for (Node *node: inlined_region->nodes())
+		for (Node *node: source_region->nodes())
 		{
 			if (node->ir_type == NodeType::PARAM)
 			{
@@ -391,7 +384,7 @@ namespace arc
 		if (call_site->ir_type == NodeType::INVOKE)
 			arg_count -= 2; /* exclude normal and exception targets */
 
-		/* replace each parameter with its corresponding argument
+		/* map each parameter to its corresponding argument
 		 * this specializes the cloned function body for this specific call site
 		 * by substituting actual values for formal parameters */
 		for (std::size_t i = 0; i < std::min(param_nodes.size(), arg_count); ++i)
@@ -399,29 +392,26 @@ namespace arc
 			Node *param = param_nodes[i];
 			Node *arg = call_site->inputs[i + 1]; /* +1 to skip function operand */
 			if (param && arg)
-			{
-				/* replace all uses of the parameter with the argument
-				 * this updates use-def chains to connect the inlined code
-				 * directly to the caller's argument values then remove
-				 * the now-unused parameter node from the inlined region */
-				update_all_connections(param, arg);
-				inlined_region->remove(param);
-			}
+				node_mapping[param] = arg;
 		}
 	}
 
-	Node *Inliner::find_return_value(Region *inlined_region)
+	Node *Inliner::find_return_value(Region *source_region, const std::unordered_map<Node *, Node *> &node_mapping)
 	{
-		if (!inlined_region)
+		if (!source_region)
 			return nullptr;
 
-		/* locate the single return statement in the inlined function
+		/* locate the single return statement in the function body
 		 * simple functions have exactly one return, so we find it and
 		 * extract the returned value to replace the call site */
-		for (Node *node: inlined_region->nodes())
+		for (Node *node: source_region->nodes())
 		{
 			if (node->ir_type == NodeType::RET && !node->inputs.empty())
-				return node->inputs[0]; /* return value is the first input */
+			{
+				/* return value is the first input */
+				const auto it = node_mapping.find(node->inputs[0]);
+				return it != node_mapping.end() ? it->second : nullptr;
+			}
 		}
 
 		return nullptr; /* void function or malformed return */
@@ -431,16 +421,8 @@ namespace arc
 	{
 		if (!func || func->ir_type != NodeType::FUNCTION)
 			return nullptr;
-
-		/* in Arc's IR structure, functions are implemented as child regions
-		 * of the module root, with the region name matching the function name */
-		std::string_view func_name = module.strtable().get(func->str_id);
-		for (Region *child: module.root()->children())
-		{
-			if (child->name() == func_name)
-				return child;
-		}
-		return nullptr; /* function declaration without implementation */
+		module.load_body(func);
+		return module.body(func);
 	}
 
 	bool Inliner::has_constant_args(Node *call_site)
@@ -0,0 +1,130 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <arc/analysis/profile.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/pass-manager.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/support/statistics.hpp>
+#include <arc/transform/instrument.hpp>
+
+namespace arc
+{
+	namespace
+	{
+		constexpr std::string_view counters_name = "__arc_profile_counters";
+
+		ARC_STATISTIC(counters_inserted, "edge-instrumentation", "profile counters allocated for entries and branch edges");
+	}
+
+	std::string EdgeInstrumentation::name() const
+	{
+		return "edge-instrumentation";
+	}
+
+	std::vector<std::string> EdgeInstrumentation::invalidates() const
+	{
+		/* counter updates are memory writes in every function */
+		return { "call-graph-analysis", "type-based-alias-analysis" };
+	}
+
+	std::vector<Region *> EdgeInstrumentation::run(Module &module, PassManager &)
+	{
+		if (counters(module))
+			return {};
+
+		const ProfileLayout layout = ProfileLayout::of(module);
+		if (layout.functions.empty())
+			return {};
+
+		/* one global array holds the counters of all functions */
+		Node *array = emit(NodeType::ALLOC, DataType::ARRAY, module.root(), nullptr, {});
+		DataTraits<DataType::ARRAY>::value arr_data = {};
+		arr_data.elem_type = DataType::UINT64;
+		arr_data.count = layout.counters;
+		array->value.set<decltype(arr_data), DataType::ARRAY>(arr_data);
+		module.intern_t(array);
+		array->str_id = module.intern_str(counters_name);
+		counters_inserted += layout.counters;
+
+		std::vector<Region *> modified = { module.root() };
+		constexpr std::uint64_t stride = sizeof(std::uint64_t);
+		for (const auto &fn: layout.functions)
+		{
+			/* count the entry ahead of everything but the parameters */
+			Node *first = nullptr;
+			for (Node *node: fn.body->nodes())
+			{
+				if (node->ir_type != NodeType::ENTRY && node->ir_type != NodeType::PARAM)
+				{
+					first = node;
+					break;
+				}
+			}
+			increment(array, constant(fn.offset * stride, fn.body, first), fn.body, first);
+			modified.push_back(fn.body);
+
+			for (std::size_t i = 0; i < fn.branches.size(); ++i)
+			{
+				Node *branch = fn.branches[i];
+				Region *region = branch->parent;
+				const std::uint64_t taken = (fn.offset + 1 + 2 * i) * stride;
+
+				Node *offset = emit(NodeType::SELECT, DataType::UINT64, region, branch, {
+					branch->inputs[0], constant(taken, region, branch), constant(taken + stride, region, branch)
+				});
+				increment(array, offset, region, branch);
+				if (region != fn.body)
+					modified.push_back(region);
+			}
+		}
+
+		return modified;
+	}
+
+	Node *EdgeInstrumentation::counters(Module &module)
+	{
+		for (Node *node: module.root()->nodes())
+		{
+			if (node->ir_type == NodeType::ALLOC && node->str_id != 0 &&
+			    module.strtable().get(node->str_id) == counters_name)
+				return node;
+		}
+		return nullptr;
+	}
+
+	Node *EdgeInstrumentation::emit(NodeType type, DataType result_type, Region *region, Node *before,
+	                                const std::vector<Node *> &inputs)
+	{
+		Node *node = region->module().create_node(type, result_type);
+		for (Node *input: inputs)
+		{
+			node->inputs.push_back(input);
+			input->users.push_back(node);
+		}
+
+		if (before)
+			region->insert_before(before, node);
+		else
+			region->append(node);
+		return node;
+	}
+
+	void EdgeInstrumentation::increment(Node *array, Node *offset, Region *region, Node *before)
+	{
+		Node *address = emit(NodeType::PTR_ADD, DataType::POINTER, region, before, { array, offset });
+		DataTraits<DataType::POINTER>::value ptr_data = {};
+		ptr_data.pointee = array;
+		address->value.set<decltype(ptr_data), DataType::POINTER>(ptr_data);
+
+		Node *old = emit(NodeType::PTR_LOAD, DataType::UINT64, region, before, { address });
+		Node *next = emit(NodeType::ADD, DataType::UINT64, region, before, { old, constant(1, region, before) });
+		emit(NodeType::PTR_STORE, DataType::VOID, region, before, { next, address });
+	}
+
+	Node *EdgeInstrumentation::constant(const std::uint64_t value, Region *region, Node *before)
+	{
+		Node *node = emit(NodeType::LIT, DataType::UINT64, region, before, {});
+		node->value.set<std::uint64_t, DataType::UINT64>(value);
+		return node;
+	}
+}
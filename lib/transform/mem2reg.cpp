@@ -11,10 +11,17 @@
 #include <arc/foundation/pass-manager.hpp>
 #include <arc/foundation/region.hpp>
 #include <arc/support/allocator.hpp>
+#include <arc/support/statistics.hpp>
 #include <arc/transform/mem2reg.hpp>
 
 namespace arc
 {
+	namespace
+	{
+		ARC_STATISTIC(allocs_promoted, "mem2reg", "stack allocations promoted to values");
+		ARC_STATISTIC(loads_replaced, "mem2reg", "loads replaced by the reaching stored value");
+	}
+
 	/**
 	 * @brief Information about a promotable stack allocation
 	 */
@@ -387,22 +394,12 @@ namespace arc
 		const auto &tbaa_result = pm.get<TypeBasedAliasResult>();
 		std::vector<Region *> all_modified_regions = {};
 
-		for (const Node *func_node: module.functions())
+		for (Node *func_node: module.functions())
 		{
 			if (func_node->ir_type != NodeType::FUNCTION)
 				continue;
 
-			const std::string_view func_name = module.strtable().get(func_node->str_id);
-			Region *func_region = nullptr;
-			for (Region *child: module.root()->children())
-			{
-				if (child->name() == func_name)
-				{
-					func_region = child;
-					break;
-				}
-			}
-
+			Region *func_region = module.open_body(func_node);
 			if (!func_region)
 				continue;
 
@@ -426,6 +423,8 @@ namespace arc
 
 			insert_phi_nodes(alloc_info);
 			rename_variables(func_region, alloc_info);
+			++allocs_promoted;
+			loads_replaced += alloc_info.loads.size();
 		}
 
 		/* after that, cleanup memory operations */
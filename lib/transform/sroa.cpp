@@ -11,12 +11,16 @@
 #include <arc/support/algorithm.hpp>
 #include <arc/support/allocator.hpp>
 #include <arc/support/inference.hpp>
+#include <arc/support/statistics.hpp>
 #include <arc/transform/sroa.hpp>
 
 namespace arc
 {
 	namespace
 	{
+		ARC_STATISTIC(aggregates_split, "scalar-replacement-of-aggregates", "aggregates replaced entirely by scalars");
+		ARC_STATISTIC(aggregates_narrowed, "scalar-replacement-of-aggregates", "aggregates reduced to their escaping fields");
+
 		bool is_promotable_allocation(Node* alloc, const TypeBasedAliasResult& tbaa)
 		{
 			if (!alloc || alloc->ir_type != NodeType::ALLOC)
@@ -110,17 +114,9 @@ namespace arc
 					info.fully_promotable = false;
 					if (alloc->value.type() == DataType::STRUCT)
 					{
-						const auto& struct_data = alloc->value.get<DataType::STRUCT>();
-						std::size_t logical_field_index = 0;
-						for (const auto& [name_id, field_type, field_data] : struct_data.fields)
-						{
-							std::string_view field_name = alloc->parent->module().strtable().get(name_id);
-							if (!field_name.starts_with("__pad"))
-							{
-								info.escaped_fields.insert(logical_field_index);
-								logical_field_index++;
-							}
-						}
+						const StructLayout& layout = alloc->parent->module().layout().of(alloc->value.get<DataType::STRUCT>());
+						for (std::size_t logical_field_index = 0; logical_field_index < layout.fields.size(); ++logical_field_index)
+							info.escaped_fields.insert(logical_field_index);
 					}
 					return;
 				}
@@ -182,14 +178,8 @@ namespace arc
 				return false;
 
 			/* count logical fields; no padding counted */
-			const auto& struct_data = info.alloc_node->value.get<DataType::STRUCT>();
-			std::size_t logical_field_count = 0;
-			for (const auto& [name_id, field_type, field_data] : struct_data.fields)
-			{
-				std::string_view field_name = info.alloc_node->parent->module().strtable().get(name_id);
-				if (!field_name.starts_with("__pad"))
-					logical_field_count++;
-			}
+			const std::size_t logical_field_count =
+				info.alloc_node->parent->module().layout().of(info.alloc_node->value.get<DataType::STRUCT>()).fields.size();
 
 			/* check for ACCESS nodes that might escape through calls or returns */
 			for (Node* user : info.alloc_node->users)
@@ -237,15 +227,13 @@ namespace arc
 			if (!alloc_region)
 				return;
 
-			/* count logical fields and create scalar allocations */
-			std::size_t logical_field_index = 0;
+			/* create scalar allocations for logical fields */
+			const StructLayout& layout = module.layout().of(struct_data);
 			Node* insert_point = info.alloc_node;
 
-			for (const auto& [name_id, field_type, field_data] : struct_data.fields)
+			for (std::size_t logical_field_index = 0; logical_field_index < layout.fields.size();)
 			{
-				std::string_view field_name = module.strtable().get(name_id);
-				if (field_name.starts_with("__pad"))
-					continue;
+				const DataType field_type = std::get<1>(struct_data.fields[layout.fields[logical_field_index]]);
 
 				if (logical_field_index >= info.scalar_allocs.size())
 					info.scalar_allocs.resize(logical_field_index + 1, nullptr);
@@ -377,39 +365,31 @@ namespace arc
 			const auto& original_struct = info.alloc_node->value.get<DataType::STRUCT>();
 
 			/* collect fields that are non-promotable e.g. escaped etc. */
-			u8slice<std::tuple<StringTable::StringId, DataType, TypedData>> reduced_fields{};
+			std::vector<TypeContext::Field> reduced_fields;
+			const StructLayout& layout = module.layout().of(original_struct);
 			std::size_t logical_field_index = 0;
 
-			for (const auto& [name_id, field_type, field_data] : original_struct.fields)
+			for (std::size_t i = 0; i < original_struct.fields.size(); ++i)
 			{
-				std::string_view field_name = module.strtable().get(name_id);
-				if (field_name.starts_with("__pad"))
+				/* include padding fields in reduced struct */
+				if (layout.padding_at(i))
 				{
-					/* include padding fields in reduced struct */
-					reduced_fields.emplace_back(name_id, field_type, field_data);
+					reduced_fields.push_back(original_struct.fields[i]);
 					continue;
 				}
 
 				if (info.escaped_fields.contains(logical_field_index))
-					reduced_fields.emplace_back(name_id, field_type, field_data);
+					reduced_fields.push_back(original_struct.fields[i]);
 
 				logical_field_index++;
 			}
 
-			/* create reduced struct type */
-			DataTraits<DataType::STRUCT>::value reduced_struct;
-			reduced_struct.fields = std::move(reduced_fields);
-			reduced_struct.alignment = original_struct.alignment;
-
 			/* generate unique name for reduced struct */
 			static std::atomic<std::uint32_t> counter{0};
 			std::string reduced_name = "__sroa_reduced_" + std::to_string(counter.fetch_add(1));
-			reduced_struct.name = module.intern_str(reduced_name);
-
-			TypedData reduced_type;
-			reduced_type.set<decltype(reduced_struct), DataType::STRUCT>(std::move(reduced_struct));
 
-			return reduced_type;
+			/* create reduced struct type */
+			return module.types().struct_t(module.intern_str(reduced_name), reduced_fields, original_struct.alignment);
 		}
 
 		bool transform_allocation(AllocationInfo& info, Module& module)
@@ -424,6 +404,7 @@ namespace arc
 				if (info.alloc_node->parent)
 					info.alloc_node->parent->remove(info.alloc_node);
 
+				++aggregates_split;
 				return true;
 			}
 
@@ -432,14 +413,8 @@ namespace arc
 			{
 				if (info.alloc_node->value.type() == DataType::STRUCT)
 				{
-					const auto& struct_data = info.alloc_node->value.get<DataType::STRUCT>();
-					std::size_t total_logical_fields = 0;
-					for (const auto& [name_id, field_type, field_data] : struct_data.fields)
-					{
-						std::string_view field_name = module.strtable().get(name_id);
-						if (!field_name.starts_with("__pad"))
-							total_logical_fields++;
-					}
+					const std::size_t total_logical_fields =
+						module.layout().of(info.alloc_node->value.get<DataType::STRUCT>()).fields.size();
 
 					if (info.escaped_fields.size() < total_logical_fields)
 					{
@@ -452,9 +427,11 @@ namespace arc
 
 						info.alloc_node->value = reduced_type;
 						info.alloc_node->type_kind = DataType::STRUCT;
+						module.intern_t(info.alloc_node);
 
 						make_scalar_allocations(info, module);
 						replace_field_accesses(info);
+						++aggregates_narrowed;
 						return true;
 					}
 				}
@@ -520,23 +497,12 @@ namespace arc
 		const auto& tbaa_result = pm.get<TypeBasedAliasResult>();
 		std::vector<Region*> all_modified_regions;
 
-		for (const Node* func_node : module.functions())
+		for (Node* func_node : module.functions())
 		{
 			if (func_node->ir_type != NodeType::FUNCTION)
 				continue;
 
-			const std::string_view func_name = module.strtable().get(func_node->str_id);
-			Region* func_region = nullptr;
-
-			for (Region* child : module.root()->children())
-			{
-				if (child->name() == func_name)
-				{
-					func_region = child;
-					break;
-				}
-			}
-
+			Region* func_region = module.open_body(func_node);
 			if (!func_region)
 				continue;
 
@@ -0,0 +1,177 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <memory>
+#include <arc/analysis/block-frequency.hpp>
+#include <arc/foundation/builder.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/pass-manager.hpp>
+#include <gtest/gtest.h>
+
+class BlockFrequencyFixture : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		module = std::make_unique<arc::Module>("block_frequency_test_module");
+		builder = std::make_unique<arc::Builder>(*module);
+	}
+
+	arc::Region *get_region(arc::Region *parent, const std::string &name)
+	{
+		for (arc::Region *child: parent->children())
+		{
+			if (child->name() == name)
+				return child;
+		}
+		return nullptr;
+	}
+
+	/* loop -> (hot | cold) -> latch -> loop | exit */
+	arc::Node *build_loop()
+	{
+		return builder->function<arc::DataType::INT32>("kernel")
+				.param<arc::DataType::INT32>("n")
+				.body([&](arc::Builder &fb, arc::Node *n)
+				{
+					auto loop = fb.block<arc::DataType::VOID>("loop");
+					auto hot = fb.block<arc::DataType::VOID>("hot");
+					auto cold = fb.block<arc::DataType::VOID>("cold");
+					auto exit = fb.block<arc::DataType::VOID>("exit");
+
+					auto *counter = fb.alloc<arc::DataType::INT32>(fb.lit(1));
+					fb.store(fb.lit(0), counter);
+					fb.jump(loop.entry());
+
+					loop([&](arc::Builder &lb)
+					{
+						auto *i = lb.add(lb.load(counter), lb.lit(1));
+						lb.store(i, counter);
+						return lb.branch(lb.lt(i, lb.lit(0)), cold.entry(), hot.entry());
+					});
+
+					hot([&](arc::Builder &hb)
+					{
+						return hb.branch(hb.lt(hb.load(counter), n), loop.entry(), exit.entry());
+					});
+
+					cold([&](arc::Builder &cb)
+					{
+						return cb.jump(exit.entry());
+					});
+
+					exit([&](arc::Builder &eb)
+					{
+						return eb.ret(eb.load(counter));
+					});
+
+					return nullptr;
+				});
+	}
+
+	std::unique_ptr<arc::Module> module;
+	std::unique_ptr<arc::Builder> builder;
+};
+
+TEST_F(BlockFrequencyFixture, HeuristicLoopScaling)
+{
+	build_loop();
+
+	arc::PassManager pm;
+	pm.add<arc::BlockFrequencyAnalysisPass>();
+	pm.run(*module);
+	const auto &result = pm.get<arc::BlockFrequencyResult>();
+
+	arc::Region *body = get_region(module->root(), "kernel");
+	arc::Region *loop = get_region(body, "loop");
+	arc::Region *hot = get_region(body, "hot");
+	arc::Region *cold = get_region(body, "cold");
+	arc::Region *exit = get_region(body, "exit");
+
+	EXPECT_TRUE(result.loop_header(loop));
+	EXPECT_FALSE(result.loop_header(hot));
+
+	/* the back edge is likely, the negative check and loop exit are not */
+	EXPECT_GT(result.edge_probability(hot, loop), 0.8f);
+	EXPECT_LT(result.edge_probability(loop, cold), 0.1f);
+	EXPECT_FLOAT_EQ(result.edge_probability(loop, cold) + result.edge_probability(loop, hot), 1.0f);
+
+	EXPECT_FLOAT_EQ(result.frequency(body).value_or(0.0f), 1.0f);
+	EXPECT_GT(result.frequency(loop).value_or(0.0f), 4.0f);
+	EXPECT_LT(result.frequency(cold).value_or(1.0f), 1.0f);
+	EXPECT_NEAR(result.frequency(exit).value_or(0.0f), 1.0f, 1e-4f);
+}
+
+TEST_F(BlockFrequencyFixture, ProfileWeightsOverrideHeuristics)
+{
+	build_loop();
+
+	arc::Profile profile;
+	profile.functions["kernel"] = { .entry_count = 3, .branches = { { 0, 30 }, { 27, 3 } } };
+
+	arc::PassManager pm;
+	pm.add<arc::BlockFrequencyAnalysisPass>(profile);
+	pm.run(*module);
+	const auto &result = pm.get<arc::BlockFrequencyResult>();
+
+	arc::Region *body = get_region(module->root(), "kernel");
+	EXPECT_NEAR(result.frequency(get_region(body, "loop")).value_or(0.0f), 10.0f, 1e-3f);
+	EXPECT_FLOAT_EQ(result.frequency(get_region(body, "cold")).value_or(1.0f), 0.0f);
+	EXPECT_NEAR(result.frequency(get_region(body, "exit")).value_or(0.0f), 1.0f, 1e-4f);
+}
+
+TEST_F(BlockFrequencyFixture, NullCheckAndUnwindAreCold)
+{
+	arc::Node *callee = builder->function<arc::DataType::INT32>("may_throw")
+			.param<arc::DataType::INT32>("x")
+			.body([](arc::Builder &fb, arc::Node *x)
+			{
+				return fb.ret(x);
+			});
+
+	builder->function<arc::DataType::INT32>("guarded")
+			.param<arc::DataType::INT32>("x")
+			.body([&](arc::Builder &fb, arc::Node *x)
+			{
+				auto error = fb.block<arc::DataType::VOID>("error");
+				auto work = fb.block<arc::DataType::VOID>("work");
+				auto done = fb.block<arc::DataType::VOID>("done");
+				auto handler = fb.block<arc::DataType::VOID>("handler");
+
+				fb.branch(fb.eq(x, fb.lit(0)), error.entry(), work.entry());
+
+				error([&](arc::Builder &eb)
+				{
+					return eb.ret(eb.lit(-1));
+				});
+
+				work([&](arc::Builder &wb)
+				{
+					wb.invoke(callee, { x }, done.entry(), handler.entry());
+					return nullptr;
+				});
+
+				done([&](arc::Builder &db)
+				{
+					return db.ret(x);
+				});
+
+				handler([&](arc::Builder &hb)
+				{
+					return hb.ret(hb.lit(-2));
+				});
+
+				return nullptr;
+			});
+
+	arc::PassManager pm;
+	pm.add<arc::BlockFrequencyAnalysisPass>();
+	pm.run(*module);
+	const auto &result = pm.get<arc::BlockFrequencyResult>();
+
+	arc::Region *body = get_region(module->root(), "guarded");
+	arc::Region *work = get_region(body, "work");
+	EXPECT_FLOAT_EQ(result.edge_probability(body, get_region(body, "error")), 0.375f);
+	EXPECT_LT(result.edge_probability(work, get_region(body, "handler")), 1e-3f);
+	EXPECT_GT(result.frequency(get_region(body, "done")).value_or(0.0f),
+	          result.frequency(get_region(body, "handler")).value_or(1.0f));
+}
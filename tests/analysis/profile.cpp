@@ -0,0 +1,172 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <arc/analysis/profile.hpp>
+#include <arc/foundation/builder.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/pass-manager.hpp>
+#include <gtest/gtest.h>
+
+class ProfileFixture : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		module = std::make_unique<arc::Module>("profile_test_module");
+		builder = std::make_unique<arc::Builder>(*module);
+	}
+
+	arc::Region *get_region(arc::Region *parent, const std::string &name)
+	{
+		for (arc::Region *child: parent->children())
+		{
+			if (child->name() == name)
+				return child;
+		}
+		return nullptr;
+	}
+
+	/* loop -> (hot | cold) -> latch -> loop | exit */
+	arc::Node *build_loop()
+	{
+		return builder->function<arc::DataType::INT32>("kernel")
+				.param<arc::DataType::INT32>("n")
+				.body([&](arc::Builder &fb, arc::Node *n)
+				{
+					auto loop = fb.block<arc::DataType::VOID>("loop");
+					auto hot = fb.block<arc::DataType::VOID>("hot");
+					auto cold = fb.block<arc::DataType::VOID>("cold");
+					auto exit = fb.block<arc::DataType::VOID>("exit");
+
+					auto *counter = fb.alloc<arc::DataType::INT32>(fb.lit(1));
+					fb.store(fb.lit(0), counter);
+					fb.jump(loop.entry());
+
+					loop([&](arc::Builder &lb)
+					{
+						auto *i = lb.add(lb.load(counter), lb.lit(1));
+						lb.store(i, counter);
+						return lb.branch(lb.lt(i, lb.lit(0)), cold.entry(), hot.entry());
+					});
+
+					hot([&](arc::Builder &hb)
+					{
+						return hb.branch(hb.lt(hb.load(counter), n), loop.entry(), exit.entry());
+					});
+
+					cold([&](arc::Builder &cb)
+					{
+						return cb.jump(exit.entry());
+					});
+
+					exit([&](arc::Builder &eb)
+					{
+						return eb.ret(eb.load(counter));
+					});
+
+					return nullptr;
+				});
+	}
+
+	std::unique_ptr<arc::Module> module;
+	std::unique_ptr<arc::Builder> builder;
+};
+
+TEST_F(ProfileFixture, LayoutCoversBranches)
+{
+	arc::Node *fn = build_loop();
+
+	const arc::ProfileLayout layout = arc::ProfileLayout::of(*module);
+	ASSERT_EQ(layout.functions.size(), 1);
+	EXPECT_EQ(layout.functions[0].node, fn);
+	EXPECT_EQ(layout.functions[0].branches.size(), 2);
+	EXPECT_EQ(layout.counters, 5);
+}
+
+TEST_F(ProfileFixture, FileRoundTrip)
+{
+	arc::Profile profile;
+	profile.functions["kernel"] = { .entry_count = 3, .branches = { { 0, 30 }, { 27, 3 } } };
+	profile.functions["leaf"] = { .entry_count = 12, .branches = {} };
+
+	std::stringstream stream;
+	profile.write(stream);
+	EXPECT_EQ(stream.str(), "arc-profile 1\n"
+	                        "function kernel 3 2\n0 30\n27 3\n"
+	                        "function leaf 12 0\n");
+
+	const arc::Profile parsed = arc::Profile::read(stream);
+	ASSERT_EQ(parsed.functions.size(), 2);
+	EXPECT_EQ(parsed.functions.at("kernel").entry_count, 3);
+	EXPECT_EQ(parsed.functions.at("kernel").branches, profile.functions["kernel"].branches);
+	EXPECT_EQ(parsed.functions.at("leaf").entry_count, 12);
+}
+
+TEST_F(ProfileFixture, MalformedFileRejected)
+{
+	std::istringstream bad_header("gcov 1\n");
+	EXPECT_THROW(arc::Profile::read(bad_header), std::runtime_error);
+
+	std::istringstream truncated("arc-profile 1\nfunction kernel 3 2\n0 30\n");
+	EXPECT_THROW(arc::Profile::read(truncated), std::runtime_error);
+}
+
+TEST_F(ProfileFixture, MergeSumsRuns)
+{
+	arc::Profile first;
+	first.functions["kernel"] = { .entry_count = 1, .branches = { { 2, 3 } } };
+
+	arc::Profile second;
+	second.functions["kernel"] = { .entry_count = 4, .branches = { { 5, 6 } } };
+	second.functions["other"] = { .entry_count = 7, .branches = {} };
+
+	first.merge(second);
+	EXPECT_EQ(first.functions["kernel"].entry_count, 5);
+	EXPECT_EQ(first.functions["kernel"].branches[0], (arc::BranchWeights { 7, 9 }));
+	EXPECT_EQ(first.functions["other"].entry_count, 7);
+
+	arc::Profile reshaped;
+	reshaped.functions["kernel"] = { .entry_count = 1, .branches = {} };
+	EXPECT_THROW(first.merge(reshaped), std::invalid_argument);
+}
+
+TEST_F(ProfileFixture, RegionCountsFromBranchWeights)
+{
+	arc::Node *fn = build_loop();
+
+	arc::Profile profile;
+	profile.functions["kernel"] = { .entry_count = 3, .branches = { { 0, 30 }, { 27, 3 } } };
+
+	arc::PassManager pm;
+	pm.add<arc::ProfileAnalysisPass>(profile);
+	pm.run(*module);
+	const auto &result = pm.get<arc::ProfileResult>();
+
+	arc::Region *body = get_region(module->root(), "kernel");
+	ASSERT_NE(body, nullptr);
+	EXPECT_EQ(result.entry_count(fn), 3);
+	EXPECT_EQ(result.count(body), 3);
+	EXPECT_EQ(result.count(get_region(body, "loop")), 30);
+	EXPECT_EQ(result.count(get_region(body, "hot")), 30);
+	EXPECT_EQ(result.count(get_region(body, "exit")), 3);
+	EXPECT_TRUE(result.cold(get_region(body, "cold")));
+	EXPECT_FLOAT_EQ(result.frequency(get_region(body, "loop")).value_or(0.0f), 10.0f);
+}
+
+TEST_F(ProfileFixture, StaleFunctionIgnored)
+{
+	arc::Node *fn = build_loop();
+
+	arc::Profile profile;
+	profile.functions["kernel"] = { .entry_count = 3, .branches = { { 0, 30 } } };
+
+	arc::PassManager pm;
+	pm.add<arc::ProfileAnalysisPass>(profile);
+	pm.run(*module);
+	const auto &result = pm.get<arc::ProfileResult>();
+
+	EXPECT_TRUE(result.empty());
+	EXPECT_FALSE(result.entry_count(fn).has_value());
+}
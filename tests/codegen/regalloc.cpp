@@ -797,3 +797,135 @@ TEST_F(RegisterAllocatorFixture, CrossRegionValueFlow)
 	std::print("total pressure: {}\n", total_pressure);
 }
 
+
+TEST_F(RegisterAllocatorFixture, ParallelCopySequencing)
+{
+	using Allocator = arc::RegisterAllocator<MockTarget>;
+
+	/* a chain must write the destination that is still read last */
+	auto chain = Allocator::sequence({ { 1, 2 }, { 2, 3 } });
+	ASSERT_EQ(chain.size(), 2);
+	EXPECT_EQ(chain[0].src, 2);
+	EXPECT_EQ(chain[0].dst, 3);
+	EXPECT_EQ(chain[1].src, 1);
+	EXPECT_EQ(chain[1].dst, 2);
+
+	/* self copies are free */
+	EXPECT_TRUE(Allocator::sequence({ { 4, 4 } }).empty());
+
+	/* a cycle goes through the scratch register when one is given */
+	auto rotated = Allocator::sequence({ { 1, 2 }, { 2, 3 }, { 3, 1 } }, 9u);
+	EXPECT_EQ(rotated.size(), 4);
+
+	std::unordered_map<std::uint32_t, std::uint32_t> regs = { { 1, 10 }, { 2, 20 }, { 3, 30 }, { 9, 0 } };
+	for (const auto &move: rotated)
+	{
+		EXPECT_FALSE(move.swap);
+		regs[move.dst] = regs[move.src];
+	}
+	EXPECT_EQ(regs[2], 10);
+	EXPECT_EQ(regs[3], 20);
+	EXPECT_EQ(regs[1], 30);
+
+	/* and is resolved with swaps otherwise */
+	auto swapped = Allocator::sequence({ { 1, 2 }, { 2, 3 }, { 3, 1 } });
+	EXPECT_EQ(swapped.size(), 2);
+
+	regs = { { 1, 10 }, { 2, 20 }, { 3, 30 } };
+	for (const auto &move: swapped)
+	{
+		EXPECT_TRUE(move.swap);
+		std::swap(regs[move.src], regs[move.dst]);
+	}
+	EXPECT_EQ(regs[2], 10);
+	EXPECT_EQ(regs[3], 20);
+	EXPECT_EQ(regs[1], 30);
+}
+
+TEST_F(RegisterAllocatorFixture, LoopFROMWebCoalescing)
+{
+	auto *preheader = module->create_region("preheader");
+	auto *header = module->create_region("header", preheader);
+	auto *exit = module->create_region("exit", preheader);
+
+	arc::Builder builder(*module);
+	builder.set_insertion_point(preheader);
+	auto *init = builder.lit(0);
+
+	/* i = FROM(init, next); next = i + 1; loop while next < 10 */
+	builder.set_insertion_point(header);
+	auto *i = builder.from({ init });
+	auto *next = builder.add(i, builder.lit(1));
+	i->inputs.push_back(next);
+	next->users.push_back(i);
+	builder.branch(builder.lt(next, builder.lit(10)), header->entry(), exit->entry());
+
+	arc::SelectionDAG<MockTarget::instruction_type> loop_dag(header);
+	loop_dag.build();
+	loop_dag.linearize();
+
+	arc::RegisterAllocator<MockTarget> loop_allocator(*target, loop_dag);
+	loop_allocator.allocate(preheader, create_test_budget());
+
+	auto *dag_i = loop_dag.find(i);
+	auto *dag_next = loop_dag.find(next);
+	auto *dag_init = loop_dag.find(init);
+	ASSERT_NE(dag_i, nullptr);
+	ASSERT_NE(dag_next, nullptr);
+	ASSERT_NE(dag_init, nullptr);
+
+	EXPECT_TRUE(loop_allocator.coalesced(dag_i, dag_next));
+	EXPECT_TRUE(loop_allocator.coalesced(dag_i, dag_init));
+
+	/* neither the back edge nor the loop entry needs a move */
+	EXPECT_TRUE(loop_allocator.copies(header, header).empty());
+	EXPECT_TRUE(loop_allocator.copies(preheader, header).empty());
+}
+
+TEST_F(RegisterAllocatorFixture, InterferingFROMWebsSwap)
+{
+	auto *preheader = module->create_region("preheader");
+	auto *header = module->create_region("header", preheader);
+	auto *exit = module->create_region("exit", preheader);
+
+	arc::Builder builder(*module);
+	builder.set_insertion_point(preheader);
+	auto *a0 = builder.lit(1);
+	auto *b0 = builder.lit(2);
+	auto *cond = builder.lt(a0, b0);
+
+	/* a = FROM(a0, b); b = FROM(b0, a) swaps both values on every iteration */
+	builder.set_insertion_point(header);
+	auto *a = builder.from({ a0 });
+	auto *b = builder.from({ b0, a });
+	a->inputs.push_back(b);
+	b->users.push_back(a);
+	builder.branch(cond, header->entry(), exit->entry());
+
+	arc::SelectionDAG<MockTarget::instruction_type> loop_dag(header);
+	loop_dag.build();
+	loop_dag.linearize();
+
+	arc::RegisterAllocator<MockTarget> loop_allocator(*target, loop_dag);
+	loop_allocator.allocate(preheader, create_test_budget());
+
+	auto *dag_a = loop_dag.find(a);
+	auto *dag_b = loop_dag.find(b);
+	ASSERT_NE(dag_a, nullptr);
+	ASSERT_NE(dag_b, nullptr);
+
+	/* both values are live at the same time and cannot share a register */
+	EXPECT_FALSE(loop_allocator.coalesced(dag_a, dag_b));
+	auto reg_a = loop_allocator.get(dag_a).reg;
+	auto reg_b = loop_allocator.get(dag_b).reg;
+	ASSERT_TRUE(reg_a.has_value());
+	ASSERT_TRUE(reg_b.has_value());
+	EXPECT_NE(*reg_a, *reg_b);
+
+	auto swapped = loop_allocator.copies(header, header);
+	ASSERT_EQ(swapped.size(), 1);
+	EXPECT_TRUE(swapped[0].swap);
+
+	auto through_temp = loop_allocator.copies(header, header, 15u);
+	EXPECT_EQ(through_temp.size(), 3);
+}
@@ -0,0 +1,390 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include <arc/analysis/call-graph.hpp>
+#include <arc/foundation/builder.hpp>
+#include <arc/foundation/cold-store.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/pass-manager.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/foundation/verifier.hpp>
+#include <arc/support/output-buffer.hpp>
+#include <arc/support/printer.hpp>
+#include <arc/transform/constfold.hpp>
+#include <arc/transform/inliner.hpp>
+#include <gtest/gtest.h>
+
+namespace
+{
+	std::string print(arc::Module &module)
+	{
+		arc::OutputBuffer out;
+		arc::Printer(module).print(out);
+		return out.str();
+	}
+
+	bool is_extern(const arc::Node *fn)
+	{
+		return (fn->traits & arc::NodeTraits::EXTERN) != arc::NodeTraits::NONE;
+	}
+
+	/* counts the functions that stand as declarations while it runs */
+	class ExternProbe final : public arc::TransformPass
+	{
+	public:
+		explicit ExternProbe(std::size_t &seen) : seen(seen) {}
+
+		[[nodiscard]] std::string name() const override
+		{
+			return "extern-probe";
+		}
+
+		std::vector<arc::Region *> run(arc::Module &module, arc::PassManager &) override
+		{
+			seen = 0;
+			for (const arc::Node *fn: module.functions())
+				seen += is_extern(fn);
+			return {};
+		}
+
+	private:
+		std::size_t &seen;
+	};
+
+	/* records the resident footprint of the module while it runs */
+	class ResidentProbe final : public arc::TransformPass
+	{
+	public:
+		explicit ResidentProbe(std::vector<std::size_t> &resident) : resident(resident) {}
+
+		[[nodiscard]] std::string name() const override
+		{
+			return "resident-probe";
+		}
+
+		std::vector<arc::Region *> run(arc::Module &module, arc::PassManager &) override
+		{
+			if (const arc::ColdStore *cold = module.cold_store())
+				resident.push_back(cold->resident_bytes());
+			return {};
+		}
+
+	private:
+		std::vector<std::size_t> &resident;
+	};
+
+	/* inlines the call sites the call graph found, as an inter-procedural pipeline would */
+	class InlinePass final : public arc::TransformPass
+	{
+	public:
+		explicit InlinePass(std::size_t &inlined) : inlined(inlined) {}
+
+		[[nodiscard]] std::string name() const override
+		{
+			return "inline";
+		}
+
+		[[nodiscard]] std::vector<std::string> require() const override
+		{
+			return { "call-graph-analysis" };
+		}
+
+		[[nodiscard]] std::vector<std::string> invalidates() const override
+		{
+			return { "call-graph-analysis" };
+		}
+
+		std::vector<arc::Region *> run(arc::Module &module, arc::PassManager &pm) override
+		{
+			const auto &cg = pm.get<arc::CallGraphResult>();
+			const arc::Inliner inliner;
+			std::vector<arc::Region *> modified;
+			for (arc::Node *fn: module.functions())
+			{
+				for (arc::Node *call: cg.call_sites(fn))
+				{
+					const arc::Inliner::Result result = inliner.inline_call(call, cg.callee(call), module, &cg);
+					if (!result.success)
+						continue;
+					++inlined;
+					modified.insert(modified.end(), result.modified.begin(), result.modified.end());
+				}
+			}
+			return modified;
+		}
+
+	private:
+		std::size_t &inlined;
+	};
+
+	struct LoadedBodies final : arc::Analysis
+	{
+		[[nodiscard]] std::string name() const override
+		{
+			return "loaded-bodies";
+		}
+	};
+
+	/* stands for an analysis that looks into callees through `Module::load_body` */
+	class BodyLoadingAnalysis final : public arc::AnalysisPass
+	{
+	public:
+		[[nodiscard]] std::string name() const override
+		{
+			return "body-loading-analysis";
+		}
+
+		[[nodiscard]] bool loads_bodies() const override
+		{
+			return true;
+		}
+
+		arc::Analysis *run(const arc::Module &) override
+		{
+			return allocate_result<LoadedBodies>();
+		}
+	};
+}
+
+class ColdStoreFixture : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		module = std::make_unique<arc::Module>("program");
+		arc::Builder builder(*module);
+
+		/* f0(x) = x + 2 * 3, and every f<i>(x) = f<i-1>(x) + 2 * 3 */
+		arc::Node *callee = nullptr;
+		for (std::size_t i = 0; i < functions; ++i)
+		{
+			callee = builder.function<arc::DataType::INT32>("f" + std::to_string(i))
+					.param<arc::DataType::INT32>("x")
+					.body([&](arc::Builder &fb, arc::Node *x)
+					{
+						arc::Node *base = callee ? fb.call(callee, { x }) : x;
+						return fb.ret(fb.add(base, fb.mul(fb.lit(2), fb.lit(3))));
+					});
+		}
+		original = print(*module);
+	}
+
+	static constexpr std::size_t functions = 8;
+	std::unique_ptr<arc::Module> module;
+	std::string original;
+};
+
+TEST_F(ColdStoreFixture, EvictedFunctionsStandAsDeclarations)
+{
+	arc::ColdStore cold(*module);
+	arc::Node *fn = module->find_fn("f3");
+	const std::size_t before = cold.resident_bytes(fn);
+
+	ASSERT_TRUE(cold.evict(fn));
+	EXPECT_TRUE(cold.evicted(fn));
+	EXPECT_TRUE(is_extern(fn));
+	EXPECT_LT(cold.resident_bytes(fn), before);
+	EXPECT_GT(cold.stored_bytes(), 0u);
+	EXPECT_LT(cold.stored_bytes(), before / 4);
+	EXPECT_TRUE(arc::Verifier(*module).verify().empty());
+
+	/* already evicted, or no body to evict */
+	EXPECT_FALSE(cold.evict(fn));
+	EXPECT_FALSE(cold.evict(nullptr));
+	EXPECT_EQ(cold.evicted_count(), 1u);
+}
+
+TEST_F(ColdStoreFixture, RehydratedFunctionsMatchTheOriginal)
+{
+	arc::ColdStore cold(*module);
+	const std::size_t before = cold.resident_bytes();
+	EXPECT_EQ(cold.evict(module->functions()), functions);
+	EXPECT_LT(cold.resident_bytes(), before);
+	EXPECT_NE(print(*module), original);
+
+	/* callers keep targeting the same FUNCTION node, before and after */
+	arc::Node *callee = module->find_fn("f4");
+	cold.rehydrate(module->find_fn("f5"));
+	ASSERT_EQ(callee->users.size(), 1u);
+	const arc::Node *call = callee->users[0];
+	EXPECT_EQ(call->inputs[0], callee);
+
+	cold.rehydrate(callee);
+	EXPECT_FALSE(is_extern(callee));
+	EXPECT_EQ(call->inputs[0], callee);
+
+	EXPECT_EQ(cold.rehydrate_all(), functions - 2);
+	EXPECT_EQ(cold.evicted_count(), 0u);
+	EXPECT_EQ(cold.stored_bytes(), 0u);
+	EXPECT_EQ(print(*module), original);
+	EXPECT_TRUE(arc::Verifier(*module).verify().empty());
+}
+
+TEST_F(ColdStoreFixture, FileMediumRoundTrips)
+{
+	arc::ColdStore cold(*module, arc::ColdMedium::FILE);
+	EXPECT_EQ(cold.evict(module->functions()), functions);
+	EXPECT_GT(cold.stored_bytes(), 0u);
+
+	EXPECT_EQ(cold.rehydrate_all(), functions);
+	EXPECT_EQ(print(*module), original);
+	EXPECT_TRUE(arc::Verifier(*module).verify().empty());
+}
+
+TEST_F(ColdStoreFixture, DestroyingTheStoreRehydrates)
+{
+	{
+		arc::ColdStore cold(*module, arc::ColdMedium::FILE);
+		cold.evict(module->functions());
+	}
+	EXPECT_EQ(print(*module), original);
+}
+
+TEST_F(ColdStoreFixture, EnforceOnlyEvictsFunctionsThatStoppedChanging)
+{
+	arc::ColdStore cold(*module);
+	const arc::EvictionPolicy policy { .budget = 1, .cold_after = 1 };
+
+	/* the first look only learns when every function last changed */
+	EXPECT_EQ(cold.enforce(policy), 0u);
+
+	/* f2 changes in between, so it is the one left resident */
+	arc::Node *fn = module->find_fn("f2");
+	for (arc::Region *child: module->root()->children())
+	{
+		if (child->name() == "f2")
+			module->touch(child);
+	}
+	EXPECT_EQ(cold.enforce(policy), functions - 1);
+	EXPECT_FALSE(cold.evicted(fn));
+
+	/* under budget nothing goes */
+	cold.rehydrate_all();
+	EXPECT_EQ(cold.enforce({ .budget = cold.resident_bytes(), .cold_after = 0 }), 0u);
+}
+
+TEST_F(ColdStoreFixture, PassManagerEvictsColdFunctionsUnderBudget)
+{
+	std::size_t seen = 0;
+	arc::PassManager budgeted;
+	budgeted.memory_budget({ .budget = 1, .cold_after = 1 });
+	budgeted.add<arc::ConstantFoldingPass>().add<arc::ConstantFoldingPass>().add<ExternProbe>(seen);
+	budgeted.run(*module);
+
+	/* folded by the first pass, unchanged by the second, evicted before the probe */
+	EXPECT_EQ(seen, functions);
+	for (const arc::Node *fn: module->functions())
+		EXPECT_FALSE(is_extern(fn));
+
+	/* and the module comes out as it does without a budget */
+	const std::string output = print(*module);
+	SetUp();
+	arc::PassManager reference;
+	reference.add<arc::ConstantFoldingPass>().add<arc::ConstantFoldingPass>().add<ExternProbe>(seen);
+	reference.run(*module);
+	EXPECT_EQ(seen, 0u);
+	EXPECT_EQ(output, print(*module));
+}
+
+TEST_F(ColdStoreFixture, LookingIntoAnEvictedFunctionRehydratesIt)
+{
+	arc::ColdStore cold(*module);
+	arc::Node *fn = module->find_fn("f3");
+	ASSERT_TRUE(cold.evict(fn));
+
+	/* what inter-procedural passes do before reading a callee's body */
+	EXPECT_TRUE(module->load_body(fn));
+	EXPECT_FALSE(cold.evicted(fn));
+	EXPECT_FALSE(is_extern(fn));
+	EXPECT_FALSE(module->load_body(fn));
+	EXPECT_EQ(print(*module), original);
+}
+
+TEST_F(ColdStoreFixture, DestroyingTheStoreRemovesItsLoader)
+{
+	arc::Node *fn = module->find_fn("f3");
+	{
+		arc::ColdStore cold(*module);
+		cold.evict(fn);
+	}
+	fn->traits = fn->traits | arc::NodeTraits::EXTERN;
+	EXPECT_FALSE(module->load_body(fn));
+}
+
+TEST_F(ColdStoreFixture, InliningPipelineStaysUnderBudget)
+{
+	/* large spares come first, so they are the ones evicted; the callers inline the
+	 * leaf and look into the first spare, which the Inliner brings back */
+	arc::Module program("program");
+	arc::Builder builder(program);
+	std::vector<arc::Node *> spares;
+	for (std::size_t i = 0; i < functions; ++i)
+	{
+		spares.push_back(builder.function<arc::DataType::INT32>("s" + std::to_string(i))
+				.param<arc::DataType::INT32>("x")
+				.body([](arc::Builder &fb, arc::Node *x)
+				{
+					arc::Node *value = x;
+					for (std::size_t k = 0; k < 32; ++k)
+						value = fb.mul(value, x);
+					return fb.ret(value);
+				}));
+	}
+	arc::Node *leaf = builder.function<arc::DataType::INT32>("leaf")
+			.param<arc::DataType::INT32>("x")
+			.body([](arc::Builder &fb, arc::Node *x)
+			{
+				return fb.ret(fb.add(x, fb.mul(fb.lit(2), fb.lit(3))));
+			});
+	for (std::size_t i = 0; i < 2; ++i)
+	{
+		builder.function<arc::DataType::INT32>("c" + std::to_string(i))
+				.param<arc::DataType::INT32>("x")
+				.body([&](arc::Builder &fb, arc::Node *x)
+				{
+					return fb.ret(fb.add(fb.call(leaf, { x }), fb.call(spares[0], { x })));
+				});
+	}
+	const std::size_t budget = arc::ColdStore(program).resident_bytes() / 2;
+
+	std::size_t inlined = 0;
+	std::vector<std::size_t> resident;
+	arc::PassManager pm;
+	pm.memory_budget({ .budget = budget, .cold_after = 0 });
+	pm.add<arc::CallGraphAnalysisPass>()
+			.add<ResidentProbe>(resident)
+			.add<InlinePass>(inlined)
+			.add<ResidentProbe>(resident);
+	pm.run(program);
+
+	/* the call graph computed again after the evictions reads them from the store,
+	 * and what the Inliner brought back goes again once the call graph is dropped */
+	ASSERT_EQ(resident.size(), 2u);
+	EXPECT_LE(resident[0], budget);
+	EXPECT_LE(resident[1], budget);
+	EXPECT_EQ(inlined, 2u);
+
+	for (const arc::Node *fn: program.functions())
+		EXPECT_FALSE(is_extern(fn));
+	EXPECT_TRUE(arc::Verifier(program).verify().empty());
+}
+
+TEST_F(ColdStoreFixture, AnalysisLoadingBodiesHoldsEvictionsOff)
+{
+	std::size_t seen = 0;
+	arc::PassManager pm;
+	pm.memory_budget({ .budget = 1, .cold_after = 0 });
+	pm.add<BodyLoadingAnalysis>().add<ExternProbe>(seen);
+	pm.run(*module);
+	EXPECT_EQ(seen, 0u);
+
+	/* without it, the same budget evicts every function at that safe point */
+	arc::PassManager reference;
+	reference.memory_budget({ .budget = 1, .cold_after = 0 });
+	reference.add<ExternProbe>(seen).add<ExternProbe>(seen);
+	reference.run(*module);
+	EXPECT_EQ(seen, functions);
+}
@@ -0,0 +1,146 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <memory>
+#include <thread>
+#include <vector>
+#include <arc/foundation/builder.hpp>
+#include <arc/foundation/data-layout.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/support/algorithm.hpp>
+#include <gtest/gtest.h>
+
+class DataLayoutFixture : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		module = std::make_unique<arc::Module>("data_layout_test_module");
+		builder = std::make_unique<arc::Builder>(*module);
+	}
+
+	std::unique_ptr<arc::Module> module;
+	std::unique_ptr<arc::Builder> builder;
+};
+
+TEST_F(DataLayoutFixture, StructOffsetsSkipPadding)
+{
+	/* a: 0, __pad: 2, b: 4, c: 8 */
+	const arc::TypedData type = builder->struct_type("Padded")
+			.field("a", arc::DataType::INT16)
+			.field("b", arc::DataType::INT32)
+			.field("c", arc::DataType::INT64)
+			.build();
+
+	const arc::StructLayout &layout = module->layout().of(type.get<arc::DataType::STRUCT>());
+	EXPECT_EQ(layout.size, 16);
+	EXPECT_EQ(layout.alignment, 8);
+	EXPECT_EQ(layout.padding, 2);
+	ASSERT_EQ(layout.offsets.size(), 4);
+	ASSERT_EQ(layout.fields.size(), 3);
+
+	EXPECT_EQ(layout.offset_of(0), 0);
+	EXPECT_EQ(layout.offset_of(1), 4);
+	EXPECT_EQ(layout.offset_of(2), 8);
+	EXPECT_FALSE(layout.offset_of(3).has_value());
+
+	EXPECT_TRUE(layout.padding_at(1));
+	EXPECT_FALSE(layout.padding_at(2));
+	EXPECT_EQ(layout.index_of(module->intern_str("b")), 2);
+	EXPECT_FALSE(layout.index_of(module->intern_str("__pad1")).has_value());
+	EXPECT_FALSE(layout.index_of(module->intern_str("missing")).has_value());
+}
+
+TEST_F(DataLayoutFixture, LayoutsAreCachedPerType)
+{
+	const arc::TypedData type = builder->struct_type("Pair")
+			.field("x", arc::DataType::INT32)
+			.field("y", arc::DataType::INT32)
+			.build();
+
+	/* copies of an interned struct share one cached layout */
+	const arc::TypedData copy = type;
+	const arc::StructLayout &first = module->layout().of(type.get<arc::DataType::STRUCT>());
+	const arc::StructLayout &second = module->layout().of(copy.get<arc::DataType::STRUCT>());
+	EXPECT_EQ(&first, &second);
+	EXPECT_EQ(module->layout().size(), 1);
+
+	module->layout().clear();
+	EXPECT_EQ(module->layout().size(), 0);
+}
+
+TEST_F(DataLayoutFixture, ConcurrentLookupsShareOneLayout)
+{
+	const arc::TypedData inner = builder->struct_type("Inner")
+			.field("value", arc::DataType::INT64)
+			.build();
+	const arc::TypedData outer = builder->struct_type("Outer")
+			.field("x", arc::DataType::UINT32)
+			.field("inner", arc::DataType::STRUCT, inner)
+			.build();
+
+	/* passes of a parallel batch lay out the same types at once */
+	std::vector<const arc::StructLayout *> seen(4);
+	std::vector<std::thread> threads;
+	for (auto &out: seen)
+	{
+		threads.emplace_back([&]
+		{
+			out = &module->layout().of(outer.get<arc::DataType::STRUCT>());
+		});
+	}
+	for (auto &thread: threads)
+		thread.join();
+
+	for (const arc::StructLayout *layout: seen)
+		EXPECT_EQ(layout, seen.front());
+	EXPECT_EQ(seen.front()->size, 16);
+	EXPECT_EQ(module->layout().size(), 2);
+}
+
+TEST_F(DataLayoutFixture, NestedStructsContributeTheirSize)
+{
+	const arc::TypedData inner = builder->struct_type("Inner")
+			.field("value", arc::DataType::INT64)
+			.build();
+
+	/* x: 0, inner: 4, __pad_final: 12 */
+	const arc::TypedData outer = builder->struct_type("Outer")
+			.field("x", arc::DataType::UINT32)
+			.field("inner", arc::DataType::STRUCT, inner)
+			.build();
+
+	arc::DataLayout &dl = module->layout();
+	EXPECT_EQ(dl.size_of(arc::DataType::STRUCT, inner), 8);
+	EXPECT_EQ(dl.size_of(arc::DataType::STRUCT, outer), 16);
+	EXPECT_EQ(dl.of(outer.get<arc::DataType::STRUCT>()).offset_of(1), 4);
+	EXPECT_EQ(dl.size(), 2);
+
+	arc::TypedData array;
+	arc::DataTraits<arc::DataType::ARRAY>::value array_data = {};
+	array_data.elem_type = arc::DataType::INT16;
+	array_data.count = 5;
+	array.set<decltype(array_data), arc::DataType::ARRAY>(array_data);
+	EXPECT_EQ(dl.size_of(arc::DataType::ARRAY, array), 10);
+	EXPECT_EQ(dl.align_of(arc::DataType::ARRAY, array), 2);
+	EXPECT_EQ(dl.size_of(arc::DataType::FLOAT64, {}), 8);
+}
+
+TEST_F(DataLayoutFixture, StructFieldUsesLayout)
+{
+	const arc::TypedData type = builder->struct_type("Padded")
+			.field("a", arc::DataType::INT16)
+			.field("b", arc::DataType::INT32)
+			.build();
+
+	builder->function<arc::DataType::VOID>("access")
+			.body([&](arc::Builder &fb)
+			{
+				auto *object = fb.alloc(type);
+				auto *b = fb.struct_field(object, "b");
+				EXPECT_EQ(b->type_kind, arc::DataType::INT32);
+				EXPECT_EQ(arc::extract_literal_value(b->inputs[1]), 2);
+				EXPECT_THROW(fb.struct_field(object, "__pad1"), std::invalid_argument);
+				EXPECT_THROW(fb.struct_field(object, "never_interned"), std::invalid_argument);
+				return fb.ret();
+			});
+}
@@ -0,0 +1,98 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <memory>
+#include <string>
+#include <arc/analysis/call-graph.hpp>
+#include <arc/analysis/tbaa.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/partition.hpp>
+#include <arc/foundation/pass-manager.hpp>
+#include <arc/foundation/taskgraph.hpp>
+#include <arc/support/generator.hpp>
+#include <arc/support/output-buffer.hpp>
+#include <arc/support/printer.hpp>
+#include <arc/transform/constfold.hpp>
+#include <arc/transform/cse.hpp>
+#include <arc/transform/dce.hpp>
+#include <gtest/gtest.h>
+
+namespace
+{
+	/* every thread count from 1 up to this one has to print the same module */
+	constexpr unsigned max_threads = 8;
+
+	std::unique_ptr<arc::Module> program()
+	{
+		return arc::generate({ .seed = 42, .nodes = 4096 });
+	}
+
+	void optimize(arc::Module &module)
+	{
+		arc::PassManager pm;
+		pm.add<arc::TypeBasedAliasAnalysisPass>()
+				.add<arc::ConstantFoldingPass>()
+				.add<arc::CommonSubexpressionEliminationPass>()
+				.add<arc::DeadCodeElimination>();
+		pm.run(module);
+	}
+
+	arc::PassManager pipeline(const arc::ExecutionPolicy policy)
+	{
+		auto tasks = arc::TaskGraph()
+				.add<arc::TypeBasedAliasAnalysisPass>()
+				.add<arc::CallGraphAnalysisPass>()
+				.add<arc::ConstantFoldingPass>()
+				.add<arc::DeadCodeElimination>()
+				.add<arc::CommonSubexpressionEliminationPass>();
+		return tasks.build(policy);
+	}
+
+	std::string print(arc::Module &module, const unsigned threads)
+	{
+		arc::OutputBuffer out;
+		arc::Printer(module, threads).print(out);
+		return out.str();
+	}
+}
+
+TEST(DeterminismTest, PrinterOutputIsIndependentOfThreads)
+{
+	const std::unique_ptr<arc::Module> module = program();
+	optimize(*module);
+
+	const std::string expected = print(*module, 1);
+	for (unsigned threads = 2; threads <= max_threads; ++threads)
+		EXPECT_EQ(print(*module, threads), expected) << threads << " threads";
+}
+
+TEST(DeterminismTest, PartitionedCompileIsIndependentOfThreads)
+{
+	std::string expected;
+	for (unsigned threads = 1; threads <= max_threads; ++threads)
+	{
+		const std::unique_ptr<arc::Module> module = program();
+		const arc::Partitioner partitioner(*module, { .partitions = threads });
+		const std::unique_ptr<arc::Module> merged = partitioner.run(optimize);
+
+		const std::string output = print(*merged, threads);
+		if (threads == 1)
+			expected = output;
+		else
+			EXPECT_EQ(output, expected) << threads << " threads";
+	}
+}
+
+TEST(DeterminismTest, DeterministicPolicyMatchesSequential)
+{
+	const std::unique_ptr<arc::Module> sequential = program();
+	pipeline(arc::ExecutionPolicy::SEQUENTIAL).run(*sequential);
+	const std::string expected = print(*sequential, 1);
+
+	/* repeated, since a race would only show up in some of the runs */
+	for (unsigned run = 0; run < max_threads; ++run)
+	{
+		const std::unique_ptr<arc::Module> module = program();
+		pipeline(arc::ExecutionPolicy::DETERMINISTIC).run(*module);
+		EXPECT_EQ(print(*module, run + 1), expected) << "run " << run;
+	}
+}
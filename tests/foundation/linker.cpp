@@ -0,0 +1,296 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include <arc/foundation/builder.hpp>
+#include <arc/foundation/linker.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/foundation/verifier.hpp>
+#include <arc/transform/inliner.hpp>
+#include <gtest/gtest.h>
+
+class LinkerFixture : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		main = std::make_unique<arc::Module>("main");
+		math = std::make_unique<arc::Module>("math");
+	}
+
+	/* exported `square(x) = x * x`, calling a private `helper` when asked to */
+	static arc::Node *define_square(arc::Module &module, const bool via_helper = false)
+	{
+		arc::Builder builder(module);
+		arc::Node *helper = nullptr;
+		if (via_helper)
+		{
+			helper = builder.function<arc::DataType::INT32>("helper")
+					.param<arc::DataType::INT32>("x")
+					.body([](arc::Builder &fb, arc::Node *x)
+					{
+						return fb.ret(fb.mul(x, x));
+					});
+		}
+
+		return builder.function<arc::DataType::INT32>("square")
+				.param<arc::DataType::INT32>("x")
+				.exported()
+				.body([&](arc::Builder &fb, arc::Node *x)
+				{
+					return fb.ret(helper ? fb.call(helper, { x }) : fb.mul(x, x));
+				});
+	}
+
+	/* `main` declares `square` and calls it, returning the call */
+	arc::Node *declare_and_call(arc::Node **call_site = nullptr) const
+	{
+		arc::Builder builder(*main);
+		arc::Node *square = builder.function<arc::DataType::INT32>("square")
+				.param<arc::DataType::INT32>("x")
+				.imported()
+				.body([](arc::Builder &fb, arc::Node *)
+				{
+					return fb.ret(fb.lit(0));
+				});
+
+		builder.function<arc::DataType::INT32>("entry")
+				.body([&](arc::Builder &fb)
+				{
+					arc::Node *call = fb.call(square, { fb.lit(7) });
+					if (call_site)
+						*call_site = call;
+					return fb.ret(call);
+				});
+		return square;
+	}
+
+	static arc::Region *body_of(arc::Module &module, const std::string_view name)
+	{
+		for (arc::Region *child: module.root()->children())
+		{
+			if (child->name() == name)
+				return child;
+		}
+		return nullptr;
+	}
+
+	static bool has_node(const arc::Region *region, const arc::NodeType type)
+	{
+		return std::ranges::any_of(region->nodes(), [&](const arc::Node *node) { return node->ir_type == type; });
+	}
+
+	std::unique_ptr<arc::Module> main;
+	std::unique_ptr<arc::Module> math;
+};
+
+TEST_F(LinkerFixture, ResolvesDeclarationInPlace)
+{
+	arc::Node *call_site = nullptr;
+	arc::Node *square = declare_and_call(&call_site);
+	define_square(*math);
+
+	arc::Linker linker(*main);
+	linker.add(*math);
+	EXPECT_EQ(linker.unresolved(), std::vector<std::string>{ "square" });
+	EXPECT_EQ(linker.resolve(), 1u);
+	EXPECT_TRUE(linker.unresolved().empty());
+
+	/* the call still targets the same node, which is now a definition */
+	EXPECT_EQ(call_site->inputs[0], square);
+	EXPECT_EQ(square->traits & arc::NodeTraits::EXTERN, arc::NodeTraits::NONE);
+	EXPECT_NE(square->traits & arc::NodeTraits::EXPORT, arc::NodeTraits::NONE);
+
+	const arc::Region *body = body_of(*main, "square");
+	ASSERT_NE(body, nullptr);
+	EXPECT_TRUE(has_node(body, arc::NodeType::MUL));
+
+	/* the multiply reads the declaration's own parameter */
+	const auto mul = std::ranges::find_if(body->nodes(), [](const arc::Node *node)
+	{
+		return node->ir_type == arc::NodeType::MUL;
+	});
+	EXPECT_EQ((*mul)->inputs[0], square->inputs[0]);
+	EXPECT_TRUE(arc::Verifier(*main).verify().empty());
+
+	/* the source is untouched */
+	EXPECT_EQ(math->functions().size(), 1u);
+}
+
+TEST_F(LinkerFixture, InlinerSeesThroughResolvedDeclaration)
+{
+	arc::Node *call_site = nullptr;
+	arc::Node *square = declare_and_call(&call_site);
+	define_square(*math);
+
+	arc::Inliner inliner;
+	EXPECT_FALSE(inliner.evaluate(call_site, square).should_inline);
+
+	arc::Linker linker(*main);
+	linker.add(*math).resolve();
+	EXPECT_TRUE(inliner.evaluate(call_site, square).should_inline);
+	EXPECT_TRUE(inliner.inline_call(call_site, square, *main).success);
+	EXPECT_TRUE(has_node(body_of(*main, "entry"), arc::NodeType::MUL));
+}
+
+TEST_F(LinkerFixture, ImportPullsInPrivateCalleesAndRenamesClashes)
+{
+	define_square(*math, true);
+
+	arc::Builder builder(*main);
+	builder.function<arc::DataType::INT32>("helper")
+			.body([](arc::Builder &fb)
+			{
+				return fb.ret(fb.lit(1));
+			});
+
+	arc::Linker linker(*main);
+	arc::Node *square = linker.add(*math).import("square");
+	ASSERT_NE(square, nullptr);
+	EXPECT_EQ(main->functions().size(), 3u);
+	EXPECT_NE(main->find_fn("helper.math"), nullptr);
+
+	/* the copy calls the renamed copy of the helper, not main's own helper */
+	const arc::Region *body = body_of(*main, "square");
+	const auto call = std::ranges::find_if(body->nodes(), [](const arc::Node *node)
+	{
+		return node->ir_type == arc::NodeType::CALL;
+	});
+	ASSERT_NE(call, body->nodes().end());
+	EXPECT_EQ((*call)->inputs[0], main->find_fn("helper.math"));
+	EXPECT_TRUE(arc::Verifier(*main).verify().empty());
+
+	/* importing twice returns the same copy */
+	EXPECT_EQ(linker.import("square"), square);
+	EXPECT_THROW(linker.import("helper"), arc::LinkError);
+}
+
+TEST_F(LinkerFixture, DuplicateExportsAreRejected)
+{
+	arc::Module other("other");
+	define_square(*math);
+	define_square(other);
+
+	arc::Linker linker(*main);
+	linker.add(*math);
+	try
+	{
+		linker.add(other);
+		FAIL() << "expected a LinkError";
+	}
+	catch (const arc::LinkError &e)
+	{
+		EXPECT_EQ(e.symbol(), "square");
+	}
+	EXPECT_THROW(linker.add(*main), std::invalid_argument);
+}
+
+TEST_F(LinkerFixture, DefinitionInDestinationIsRejected)
+{
+	define_square(*main);
+	define_square(*math);
+
+	arc::Linker linker(*main);
+	EXPECT_THROW(linker.add(*math).import("square"), arc::LinkError);
+}
+
+TEST_F(LinkerFixture, SignatureMismatchIsRejected)
+{
+	declare_and_call();
+
+	arc::Builder builder(*math);
+	builder.function<arc::DataType::INT32>("square")
+			.param<arc::DataType::INT64>("x")
+			.exported()
+			.body([](arc::Builder &fb, arc::Node *)
+			{
+				return fb.ret(fb.lit(0));
+			});
+
+	arc::Linker linker(*main);
+	EXPECT_THROW(linker.add(*math).resolve(), arc::LinkError);
+}
+
+TEST_F(LinkerFixture, TypedefsAreMergedAndConflictsRejected)
+{
+	arc::TypedData i32;
+	i32.set<std::int32_t, arc::DataType::INT32>(0);
+	const std::vector<arc::TypeContext::Field> fields = {
+		{ math->intern_str("x"), arc::DataType::INT32, i32 },
+		{ math->intern_str("y"), arc::DataType::INT32, i32 }
+	};
+	math->add_t("point", math->types().struct_t(math->intern_str("point"), fields, 4));
+	define_square(*math);
+
+	arc::Linker linker(*main);
+	linker.add(*math).import("square");
+
+	/* the struct is rebuilt in the destination's context with its own strings */
+	ASSERT_TRUE(main->typemap().contains("point"));
+	const arc::TypedData &point = main->at_t("point");
+	const auto &data = point.get<arc::DataType::STRUCT>();
+	EXPECT_TRUE(main->types().owns(data.fields.data()));
+	EXPECT_EQ(main->strtable().get(data.name), "point");
+	EXPECT_EQ(main->strtable().get(std::get<0>(data.fields[1])), "y");
+
+	arc::Module other("other");
+	other.add_t("point", i32);
+	arc::Builder(other).function<arc::DataType::VOID>("unrelated")
+			.exported()
+			.body([](arc::Builder &fb)
+			{
+				return fb.ret();
+			});
+	EXPECT_THROW(linker.add(other).import("unrelated"), arc::LinkError);
+}
+
+TEST_F(LinkerFixture, LinkMergesEverything)
+{
+	declare_and_call();
+	define_square(*math, true);
+
+	arc::Module other("other");
+	arc::Builder(other).function<arc::DataType::INT32>("unused")
+			.exported()
+			.body([](arc::Builder &fb)
+			{
+				return fb.ret(fb.lit(3));
+			});
+
+	arc::Linker linker(*main);
+	linker.add(*math).add(other).link();
+	EXPECT_TRUE(linker.unresolved().empty());
+	EXPECT_NE(main->find_fn("helper"), nullptr);
+	EXPECT_NE(main->find_fn("unused"), nullptr);
+	EXPECT_EQ(main->functions().size(), 4u);
+	EXPECT_TRUE(arc::Verifier(*main).verify().empty());
+}
+
+TEST_F(LinkerFixture, UnresolvedListsMissingDefinitions)
+{
+	declare_and_call();
+
+	arc::Linker linker(*main);
+	EXPECT_EQ(linker.add(*math).resolve(), 0u);
+	EXPECT_EQ(linker.unresolved(), std::vector<std::string>{ "square" });
+}
+
+TEST_F(LinkerFixture, DeclareIfLeavesCalleesBehind)
+{
+	define_square(*math, true);
+	arc::Node *helper = math->find_fn("helper");
+
+	arc::Linker linker(*main);
+	linker.add(*math).declare_if([&](const arc::Node *fn) { return fn == helper; });
+	linker.import("square");
+	EXPECT_EQ(linker.unresolved(), std::vector<std::string>{ "helper" });
+	EXPECT_EQ(body_of(*main, "helper")->nodes().size(), 2u); /* ENTRY and the parameter */
+
+	/* importing it explicitly fills in the declaration */
+	EXPECT_EQ(linker.import(helper), main->find_fn("helper"));
+	EXPECT_TRUE(linker.unresolved().empty());
+	EXPECT_TRUE(arc::Verifier(*main).verify().empty());
+}
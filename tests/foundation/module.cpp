@@ -1,7 +1,10 @@
 /* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
 
+#include <algorithm>
+#include <arc/foundation/builder.hpp>
 #include <arc/foundation/module.hpp>
 #include <arc/foundation/region.hpp>
+#include <arc/support/algorithm.hpp>
 #include <gtest/gtest.h>
 
 class ModuleFixture : public ::testing::Test
@@ -76,3 +79,157 @@ TEST_F(ModuleFixture, RegionCreation)
 	EXPECT_EQ(region1->parent(), module->root());
 	EXPECT_EQ(region2->parent(), module->root());
 }
+
+TEST_F(ModuleFixture, FunctionBodiesAreFoundByName)
+{
+	arc::Builder builder(*module);
+	arc::Node *f = builder.function<arc::DataType::INT32>("f")
+			.body([&](arc::Builder &fb)
+			{
+				return fb.ret(fb.lit(1));
+			});
+
+	arc::Region *body = module->body(f);
+	ASSERT_NE(body, nullptr);
+	EXPECT_EQ(body->name(), "f");
+	EXPECT_EQ(body->parent(), module->root());
+	EXPECT_EQ(module->bodies().at("f"), body);
+	EXPECT_EQ(module->body(nullptr), nullptr);
+
+	/* nested regions come after their parent */
+	arc::Region *inner = module->create_region("inner", body);
+	const std::vector<arc::Region *> regions = body->dominated_regions();
+	ASSERT_EQ(regions.size(), 2u);
+	EXPECT_EQ(regions[0], body);
+	EXPECT_EQ(regions[1], inner);
+}
+
+TEST_F(ModuleFixture, JournalRecordsChangesAfterCheckpoint)
+{
+	arc::Node *lhs = nullptr;
+	arc::Node *rhs = nullptr;
+	arc::Node *sum = nullptr;
+	arc::Builder builder(*module);
+	builder.function<arc::DataType::INT32>("f")
+			.body([&](arc::Builder &fb)
+			{
+				lhs = fb.lit(1);
+				rhs = fb.lit(2);
+				sum = fb.add(lhs, lhs);
+				return fb.ret(sum);
+			});
+	arc::Region *body = sum->parent;
+
+	const std::uint64_t epoch = module->checkpoint();
+	EXPECT_TRUE(module->changes_since(epoch).complete);
+	EXPECT_TRUE(module->changes_since(epoch).nodes.empty());
+
+	arc::update_connection(sum, lhs, rhs);
+	const arc::ChangeSet changes = module->changes_since(epoch);
+	ASSERT_TRUE(changes.complete);
+	EXPECT_TRUE(changes.regions.empty());
+	for (const arc::Node *node: { sum, lhs, rhs })
+		EXPECT_EQ(std::ranges::count(changes.nodes, node), 1);
+	EXPECT_GT(body->modified(), epoch);
+
+	/* a newer epoch sees nothing until the next change */
+	const std::uint64_t later = module->checkpoint();
+	EXPECT_TRUE(module->changes_since(later).nodes.empty());
+	module->touch(body);
+	EXPECT_EQ(module->changes_since(later).regions, std::vector<arc::Region *>{ body });
+	EXPECT_EQ(module->changes_since(epoch).nodes.size(), 3u);
+}
+
+TEST_F(ModuleFixture, JournalDoesNotCoverForeignEpochs)
+{
+	/* epochs from before this module existed cannot be answered */
+	const auto older = std::make_unique<arc::Module>("older");
+	const std::uint64_t foreign = older->checkpoint();
+	const auto fresh = std::make_unique<arc::Module>("fresh");
+	EXPECT_FALSE(fresh->changes_since(foreign).complete);
+	EXPECT_TRUE(fresh->changes_since(fresh->checkpoint()).complete);
+}
+
+TEST_F(ModuleFixture, ForgottenNodesLeaveTheJournal)
+{
+	arc::Node *value = nullptr;
+	arc::Builder builder(*module);
+	builder.function<arc::DataType::INT32>("f")
+			.body([&](arc::Builder &fb)
+			{
+				value = fb.lit(1);
+				return fb.ret(value);
+			});
+
+	const std::uint64_t epoch = module->checkpoint();
+	arc::Region *body = value->parent;
+	body->remove(value);
+	EXPECT_EQ(module->changes_since(epoch).nodes, std::vector<arc::Node *>{ value });
+
+	module->forget({ value });
+	EXPECT_TRUE(module->changes_since(epoch).nodes.empty());
+}
+
+TEST_F(ModuleFixture, RetiredNodesAreRecycled)
+{
+	arc::Node *lhs = nullptr;
+	arc::Node *rhs = nullptr;
+	arc::Node *sum = nullptr;
+	arc::Builder builder(*module);
+	builder.function<arc::DataType::INT32>("f")
+			.body([&](arc::Builder &fb)
+			{
+				lhs = fb.lit(1);
+				rhs = fb.lit(2);
+				sum = fb.add(lhs, rhs);
+				return fb.ret(rhs);
+			});
+
+	sum->parent->remove(sum);
+	module->retire(sum);
+	module->retire(sum);
+	EXPECT_EQ(module->reclaim(), 1u);
+	EXPECT_TRUE(lhs->users.empty());
+	EXPECT_EQ(rhs->users.size(), 1u);
+
+	arc::Node *reused = module->create_node(arc::NodeType::LIT, arc::DataType::INT64);
+	EXPECT_EQ(reused, sum);
+	EXPECT_TRUE(reused->inputs.empty());
+	EXPECT_EQ(reused->parent, nullptr);
+	EXPECT_EQ(reused->type_kind, arc::DataType::INT64);
+	EXPECT_EQ(module->reclaim(), 0u);
+}
+
+TEST_F(ModuleFixture, RetiredNodesWaitForTheirUsers)
+{
+	arc::Node *value = nullptr;
+	arc::Node *sum = nullptr;
+	arc::Node *kept = nullptr;
+	arc::Builder builder(*module);
+	builder.function<arc::DataType::INT32>("f")
+			.body([&](arc::Builder &fb)
+			{
+				value = fb.lit(1);
+				sum = fb.add(value, value);
+				kept = fb.lit(2);
+				return fb.ret(kept);
+			});
+	arc::Region *body = sum->parent;
+
+	/* still used by a placed node */
+	body->remove(value);
+	module->retire(value);
+	EXPECT_EQ(module->reclaim(), 0u);
+
+	/* placed again after being retired */
+	body->remove(kept);
+	module->retire(kept);
+	body->append(kept);
+	EXPECT_EQ(module->reclaim(), 0u);
+	EXPECT_EQ(kept->parent, body);
+
+	/* freeing the user frees what only it used */
+	body->remove(sum);
+	module->retire(sum);
+	EXPECT_EQ(module->reclaim(), 2u);
+}
@@ -0,0 +1,156 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <arc/foundation/builder.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/partition.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/foundation/verifier.hpp>
+#include <arc/support/generator.hpp>
+#include <gtest/gtest.h>
+
+class PartitionFixture : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		module = std::make_unique<arc::Module>("program");
+		builder = std::make_unique<arc::Builder>(*module);
+	}
+
+	/* `<prefix>0` is private; every later function calls the previous one twice */
+	std::vector<arc::Node *> chain(const std::string &prefix, const std::size_t length)
+	{
+		std::vector<arc::Node *> fns;
+		for (std::size_t i = 0; i < length; ++i)
+		{
+			arc::Node *callee = fns.empty() ? nullptr : fns.back();
+			fns.push_back(builder->function<arc::DataType::INT32>(prefix + std::to_string(i))
+					.param<arc::DataType::INT32>("x")
+					.body([&](arc::Builder &fb, arc::Node *x)
+					{
+						if (!callee)
+							return fb.ret(fb.add(x, fb.lit(1)));
+						return fb.ret(fb.add(fb.call(callee, { x }), fb.call(callee, { x })));
+					}));
+		}
+		return fns;
+	}
+
+	static bool has(const arc::Node *fn, const arc::NodeTraits trait)
+	{
+		return (fn->traits & trait) != arc::NodeTraits::NONE;
+	}
+
+	std::unique_ptr<arc::Module> module;
+	std::unique_ptr<arc::Builder> builder;
+};
+
+TEST_F(PartitionFixture, KeepsCallClustersTogether)
+{
+	const std::vector<arc::Node *> a = chain("a", 4);
+	const std::vector<arc::Node *> b = chain("b", 4);
+
+	const arc::Partitioner partitioner(*module, { .partitions = 2 });
+	ASSERT_EQ(partitioner.partitions().size(), 2u);
+	EXPECT_EQ(partitioner.cut_weight(), 0.0);
+
+	for (const arc::Node *fn: a)
+		EXPECT_EQ(partitioner.partition_of(fn), partitioner.partition_of(a.front()));
+	for (const arc::Node *fn: b)
+		EXPECT_EQ(partitioner.partition_of(fn), partitioner.partition_of(b.front()));
+	EXPECT_NE(partitioner.partition_of(a.front()), partitioner.partition_of(b.front()));
+}
+
+TEST_F(PartitionFixture, SplitDeclaresCalleesOfOtherPartitions)
+{
+	const std::vector<arc::Node *> fns = chain("f", 4);
+
+	/* four equally sized functions in four partitions must cut every call */
+	const arc::Partitioner partitioner(*module, { .partitions = 4, .imbalance = 1.0f });
+	ASSERT_EQ(partitioner.partitions().size(), 4u);
+	EXPECT_EQ(partitioner.cut_weight(), 6.0);
+
+	const std::vector<std::unique_ptr<arc::Module> > parts = partitioner.split();
+	ASSERT_EQ(parts.size(), 4u);
+	for (const std::unique_ptr<arc::Module> &part: parts)
+		EXPECT_TRUE(arc::Verifier(*part).verify().empty()) << part->name();
+
+	const arc::Module &first = *parts[partitioner.partition_of(fns[0])];
+	const arc::Module &second = *parts[partitioner.partition_of(fns[1])];
+	const auto find = [](const arc::Module &part, const std::string_view name) -> const arc::Node *
+	{
+		for (const arc::Node *fn: part.functions())
+		{
+			if (const_cast<arc::Module &>(part).strtable().get(fn->str_id) == name)
+				return fn;
+		}
+		return nullptr;
+	};
+
+	/* f0 is private, but f1 calls it from another partition */
+	ASSERT_NE(find(first, "f0"), nullptr);
+	EXPECT_TRUE(has(find(first, "f0"), arc::NodeTraits::EXPORT));
+	ASSERT_NE(find(second, "f0"), nullptr);
+	EXPECT_TRUE(has(find(second, "f0"), arc::NodeTraits::EXTERN));
+	EXPECT_EQ(find(first, "f1"), nullptr);
+}
+
+TEST_F(PartitionFixture, MergeRestoresTheOriginalSymbols)
+{
+	chain("f", 4);
+	const arc::Partitioner partitioner(*module, { .partitions = 4, .imbalance = 1.0f });
+
+	std::vector<std::unique_ptr<arc::Module> > parts = partitioner.split();
+	const std::unique_ptr<arc::Module> merged = partitioner.merge(parts);
+	EXPECT_EQ(merged->name(), "program");
+	ASSERT_EQ(merged->functions().size(), module->functions().size());
+	for (const arc::Node *fn: merged->functions())
+	{
+		EXPECT_FALSE(has(fn, arc::NodeTraits::EXTERN));
+		EXPECT_FALSE(has(fn, arc::NodeTraits::EXPORT));
+	}
+	EXPECT_TRUE(arc::Verifier(*merged).verify().empty());
+}
+
+TEST_F(PartitionFixture, RunsThePipelineOnEveryPartition)
+{
+	chain("a", 3);
+	chain("b", 3);
+	chain("c", 3);
+
+	const arc::Partitioner partitioner(*module, { .partitions = 3 });
+	std::atomic<std::size_t> runs = 0;
+	const std::unique_ptr<arc::Module> merged = partitioner.run([&](arc::Module &part)
+	{
+		++runs;
+		EXPECT_NE(part.name().find(".part"), std::string_view::npos);
+	});
+	EXPECT_EQ(runs, 3u);
+	EXPECT_EQ(merged->functions().size(), 9u);
+
+	EXPECT_THROW((void)partitioner.run([](arc::Module &) { throw std::runtime_error("pipeline failed"); }),
+	             std::runtime_error);
+}
+
+TEST_F(PartitionFixture, GeneratedModuleStaysBalanced)
+{
+	const std::unique_ptr<arc::Module> generated = arc::generate({ .seed = 7, .nodes = 8192 });
+	const arc::Partitioner partitioner(*generated, { .partitions = 4, .imbalance = 1.5f });
+
+	std::size_t assigned = 0;
+	for (const std::vector<arc::Node *> &part: partitioner.partitions())
+		assigned += part.size();
+	EXPECT_EQ(assigned, generated->functions().size());
+	EXPECT_LE(partitioner.partitions().size(), 4u);
+
+	std::vector<std::unique_ptr<arc::Module> > parts = partitioner.split();
+	const std::unique_ptr<arc::Module> merged = partitioner.merge(parts);
+	EXPECT_EQ(merged->functions().size(), generated->functions().size());
+	EXPECT_TRUE(arc::Verifier(*merged).verify().empty());
+}
@@ -21,11 +21,15 @@ protected:
 	std::unique_ptr<arc::Module> module;
 	std::unique_ptr<arc::PassManager> pm;
 	static inline std::vector<std::string> execution_order;
+	static inline arc::Node *retired = nullptr;
+	static inline arc::Node *created = nullptr;
 
 	friend class MockAnalysisPass;
 	friend class DependentAnalysisPass;
 	friend class MockTransformPass;
 	friend class SimpleTransformPass;
+	friend class RetireTransformPass;
+	friend class CreateTransformPass;
 };
 
 class MockAnalysisResult final : public arc::Analysis
@@ -143,6 +147,48 @@ public:
 	}
 };
 
+/* removes the last node of the first function and hands it back to the module */
+class RetireTransformPass final : public arc::TransformPass
+{
+public:
+	[[nodiscard]] std::string name() const override
+	{
+		return "retire-transform";
+	}
+
+	std::vector<arc::Region *> run(arc::Module &module, arc::PassManager &) override
+	{
+		PassManagerFixture::execution_order.push_back(name());
+
+		arc::Region *region = module.root()->children()[0];
+		arc::Node *node = region->nodes().back();
+		region->remove(node);
+		module.retire(node);
+		PassManagerFixture::retired = node;
+		return { region };
+	}
+};
+
+/* appends a new node to the first function */
+class CreateTransformPass final : public arc::TransformPass
+{
+public:
+	[[nodiscard]] std::string name() const override
+	{
+		return "create-transform";
+	}
+
+	std::vector<arc::Region *> run(arc::Module &module, arc::PassManager &) override
+	{
+		PassManagerFixture::execution_order.push_back(name());
+
+		arc::Region *region = module.root()->children()[0];
+		PassManagerFixture::created = module.create_node(arc::NodeType::LIT, arc::DataType::INT32);
+		region->append(PassManagerFixture::created);
+		return { region };
+	}
+};
+
 TEST_F(PassManagerFixture, BasicPassExecution)
 {
 	pm->add<MockAnalysisPass>()
@@ -282,6 +328,24 @@ TEST_F(PassManagerFixture, ParallelExecutionPolicy)
 	EXPECT_EQ(execution_order.size(), 2);
 }
 
+TEST_F(PassManagerFixture, DeterministicPolicyRunsTransformsInBatchOrder)
+{
+	auto tasks = arc::TaskGraph()
+			.add<SimpleTransformPass>()
+			.add<MockAnalysisPass>()
+			.add<DependentAnalysisPass>()
+			.add<MockTransformPass>();
+
+	auto deterministic_pm = tasks.build(arc::ExecutionPolicy::DETERMINISTIC);
+	deterministic_pm.run(*module);
+
+	/* within a batch the analysis goes first, then the transforms take turns */
+	const std::vector<std::string> expected = {
+		"mock-analysis", "simple-transform", "dependent-analysis", "mock-transform"
+	};
+	EXPECT_EQ(execution_order, expected);
+}
+
 TEST_F(PassManagerFixture, TaskGraphCycleDetection)
 {
 	class CyclicPass : public arc::AnalysisPass
@@ -400,3 +464,40 @@ TEST_F(PassManagerFixture, MixedExecutionModes)
 	task_pm.run(*module);
 	EXPECT_GT(execution_order.size(), 0);
 }
+
+TEST_F(PassManagerFixture, RetiredNodesWaitForCachedAnalyses)
+{
+	arc::Region *region = module->create_region("f");
+	region->append(module->create_node(arc::NodeType::LIT, arc::DataType::INT32));
+
+	/* the analysis was cached across the removal and may still be keyed by
+	 * the retired node, so its address is not handed out again */
+	pm->add<MockAnalysisPass>()
+			.add<RetireTransformPass>()
+			.add<CreateTransformPass>();
+	pm->run(*module);
+
+	const std::vector<std::string> expected = {
+		"mock-analysis", "retire-transform", "create-transform"
+	};
+	EXPECT_EQ(execution_order, expected);
+	EXPECT_NE(created, retired);
+}
+
+TEST_F(PassManagerFixture, RetiredNodesAreRecycledWithoutCachedAnalyses)
+{
+	arc::Region *region = module->create_region("f");
+	region->append(module->create_node(arc::NodeType::LIT, arc::DataType::INT32));
+
+	/* computed after the removal, the analysis cannot refer to the retired node */
+	pm->add<RetireTransformPass>()
+			.add<MockAnalysisPass>()
+			.add<CreateTransformPass>();
+	pm->run(*module);
+
+	const std::vector<std::string> expected = {
+		"retire-transform", "mock-analysis", "create-transform"
+	};
+	EXPECT_EQ(execution_order, expected);
+	EXPECT_EQ(created, retired);
+}
@@ -0,0 +1,205 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <arc/foundation/builder.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/pass-manager.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/foundation/snapshot.hpp>
+#include <arc/foundation/verifier.hpp>
+#include <arc/support/output-buffer.hpp>
+#include <arc/support/printer.hpp>
+#include <arc/transform/constfold.hpp>
+#include <arc/transform/dce.hpp>
+#include <gtest/gtest.h>
+
+namespace
+{
+	std::string print(arc::Module &module)
+	{
+		arc::OutputBuffer out;
+		arc::Printer(module).print(out);
+		return out.str();
+	}
+
+	std::size_t count_nodes(const arc::Module &module)
+	{
+		std::size_t count = 0;
+		for (const arc::Region *region: module.root()->children())
+		{
+			std::vector<const arc::Region *> worklist = { region };
+			while (!worklist.empty())
+			{
+				const arc::Region *current = worklist.back();
+				worklist.pop_back();
+				count += current->nodes().size();
+				worklist.insert(worklist.end(), current->children().begin(), current->children().end());
+			}
+		}
+		return count;
+	}
+
+	std::string print_body(arc::Module &module, const std::string &name)
+	{
+		arc::OutputBuffer out;
+		for (arc::Region *region: module.root()->children())
+		{
+			if (region->name() == name)
+				arc::Printer(module).print(*region, out);
+		}
+		return out.str();
+	}
+
+	bool is_extern(const arc::Node *fn)
+	{
+		return (fn->traits & arc::NodeTraits::EXTERN) != arc::NodeTraits::NONE;
+	}
+}
+
+class SnapshotFixture : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		std::unique_ptr<arc::Module> module = build();
+		base = module.get();
+		original = print(*module);
+		snapshot = std::make_unique<arc::ModuleSnapshot>(std::move(module));
+	}
+
+	static std::unique_ptr<arc::Module> build()
+	{
+		auto module = std::make_unique<arc::Module>("program");
+		arc::Builder builder(*module);
+
+		/* f0(x) = x + 2 * 3, and every f<i>(x) = f<i-1>(x) + 2 * 3 */
+		arc::Node *callee = nullptr;
+		for (std::size_t i = 0; i < functions; ++i)
+		{
+			callee = builder.function<arc::DataType::INT32>("f" + std::to_string(i))
+					.param<arc::DataType::INT32>("x")
+					.body([&](arc::Builder &fb, arc::Node *x)
+					{
+						arc::Node *base = callee ? fb.call(callee, { x }) : x;
+						return fb.ret(fb.add(base, fb.mul(fb.lit(2), fb.lit(3))));
+					});
+		}
+		return module;
+	}
+
+	static constexpr std::size_t functions = 8;
+	arc::Module *base = nullptr;
+	std::string original;
+	std::unique_ptr<arc::ModuleSnapshot> snapshot;
+};
+
+TEST_F(SnapshotFixture, ForkSharesEveryFunction)
+{
+	const std::unique_ptr<arc::ModuleVariant> variant = snapshot->fork();
+	arc::Module &module = variant->module();
+
+	ASSERT_EQ(module.functions().size(), functions);
+	EXPECT_EQ(variant->shared_count(), functions);
+	for (const arc::Node *fn: module.functions())
+	{
+		EXPECT_TRUE(variant->shared(fn));
+		EXPECT_TRUE(is_extern(fn));
+	}
+	EXPECT_LT(count_nodes(module) * 2, count_nodes(*base));
+}
+
+TEST_F(SnapshotFixture, MaterializedVariantMatchesTheSnapshot)
+{
+	const std::unique_ptr<arc::ModuleVariant> variant = snapshot->fork();
+	EXPECT_EQ(variant->materialize_all(), functions);
+	EXPECT_EQ(variant->shared_count(), 0u);
+	EXPECT_EQ(print(variant->module()), original);
+	EXPECT_TRUE(arc::Verifier(variant->module()).verify().empty());
+}
+
+TEST_F(SnapshotFixture, MaterializingKeepsCallersPointingAtTheFunction)
+{
+	const std::unique_ptr<arc::ModuleVariant> variant = snapshot->fork();
+	arc::Node *caller = variant->materialize("f5");
+	arc::Node *callee = variant->module().find_fn("f4");
+	EXPECT_FALSE(variant->shared(caller));
+	EXPECT_TRUE(variant->shared(callee));
+	EXPECT_EQ(variant->shared_count(), functions - 1);
+
+	/* the copied call targets the declaration, which later becomes the definition */
+	ASSERT_EQ(callee->users.size(), 1u);
+	const arc::Node *call = callee->users[0];
+	EXPECT_EQ(&call->parent->module(), &variant->module());
+
+	EXPECT_EQ(variant->materialize("f4"), callee);
+	EXPECT_FALSE(is_extern(callee));
+	EXPECT_EQ(call->inputs[0], callee);
+	EXPECT_TRUE(arc::Verifier(variant->module()).verify().empty());
+
+	EXPECT_THROW(variant->materialize("missing"), std::invalid_argument);
+}
+
+TEST_F(SnapshotFixture, VariantsDoNotSeeEachOthersChanges)
+{
+	const std::unique_ptr<arc::ModuleVariant> folded = snapshot->fork();
+	const std::unique_ptr<arc::ModuleVariant> untouched = snapshot->fork();
+	folded->materialize("f3");
+	untouched->materialize("f3");
+
+	arc::PassManager pm;
+	pm.add<arc::ConstantFoldingPass>();
+	pm.run(folded->module());
+
+	folded->materialize_all();
+	untouched->materialize_all();
+	EXPECT_NE(print(folded->module()), original);
+	EXPECT_EQ(print(untouched->module()), original);
+
+	/* the snapshot itself is never written to */
+	EXPECT_EQ(print(*base), original);
+}
+
+TEST_F(SnapshotFixture, PipelineOnAForkMatchesTheOriginal)
+{
+	const std::unique_ptr<arc::ModuleVariant> variant = snapshot->fork();
+	const std::unique_ptr<arc::Module> module = build();
+
+	for (arc::Module *target: { &variant->module(), module.get() })
+	{
+		arc::PassManager pm;
+		pm.add<arc::ConstantFoldingPass>();
+		pm.add<arc::DeadCodeElimination>();
+		pm.run(*target);
+	}
+
+	/* walking into a shared function copies it out before it is changed */
+	EXPECT_EQ(variant->shared_count(), 0u);
+	EXPECT_EQ(print(variant->module()), print(*module));
+	EXPECT_NE(print(variant->module()), original);
+	EXPECT_TRUE(arc::Verifier(variant->module()).verify().empty());
+	EXPECT_EQ(print(*base), original);
+}
+
+TEST_F(SnapshotFixture, LookingIntoACalleeMaterializesIt)
+{
+	const std::unique_ptr<arc::ModuleVariant> variant = snapshot->fork();
+	arc::Module &module = variant->module();
+	variant->materialize("f5");
+
+	/* what inter-procedural passes do before reading a callee's body */
+	arc::Node *callee = module.find_fn("f4");
+	EXPECT_TRUE(module.load_body(callee));
+	EXPECT_FALSE(variant->shared(callee));
+	EXPECT_FALSE(is_extern(callee));
+	EXPECT_EQ(print_body(module, "f4"), print_body(*base, "f4"));
+
+	/* a definition has nothing to load */
+	EXPECT_FALSE(module.load_body(callee));
+	EXPECT_FALSE(module.load_body(nullptr));
+	EXPECT_EQ(variant->shared_count(), functions - 2);
+	EXPECT_TRUE(arc::Verifier(module).verify().empty());
+}
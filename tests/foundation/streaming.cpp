@@ -0,0 +1,200 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <arc/foundation/builder.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/pass-manager.hpp>
+#include <arc/foundation/streaming.hpp>
+#include <arc/foundation/verifier.hpp>
+#include <arc/transform/constfold.hpp>
+#include <gtest/gtest.h>
+
+namespace
+{
+	std::atomic<std::size_t> function_runs = 0;
+	std::atomic<std::size_t> module_runs = 0;
+
+	class CountingPass final : public arc::TransformPass
+	{
+	public:
+		explicit CountingPass(std::atomic<std::size_t> *counter = nullptr) : counter(counter) {}
+
+		[[nodiscard]] std::string name() const override
+		{
+			return "counting";
+		}
+
+		std::vector<arc::Region *> run(arc::Module &, arc::PassManager &) override
+		{
+			++*counter;
+			return {};
+		}
+
+	private:
+		std::atomic<std::size_t> *counter;
+	};
+}
+
+class StreamingFixture : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		module = std::make_unique<arc::Module>("program");
+		function_runs = 0;
+		module_runs = 0;
+	}
+
+	/* `f<i>(x)` returns `f<i-1>(x) + 2 * 3`, declaring its callee the way a front end would */
+	static void build(arc::Module &unit, const std::size_t i)
+	{
+		arc::Builder builder(unit);
+		arc::Node *callee = nullptr;
+		if (i > 0)
+		{
+			callee = builder.function<arc::DataType::INT32>("f" + std::to_string(i - 1))
+					.param<arc::DataType::INT32>("x")
+					.imported()
+					.body([](arc::Builder &fb, arc::Node *)
+					{
+						return fb.ret(fb.lit(0));
+					});
+		}
+
+		builder.function<arc::DataType::INT32>("f" + std::to_string(i))
+				.param<arc::DataType::INT32>("x")
+				.body([&](arc::Builder &fb, arc::Node *x)
+				{
+					arc::Node *base = callee ? fb.call(callee, { x }) : x;
+					return fb.ret(fb.add(base, fb.mul(fb.lit(2), fb.lit(3))));
+				});
+	}
+
+	void stream(arc::StreamingCompiler &compiler, const std::size_t count) const
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			std::unique_ptr<arc::Module> unit = compiler.unit("f" + std::to_string(i));
+			build(*unit, i);
+			compiler.submit(std::move(unit));
+		}
+	}
+
+	static bool has(const arc::Node *fn, const arc::NodeTraits trait)
+	{
+		return (fn->traits & trait) != arc::NodeTraits::NONE;
+	}
+
+	std::unique_ptr<arc::Module> module;
+};
+
+TEST_F(StreamingFixture, LinksOptimizedFunctionsInSubmissionOrder)
+{
+	arc::StreamingCompiler compiler(*module, { .workers = 4 });
+	compiler.function_passes([](arc::PassManager &pm)
+			{
+				pm.add<arc::ConstantFoldingPass>();
+				pm.add<CountingPass>(&function_runs);
+			})
+			.module_passes([](arc::PassManager &pm)
+			{
+				pm.add<CountingPass>(&module_runs);
+			});
+
+	stream(compiler, 16);
+	compiler.finish();
+	EXPECT_EQ(compiler.submitted(), 16u);
+	EXPECT_EQ(function_runs, 16u);
+	EXPECT_EQ(module_runs, 1u);
+
+	ASSERT_EQ(module->functions().size(), 16u);
+	for (std::size_t i = 0; i < 16; ++i)
+	{
+		const arc::Node *fn = module->functions()[i];
+		EXPECT_EQ(module->strtable().get(fn->str_id), "f" + std::to_string(i));
+		EXPECT_FALSE(has(fn, arc::NodeTraits::EXTERN));
+		EXPECT_FALSE(has(fn, arc::NodeTraits::EXPORT));
+	}
+	EXPECT_TRUE(arc::Verifier(*module).verify().empty());
+}
+
+TEST_F(StreamingFixture, CallsIntoLaterUnitsAreResolved)
+{
+	arc::StreamingCompiler compiler(*module, { .workers = 2 });
+
+	/* the caller arrives before its callee */
+	std::unique_ptr<arc::Module> caller = compiler.unit("f1");
+	build(*caller, 1);
+	compiler.submit(std::move(caller));
+
+	std::unique_ptr<arc::Module> callee = compiler.unit("f0");
+	build(*callee, 0);
+	compiler.submit(std::move(callee));
+	compiler.finish();
+
+	ASSERT_EQ(module->functions().size(), 2u);
+	for (const arc::Node *fn: module->functions())
+		EXPECT_FALSE(has(fn, arc::NodeTraits::EXTERN));
+	EXPECT_TRUE(arc::Verifier(*module).verify().empty());
+}
+
+TEST_F(StreamingFixture, QueueDepthBoundsUnitsInFlight)
+{
+	std::atomic<std::size_t> busy = 0;
+	std::atomic<std::size_t> peak = 0;
+
+	arc::StreamingCompiler compiler(*module, { .workers = 4, .queue_depth = 2 });
+	compiler.sink([&](arc::Module &)
+	{
+		const std::size_t now = ++busy;
+		std::size_t seen = peak;
+		while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		--busy;
+	});
+
+	stream(compiler, 24);
+	compiler.finish();
+	EXPECT_LE(peak, 2u);
+	EXPECT_EQ(module->functions().size(), 24u);
+}
+
+TEST_F(StreamingFixture, UnitsAreDroppedWithoutRetain)
+{
+	std::atomic<std::size_t> sunk = 0;
+	arc::StreamingCompiler compiler(*module, { .workers = 2, .retain = false });
+	compiler.sink([&](arc::Module &unit)
+	{
+		EXPECT_FALSE(unit.functions().empty());
+		++sunk;
+	});
+
+	stream(compiler, 8);
+	compiler.finish();
+	EXPECT_EQ(sunk, 8u);
+	EXPECT_TRUE(module->functions().empty());
+}
+
+TEST_F(StreamingFixture, ErrorsSurfaceFromFinish)
+{
+	arc::StreamingCompiler compiler(*module, { .workers = 2 });
+	compiler.sink([](arc::Module &unit)
+	{
+		if (unit.name() == "f3")
+			throw std::runtime_error("codegen failed");
+	});
+
+	stream(compiler, 6);
+	EXPECT_THROW(compiler.finish(), std::runtime_error);
+	EXPECT_THROW(compiler.submit(compiler.unit("late")), std::logic_error);
+
+	/* the failed unit is skipped; everything else still arrives */
+	EXPECT_EQ(module->functions().size(), 6u);
+	EXPECT_TRUE(has(module->find_fn("f3"), arc::NodeTraits::EXTERN));
+}
@@ -0,0 +1,183 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <arc/foundation/builder.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/foundation/transaction.hpp>
+#include <arc/foundation/verifier.hpp>
+#include <arc/transform/inliner.hpp>
+#include <gtest/gtest.h>
+
+class TransactionFixture : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		module = std::make_unique<arc::Module>("test");
+		arc::Builder builder(*module);
+		builder.function<arc::DataType::INT32>("f")
+				.param<arc::DataType::INT32>("x")
+				.body([&](arc::Builder &fb, arc::Node *x)
+				{
+					lhs = fb.lit(2);
+					rhs = fb.lit(3);
+					sum = fb.add(lhs, x);
+					product = fb.mul(sum, rhs);
+					return fb.ret(product);
+				});
+		body = sum->parent;
+	}
+
+	/* everything rollback has to put back: order, edges and fields */
+	struct Snapshot
+	{
+		std::vector<arc::Node *> nodes;
+		std::vector<std::vector<arc::Node *> > inputs;
+		std::vector<std::vector<arc::Node *> > users;
+		std::vector<arc::NodeTraits> traits;
+		std::vector<arc::DataType> types;
+
+		bool operator==(const Snapshot &) const = default;
+	};
+
+	static arc::TypedData int32(const std::int32_t v)
+	{
+		arc::TypedData data;
+		data.set<std::int32_t, arc::DataType::INT32>(v);
+		return data;
+	}
+
+	[[nodiscard]] Snapshot snapshot() const
+	{
+		Snapshot s;
+		s.nodes = body->nodes();
+		for (const arc::Node *node: s.nodes)
+		{
+			s.inputs.emplace_back(node->inputs.begin(), node->inputs.end());
+			s.users.emplace_back(node->users.begin(), node->users.end());
+			s.traits.push_back(node->traits);
+			s.types.push_back(node->type_kind);
+		}
+		return s;
+	}
+
+	std::unique_ptr<arc::Module> module;
+	arc::Region *body = nullptr;
+	arc::Node *lhs = nullptr;
+	arc::Node *rhs = nullptr;
+	arc::Node *sum = nullptr;
+	arc::Node *product = nullptr;
+};
+
+TEST_F(TransactionFixture, RollbackRestoresGraph)
+{
+	const Snapshot before = snapshot();
+	{
+		arc::Transaction tx;
+		arc::Node *folded = tx.clone(rhs);
+		tx.set_value(folded, int32(7));
+		tx.insert_before(product, folded);
+		EXPECT_EQ(tx.replace_all_uses(rhs, folded), 1u);
+		tx.erase(rhs);
+		tx.insert_after(product, lhs);
+		tx.set_traits(sum, arc::NodeTraits::DRIVER);
+		tx.set_type(product, arc::DataType::INT64);
+
+		EXPECT_EQ(product->inputs[1], folded);
+		EXPECT_EQ(std::ranges::find(body->nodes(), rhs), body->nodes().end());
+		EXPECT_FALSE(tx.empty());
+
+		tx.rollback();
+		EXPECT_TRUE(tx.empty());
+	}
+
+	EXPECT_EQ(snapshot(), before);
+	EXPECT_EQ(product->inputs[1], rhs);
+	EXPECT_TRUE(arc::Verifier(*module).verify().empty());
+}
+
+TEST_F(TransactionFixture, PartialRollbackKeepsEarlierEdits)
+{
+	arc::Transaction tx;
+	tx.set_input(product, 1, lhs);
+	const Snapshot kept = snapshot();
+
+	const std::size_t mark = tx.mark();
+	tx.connect(sum, rhs);
+	tx.remove(lhs);
+	tx.set_value(lhs, int32(9));
+	EXPECT_GT(tx.size(), mark);
+
+	tx.rollback(mark);
+	EXPECT_EQ(tx.size(), mark);
+	EXPECT_EQ(snapshot(), kept);
+	EXPECT_EQ(lhs->value.get<arc::DataType::INT32>(), 2);
+	EXPECT_EQ(product->inputs[1], lhs);
+	tx.commit();
+}
+
+TEST_F(TransactionFixture, CommitKeepsEdits)
+{
+	{
+		arc::Transaction tx;
+		tx.replace_all_uses(rhs, lhs);
+		tx.erase(rhs);
+		tx.commit();
+		EXPECT_TRUE(tx.empty());
+	}
+
+	EXPECT_EQ(product->inputs[1], lhs);
+	EXPECT_TRUE(rhs->users.empty());
+	EXPECT_EQ(std::ranges::find(body->nodes(), rhs), body->nodes().end());
+	EXPECT_EQ(std::ranges::count(lhs->users, product), 1);
+}
+
+TEST_F(TransactionFixture, DestructorRollsBack)
+{
+	const Snapshot before = snapshot();
+	{
+		arc::Transaction tx;
+		arc::Node *extra = tx.create(arc::NodeType::LIT, arc::DataType::INT32);
+		tx.append(body, extra);
+		tx.connect(product, extra);
+		tx.remove(sum);
+	}
+	EXPECT_EQ(snapshot(), before);
+}
+
+TEST_F(TransactionFixture, SpeculativeInlineRollsBack)
+{
+	arc::Builder builder(*module);
+	arc::Node *callee = module->functions().front();
+	arc::Node *call_site = nullptr;
+	builder.function<arc::DataType::INT32>("main")
+			.body([&](arc::Builder &fb)
+			{
+				call_site = fb.call(callee, { fb.lit(4) });
+				return fb.ret(call_site);
+			});
+
+	arc::Region *caller = call_site->parent;
+	const std::vector<arc::Node *> nodes = caller->nodes();
+	const std::vector<arc::Node *> call_users(call_site->users.begin(), call_site->users.end());
+
+	arc::Inliner inliner;
+	arc::Transaction tx;
+	const auto result = inliner.inline_call(call_site, callee, *module, nullptr, nullptr, &tx);
+	ASSERT_TRUE(result.success);
+	EXPECT_EQ(std::ranges::find(caller->nodes(), call_site), caller->nodes().end());
+	EXPECT_GT(caller->nodes().size(), nodes.size() - 1);
+
+	tx.rollback();
+	EXPECT_EQ(caller->nodes(), nodes);
+	EXPECT_EQ(std::vector<arc::Node *>(call_site->users.begin(), call_site->users.end()), call_users);
+	EXPECT_TRUE(arc::Verifier(*module).verify().empty());
+
+	/* the same call still inlines for real afterwards */
+	EXPECT_TRUE(inliner.inline_call(call_site, callee, *module).success);
+	EXPECT_TRUE(arc::Verifier(*module).verify().empty());
+}
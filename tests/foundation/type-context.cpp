@@ -0,0 +1,178 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <arc/foundation/builder.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/type-context.hpp>
+#include <gtest/gtest.h>
+
+class TypeContextFixture : public ::testing::Test
+{
+protected:
+	static arc::TypedData i32(const std::int32_t value = 0)
+	{
+		arc::TypedData data;
+		data.set<std::int32_t, arc::DataType::INT32>(value);
+		return data;
+	}
+
+	arc::TypeContext types;
+};
+
+TEST_F(TypeContextFixture, StructsAreUniqued)
+{
+	const std::vector<arc::TypeContext::Field> fields = {
+		{ 1, arc::DataType::INT32, i32() },
+		{ 2, arc::DataType::INT32, i32() }
+	};
+
+	const arc::TypedData a = types.struct_t(10, fields, 4);
+	const arc::TypedData b = types.struct_t(10, fields, 4);
+	EXPECT_EQ(types.size(), 1);
+
+	/* both view the same canonical storage, not the caller's vector */
+	const auto &sa = a.get<arc::DataType::STRUCT>();
+	const auto &sb = b.get<arc::DataType::STRUCT>();
+	EXPECT_EQ(sa.fields.data(), sb.fields.data());
+	EXPECT_NE(sa.fields.data(), fields.data());
+	EXPECT_TRUE(sa == sb);
+	EXPECT_TRUE(types.same(a, b));
+	EXPECT_EQ(types.intern(a), types.intern(b));
+
+	/* a different name is a different type even with the same fields */
+	const arc::TypedData c = types.struct_t(11, fields, 4);
+	EXPECT_EQ(types.size(), 2);
+	EXPECT_FALSE(types.same(a, c));
+}
+
+TEST_F(TypeContextFixture, StructsIgnoreFieldValues)
+{
+	/* a struct literal holds values in its fields; they are not part of its type */
+	const std::vector<arc::TypeContext::Field> zero = { { 1, arc::DataType::INT32, i32(0) } };
+	const std::vector<arc::TypeContext::Field> seven = { { 1, arc::DataType::INT32, i32(7) } };
+
+	const arc::TypedData a = types.struct_t(10, zero, 4);
+	const arc::TypedData b = types.struct_t(10, seven, 4);
+	EXPECT_TRUE(a.get<arc::DataType::STRUCT>() == b.get<arc::DataType::STRUCT>());
+	EXPECT_EQ(types.size(), 1);
+}
+
+TEST_F(TypeContextFixture, NestedStructsCompareByIdentity)
+{
+	const std::vector<arc::TypeContext::Field> inner_fields = {
+		{ 1, arc::DataType::INT32, i32() }
+	};
+	const arc::TypedData inner = types.struct_t(20, inner_fields, 4);
+
+	const std::vector<arc::TypeContext::Field> outer_fields = {
+		{ 2, arc::DataType::STRUCT, inner },
+		{ 3, arc::DataType::INT32, i32() }
+	};
+	const arc::TypedData outer = types.struct_t(21, outer_fields, 4);
+	EXPECT_EQ(types.struct_t(21, outer_fields, 4).get<arc::DataType::STRUCT>().fields.data(),
+	          outer.get<arc::DataType::STRUCT>().fields.data());
+
+	const auto &nested = std::get<2>(outer.get<arc::DataType::STRUCT>().fields[0]);
+	EXPECT_TRUE(types.same(nested, inner));
+	EXPECT_EQ(types.size(), 2);
+}
+
+TEST_F(TypeContextFixture, ArraysIgnoreElements)
+{
+	arc::TypedData a, b;
+	arc::DataTraits<arc::DataType::ARRAY>::value array = {};
+	array.elem_type = arc::DataType::INT32;
+	array.count = 4;
+	a.set<decltype(array), arc::DataType::ARRAY>(array);
+
+	array.elements = { nullptr, nullptr };
+	b.set<decltype(array), arc::DataType::ARRAY>(array);
+
+	const arc::TypeContext::TypeId id = types.intern(a);
+	EXPECT_NE(id, arc::TypeContext::invalid);
+	EXPECT_EQ(types.intern(b), id);
+	EXPECT_TRUE(types.get(id).get<arc::DataType::ARRAY>().elements.empty());
+
+	array.count = 8;
+	b.set<decltype(array), arc::DataType::ARRAY>(array);
+	EXPECT_NE(types.intern(b), id);
+	EXPECT_EQ(types.find(i32()), arc::TypeContext::invalid);
+	EXPECT_THROW(types.intern(i32()), std::invalid_argument);
+	EXPECT_THROW(std::ignore = types.get(42), std::out_of_range);
+}
+
+TEST_F(TypeContextFixture, ModuleTypedefsAreCanonical)
+{
+	arc::Module module("type_context_test_module");
+	const std::vector<arc::TypeContext::Field> fields = {
+		{ module.intern_str("x"), arc::DataType::INT32, i32() }
+	};
+
+	/* a struct built outside the module is copied into its context */
+	const arc::TypedData foreign = types.struct_t(module.intern_str("point"), fields, 4);
+	const arc::TypedData &point = module.add_t("point", foreign);
+	EXPECT_NE(point.get<arc::DataType::STRUCT>().fields.data(),
+	          foreign.get<arc::DataType::STRUCT>().fields.data());
+	EXPECT_TRUE(module.types().same(point, foreign));
+
+	const arc::TypedData &alias = module.add_t("point_alias", foreign);
+	EXPECT_TRUE(point.get<arc::DataType::STRUCT>() == alias.get<arc::DataType::STRUCT>());
+	EXPECT_EQ(module.types().size(), 1);
+}
+
+TEST_F(TypeContextFixture, ConcurrentInterningAgrees)
+{
+	/* threads of a parallel pass batch intern the same types at once */
+	auto intern_all = [this](std::vector<arc::TypeContext::TypeId> &ids)
+	{
+		for (std::uint32_t count = 1; count <= 64; ++count)
+		{
+			arc::TypedData array;
+			arc::DataTraits<arc::DataType::ARRAY>::value data = {};
+			data.elem_type = arc::DataType::INT32;
+			data.count = count;
+			array.set<decltype(data), arc::DataType::ARRAY>(data);
+			ids.push_back(types.intern(array));
+		}
+	};
+
+	std::vector<std::vector<arc::TypeContext::TypeId> > ids(4);
+	std::vector<std::thread> threads;
+	for (auto &out: ids)
+		threads.emplace_back(intern_all, std::ref(out));
+	for (auto &thread: threads)
+		thread.join();
+
+	EXPECT_EQ(types.size(), 64);
+	for (const auto &out: ids)
+		EXPECT_EQ(out, ids.front());
+}
+
+TEST_F(TypeContextFixture, NodesCarryTypeHandles)
+{
+	arc::Module module("type_context_test_module");
+	arc::Builder builder(module);
+
+	arc::Node *a = nullptr, *b = nullptr, *sum = nullptr, *x = nullptr;
+	arc::Node *fn = builder.function<arc::DataType::INT32>("f")
+		.body([&](arc::Builder &fb)
+		{
+			a = fb.vector_splat(fb.lit(1), 4);
+			b = fb.vector_splat(fb.lit(2), 4);
+			sum = fb.add(a, b);
+			x = fb.lit(3);
+			return fb.ret(x);
+		});
+
+	/* every vector of the same shape refers to one descriptor */
+	ASSERT_NE(a->type_id, arc::TypeContext::invalid);
+	EXPECT_EQ(b->type_id, a->type_id);
+	EXPECT_EQ(sum->type_id, a->type_id);
+	EXPECT_EQ(module.types().get(a->type_id).get<arc::DataType::VECTOR>().lane_count, 4u);
+
+	EXPECT_NE(fn->type_id, arc::TypeContext::invalid);
+	EXPECT_EQ(module.types().get(fn->type_id).type(), arc::DataType::FUNCTION);
+	EXPECT_EQ(x->type_id, arc::TypeContext::invalid);
+}
@@ -1,5 +1,6 @@
 /* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
 
+#include <arc/foundation/type-context.hpp>
 #include <arc/foundation/typed-data.hpp>
 #include <gtest/gtest.h>
 
@@ -11,6 +12,7 @@ protected:
 	void TearDown() override {}
 
 	arc::TypedData data;
+	arc::TypeContext types;
 };
 
 TEST_F(TypedDataFixture, DefaultConstructor)
@@ -93,21 +95,17 @@ TEST_F(TypedDataFixture, SetArrayData)
 
 TEST_F(TypedDataFixture, SetStructData)
 {
-	arc::DataTraits<arc::DataType::STRUCT>::value struct_data;
-
 	arc::TypedData field1_value = {};
 	arc::TypedData field2_value = {};
 	field1_value.set<std::int32_t, arc::DataType::INT32>(42);
 	field2_value.set<float, arc::DataType::FLOAT32>(3.14f);
 
-	struct_data.fields = arc::u8slice<std::tuple<arc::StringTable::StringId, arc::DataType, arc::TypedData> > {
+	const std::vector<arc::TypeContext::Field> fields = {
 		{ 1, arc::DataType::INT32, std::move(field1_value) },
 		{ 2, arc::DataType::FLOAT32, std::move(field2_value) }
 	};
-	struct_data.alignment = 8;
-	struct_data.name = 123;
 
-	data.set<decltype(struct_data), arc::DataType::STRUCT>(std::move(struct_data));
+	data = types.struct_t(123, fields, 8);
 	EXPECT_EQ(data.type(), arc::DataType::STRUCT);
 
 	auto &retrieved = data.get<arc::DataType::STRUCT>();
@@ -127,8 +125,6 @@ TEST_F(TypedDataFixture, SetStructData)
 
 TEST_F(TypedDataFixture, SelfReferenceStruct)
 {
-	arc::DataTraits<arc::DataType::STRUCT>::value node_struct;
-
 	arc::TypedData next_field_type;
 	arc::DataTraits<arc::DataType::POINTER>::value ptr_type = {};
 	ptr_type.pointee = nullptr;
@@ -137,14 +133,12 @@ TEST_F(TypedDataFixture, SelfReferenceStruct)
 
 	arc::TypedData value_field_type;
 
-	node_struct.fields = arc::u8slice<std::tuple<arc::StringTable::StringId, arc::DataType, arc::TypedData> > {
+	const std::vector<arc::TypeContext::Field> fields = {
 		{ 1, arc::DataType::POINTER, std::move(next_field_type) },
 		{ 2, arc::DataType::INT32, std::move(value_field_type) }
 	};
-	node_struct.alignment = 8;
-	node_struct.name = 99;
 
-	data.set<decltype(node_struct), arc::DataType::STRUCT>(std::move(node_struct));
+	data = types.struct_t(99, fields, 8);
 	EXPECT_EQ(data.type(), arc::DataType::STRUCT);
 
 	auto &retrieved = data.get<arc::DataType::STRUCT>();
@@ -171,27 +165,20 @@ TEST_F(TypedDataFixture, NestedStructInstance)
 
     zip_val.set<int, arc::DataType::INT32>(12345);
 
-    arc::DataTraits<arc::DataType::STRUCT>::value addr_struct;
-    addr_struct.fields = arc::u8slice<std::tuple<arc::StringTable::StringId, arc::DataType, arc::TypedData> > {
+    const std::vector<arc::TypeContext::Field> addr_fields = {
        { 10, arc::DataType::POINTER, std::move(street_val) },
        { 11, arc::DataType::INT32, std::move(zip_val) }
     };
-    addr_struct.alignment = 4;
-    addr_struct.name = 50;
 
-    arc::TypedData addr_val, age_val;
-    addr_val.set<decltype(addr_struct), arc::DataType::STRUCT>(std::move(addr_struct));
+    arc::TypedData addr_val = types.struct_t(50, addr_fields, 4), age_val;
     age_val.set<int, arc::DataType::INT32>(30);
 
-    arc::DataTraits<arc::DataType::STRUCT>::value person_struct;
-    person_struct.fields = arc::u8slice<std::tuple<arc::StringTable::StringId, arc::DataType, arc::TypedData> > {
+    const std::vector<arc::TypeContext::Field> person_fields = {
        { 20, arc::DataType::STRUCT, std::move(addr_val) },
        { 21, arc::DataType::INT32, std::move(age_val) }
     };
-    person_struct.alignment = 8;
-    person_struct.name = 60;
 
-    data.set<decltype(person_struct), arc::DataType::STRUCT>(std::move(person_struct));
+    data = types.struct_t(60, person_fields, 8);
     EXPECT_EQ(data.type(), arc::DataType::STRUCT);
 
     auto &person = data.get<arc::DataType::STRUCT>();
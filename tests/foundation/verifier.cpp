@@ -0,0 +1,235 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <memory>
+#include <arc/foundation/builder.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/pass-manager.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/foundation/verifier.hpp>
+#include <gtest/gtest.h>
+
+class VerifierFixture : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		module = std::make_unique<arc::Module>("verifier_test_module");
+		builder = std::make_unique<arc::Builder>(*module);
+	}
+
+	arc::Region *get_region(arc::Region *parent, const std::string &name)
+	{
+		for (arc::Region *child: parent->children())
+		{
+			if (child->name() == name)
+				return child;
+		}
+		return nullptr;
+	}
+
+	/* entry -> (then | done), then -> done */
+	void build_diamond()
+	{
+		builder->function<arc::DataType::INT32>("diamond")
+				.param<arc::DataType::INT32>("x")
+				.body([&](arc::Builder &fb, arc::Node *x)
+				{
+					auto then = fb.block<arc::DataType::VOID>("then");
+					auto done = fb.block<arc::DataType::VOID>("done");
+
+					auto *y = fb.add(x, fb.lit(1));
+					fb.branch(fb.lt(y, fb.lit(10)), then.entry(), done.entry());
+
+					arc::Node *doubled = nullptr;
+					then([&](arc::Builder &tb)
+					{
+						doubled = tb.mul(y, tb.lit(2));
+						return tb.jump(done.entry());
+					});
+
+					done([&](arc::Builder &db)
+					{
+						return db.ret(db.from({ y, doubled }));
+					});
+
+					return nullptr;
+				});
+	}
+
+	static bool mentions(const std::vector<arc::Diagnostic> &diags, const std::string &text)
+	{
+		return std::ranges::any_of(diags, [&](const arc::Diagnostic &d)
+		{
+			return d.message.find(text) != std::string::npos;
+		});
+	}
+
+	std::unique_ptr<arc::Module> module;
+	std::unique_ptr<arc::Builder> builder;
+};
+
+/* removes the terminator of a function body, reporting the body as modified or not */
+class DropReturnPass final : public arc::TransformPass
+{
+public:
+	explicit DropReturnPass(const bool report = true) : report(report) {}
+
+	[[nodiscard]] std::string name() const override
+	{
+		return "drop-return";
+	}
+
+	std::vector<arc::Region *> run(arc::Module &module, arc::PassManager &) override
+	{
+		for (arc::Region *body: module.root()->children())
+		{
+			if (body->name() != "identity")
+				continue;
+
+			arc::Node *ret = body->nodes().back();
+			body->remove(ret);
+			if (report)
+				return { body };
+		}
+		return {};
+	}
+
+private:
+	bool report;
+};
+
+TEST_F(VerifierFixture, WellFormedModule)
+{
+	build_diamond();
+
+	arc::Verifier verifier(*module);
+	const std::vector<arc::Diagnostic> diags = verifier.verify();
+	for (const arc::Diagnostic &d: diags)
+		ADD_FAILURE() << d.message;
+	EXPECT_NO_THROW(verifier.check());
+}
+
+TEST_F(VerifierFixture, BrokenUseListAndTypes)
+{
+	build_diamond();
+
+	arc::Region *body = get_region(module->root(), "diamond");
+	ASSERT_NE(body, nullptr);
+	arc::Node *add = *std::ranges::find_if(body->nodes(), [](const arc::Node *n)
+	{
+		return n->ir_type == arc::NodeType::ADD;
+	});
+	arc::Node *lt = *std::ranges::find_if(body->nodes(), [](const arc::Node *n)
+	{
+		return n->ir_type == arc::NodeType::LT;
+	});
+
+	/* drop the ADD from the users of its literal operand and give the compare a bogus type */
+	arc::Node *one = add->inputs[1];
+	one->users.erase(std::ranges::find(one->users, add));
+	lt->type_kind = arc::DataType::INT32;
+
+	arc::Verifier verifier(*module);
+	const std::vector<arc::Diagnostic> diags = verifier.verify({ body });
+	EXPECT_TRUE(mentions(diags, "input does not list the node as a user"));
+	EXPECT_TRUE(mentions(diags, "comparison does not produce BOOL"));
+	EXPECT_THROW(verifier.check({ body }), arc::VerificationError);
+
+	/* the blocks were not touched and verify cleanly on their own */
+	EXPECT_TRUE(verifier.verify({ get_region(body, "then") }).empty());
+}
+
+TEST_F(VerifierFixture, FromArityAndTermination)
+{
+	build_diamond();
+
+	arc::Region *body = get_region(module->root(), "diamond");
+	arc::Region *done = get_region(body, "done");
+	arc::Region *then = get_region(body, "then");
+	ASSERT_NE(done, nullptr);
+	ASSERT_NE(then, nullptr);
+
+	/* a third incoming value for a region with two predecessors */
+	arc::Node *from = *std::ranges::find_if(done->nodes(), [](const arc::Node *n)
+	{
+		return n->ir_type == arc::NodeType::FROM;
+	});
+	arc::Node *extra = from->inputs[0];
+	from->inputs.push_back(extra);
+	extra->users.push_back(from);
+
+	/* and a block that falls off its end */
+	then->remove(then->nodes().back());
+
+	arc::Verifier verifier(*module);
+	const std::vector<arc::Diagnostic> diags = verifier.verify();
+	/* `then` no longer jumps to `done`, leaving the branch as its only predecessor */
+	EXPECT_TRUE(mentions(diags, "FROM has more inputs (3) than the region has predecessors (1)"));
+	EXPECT_TRUE(mentions(diags, "region 'then': region does not end with a terminator"));
+}
+
+TEST_F(VerifierFixture, PassManagerHook)
+{
+	auto build = [&]
+	{
+		builder->function<arc::DataType::INT32>("identity")
+				.param<arc::DataType::INT32>("x")
+				.body([](arc::Builder &fb, arc::Node *x)
+				{
+					return fb.ret(fb.add(x, fb.lit(1)));
+				});
+	};
+
+	{
+		build();
+		arc::PassManager pm;
+		pm.add<DropReturnPass>().verify(arc::VerifyMode::MODIFIED);
+		try
+		{
+			pm.run(*module);
+			FAIL() << "expected a verification error";
+		}
+		catch (const arc::VerificationError &e)
+		{
+			EXPECT_NE(std::string(e.what()).find("pass 'drop-return'"), std::string::npos);
+			EXPECT_EQ(e.diagnostics().size(), 1);
+		}
+	}
+
+	/* a pass that does not report its changes is only caught by a full check */
+	for (const arc::VerifyMode mode: { arc::VerifyMode::NONE, arc::VerifyMode::MODIFIED, arc::VerifyMode::FULL })
+	{
+		SetUp();
+		build();
+		arc::PassManager pm;
+		pm.add<DropReturnPass>(false).verify(mode);
+		if (mode == arc::VerifyMode::FULL)
+			EXPECT_THROW(pm.run(*module), arc::VerificationError);
+		else
+			EXPECT_NO_THROW(pm.run(*module));
+	}
+}
+
+TEST_F(VerifierFixture, IndexFollowsAddedFunctions)
+{
+	build_diamond();
+
+	/* the body index is built once and kept for later calls */
+	arc::Verifier verifier(*module);
+	EXPECT_TRUE(verifier.verify().empty());
+
+	builder->function<arc::DataType::INT32>("later")
+			.param<arc::DataType::INT32>("x")
+			.body([](arc::Builder &fb, arc::Node *x)
+			{
+				return fb.ret(fb.add(x, fb.lit(1)));
+			});
+	arc::Region *body = get_region(module->root(), "later");
+	ASSERT_NE(body, nullptr);
+	body->remove(body->nodes().back());
+
+	/* a function added since is still known as one */
+	EXPECT_TRUE(mentions(verifier.verify({ body }), "region does not end with a terminator"));
+	EXPECT_TRUE(verifier.verify({ get_region(module->root(), "diamond") }).empty());
+}
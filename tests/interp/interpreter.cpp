@@ -0,0 +1,357 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <memory>
+#include <stdexcept>
+#include <arc/foundation/builder.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/interp/interpreter.hpp>
+#include <gtest/gtest.h>
+
+class InterpreterFixture : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		module = std::make_unique<arc::Module>("interp_test");
+		builder = std::make_unique<arc::Builder>(*module);
+	}
+
+	arc::Region *get_function_region(const std::string &name)
+	{
+		for (arc::Region *child: module->root()->children())
+		{
+			if (child->name() == name)
+				return child;
+		}
+		return nullptr;
+	}
+
+	std::unique_ptr<arc::Module> module;
+	std::unique_ptr<arc::Builder> builder;
+};
+
+TEST_F(InterpreterFixture, IntegerArithmetic)
+{
+	builder->function<arc::DataType::INT32>("arith")
+			.param<arc::DataType::INT32>("a")
+			.param<arc::DataType::INT32>("b")
+			.body([](arc::Builder &fb, arc::Node *a, arc::Node *b)
+			{
+				auto *sum = fb.add(a, b);
+				auto *product = fb.mul(sum, fb.lit(3));
+				return fb.ret(fb.sub(product, fb.div(a, b)));
+			});
+
+	arc::Interpreter interp(*module);
+	EXPECT_EQ(interp.call("arith", { 10, 2 }).as<std::int32_t>(), 31);
+	EXPECT_EQ(interp.call("arith", { -7, 2 }).as<std::int32_t>(), -12);
+}
+
+TEST_F(InterpreterFixture, NarrowIntegersWrap)
+{
+	builder->function<arc::DataType::UINT8>("wrap")
+			.param<arc::DataType::UINT8>("x")
+			.body([](arc::Builder &fb, arc::Node *x)
+			{
+				return fb.ret(fb.add(x, fb.lit(static_cast<std::uint8_t>(200))));
+			});
+
+	builder->function<arc::DataType::INT32>("widen")
+			.param<arc::DataType::INT64>("x")
+			.body([](arc::Builder &fb, arc::Node *x)
+			{
+				return fb.ret(fb.cast<arc::DataType::INT32>(x));
+			});
+
+	arc::Interpreter interp(*module);
+	EXPECT_EQ(interp.call("wrap", { static_cast<std::uint8_t>(100) }).as<std::uint8_t>(), 44);
+	EXPECT_EQ(interp.call("widen", { std::int64_t { 0x1'0000'0005 } }).as<std::int32_t>(), 5);
+	EXPECT_EQ(interp.call("widen", { std::int64_t { -1 } }).as<std::int64_t>(), -1);
+}
+
+TEST_F(InterpreterFixture, FloatingPoint)
+{
+	builder->function<arc::DataType::FLOAT64>("mix")
+			.param<arc::DataType::FLOAT64>("x")
+			.param<arc::DataType::INT32>("n")
+			.body([](arc::Builder &fb, arc::Node *x, arc::Node *n)
+			{
+				auto *scaled = fb.mul(x, fb.cast<arc::DataType::FLOAT64>(n));
+				return fb.ret(fb.div(scaled, fb.lit(4.0)));
+			});
+
+	arc::Interpreter interp(*module);
+	EXPECT_DOUBLE_EQ(interp.call("mix", { 1.5, 6 }).as<double>(), 2.25);
+}
+
+TEST_F(InterpreterFixture, LoopThroughMemory)
+{
+	builder->function<arc::DataType::INT32>("sum")
+			.param<arc::DataType::INT32>("limit")
+			.body([&](arc::Builder &fb, arc::Node *limit)
+			{
+				auto loop = fb.block<arc::DataType::VOID>("loop");
+				auto exit = fb.block<arc::DataType::VOID>("exit");
+
+				auto *counter = fb.alloc<arc::DataType::INT32>(fb.lit(1));
+				auto *total = fb.alloc<arc::DataType::INT32>(fb.lit(1));
+				fb.store(fb.lit(0), counter);
+				fb.store(fb.lit(0), total);
+				fb.jump(loop.entry());
+
+				loop([&](arc::Builder &lb)
+				{
+					auto *i = lb.add(lb.load(counter), lb.lit(1));
+					lb.store(i, counter);
+					lb.store(lb.add(lb.load(total), i), total);
+					return lb.branch(lb.lt(i, limit), loop.entry(), exit.entry());
+				});
+
+				exit([&](arc::Builder &eb)
+				{
+					return eb.ret(eb.load(total));
+				});
+
+				return nullptr;
+			});
+
+	arc::Interpreter interp(*module);
+	EXPECT_EQ(interp.call("sum", { 100 }).as<std::int32_t>(), 5050);
+}
+
+TEST_F(InterpreterFixture, FromParallelCopies)
+{
+	/* a, b = b, a on the back edge needs the copies to be sequenced */
+	auto *entry = module->create_region("swap", module->root());
+	auto *loop = module->create_region("loop", entry);
+	auto *exit = module->create_region("exit", entry);
+
+	builder->set_insertion_point(module->root());
+	auto *fn = builder->create_node(arc::NodeType::FUNCTION, arc::DataType::FUNCTION);
+	fn->str_id = module->intern_str("swap");
+	module->add_fn(fn);
+
+	builder->set_insertion_point(entry);
+	auto *one = builder->lit(1);
+	auto *two = builder->lit(2);
+	auto *zero = builder->lit(0);
+	builder->jump(loop->entry());
+
+	builder->set_insertion_point(loop);
+	auto *a = builder->from({ one });
+	auto *b = builder->from({ two });
+	auto *i = builder->from({ zero });
+	auto *next = builder->add(i, builder->lit(1));
+	for (auto [merge, value]: { std::pair { a, b }, std::pair { b, a }, std::pair { i, next } })
+		arc::Builder::connect_inputs(merge, { value });
+	builder->branch(builder->lt(next, builder->lit(4)), loop->entry(), exit->entry());
+
+	builder->set_insertion_point(exit);
+	builder->ret(builder->sub(builder->mul(a, builder->lit(10)), b));
+
+	/* three back edges leave the pair swapped */
+	arc::Interpreter interp(*module);
+	EXPECT_EQ(interp.call("swap").as<std::int32_t>(), 19);
+}
+
+TEST_F(InterpreterFixture, RecursiveCall)
+{
+	auto factorial = builder->opaque_t<arc::DataType::FUNCTION>("factorial");
+	factorial.function<arc::DataType::INT64>()
+			.param<arc::DataType::INT64>("n")
+			.body([&](arc::Builder &fb, arc::Node *n)
+			{
+				auto *one = fb.lit(std::int64_t { 1 });
+				auto *base = fb.block<arc::DataType::INT64>("base")([&](arc::Builder &bb)
+				{
+					return bb.ret(one);
+				});
+
+				auto *recurse = fb.block<arc::DataType::INT64>("recurse")([&](arc::Builder &bb)
+				{
+					auto *rec = bb.call(factorial.node(), { bb.sub(n, one) });
+					return bb.ret(bb.mul(n, rec));
+				});
+
+				return fb.branch(fb.lte(n, one), base->parent->entry(), recurse->parent->entry());
+			});
+
+	arc::Interpreter interp(*module);
+	EXPECT_EQ(interp.call("factorial", { std::int64_t { 20 } }).as<std::int64_t>(), 2432902008176640000);
+}
+
+TEST_F(InterpreterFixture, StackOverflowTraps)
+{
+	auto forever = builder->opaque_t<arc::DataType::FUNCTION>("forever");
+	forever.function<arc::DataType::INT32>()
+			.body([&](arc::Builder &fb)
+			{
+				return fb.ret(fb.call(forever.node()));
+			});
+
+	arc::Interpreter interp(*module, { .stack_slots = 1 << 10, .max_depth = 64, .arena_bytes = 64 });
+	EXPECT_THROW(interp.call("forever"), std::runtime_error);
+}
+
+TEST_F(InterpreterFixture, DivisionByZeroTraps)
+{
+	builder->function<arc::DataType::INT32>("divide")
+			.param<arc::DataType::INT32>("a")
+			.param<arc::DataType::INT32>("b")
+			.body([](arc::Builder &fb, arc::Node *a, arc::Node *b)
+			{
+				return fb.ret(fb.div(a, b));
+			});
+
+	arc::Interpreter interp(*module);
+	EXPECT_EQ(interp.call("divide", { 9, 3 }).as<std::int32_t>(), 3);
+	EXPECT_THROW(interp.call("divide", { 1, 0 }), std::runtime_error);
+
+	/* the interpreter is still usable after an unhandled trap */
+	EXPECT_EQ(interp.call("divide", { 8, 2 }).as<std::int32_t>(), 4);
+}
+
+TEST_F(InterpreterFixture, HostFunction)
+{
+	auto *host = builder->function<arc::DataType::INT32>("host_scale")
+			.param<arc::DataType::INT32>("x")
+			.imported()
+			.body([](arc::Builder &fb, arc::Node *)
+			{
+				return fb.ret();
+			});
+
+	builder->function<arc::DataType::INT32>("caller")
+			.param<arc::DataType::INT32>("x")
+			.body([&](arc::Builder &fb, arc::Node *x)
+			{
+				return fb.ret(fb.add(fb.call(host, { x }), fb.lit(1)));
+			});
+
+	arc::Interpreter interp(*module);
+	EXPECT_THROW(interp.call("caller", { 2 }), std::runtime_error);
+
+	interp.bind("host_scale", [](std::span<const arc::Value> args)
+	{
+		return arc::Value(args[0].as<std::int32_t>() * 7);
+	});
+	EXPECT_EQ(interp.call("caller", { 3 }).as<std::int32_t>(), 22);
+	EXPECT_THROW(interp.bind("caller", {}), std::invalid_argument);
+}
+
+TEST_F(InterpreterFixture, InvokeUnwindsOnTrap)
+{
+	auto *divide = builder->function<arc::DataType::INT32>("divide")
+			.param<arc::DataType::INT32>("a")
+			.param<arc::DataType::INT32>("b")
+			.body([](arc::Builder &fb, arc::Node *a, arc::Node *b)
+			{
+				return fb.ret(fb.div(a, b));
+			});
+
+	builder->function<arc::DataType::INT32>("safe_divide")
+			.param<arc::DataType::INT32>("a")
+			.param<arc::DataType::INT32>("b")
+			.body([&](arc::Builder &fb, arc::Node *a, arc::Node *b)
+			{
+				arc::Node *result = nullptr;
+				auto normal = fb.block<arc::DataType::INT32>("normal");
+				auto except = fb.block<arc::DataType::INT32>("except");
+				result = fb.invoke(divide, { a, b }, normal.entry(), except.entry());
+
+				normal([&](arc::Builder &nb)
+				{
+					return nb.ret(result);
+				});
+
+				except([&](arc::Builder &eb)
+				{
+					return eb.ret(eb.lit(-1));
+				});
+
+				return nullptr;
+			});
+
+	arc::Interpreter interp(*module);
+	EXPECT_EQ(interp.call("safe_divide", { 12, 4 }).as<std::int32_t>(), 3);
+	EXPECT_EQ(interp.call("safe_divide", { 12, 0 }).as<std::int32_t>(), -1);
+}
+
+TEST_F(InterpreterFixture, AtomicsAndSelect)
+{
+	builder->function<arc::DataType::INT32>("atomics")
+			.param<arc::DataType::INT32>("x")
+			.body([](arc::Builder &fb, arc::Node *x)
+			{
+				auto *cell = fb.alloc<arc::DataType::INT32>(fb.lit(1));
+				fb.store(x).to_atomic(cell, arc::AtomicOrdering::RELEASE);
+
+				auto *address = fb.addr_of(cell);
+				auto *acquire = fb.lit(static_cast<std::uint8_t>(arc::AtomicOrdering::ACQUIRE));
+				auto *load = fb.create_node(arc::NodeType::ATOMIC_LOAD, arc::DataType::INT32);
+				arc::Builder::connect_inputs(load, { address, acquire });
+
+				/* exchange succeeds only when the cell still holds 5 */
+				auto *expected = fb.lit(5);
+				auto *desired = fb.lit(50);
+				auto *cas = fb.create_node(arc::NodeType::ATOMIC_CAS, arc::DataType::INT32);
+				arc::Builder::connect_inputs(cas, { address, expected, desired });
+
+				auto *now = fb.load(cell);
+				auto *changed = fb.neq(cas, now);
+				return fb.ret(fb.select(changed, fb.add(load, now), fb.lit(0)));
+			});
+
+	arc::Interpreter interp(*module);
+	EXPECT_EQ(interp.call("atomics", { 5 }).as<std::int32_t>(), 55);
+	EXPECT_EQ(interp.call("atomics", { -3 }).as<std::int32_t>(), 0);
+}
+
+TEST_F(InterpreterFixture, StructFieldsAndVectors)
+{
+	auto point = builder->struct_type("point")
+			.field("x", arc::DataType::INT32)
+			.field("y", arc::DataType::INT64)
+			.build();
+
+	builder->function<arc::DataType::INT64>("fields")
+			.param<arc::DataType::INT32>("x")
+			.body([&](arc::Builder &fb, arc::Node *x)
+			{
+				auto *p = fb.alloc(point);
+				fb.store(x, fb.struct_field(p, "x"));
+				fb.store(fb.lit(std::int64_t { 40 }), fb.struct_field(p, "y"));
+
+				auto *v = fb.vector_splat(x, 4);
+				auto *lane = fb.vector_extract(fb.add(v, v), 3);
+				auto *sum = fb.add(fb.cast<arc::DataType::INT64>(fb.load(fb.struct_field(p, "x"))),
+				                   fb.load(fb.struct_field(p, "y")));
+				return fb.ret(fb.add(sum, fb.cast<arc::DataType::INT64>(lane)));
+			});
+
+	arc::Interpreter interp(*module);
+	EXPECT_EQ(interp.call("fields", { 1 }).as<std::int64_t>(), 43);
+}
+
+TEST_F(InterpreterFixture, CompiledLayout)
+{
+	builder->function<arc::DataType::INT32>("straight")
+			.param<arc::DataType::INT32>("a")
+			.body([](arc::Builder &fb, arc::Node *a)
+			{
+				return fb.ret(fb.add(a, fb.lit(1)));
+			});
+
+	arc::Interpreter interp(*module);
+	const auto *fn = interp.function("straight");
+	ASSERT_NE(fn, nullptr);
+	EXPECT_EQ(interp.function("missing"), nullptr);
+
+	/* one add and one return; constants are part of the frame template */
+	ASSERT_EQ(fn->code.size(), 2);
+	EXPECT_EQ(fn->code[0].op, arc::Interpreter::Opcode::ADD_I32);
+	EXPECT_EQ(fn->code[1].op, arc::Interpreter::Opcode::RET);
+	EXPECT_NE(fn->code[0].handler, nullptr);
+	EXPECT_EQ(fn->params.size(), 1);
+	EXPECT_THROW(interp.call("missing"), std::invalid_argument);
+}
@@ -0,0 +1,183 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <cstdlib>
+#include <format>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <arc/foundation/builder.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/pass-manager.hpp>
+#include <arc/support/compile-server.hpp>
+#include <arc/support/output-buffer.hpp>
+#include <arc/support/parser.hpp>
+#include <arc/support/printer.hpp>
+#include <arc/transform/constfold.hpp>
+#include <arc/transform/dce.hpp>
+#include <gtest/gtest.h>
+
+namespace
+{
+	/* misbehaves in the way the module's function is named after */
+	class HazardPass final : public arc::TransformPass
+	{
+	public:
+		[[nodiscard]] std::string name() const override
+		{
+			return "hazard";
+		}
+
+		std::vector<arc::Region *> run(arc::Module &module, arc::PassManager &) override
+		{
+			if (module.find_fn("crash"))
+				std::abort();
+			if (module.find_fn("fail"))
+				throw std::runtime_error("pass failed");
+			if (module.find_fn("hog"))
+			{
+				std::vector<char> hog(std::size_t { 1 } << 32);
+				hog.back() = 1;
+			}
+			return {};
+		}
+	};
+
+	void configure(arc::PassManager &pm)
+	{
+		pm.add<arc::ConstantFoldingPass>();
+		pm.add<arc::DeadCodeElimination>();
+		pm.add<HazardPass>();
+	}
+
+	std::string print(arc::Module &module)
+	{
+		arc::OutputBuffer out;
+		arc::Printer(module).print(out);
+		return out.str();
+	}
+
+	/* `name(x)` returns `x + 2 * 3` */
+	std::string source(const std::string &name)
+	{
+		arc::Module module("job");
+		arc::Builder builder(module);
+		builder.function<arc::DataType::INT32>(name)
+				.param<arc::DataType::INT32>("x")
+				.body([](arc::Builder &fb, arc::Node *x)
+				{
+					return fb.ret(fb.add(x, fb.mul(fb.lit(2), fb.lit(3))));
+				});
+		return print(module);
+	}
+
+	class CompileServerFixture : public testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			path = std::format("/tmp/arc-compile-server-test-{}.sock", ::getpid());
+			server = std::make_unique<arc::CompileServer>(arc::ServerConfig {
+				.socket_path = path,
+				.workers = 4,
+				.memory_limit = std::size_t { 256 } << 20,
+				.max_request = std::size_t { 1 } << 20,
+				.warm_up_nodes = 256
+			});
+			server->pipeline(configure);
+			serving = std::thread([this] { server->serve(); });
+		}
+
+		void TearDown() override
+		{
+			server->stop();
+			serving.join();
+			server.reset();
+		}
+
+		std::string path;
+		std::unique_ptr<arc::CompileServer> server;
+		std::thread serving;
+	};
+}
+
+TEST_F(CompileServerFixture, CompilesLikeTheLocalPipeline)
+{
+	const std::string text = source("f");
+	const arc::CompileResult result = arc::CompileClient(path).compile(text);
+	ASSERT_EQ(result.status, arc::JobStatus::OK) << result.output;
+
+	const std::unique_ptr<arc::Module> local = arc::parse(text);
+	arc::PassManager pm;
+	configure(pm);
+	pm.run(*local);
+	EXPECT_EQ(result.output, print(*local));
+	EXPECT_NE(result.output, text);
+}
+
+TEST_F(CompileServerFixture, ReportsParseErrors)
+{
+	const arc::CompileResult result = arc::CompileClient(path).compile("this is not a module\n");
+	EXPECT_EQ(result.status, arc::JobStatus::PARSE_ERROR);
+	EXPECT_FALSE(result.output.empty());
+}
+
+TEST_F(CompileServerFixture, FailingPassesAreReported)
+{
+	const arc::CompileResult result = arc::CompileClient(path).compile(source("fail"));
+	EXPECT_EQ(result.status, arc::JobStatus::FAILED);
+	EXPECT_EQ(result.output, "pass failed");
+}
+
+TEST_F(CompileServerFixture, CrashedJobsLeaveTheServerRunning)
+{
+	const arc::CompileClient client(path);
+	EXPECT_EQ(client.compile(source("crash")).status, arc::JobStatus::CRASHED);
+	EXPECT_EQ(client.compile(source("f")).status, arc::JobStatus::OK);
+}
+
+TEST_F(CompileServerFixture, JobsOverTheMemoryLimitFailAlone)
+{
+	const arc::CompileClient client(path);
+	const arc::CompileResult result = client.compile(source("hog"));
+	EXPECT_EQ(result.status, arc::JobStatus::OUT_OF_MEMORY) << result.output;
+	EXPECT_EQ(client.compile(source("f")).status, arc::JobStatus::OK);
+}
+
+TEST_F(CompileServerFixture, OversizedRequestsAreRejected)
+{
+	const std::string text(std::size_t { 2 } << 20, ' ');
+	EXPECT_EQ(arc::CompileClient(path).compile(text).status, arc::JobStatus::REJECTED);
+}
+
+TEST_F(CompileServerFixture, ServesConcurrentClients)
+{
+	constexpr std::size_t clients = 8;
+	constexpr std::size_t jobs = 8;
+	const std::string text = source("f");
+	const std::string expected = arc::CompileClient(path).compile(text).output;
+
+	std::vector<std::thread> threads;
+	std::vector<std::size_t> matched(clients, 0);
+	const arc::CompileClient client(path);
+	for (std::size_t i = 0; i < clients; ++i)
+	{
+		threads.emplace_back([&, i]
+		{
+			for (std::size_t j = 0; j < jobs; ++j)
+			{
+				const arc::CompileResult result = client.compile(text);
+				if (result.status == arc::JobStatus::OK && result.output == expected)
+					++matched[i];
+			}
+		});
+	}
+	for (std::thread &thread: threads)
+		thread.join();
+
+	for (const std::size_t count: matched)
+		EXPECT_EQ(count, jobs);
+	EXPECT_EQ(server->jobs(), clients * jobs + 1);
+}
@@ -0,0 +1,89 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/node.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/foundation/verifier.hpp>
+#include <arc/support/dump.hpp>
+#include <arc/support/generator.hpp>
+#include <gtest/gtest.h>
+
+namespace
+{
+	std::string text_of(arc::Module &module)
+	{
+		std::ostringstream os;
+		arc::dump(module, os);
+		return os.str();
+	}
+
+	std::size_t count_nodes(const arc::Region *region, arc::NodeType type = arc::NodeType::ENTRY, bool any = true) // NOLINT(*-no-recursion)
+	{
+		std::size_t count = 0;
+		for (const arc::Node *node: region->nodes())
+		{
+			if (any || node->ir_type == type)
+				++count;
+		}
+		for (const arc::Region *child: region->children())
+			count += count_nodes(child, type, any);
+		return count;
+	}
+}
+
+TEST(GeneratorTest, SameSeedSameModule)
+{
+	const arc::GeneratorOptions options { .seed = 42, .nodes = 4'000 };
+	const auto first = arc::generate(options);
+	const auto second = arc::generate(options);
+	EXPECT_EQ(text_of(*first), text_of(*second));
+
+	const auto other = arc::generate({ .seed = 43, .nodes = 4'000 });
+	EXPECT_NE(text_of(*first), text_of(*other));
+}
+
+TEST(GeneratorTest, ApproximatesNodeCount)
+{
+	for (const std::size_t nodes: { 1'000, 10'000, 100'000 })
+	{
+		const auto module = arc::generate({ .nodes = nodes });
+		const std::size_t count = count_nodes(module->root());
+		EXPECT_GT(count, nodes / 2) << nodes;
+		EXPECT_LT(count, nodes * 2) << nodes;
+	}
+}
+
+TEST(GeneratorTest, HonoursShape)
+{
+	const auto module = arc::generate({ .nodes = 2'000, .functions = 5, .depth = 2, .fan_out = 2 });
+	ASSERT_EQ(module->functions().size(), 5u);
+
+	/* the body plus 2 blocks plus 2 blocks in each of them */
+	for (const arc::Region *body: module->root()->children())
+	{
+		ASSERT_EQ(body->children().size(), 2u);
+		for (const arc::Region *block: body->children())
+			EXPECT_EQ(block->children().size(), 2u);
+	}
+}
+
+TEST(GeneratorTest, FollowsNodeMix)
+{
+	const auto module = arc::generate({ .nodes = 5'000, .mix = { .arithmetic = 1, .memory = 0, .calls = 0, .vectors = 0, .atomics = 0 } });
+	EXPECT_EQ(count_nodes(module->root(), arc::NodeType::CALL, false), 0u);
+	EXPECT_EQ(count_nodes(module->root(), arc::NodeType::VECTOR_SPLAT, false), 0u);
+
+	const auto calls = arc::generate({ .nodes = 5'000, .mix = { .arithmetic = 1, .memory = 0, .calls = 1, .vectors = 0, .atomics = 0 } });
+	EXPECT_GT(count_nodes(calls->root(), arc::NodeType::CALL, false), 0u);
+}
+
+TEST(GeneratorTest, ProducesWellFormedIR)
+{
+	const auto module = arc::generate({ .nodes = 20'000, .depth = 3, .loops = 0.5 });
+	arc::Verifier verifier(*module);
+	const auto diagnostics = verifier.verify();
+	EXPECT_TRUE(diagnostics.empty()) << (diagnostics.empty() ? "" : diagnostics.front().message);
+}
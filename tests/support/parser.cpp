@@ -0,0 +1,244 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <unistd.h>
+#include <arc/foundation/builder.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/region.hpp>
+#include <arc/support/dump.hpp>
+#include <arc/support/parser.hpp>
+#include <gtest/gtest.h>
+
+namespace
+{
+	std::string text_of(arc::Module &module)
+	{
+		std::ostringstream os;
+		arc::dump(module, os);
+		return os.str();
+	}
+
+	class ParserFixture : public testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			module = std::make_unique<arc::Module>("parser_module");
+			builder = std::make_unique<arc::Builder>(*module);
+		}
+
+		void TearDown() override
+		{
+			builder.reset();
+			module.reset();
+		}
+
+		/* the parsed module must print exactly like the one it was printed from */
+		void expect_round_trip()
+		{
+			const std::string text = text_of(*module);
+			const std::unique_ptr<arc::Module> parsed = arc::parse(text);
+			ASSERT_NE(parsed, nullptr);
+			EXPECT_EQ(text_of(*parsed), text);
+		}
+
+		std::unique_ptr<arc::Module> module;
+		std::unique_ptr<arc::Builder> builder;
+	};
+}
+
+TEST_F(ParserFixture, RoundTripsArithmetic)
+{
+	builder->function<arc::DataType::INT32>("compute")
+		.param<arc::DataType::INT32>("a")
+		.param<arc::DataType::INT32>("b")
+		.body([](arc::Builder &fb, arc::Node *a, arc::Node *b)
+		{
+			auto *shared = fb.lit(7);
+			auto *sum = fb.add(a, shared);
+			auto *product = fb.mul(sum, fb.sub(b, shared));
+			return fb.ret(fb.div(product, fb.lit(3)));
+		});
+
+	expect_round_trip();
+}
+
+TEST_F(ParserFixture, RoundTripsStructs)
+{
+	auto inner = builder->struct_type("Inner")
+		.field("flag", arc::DataType::UINT8)
+		.field("value", arc::DataType::INT64)
+		.build();
+	auto outer = builder->struct_type("Outer")
+		.field("id", arc::DataType::INT32)
+		.field("inner", arc::DataType::STRUCT, inner)
+		.build();
+
+	builder->function<arc::DataType::INT64>("read")
+		.param<arc::DataType::INT64>("x")
+		.body([&](arc::Builder &fb, arc::Node *x)
+		{
+			auto *object = fb.alloc(outer);
+			auto *nested = fb.struct_field(object, "inner");
+			fb.store(x, fb.struct_field(nested, "value"));
+			return fb.ret(fb.load(fb.struct_field(nested, "value")));
+		});
+
+	expect_round_trip();
+
+	const std::unique_ptr<arc::Module> parsed = arc::parse(text_of(*module));
+	EXPECT_TRUE(parsed->typemap().contains("Inner"));
+	EXPECT_TRUE(parsed->typemap().contains("Outer"));
+}
+
+TEST_F(ParserFixture, RoundTripsControlFlow)
+{
+	builder->function<arc::DataType::INT32>("choose")
+		.param<arc::DataType::INT32>("x")
+		.body([](arc::Builder &fb, arc::Node *x)
+		{
+			auto *slot = fb.alloc<arc::DataType::INT32>(fb.lit(1));
+			fb.store(fb.lit(0), slot);
+
+			auto *merge = fb.block<arc::DataType::INT32>("merge")([&](arc::Builder &bb)
+			{
+				return bb.ret(bb.load(slot));
+			});
+
+			auto *then = fb.block<arc::DataType::VOID>("then")([&](arc::Builder &bb)
+			{
+				bb.store(x, slot);
+				bb.jump(merge->parent->entry());
+				return bb.ret();
+			});
+
+			auto *otherwise = fb.block<arc::DataType::VOID>("otherwise")([&](arc::Builder &bb)
+			{
+				bb.store(bb.lit(-1), slot);
+				bb.jump(merge->parent->entry());
+				return bb.ret();
+			});
+
+			fb.branch(fb.gt(x, fb.lit(0)), then->parent->entry(), otherwise->parent->entry());
+			return fb.ret();
+		});
+
+	expect_round_trip();
+}
+
+TEST_F(ParserFixture, RoundTripsCalls)
+{
+	auto *helper = builder->function<arc::DataType::INT32>("helper")
+		.param<arc::DataType::INT32>("x")
+		.body([](arc::Builder &fb, arc::Node *x)
+		{
+			return fb.ret(fb.add(x, fb.lit(1)));
+		});
+
+	builder->function<arc::DataType::INT32>("caller")
+		.param<arc::DataType::INT32>("input")
+		.body([helper](arc::Builder &fb, arc::Node *input)
+		{
+			auto *first = fb.call(helper, { input });
+			return fb.ret(fb.call(helper, { first }));
+		});
+
+	expect_round_trip();
+}
+
+TEST(ParserTest, ResolvesForwardReferences)
+{
+	/* %4 is used before it is defined and $done is jumped to before its header */
+	const std::string text =
+		"#! module: forward\n"
+		"section .__rodata\n"
+		"end .__rodata\n"
+		"\n"
+		"fn @later(i32 %1) -> i32\n"
+		"{\n"
+		"    $later:\n"
+		"        entry\n"
+		"        %2 = jump $done;\n"
+		"        %3 = i32 add %1, %4;\n"
+		"        %4 = i32 mul %1, #2;\n"
+		"        ret %3;\n"
+		"        $done:\n"
+		"            entry\n"
+		"            ret %1;\n"
+		"}\n";
+
+	const std::unique_ptr<arc::Module> parsed = arc::parse(text);
+	ASSERT_EQ(parsed->functions().size(), 1u);
+
+	const std::string printed = text_of(*parsed);
+	EXPECT_NE(printed.find("= jump $done"), std::string::npos);
+	EXPECT_NE(printed.find("i32 mul"), std::string::npos);
+	EXPECT_EQ(text_of(*arc::parse(printed)), printed);
+}
+
+TEST(ParserTest, ReportsLineOfError)
+{
+	const std::string text =
+		"#! module: broken\n"
+		"section .__rodata\n"
+		"end .__rodata\n"
+		"\n"
+		"fn @f() -> void\n"
+		"{\n"
+		"    $f:\n"
+		"        entry\n"
+		"        %1 = i32 frobnicate #1;\n"
+		"}\n";
+
+	try
+	{
+		arc::parse(text);
+		FAIL() << "expected a parse error";
+	}
+	catch (const arc::ParseError &error)
+	{
+		EXPECT_EQ(error.line(), 9u);
+		EXPECT_GT(error.column(), 1u);
+	}
+}
+
+TEST(ParserTest, RejectsUndefinedValues)
+{
+	const std::string text =
+		"#! module: undefined\n"
+		"fn @f(i32 %1) -> i32\n"
+		"{\n"
+		"    $f:\n"
+		"        entry\n"
+		"        ret %9;\n"
+		"}\n";
+
+	EXPECT_THROW(arc::parse(text), arc::ParseError);
+}
+
+TEST_F(ParserFixture, ParsesMappedFile)
+{
+	builder->function<arc::DataType::INT32>("mapped")
+		.param<arc::DataType::INT32>("a")
+		.body([](arc::Builder &fb, arc::Node *a)
+		{
+			return fb.ret(fb.mul(a, a));
+		});
+
+	const std::string text = text_of(*module);
+	char path[] = "/tmp/arc-parser-XXXXXX";
+	const int fd = mkstemp(path);
+	ASSERT_GE(fd, 0);
+	ASSERT_EQ(write(fd, text.data(), text.size()), static_cast<ssize_t>(text.size()));
+	close(fd);
+
+	const std::unique_ptr<arc::Module> parsed = arc::parse_file(path);
+	unlink(path);
+	EXPECT_EQ(text_of(*parsed), text);
+
+	EXPECT_THROW(arc::parse_file("/nonexistent/arc-parser"), std::system_error);
+}
@@ -0,0 +1,130 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <arc/analysis/call-graph.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/pass-manager.hpp>
+#include <arc/support/generator.hpp>
+#include <arc/support/perf-counters.hpp>
+#include <arc/transform/constfold.hpp>
+#include <gtest/gtest.h>
+
+/* counters may be unavailable in CI containers, so every test has to hold
+ * whether or not `perf_event_open` works on the host */
+
+namespace
+{
+	volatile std::uint64_t sink = 0;
+
+	void busy_work()
+	{
+		for (std::uint64_t i = 0; i < 1'000'000; ++i)
+			sink = sink + i * 3;
+	}
+}
+
+TEST(PerfCountersTest, SampleIsEmptyOrCountsWork)
+{
+	arc::PerfCounters counters;
+	counters.start();
+	busy_work();
+	const arc::PerfSample sample = counters.stop();
+
+	if (!counters.available())
+	{
+		EXPECT_EQ(sample.present, 0u);
+		GTEST_SKIP() << "hardware counters unavailable";
+	}
+
+	if (sample.has(arc::PerfEvent::INSTRUCTIONS))
+		EXPECT_GT(sample[arc::PerfEvent::INSTRUCTIONS], 1'000'000u);
+	if (sample.has(arc::PerfEvent::CYCLES) && sample.has(arc::PerfEvent::INSTRUCTIONS))
+		EXPECT_GT(sample.ipc(), 0.0);
+}
+
+TEST(PerfCountersTest, MissingEventsAreNotRatios)
+{
+	arc::PerfSample sample;
+	sample.values[static_cast<std::size_t>(arc::PerfEvent::CYCLES)] = 100;
+	sample.present = 1u << static_cast<std::uint32_t>(arc::PerfEvent::CYCLES);
+
+	EXPECT_LT(sample.ipc(), 0.0);
+	EXPECT_LT(sample.mpki(arc::PerfEvent::LLC_MISSES), 0.0);
+
+	sample.values[static_cast<std::size_t>(arc::PerfEvent::INSTRUCTIONS)] = 250;
+	sample.values[static_cast<std::size_t>(arc::PerfEvent::BRANCH_MISSES)] = 5;
+	sample.present |= 1u << static_cast<std::uint32_t>(arc::PerfEvent::INSTRUCTIONS);
+	sample.present |= 1u << static_cast<std::uint32_t>(arc::PerfEvent::BRANCH_MISSES);
+
+	EXPECT_DOUBLE_EQ(sample.ipc(), 2.5);
+	EXPECT_DOUBLE_EQ(sample.mpki(arc::PerfEvent::BRANCH_MISSES), 20.0);
+	EXPECT_LT(sample.mpki(arc::PerfEvent::L1D_MISSES), 0.0);
+}
+
+TEST(PerfCountersTest, AccumulationKeepsOnlyCommonEvents)
+{
+	arc::PerfSample a;
+	a.values = { 10, 20, 0, 0, 1 };
+	a.present = 0b10011;
+
+	arc::PerfSample b;
+	b.values = { 5, 5, 0, 0, 0 };
+	b.present = 0b00011;
+
+	a += b;
+	EXPECT_EQ(a[arc::PerfEvent::CYCLES], 15u);
+	EXPECT_EQ(a[arc::PerfEvent::INSTRUCTIONS], 25u);
+	EXPECT_TRUE(a.has(arc::PerfEvent::CYCLES));
+	EXPECT_FALSE(a.has(arc::PerfEvent::BRANCH_MISSES));
+}
+
+TEST(PerfCountersTest, ScopesAccumulateByName)
+{
+	arc::PerfProfile profile;
+	for (int i = 0; i < 3; ++i)
+	{
+		auto scope = profile.scope("isel");
+		busy_work();
+	}
+	{
+		auto scope = profile.scope("regalloc");
+		busy_work();
+	}
+
+	const auto entries = profile.entries();
+	ASSERT_EQ(entries.size(), 2u);
+	EXPECT_EQ(entries[0].name, "isel");
+	EXPECT_EQ(entries[0].runs, 3u);
+	EXPECT_EQ(entries[1].name, "regalloc");
+	EXPECT_EQ(entries[1].runs, 1u);
+
+	profile.clear();
+	EXPECT_TRUE(profile.entries().empty());
+}
+
+TEST(PerfCountersTest, PassManagerRecordsEveryPass)
+{
+	const std::unique_ptr<arc::Module> module = arc::generate({ .seed = 7, .nodes = 2048 });
+
+	arc::PerfProfile profile;
+	arc::PassManager pm;
+	pm.add<arc::CallGraphAnalysisPass>();
+	pm.add<arc::ConstantFoldingPass>();
+	pm.profile(profile).run(*module);
+
+	const auto entries = profile.entries();
+	ASSERT_EQ(entries.size(), 2u);
+	EXPECT_EQ(entries[0].name, arc::CallGraphAnalysisPass().name());
+	EXPECT_EQ(entries[1].name, arc::ConstantFoldingPass().name());
+
+	std::ostringstream os;
+	profile.print(os);
+	const std::string table = os.str();
+	EXPECT_NE(table.find("ipc"), std::string::npos);
+	EXPECT_NE(table.find(entries[1].name), std::string::npos);
+	if (!profile.available())
+		EXPECT_NE(table.find("n/a"), std::string::npos);
+}
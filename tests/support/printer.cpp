@@ -0,0 +1,188 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <cstdio>
+#include <format>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <arc/foundation/builder.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/support/dump.hpp>
+#include <arc/support/output-buffer.hpp>
+#include <arc/support/printer.hpp>
+#include <gtest/gtest.h>
+
+namespace
+{
+	class PrinterFixture : public testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			module = std::make_unique<arc::Module>("printer_module");
+			builder = std::make_unique<arc::Builder>(*module);
+		}
+
+		void TearDown() override
+		{
+			builder.reset();
+			module.reset();
+		}
+
+		/* enough functions to take the parallel path */
+		void build_functions(std::size_t count)
+		{
+			auto point_type = builder->struct_type("Point")
+				.field("x", arc::DataType::INT32)
+				.field("y", arc::DataType::INT32)
+				.build();
+
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				builder->function<arc::DataType::INT32>("fn" + std::to_string(i))
+					.param<arc::DataType::INT32>("a")
+					.param<arc::DataType::INT32>("b")
+					.body([&, i](arc::Builder &fb, arc::Node *a, arc::Node *b)
+					{
+						auto *point = fb.alloc(point_type);
+						fb.store(a, fb.struct_field(point, "x"));
+						fb.store(b, fb.struct_field(point, "y"));
+						auto *sum = fb.add(a, fb.lit(static_cast<std::int32_t>(i)));
+						return fb.ret(fb.mul(sum, b));
+					});
+			}
+		}
+
+		std::string print(unsigned threads)
+		{
+			arc::OutputBuffer out;
+			arc::Printer(*module, threads).print(out);
+			return out.str();
+		}
+
+		std::unique_ptr<arc::Module> module;
+		std::unique_ptr<arc::Builder> builder;
+	};
+}
+
+TEST(OutputBufferTest, FormatsLikeFormat)
+{
+	arc::OutputBuffer out;
+	out << "x" << ' ' << -42 << ' ' << 18446744073709551615ULL << ' ' << 3.14f << ' ' << 2.718281828459045;
+
+	EXPECT_EQ(out.str(), std::format("x {} {} {} {}", -42, 18446744073709551615ULL, 3.14f, 2.718281828459045));
+	EXPECT_EQ(out.size(), out.str().size());
+}
+
+TEST(OutputBufferTest, SpansChunks)
+{
+	arc::OutputBuffer out;
+	const std::string line(1000, 'a');
+	std::string expected;
+	for (int i = 0; i < 200; ++i)
+	{
+		out << line << i;
+		expected += line + std::to_string(i);
+	}
+
+	/* a single write larger than a chunk */
+	const std::string big(arc::OutputBuffer::chunk_size * 2 + 7, 'b');
+	out << big;
+	expected += big;
+
+	EXPECT_EQ(out.size(), expected.size());
+	EXPECT_EQ(out.str(), expected);
+}
+
+TEST(OutputBufferTest, AppendSplicesInOrder)
+{
+	arc::OutputBuffer first;
+	arc::OutputBuffer second;
+	first << "hello, ";
+	second << "world";
+
+	first.append(std::move(second));
+	first << '!';
+
+	EXPECT_EQ(first.str(), "hello, world!");
+	EXPECT_TRUE(second.empty());
+}
+
+TEST(OutputBufferTest, WritesToFileDescriptor)
+{
+	std::FILE *file = std::tmpfile();
+	ASSERT_NE(file, nullptr);
+
+	arc::OutputBuffer out;
+	const std::string text(arc::OutputBuffer::chunk_size + 123, 'z');
+	out << text;
+	out.write(fileno(file));
+
+	std::rewind(file);
+	std::string read(text.size(), '\0');
+	EXPECT_EQ(std::fread(read.data(), 1, read.size(), file), text.size());
+	EXPECT_EQ(read, text);
+	std::fclose(file);
+}
+
+TEST_F(PrinterFixture, DumpPrintsModule)
+{
+	build_functions(3);
+
+	std::ostringstream os;
+	arc::dump(*module, os);
+	const std::string text = os.str();
+	EXPECT_TRUE(text.starts_with("#! module: printer_module\n"));
+	EXPECT_NE(text.find("Point = struct"), std::string::npos);
+	EXPECT_NE(text.find("fn @fn0(i32 %"), std::string::npos);
+	EXPECT_NE(text.find("fn @fn2(i32 %"), std::string::npos);
+	EXPECT_EQ(text.find("fn @fn3("), std::string::npos);
+}
+
+TEST_F(PrinterFixture, ParallelOutputIsDeterministic)
+{
+	build_functions(arc::Printer::min_parallel_functions * 4);
+
+	const std::string sequential = print(1);
+	EXPECT_EQ(print(4), sequential);
+	EXPECT_EQ(print(16), sequential);
+
+	/* functions keep module order */
+	EXPECT_LT(sequential.find("fn @fn1("), sequential.find("fn @fn2("));
+	EXPECT_LT(sequential.find("fn @fn2("), sequential.find("fn @fn63("));
+}
+
+TEST_F(PrinterFixture, NumbersRestartPerFunction)
+{
+	build_functions(2);
+
+	/* both functions number their first parameter the same */
+	const std::string text = print(1);
+	const std::size_t fn0 = text.find("fn @fn0(i32 %");
+	const std::size_t fn1 = text.find("fn @fn1(i32 %");
+	ASSERT_NE(fn0, std::string::npos);
+	ASSERT_NE(fn1, std::string::npos);
+	EXPECT_EQ(text.substr(fn0 + 13, 2), text.substr(fn1 + 13, 2));
+}
+
+TEST_F(PrinterFixture, DumpToFileDescriptor)
+{
+	build_functions(2);
+
+	int fds[2];
+	ASSERT_EQ(pipe(fds), 0);
+
+	const std::string expected = print(1);
+	ASSERT_LT(expected.size(), 4096u); /* fits in the pipe without a reader */
+	arc::dump(*module, fds[1]);
+	close(fds[1]);
+
+	std::string read;
+	char buffer[512];
+	for (ssize_t n; (n = ::read(fds[0], buffer, sizeof(buffer))) > 0;)
+		read.append(buffer, static_cast<std::size_t>(n));
+	close(fds[0]);
+
+	EXPECT_EQ(read, expected);
+}
@@ -0,0 +1,140 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <arc/analysis/tbaa.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/pass-manager.hpp>
+#include <arc/support/generator.hpp>
+#include <arc/support/statistics.hpp>
+#include <arc/transform/cse.hpp>
+#include <gtest/gtest.h>
+
+namespace
+{
+	ARC_STATISTIC(widgets_seen, "statistics-test", "widgets counted by the test");
+	ARC_STATISTIC(gadgets_seen, "statistics-test", "gadgets counted by the test");
+
+	std::uint64_t value_of(const std::string &group, const std::string &name)
+	{
+		const std::vector<arc::StatisticValue> values = arc::statistics();
+		const auto it = std::ranges::find_if(values, [&](const arc::StatisticValue &stat)
+		{
+			return stat.group == group && stat.name == name;
+		});
+		return it == values.end() ? 0 : it->value;
+	}
+}
+
+TEST(StatisticsTest, CountersAreCompiledOutWhenDisabled)
+{
+	++widgets_seen;
+	widgets_seen += 4;
+
+	if (!arc::statistics_enabled())
+	{
+		EXPECT_EQ(widgets_seen.value(), 0u);
+		EXPECT_TRUE(arc::statistics().empty());
+		GTEST_SKIP() << "built without ARC_ENABLE_STATISTICS";
+	}
+	EXPECT_GE(value_of("statistics-test", "widgets_seen"), 5u);
+}
+
+TEST(StatisticsTest, ConcurrentIncrementsAreNotLost)
+{
+	if (!arc::statistics_enabled())
+		GTEST_SKIP() << "built without ARC_ENABLE_STATISTICS";
+
+	arc::reset_statistics();
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t)
+	{
+		threads.emplace_back([]
+		{
+			for (int i = 0; i < 10'000; ++i)
+				++gadgets_seen;
+		});
+	}
+	for (std::thread &thread: threads)
+		thread.join();
+
+	EXPECT_EQ(value_of("statistics-test", "gadgets_seen"), 40'000u);
+	arc::reset_statistics();
+	EXPECT_EQ(value_of("statistics-test", "gadgets_seen"), 0u);
+}
+
+TEST(StatisticsTest, SnapshotIsSortedByGroupThenName)
+{
+	const std::vector<arc::StatisticValue> values = arc::statistics();
+	EXPECT_TRUE(std::ranges::is_sorted(values, [](const arc::StatisticValue &a, const arc::StatisticValue &b)
+	{
+		return std::tie(a.group, a.name) < std::tie(b.group, b.name);
+	}));
+}
+
+TEST(StatisticsTest, TableListsOnlyNonZeroCounters)
+{
+	if (!arc::statistics_enabled())
+		GTEST_SKIP() << "built without ARC_ENABLE_STATISTICS";
+
+	arc::reset_statistics();
+	widgets_seen += 3;
+
+	std::ostringstream os;
+	arc::print_statistics(os);
+	const std::string table = os.str();
+	EXPECT_NE(table.find("statistics-test\n"), std::string::npos);
+	EXPECT_NE(table.find("widgets_seen"), std::string::npos);
+	EXPECT_NE(table.find("widgets counted by the test"), std::string::npos);
+	EXPECT_EQ(table.find("gadgets_seen"), std::string::npos);
+}
+
+TEST(StatisticsTest, JsonGroupsCountersByPass)
+{
+	std::ostringstream os;
+	arc::print_statistics_json(os);
+	const std::string json = os.str();
+	ASSERT_FALSE(json.empty());
+	EXPECT_EQ(json.front(), '{');
+
+	if (!arc::statistics_enabled())
+	{
+		EXPECT_EQ(json, "{}\n");
+		return;
+	}
+
+	arc::reset_statistics();
+	widgets_seen += 2;
+	os.str("");
+	arc::print_statistics_json(os);
+	EXPECT_NE(os.str().find("\"statistics-test\": {"), std::string::npos);
+	EXPECT_NE(os.str().find("\"widgets_seen\": 2"), std::string::npos);
+	EXPECT_NE(os.str().find("\"gadgets_seen\": 0"), std::string::npos);
+}
+
+TEST(StatisticsTest, PassesReportTheirEvents)
+{
+	if (!arc::statistics_enabled())
+		GTEST_SKIP() << "built without ARC_ENABLE_STATISTICS";
+
+	arc::reset_statistics();
+	const std::unique_ptr<arc::Module> module = arc::generate({ .seed = 11, .nodes = 4096 });
+
+	arc::PassManager pm;
+	pm.add<arc::TypeBasedAliasAnalysisPass>();
+	pm.add<arc::CommonSubexpressionEliminationPass>();
+	pm.run(*module);
+
+	/* the generator always emits memory operations, and CSE queries every pair of equivalent loads */
+	EXPECT_GT(value_of("type-based-alias-analysis", "accesses_tracked"), 0u);
+	EXPECT_EQ(value_of("type-based-alias-analysis", "alias_queries"),
+	          value_of("type-based-alias-analysis", "no_alias_results") +
+	          value_of("type-based-alias-analysis", "must_alias_results") +
+	          value_of("type-based-alias-analysis", "partial_alias_results") +
+	          value_of("type-based-alias-analysis", "may_alias_results"));
+}
@@ -4,6 +4,7 @@
 #include <arc/foundation/builder.hpp>
 #include <arc/foundation/module.hpp>
 #include <arc/foundation/pass-manager.hpp>
+#include <arc/support/algorithm.hpp>
 #include <arc/support/dump.hpp>
 #include <arc/transform/constfold.hpp>
 #include <gtest/gtest.h>
@@ -432,3 +433,35 @@ TEST_F(ConstFoldFixture, FromFolding)
 	EXPECT_EQ(ret_value->type_kind, arc::DataType::INT32);
 	EXPECT_EQ(ret_value->value.get<arc::DataType::INT32>(), 42);
 }
+
+TEST_F(ConstFoldFixture, LaterRunsRevisitChangedNodes)
+{
+	arc::Node *x = nullptr;
+	arc::Node *five = nullptr;
+	arc::Node *sum = nullptr;
+	builder->function<arc::DataType::INT32>("test_incremental")
+			.param<arc::DataType::INT32>("x")
+			.body([&](arc::Builder &fb, arc::Node *param)
+			{
+				x = param;
+				five = fb.lit(5);
+				sum = fb.add(x, fb.lit(2));
+				return fb.ret(sum);
+			});
+
+	/* nothing folds while the operand is a parameter */
+	pass_manager->run(*module);
+	auto *func_region = get_function_region("test_incremental");
+	ASSERT_NE(func_region, nullptr);
+	EXPECT_EQ(count_nodes(func_region, arc::NodeType::ADD), 1);
+
+	/* the second run only looks at the journaled edit, which makes the add foldable */
+	arc::update_connection(sum, x, five);
+	pass_manager->run(*module);
+	EXPECT_EQ(count_nodes(func_region, arc::NodeType::ADD), 0);
+
+	auto *ret = find_return(func_region);
+	ASSERT_NE(ret, nullptr);
+	EXPECT_EQ(ret->inputs[0]->ir_type, arc::NodeType::LIT);
+	EXPECT_EQ(ret->inputs[0]->value.get<arc::DataType::INT32>(), 7);
+}
@@ -371,3 +371,32 @@ TEST_F(CSEFixture, VectorOperationsCSE)
 	EXPECT_EQ(add->inputs[0], vec1);
 	std::println("vector operations CSE test passed");
 }
+
+TEST_F(CSEFixture, ExpressionsStayInTheirFunction)
+{
+	arc::Node* first = nullptr;
+	arc::Node* second = nullptr;
+	arc::Node* ret = nullptr;
+
+	builder->function<arc::DataType::INT32>("first")
+			.body([&](arc::Builder &fb)
+			{
+				first = fb.lit(42);
+				return fb.ret(first);
+			});
+	builder->function<arc::DataType::INT32>("second")
+			.body([&](arc::Builder &fb)
+			{
+				second = fb.lit(42);
+				ret = fb.ret(second);
+				return ret;
+			});
+
+	pass_manager->run(*module);
+
+	/* merging across functions would make the result depend on which functions share a module */
+	ASSERT_EQ(ret->inputs.size(), 1);
+	EXPECT_EQ(ret->inputs[0], second);
+	EXPECT_EQ(second->parent, ret->parent);
+	EXPECT_NE(first->parent, second->parent);
+}
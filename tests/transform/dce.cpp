@@ -5,6 +5,7 @@
 #include <arc/foundation/builder.hpp>
 #include <arc/foundation/module.hpp>
 #include <arc/foundation/pass-manager.hpp>
+#include <arc/support/algorithm.hpp>
 #include <arc/support/dump.hpp>
 #include <arc/transform/dce.hpp>
 #include <gtest/gtest.h>
@@ -341,3 +342,83 @@ TEST_F(DCEFixture, AllLiveCode)
 	EXPECT_EQ(nodes_after, nodes_before);
 	std::println("All live test: removed {} nodes", nodes_before - nodes_after);
 }
+
+TEST_F(DCEFixture, LaterRunsRemoveNodesThatLostTheirUsers)
+{
+	arc::Node *x = nullptr;
+	arc::Node *sum = nullptr;
+	arc::Node *ret = nullptr;
+	builder->function<arc::DataType::INT32>("test_incremental")
+			.param<arc::DataType::INT32>("x")
+			.body([&](arc::Builder &fb, arc::Node *param)
+			{
+				x = param;
+				sum = fb.add(fb.mul(x, fb.lit(3)), fb.lit(1));
+				ret = fb.ret(sum);
+				return ret;
+			});
+
+	pass_manager->run(*module);
+	const std::size_t nodes_before = count_nodes_in_module();
+
+	/* the return no longer uses the arithmetic; the second run follows the
+	 * journaled edit down the operand chain */
+	arc::update_connection(ret, sum, x);
+	pass_manager->run(*module);
+
+	EXPECT_EQ(sum->parent, nullptr);
+	EXPECT_EQ(count_nodes_in_module(), nodes_before - 4);
+}
+
+TEST_F(DCEFixture, LaterRunsRemoveDeadCycles)
+{
+	arc::Node *x = nullptr;
+	arc::Node *merged = nullptr;
+	arc::Node *next = nullptr;
+	arc::Node *ret = nullptr;
+	builder->function<arc::DataType::INT32>("test_cycle")
+			.param<arc::DataType::INT32>("x")
+			.body([&](arc::Builder &fb, arc::Node *param)
+			{
+				/* a loop-carried value: merged = from(x, next), next = merged + 1 */
+				x = param;
+				merged = fb.from({ x });
+				next = fb.add(merged, fb.lit(1));
+				merged->inputs.push_back(next);
+				next->users.push_back(merged);
+				ret = fb.ret(merged);
+				return ret;
+			});
+
+	pass_manager->run(*module);
+	ASSERT_NE(merged->parent, nullptr);
+	const std::size_t nodes_before = count_nodes_in_module();
+
+	/* the cycle keeps itself used, but nothing live reads it anymore */
+	arc::update_connection(ret, merged, x);
+	pass_manager->run(*module);
+
+	EXPECT_EQ(merged->parent, nullptr);
+	EXPECT_EQ(next->parent, nullptr);
+	EXPECT_EQ(count_nodes_in_module(), nodes_before - 3);
+}
+
+TEST_F(DCEFixture, RemovedNodesAreRecycledBetweenPasses)
+{
+	arc::Node *dead = nullptr;
+	builder->function<arc::DataType::INT32>("test_recycle")
+			.param<arc::DataType::INT32>("a")
+			.param<arc::DataType::INT32>("b")
+			.body([&](arc::Builder &fb, arc::Node *a, arc::Node *b)
+			{
+				dead = fb.mul(a, b);
+				return fb.ret(fb.add(a, b));
+			});
+
+	/* the second pass starts at a safe point, after the first one removed `dead` */
+	pass_manager->add<arc::DeadCodeElimination>();
+	pass_manager->run(*module);
+
+	EXPECT_EQ(module->reclaim(), 0u);
+	EXPECT_EQ(module->create_node(arc::NodeType::LIT, arc::DataType::INT32), dead);
+}
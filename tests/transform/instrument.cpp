@@ -0,0 +1,122 @@
+/* this project is part of the Arc project; licensed under the MIT license. see LICENSE for more info */
+
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <arc/analysis/profile.hpp>
+#include <arc/foundation/builder.hpp>
+#include <arc/foundation/module.hpp>
+#include <arc/foundation/pass-manager.hpp>
+#include <arc/interp/interpreter.hpp>
+#include <arc/transform/instrument.hpp>
+#include <gtest/gtest.h>
+
+class InstrumentFixture : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		module = std::make_unique<arc::Module>("instrument_test");
+		builder = std::make_unique<arc::Builder>(*module);
+	}
+
+	arc::Region *get_region(arc::Region *parent, const std::string &name)
+	{
+		for (arc::Region *child: parent->children())
+		{
+			if (child->name() == name)
+				return child;
+		}
+		return nullptr;
+	}
+
+	void build_sum()
+	{
+		builder->function<arc::DataType::INT32>("sum")
+				.param<arc::DataType::INT32>("limit")
+				.body([&](arc::Builder &fb, arc::Node *limit)
+				{
+					auto loop = fb.block<arc::DataType::VOID>("loop");
+					auto exit = fb.block<arc::DataType::VOID>("exit");
+
+					auto *counter = fb.alloc<arc::DataType::INT32>(fb.lit(1));
+					auto *total = fb.alloc<arc::DataType::INT32>(fb.lit(1));
+					fb.store(fb.lit(0), counter);
+					fb.store(fb.lit(0), total);
+					fb.jump(loop.entry());
+
+					loop([&](arc::Builder &lb)
+					{
+						auto *i = lb.add(lb.load(counter), lb.lit(1));
+						lb.store(i, counter);
+						lb.store(lb.add(lb.load(total), i), total);
+						return lb.branch(lb.lt(i, limit), loop.entry(), exit.entry());
+					});
+
+					exit([&](arc::Builder &eb)
+					{
+						return eb.ret(eb.load(total));
+					});
+
+					return nullptr;
+				});
+	}
+
+	std::unique_ptr<arc::Module> module;
+	std::unique_ptr<arc::Builder> builder;
+};
+
+TEST_F(InstrumentFixture, CountsEdgesAndEntries)
+{
+	build_sum();
+
+	arc::PassManager pm;
+	pm.add<arc::EdgeInstrumentation>();
+	pm.run(*module);
+
+	arc::Node *array = arc::EdgeInstrumentation::counters(*module);
+	ASSERT_NE(array, nullptr);
+
+	arc::Interpreter interp(*module);
+	EXPECT_EQ(interp.call("sum", { 10 }).as<std::int32_t>(), 55);
+	EXPECT_EQ(interp.call("sum", { 4 }).as<std::int32_t>(), 10);
+
+	const std::size_t counters = arc::ProfileLayout::of(*module).counters;
+	ASSERT_EQ(counters, 3);
+	std::vector<std::uint64_t> values(counters);
+	std::memcpy(values.data(), interp.global(array), counters * sizeof(std::uint64_t));
+
+	const arc::Profile profile = arc::Profile::from_counters(*module, values);
+	const arc::FunctionProfile &sum = profile.functions.at("sum");
+	EXPECT_EQ(sum.entry_count, 2);
+	ASSERT_EQ(sum.branches.size(), 1);
+	EXPECT_EQ(sum.branches[0], (arc::BranchWeights { 12, 2 }));
+}
+
+TEST_F(InstrumentFixture, IdempotentAndAttachable)
+{
+	build_sum();
+
+	for (int i = 0; i < 2; ++i)
+	{
+		arc::PassManager pm;
+		pm.add<arc::EdgeInstrumentation>();
+		pm.run(*module);
+	}
+	EXPECT_EQ(arc::ProfileLayout::of(*module).counters, 3);
+
+	/* a profile collected from the instrumented build attaches to it unchanged */
+	arc::Profile profile;
+	profile.functions["sum"] = { .entry_count = 2, .branches = { { 12, 2 } } };
+
+	arc::PassManager attach;
+	attach.add<arc::ProfileAnalysisPass>(profile);
+	attach.run(*module);
+	const auto &result = attach.get<arc::ProfileResult>();
+
+	arc::Region *body = get_region(module->root(), "sum");
+	ASSERT_NE(body, nullptr);
+	EXPECT_EQ(result.count(get_region(body, "loop")), 14);
+	EXPECT_EQ(result.count(get_region(body, "exit")), 2);
+	EXPECT_FLOAT_EQ(result.frequency(get_region(body, "loop")).value_or(0.0f), 7.0f);
+}